@@ -12,11 +12,9 @@ QT += widgets network
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+include(calc/calc.pri)
+
 SOURCES += main.cpp \
-    calc/calc.cpp \
-    calc/settinghandler.cpp \
-    calc/mathfunction.cpp \
-    calc/calc_private.cpp \
     mainwindow.cpp \
     updatechecker.cpp \
     qtcalc.cpp \
@@ -30,15 +28,11 @@ SOURCES += main.cpp \
     dini/inisection.cpp \
     dini/inifile.cpp \
     dini/dini_private.cpp \
-    calchistorydialog.cpp
+    calchistorydialog.cpp \
+    plotdialog.cpp \
+    plotwidget.cpp
 HEADERS += mainwindow.h \
     calchistorydialog.h \
-    calc/calc_private.h \
-    calc/calc.h \
-    calc/settinghandler.h \
-    calc/types.h \
-    calc/mathfunction.h \
-    calc/error.h \
     updatechecker.h \
     qtcalc.h \
     varswidget.h \
@@ -51,11 +45,14 @@ HEADERS += mainwindow.h \
     dini/inisection.h \
     dini/inifile.h \
     dini/dini_private.h \
-    dini/dini.h
+    dini/dini.h \
+    plotdialog.h \
+    plotwidget.h
 FORMS += mainwindow.ui \
     varsfuncsdialog.ui \
     dialogabout.ui \
-    calchistorydialog.ui
+    calchistorydialog.ui \
+    plotdialog.ui
 RESOURCES += resources.qrc
 TRANSLATIONS = resources/lang_en.ts \
                resources/lang_nl.ts
@@ -0,0 +1,24 @@
+# -------------------------------------------------
+# Benchmarks of the calculator engine and the file formats
+# Run dalculator-bench --help for the options, the results are written as JSON
+# -------------------------------------------------
+TARGET = dalculator-bench
+TEMPLATE = app
+
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+include(../calc/calc.pri)
+
+SOURCES += main.cpp \
+    benchmark.cpp \
+    ../dini/inivalue.cpp \
+    ../dini/inisection.cpp \
+    ../dini/inifile.cpp \
+    ../dini/dini_private.cpp
+HEADERS += benchmark.h \
+    ../dini/inivalue.h \
+    ../dini/inisection.h \
+    ../dini/inifile.h \
+    ../dini/dini_private.h \
+    ../dini/dini.h
@@ -0,0 +1,174 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "benchmark.h"
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <algorithm>
+
+namespace bench
+{
+    namespace
+    {
+        // Write a string as a JSON string
+        void writeJsonString(std::ostream& out, const std::string& str)
+        {
+            out<<'"';
+            for(std::string::const_iterator pos = str.begin(); pos != str.end(); ++pos)
+            {
+                if(*pos == '"' || *pos == '\\')
+                    out<<'\\'<<*pos;
+                else if(static_cast<unsigned char>(*pos) < 0x20)
+                {
+                    const char* digits = "0123456789abcdef";
+                    out<<"\\u00"<<digits[(*pos >> 4) & 0xF]<<digits[*pos & 0xF];
+                }
+                else
+                    out<<*pos;
+            }
+            out<<'"';
+        }
+    }
+
+    // runner:
+        // Public:
+            runner::runner()
+            : repetitions(5), minTime(0.1), listOnly(false) {}
+
+            void runner::setFilter(const std::string& newFilter)
+            { filter = newFilter; }
+
+            void runner::setRepetitions(const unsigned int& newRepetitions)
+            { repetitions = std::max(newRepetitions, 1u); }
+
+            void runner::setMinTime(const double& seconds)
+            { minTime = seconds; }
+
+            void runner::setListOnly(const bool& newListOnly)
+            { listOnly = newListOnly; }
+
+            bool runner::selected(const std::string& name) const
+            { return name.find(filter) != std::string::npos; }
+
+            void runner::run(const std::string& name, const std::function<void(unsigned long long)>& body)
+            {
+                if(!selected(name))
+                    return;
+                if(listOnly)
+                {
+                    std::cout<<name<<std::endl;
+                    return;
+                }
+
+                // Find the number of operations that takes at least the minimum time
+                unsigned long long iterations = 1;
+                double elapsed = measure(body, iterations);
+                while(elapsed < minTime * 1e9 && iterations < (1ull << 40))
+                {
+                    // Aim a bit above the minimum time, but never grow more than a factor 100 at once
+                    const double factor = elapsed > 0 ? minTime * 1.2e9 / elapsed : 100;
+                    iterations = static_cast<unsigned long long>(iterations * std::min(std::max(factor, 2.0), 100.0));
+                    elapsed = measure(body, iterations);
+                }
+
+                // A warm-up run, followed by the samples
+                measure(body, iterations);
+                result res;
+                res.name = name;
+                res.iterations = iterations;
+                for(unsigned int i = 0; i < repetitions; ++i)
+                    res.samples.push_back(measure(body, iterations) / iterations);
+
+                // The statistics of the samples
+                std::vector<double> sorted = res.samples;
+                std::sort(sorted.begin(), sorted.end());
+                const size_t middle = sorted.size() / 2;
+                res.median = sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+                res.min = sorted.front();
+                res.max = sorted.back();
+                res.mean = 0;
+                for(size_t i = 0; i < sorted.size(); ++i)
+                    res.mean += sorted[i] / sorted.size();
+                res.stddev = 0;
+                for(size_t i = 0; i < sorted.size(); ++i)
+                    res.stddev += (sorted[i] - res.mean) * (sorted[i] - res.mean) / sorted.size();
+                res.stddev = std::sqrt(res.stddev);
+                results.push_back(res);
+
+                // Show the progress, the results themselves are written as JSON
+                std::cerr<<name<<": "<<res.median<<" ns"<<std::endl;
+            }
+
+            const std::vector<result>& runner::getResults() const
+            { return results; }
+
+            void runner::writeJson(std::ostream& out, const std::string& label) const
+            {
+                // Describe the run
+                char date[32];
+                const std::time_t now = std::time(0);
+                std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+                out.precision(17);
+                out<<"{\n  \"context\": {\n    \"label\": ";
+                writeJsonString(out, label);
+                out<<",\n    \"date\": ";
+                writeJsonString(out, date);
+#ifdef __VERSION__
+                out<<",\n    \"compiler\": ";
+                writeJsonString(out, __VERSION__);
+#endif
+#ifdef NDEBUG
+                out<<",\n    \"debug\": false";
+#else
+                out<<",\n    \"debug\": true";
+#endif
+                out<<",\n    \"repetitions\": "<<repetitions;
+                out<<",\n    \"min_time_s\": "<<minTime;
+                out<<"\n  },\n  \"benchmarks\": [";
+
+                // Followed by the results
+                for(size_t i = 0; i < results.size(); ++i)
+                {
+                    const result& res = results[i];
+                    out<<(i ? "," : "")<<"\n    {\n      \"name\": ";
+                    writeJsonString(out, res.name);
+                    out<<",\n      \"iterations\": "<<res.iterations;
+                    out<<",\n      \"median_ns\": "<<res.median;
+                    out<<",\n      \"min_ns\": "<<res.min;
+                    out<<",\n      \"max_ns\": "<<res.max;
+                    out<<",\n      \"mean_ns\": "<<res.mean;
+                    out<<",\n      \"stddev_ns\": "<<res.stddev;
+                    out<<",\n      \"samples_ns\": [";
+                    for(size_t j = 0; j < res.samples.size(); ++j)
+                        out<<(j ? ", " : "")<<res.samples[j];
+                    out<<"]\n    }";
+                }
+                out<<"\n  ]\n}\n";
+            }
+
+        // Private:
+            double runner::measure(const std::function<void(unsigned long long)>& body, const unsigned long long& iterations)
+            {
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                body(iterations);
+                const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                return std::chrono::duration<double, std::nano>(end - start).count();
+            }
+}
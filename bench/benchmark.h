@@ -0,0 +1,94 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+
+namespace bench
+{
+    // The measurements of a single benchmark, all times are in nanoseconds per operation
+    struct result
+    {
+        std::string name;                           // The name of the benchmark, e.g. "parse/short"
+        unsigned long long iterations;              // The number of operations in every sample
+        std::vector<double> samples;                // The time per operation of every sample
+        double median;                              // The median of the samples
+        double min;                                 // The fastest sample
+        double max;                                 // The slowest sample
+        double mean;                                // The mean of the samples
+        double stddev;                              // The standard deviation of the samples
+    };
+
+    // Runs benchmarks and collects their results
+    // A benchmark is a function that executes the measured operation a given number of times. The number of operations
+    // is raised until a single run takes at least the minimum time, after which a warm-up run and a fixed number of
+    // measured runs (the samples) are done with that number of operations.
+    class runner
+    {
+        public:
+            // Constructor
+            runner();
+
+            // Only run the benchmarks whose name contains the filter
+            void setFilter(const std::string& newFilter);
+            // Set the number of samples of every benchmark
+            void setRepetitions(const unsigned int& newRepetitions);
+            // Set the minimum time of a single sample, in seconds
+            void setMinTime(const double& seconds);
+            // Only list the names of the benchmarks instead of running them
+            void setListOnly(const bool& newListOnly);
+
+            // Returns true if the benchmark with the given name should run, this can be used to skip expensive preparations
+            bool selected(const std::string& name) const;
+            // Run a benchmark, body(n) should execute the measured operation n times
+            void run(const std::string& name, const std::function<void(unsigned long long)>& body);
+
+            // Get the results of all benchmarks that ran
+            const std::vector<result>& getResults() const;
+            // Write the results as JSON, the label is stored with them to identify the run (e.g. a commit)
+            void writeJson(std::ostream& out, const std::string& label) const;
+
+        private:
+            // Execute body(iterations) and return the elapsed time in nanoseconds
+            static double measure(const std::function<void(unsigned long long)>& body, const unsigned long long& iterations);
+
+            std::string filter;                     // The filter on the names of the benchmarks
+            unsigned int repetitions;               // The number of samples of every benchmark
+            double minTime;                         // The minimum time of a single sample, in seconds
+            bool listOnly;                          // Whether only the names are listed
+            std::vector<result> results;            // The results of the benchmarks that ran
+    };
+
+    // Make sure the compiler doesn't optimise away the calculation of a value
+    template<class T> inline void keep(const T& value)
+    {
+#ifdef __GNUC__
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static const T* volatile sink;
+        sink = &value;
+#endif
+    }
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,417 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include "calc/calc.h"
+#include "calc/builtins.h"
+#include "calc/settinghandler.h"
+#include "dini/dini.h"
+#include "benchmark.h"
+
+namespace
+{
+    typedef std::vector<calc::string> corpus;
+
+    // A small random generator that gives the same numbers on every platform, so the generated corpora never change
+    class generator
+    {
+        public:
+            generator(const unsigned long long& seed)
+            : state(seed) {}
+
+            // Get a number in [0, n)
+            unsigned int next(const unsigned int& n)
+            {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                return static_cast<unsigned int>(state >> 33) % n;
+            }
+
+        private:
+            unsigned long long state;
+    };
+
+    // Prints how this program should be used
+    void printUsage(std::ostream& out)
+    {
+        out<<"Usage: dalculator-bench [options]\n"
+             "Runs the benchmarks of the calculator engine and writes the results as JSON.\n"
+             "\n"
+             "Options:\n"
+             "  -f, --filter TEXT      Only run the benchmarks whose name contains TEXT\n"
+             "  -r, --repetitions N    The number of samples of every benchmark, 5 by default\n"
+             "  -m, --min-time SEC     The minimum duration of a single sample, 0.1 by default\n"
+             "  -o, --output FILE      Write the results to FILE instead of the standard output\n"
+             "  -l, --label TEXT       A label stored with the results, e.g. the commit that is measured\n"
+             "      --temp-dir DIR     The directory for the files of the persistence benchmarks\n"
+             "      --list             Only list the names of the benchmarks\n"
+             "  -h, --help             Show this help\n";
+    }
+
+    // The corpora of expressions, using the variables x, y and z
+        // Short expressions, as typed in the calculator
+        corpus shortCorpus()
+        {
+            const char* expressions[] = {"1+2", "3*4-5", "2^10", "10/4", "7%3", "-5+3*x", "x*y", "0x1F+1", "(1+2)*3", "2~9", "z/2+1", "1:30+0:45"};
+            return corpus(expressions, expressions + sizeof(expressions)/sizeof(expressions[0]));
+        }
+
+        // Long expressions, sums of many terms
+        corpus longCorpus()
+        {
+            const char* operands[] = {"x", "y", "z", "1.5", "2", "0.25", "pi", "e"};
+            const char* operators[] = {"+", "-", "*", "/"};
+            generator gen(1);
+            corpus result;
+            for(unsigned int i = 0; i < 8; ++i)
+            {
+                std::ostringstream expr;
+                expr<<operands[gen.next(8)];
+                for(unsigned int term = 0; term < 64; ++term)
+                    expr<<operators[gen.next(4)]<<operands[gen.next(8)];
+                result.push_back(expr.str());
+            }
+            return result;
+        }
+
+        // Deeply nested expressions
+        corpus nestedCorpus()
+        {
+            const char* operators[] = {"+", "-", "*"};
+            generator gen(2);
+            corpus result;
+            for(unsigned int depth = 8; depth <= 64; depth *= 2)
+            {
+                calc::string expr = "x";
+                for(unsigned int i = 0; i < depth; ++i)
+                    expr = "(" + expr + operators[gen.next(3)] + (i % 2 ? "y" : "0.5") + ")";
+                result.push_back(expr);
+            }
+            return result;
+        }
+
+        // Expressions calling many functions
+        corpus functionCorpus()
+        {
+            const char* expressions[] = {"sin(x)+cos(y)*tan(0.5)",
+                                         "2~abs(x-y)+log(z)*exp(0.1)",
+                                         "avg(x, y, z, 1, 2, 3)+ncr(10, 3)",
+                                         "if(x>y, floor(z/3), ceil(z/3))+round(y)",
+                                         "atan(sinh(0.5)/cosh(0.5))+asin(0.5)+acos(0.25)",
+                                         "log10(faculty(10))*deg(rad(45))",
+                                         "sin(cos(sin(cos(sin(cos(x))))))"};
+            return corpus(expressions, expressions + sizeof(expressions)/sizeof(expressions[0]));
+        }
+
+    // Benchmark calc::forceParse() and calc::calculate() on a corpus
+    void benchmarkCorpus(bench::runner& runner, const calc::string& corpusName, const corpus& expressions)
+    {
+        // Every expression gets its own calculator, which doesn't clean up the functions
+        std::vector<std::unique_ptr<calc::calc> > calculators;
+        for(corpus::const_iterator pos = expressions.begin(); pos != expressions.end(); ++pos)
+        {
+            calculators.push_back(std::unique_ptr<calc::calc>(new calc::calc(*pos, false)));
+            try
+            { calculators.back()->calculate(); }
+            catch(calc::calcError& err)
+            {
+                std::cerr<<"The expression "<<*pos<<" of the corpus can't be calculated: "<<err.msg<<std::endl;
+                std::exit(2);
+            }
+        }
+        const size_t count = calculators.size();
+
+        runner.run("parse/" + corpusName, [&](unsigned long long n)
+        {
+            for(unsigned long long i = 0; i < n; ++i)
+                calculators[i % count]->forceParse();
+        });
+
+        // The calculators are parsed (and compiled) again when they're calculated for the first time
+        runner.run("calculate/" + corpusName, [&](unsigned long long n)
+        {
+            for(unsigned long long i = 0; i < n; ++i)
+                bench::keep(calculators[i % count]->calculate());
+        });
+
+        // Parsing, compiling and calculating a new expression every time
+        runner.run("calculate-new/" + corpusName, [&](unsigned long long n)
+        {
+            calc::calc calculator("", false);
+            for(unsigned long long i = 0; i < n; ++i)
+                bench::keep(calculator.calculate(expressions[i % count]));
+        });
+    }
+
+    // Benchmark calling a user defined function that calls a chain of depth - 1 other user defined functions
+    void benchmarkFunctionChain(bench::runner& runner, const unsigned int& depth)
+    {
+        std::ostringstream name;
+        name<<"function-chain/"<<depth;
+        if(!runner.selected(name.str()))
+            return;
+
+        // chain0(a) = a*1.5+1, chainN(a) = chainN-1(a)*0.5+a
+        calc::calc calculator("", false);
+        std::vector<calc::string> names;
+        for(unsigned int i = 0; i < depth; ++i)
+        {
+            std::ostringstream functionName, expression;
+            functionName<<"chain"<<i;
+            if(i == 0)
+                expression<<"ARG0*1.5+1";
+            else
+                expression<<names.back()<<"(ARG0)*0.5+ARG0";
+            names.push_back(functionName.str());
+            calculator.setFunction(names.back(), new calc::userDefinedMathFunction(expression.str(), true));
+        }
+
+        calc::mathFunction* top = calculator.getFunction(names.back());
+        const calc::argList args(1, 2.5);
+        runner.run(name.str(), [&](unsigned long long n)
+        {
+            for(unsigned long long i = 0; i < n; ++i)
+                bench::keep(top->execute(args, names.back()));
+        });
+
+        for(std::vector<calc::string>::const_iterator pos = names.begin(); pos != names.end(); ++pos)
+            calculator.deleteFunction(*pos);
+    }
+
+    // Benchmark real2str() for every output type, and str2real() for every kind of number
+    void benchmarkConversions(bench::runner& runner)
+    {
+        struct outputCase
+        {
+            const char* name;
+            calc::realOutputType type;
+            calc::real values[4];
+        };
+        const outputCase outputCases[] = {{"auto",          calc::outputType_auto,          {3.14159265358979, -0.000125, 1e21, 42}},
+                                          {"scientific",    calc::outputType_scientific,    {6.02214076e23, -1.5e-9, 299792458, 0.5}},
+                                          {"bin",           calc::outputType_bin,           {5, 255, 65535, 123456789}},
+                                          {"oct",           calc::outputType_oct,           {5, 255, 65535, 123456789}},
+                                          {"dec",           calc::outputType_dec,           {1234.5678, -0.001, 1e15, 7}},
+                                          {"hex",           calc::outputType_hex,           {5, 255, 65535, 123456789}},
+                                          {"time",          calc::outputType_time,          {3723.25, 59, 86400, 0.5}}};
+        for(size_t i = 0; i < sizeof(outputCases)/sizeof(outputCases[0]); ++i)
+        {
+            const outputCase& test = outputCases[i];
+            runner.run(calc::string("real2str/") + test.name, [&](unsigned long long n)
+            {
+                for(unsigned long long j = 0; j < n; ++j)
+                    bench::keep(calc::real2str(test.values[j % 4], test.type));
+            });
+        }
+
+        struct inputCase
+        {
+            const char* name;
+            const char* values[4];
+        };
+        const inputCase inputCases[] = {{"dec",         {"3.14159265358979", "-12345.678", "0.000125", "42"}},
+                                        {"hex",         {"0x7FFFFFFF", "0x1F", "-0xABCDEF", "0x0"}},
+                                        {"oct",         {"0777", "012345", "-017", "01"}}};
+        for(size_t i = 0; i < sizeof(inputCases)/sizeof(inputCases[0]); ++i)
+        {
+            const inputCase& test = inputCases[i];
+            const calc::string values[4] = {test.values[0], test.values[1], test.values[2], test.values[3]};
+            runner.run(calc::string("str2real/") + test.name, [&](unsigned long long n)
+            {
+                for(unsigned long long j = 0; j < n; ++j)
+                    bench::keep(calc::str2real(values[j % 4]));
+            });
+        }
+    }
+
+    // Benchmark saving and loading the settings of the calculator, with the given number of variables and functions
+    void benchmarkSettings(bench::runner& runner, const calc::string& fileName, const unsigned int& size)
+    {
+        std::ostringstream suffix;
+        suffix<<"/"<<size;
+        if(!runner.selected("settings/save" + suffix.str()) && !runner.selected("settings/load" + suffix.str()))
+            return;
+
+        calc::settingHandler settings;
+        for(unsigned int i = 0; i < size; ++i)
+        {
+            std::ostringstream var, function, expression;
+            var<<"vvariable"<<i;
+            function<<"ffunction"<<i;
+            expression<<"ARG0*"<<i<<"+sin(ARG1)/"<<(i + 1);
+            settings[var.str()] = calc::real2str(i * 1.25);
+            settings[function.str()] = expression.str();
+        }
+
+        runner.run("settings/save" + suffix.str(), [&](unsigned long long n)
+        {
+            for(unsigned long long i = 0; i < n; ++i)
+                settings.saveToFile(fileName);
+        });
+        settings.saveToFile(fileName);
+        runner.run("settings/load" + suffix.str(), [&](unsigned long long n)
+        {
+            calc::settingHandler loaded;
+            for(unsigned long long i = 0; i < n; ++i)
+                loaded.loadFromFile(fileName);
+        });
+        std::remove(fileName.c_str());
+    }
+
+    // Benchmark saving and loading an ini file with the given number of sections and values per section
+    void benchmarkIniFile(bench::runner& runner, const calc::string& fileName, const unsigned int& sections, const unsigned int& values)
+    {
+        std::ostringstream suffix;
+        suffix<<"/"<<sections<<"x"<<values;
+        if(!runner.selected("ini/save" + suffix.str()) && !runner.selected("ini/load" + suffix.str()))
+            return;
+
+        dini::iniFile file;
+        for(unsigned int i = 0; i < sections; ++i)
+        {
+            std::ostringstream sectionName;
+            sectionName<<"section"<<i;
+            dini::iniSection& section = file[sectionName.str()];
+            for(unsigned int j = 0; j < values; ++j)
+            {
+                std::ostringstream valueName;
+                valueName<<"value"<<j;
+                switch(j % 3)
+                {
+                    case 0:     section.setValue(valueName.str(), static_cast<int>(i * values + j));    break;
+                    case 1:     section.setValue(valueName.str(), (i + 1) * 0.125 * j);                 break;
+                    default:    section.setValue(valueName.str(), "some text; with = characters");      break;
+                }
+            }
+        }
+
+        runner.run("ini/save" + suffix.str(), [&](unsigned long long n)
+        {
+            for(unsigned long long i = 0; i < n; ++i)
+                file.saveToFile(fileName);
+        });
+        file.saveToFile(fileName);
+        runner.run("ini/load" + suffix.str(), [&](unsigned long long n)
+        {
+            dini::iniFile loaded;
+            for(unsigned long long i = 0; i < n; ++i)
+                loaded.loadFromFile(fileName);
+        });
+        std::remove(fileName.c_str());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // The options, set by the command line arguments
+    bench::runner runner;
+    calc::string outputFile = "-";
+    calc::string label;
+    const char* tempDir = std::getenv("TMPDIR");
+    calc::string tempDirectory = tempDir && *tempDir ? tempDir : ".";
+
+    // Read the command line arguments
+    for(int i = 1; i < argc; ++i)
+    {
+        const calc::string arg = argv[i];
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        else if((arg == "-f" || arg == "--filter") && i+1 < argc)
+            runner.setFilter(argv[++i]);
+        else if((arg == "-r" || arg == "--repetitions") && i+1 < argc)
+            runner.setRepetitions(std::strtoul(argv[++i], 0, 10));
+        else if((arg == "-m" || arg == "--min-time") && i+1 < argc)
+            runner.setMinTime(std::strtod(argv[++i], 0));
+        else if((arg == "-o" || arg == "--output") && i+1 < argc)
+            outputFile = argv[++i];
+        else if((arg == "-l" || arg == "--label") && i+1 < argc)
+            label = argv[++i];
+        else if(arg == "--temp-dir" && i+1 < argc)
+            tempDirectory = argv[++i];
+        else if(arg == "--list")
+            runner.setListOnly(true);
+        else
+        {
+            printUsage(std::cerr);
+            return 2;
+        }
+    }
+
+    // The built-in functions and some variables used by the corpora
+    calc::builtIns builtIns;
+    calc::calc calculator("", false);
+    builtIns.addTo(calculator);
+    calculator.setVar("x", 1.25);
+    calculator.setVar("y", -3.5);
+    calculator.setVar("z", 42);
+
+    // Run the benchmarks
+    benchmarkCorpus(runner, "short", shortCorpus());
+    benchmarkCorpus(runner, "long", longCorpus());
+    benchmarkCorpus(runner, "nested", nestedCorpus());
+    benchmarkCorpus(runner, "functions", functionCorpus());
+    benchmarkFunctionChain(runner, 1);
+    benchmarkFunctionChain(runner, 4);
+    benchmarkFunctionChain(runner, 16);
+    benchmarkConversions(runner);
+    try
+    {
+        const calc::string settingsFile = tempDirectory + "/dalculator-bench.dat";
+        benchmarkSettings(runner, settingsFile, 10);
+        benchmarkSettings(runner, settingsFile, 100);
+        benchmarkSettings(runner, settingsFile, 1000);
+        benchmarkSettings(runner, settingsFile, 10000);
+
+        const calc::string iniFile = tempDirectory + "/dalculator-bench.ini";
+        benchmarkIniFile(runner, iniFile, 1, 16);
+        benchmarkIniFile(runner, iniFile, 16, 64);
+        benchmarkIniFile(runner, iniFile, 128, 256);
+    }
+    catch(calc::fileError& err)
+    {
+        std::cerr<<"Couldn't use the file "<<err.fileName<<std::endl;
+        return 2;
+    }
+    catch(dini::fileError& err)
+    {
+        std::cerr<<"Couldn't use the file "<<err.filename<<std::endl;
+        return 2;
+    }
+
+    // Write the results
+    if(outputFile == "-")
+        runner.writeJson(std::cout, label);
+    else
+    {
+        std::ofstream out(outputFile.c_str());
+        runner.writeJson(out, label);
+        if(!out)
+        {
+            std::cerr<<"Couldn't write to "<<outputFile<<std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,861 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "builtins.h"
+#include "calc.h"
+#include "context.h"
+#include "program.h"
+#include "decimal.h"
+#include "random.h"
+#include "solver.h"
+#include "gradient.h"
+#include "series.h"
+#include "quadrature.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        // The built-in functions that don't need a builtIns object, they're constant initialized so they cost nothing at startup
+        // The number of arguments of the native functions is checked by nativeMathFunction
+        nativeMathFunction<double (*)(double)> absFunction(std::abs, false);
+        nativeMathFunction<double (*)(double)> ceilFunction(std::ceil, false);
+        nativeMathFunction<double (*)(double)> expFunction(std::exp, false);
+        nativeMathFunction<double (*)(double)> logFunction(std::log, false);
+        nativeMathFunction<double (*)(double)> log10Function(std::log10, false);
+        nativeMathFunction<double (*)(double)> floorFunction(std::floor, false);
+        nativeMathFunction<double (*)(double)> degFunction(mathFunctions::deg, false);
+        nativeMathFunction<double (*)(double)> radFunction(mathFunctions::rad, false);
+        nativeMathFunction<double (*)(double)> roundFunction(mathFunctions::round, false);
+        nativeMathFunction<double (*)(double)> facultyFunction(mathFunctions::faculty, false);
+        nativeMathFunction<real (*)(long long, long long)> ncrFunction(mathFunctions::ncr, false);
+        nativeMathFunction<real (*)(long long, long long)> nprFunction(mathFunctions::npr, false);
+        nativeMathFunction<real (*)(real)> lnFactFunction(mathFunctions::lnFact, false);
+        nativeMathFunction<real (*)(real, real)> lnCrFunction(mathFunctions::lnCr, false);
+        preDefinedMathFunction avgFunction(mathFunctions::average, false);
+        preDefinedMathFunction randFunction(mathFunctions::random, false);
+        preDefinedMathFunction ifFunction(mathFunctions::ifFunction, false);
+        benchmarkMathFunction benchFunction(false);
+        solverMathFunction solveFunction(false);
+        derivativeMathFunction derivFunction(false);
+        seriesMathFunction sumFunction(false, false);
+        seriesMathFunction productFunction(true, false);
+        integralMathFunction integrateFunction(false);
+
+        // A built-in function, either function or angle is set
+        struct builtInFunction
+        {
+            const char* name;                       // The name in capital form
+            mathFunction* function;                 // The function, if it doesn't need a builtIns object
+            int angle;                              // Otherwise the index of the function in builtIns::angleFunctions
+            const char* nativeCode;                 // The C++ expression calculating the function, # is the argument (see getNativeCode())
+        };
+
+        // All built-in functions
+        constexpr builtInFunction functionTable[] =
+        {
+            {"ABS",     &absFunction,       -1,                   "std::abs(#)"},
+            {"CEIL",    &ceilFunction,      -1,                   "std::ceil(#)"},
+            {"EXP",     &expFunction,       -1,                   "std::exp(#)"},
+            {"LOG",     &logFunction,       -1,                   "std::log(#)"},
+            {"LOG10",   &log10Function,     -1,                   "std::log10(#)"},
+            {"FLOOR",   &floorFunction,     -1,                   "std::floor(#)"},
+            {"DEG",     &degFunction,       -1,                   "#*(180/3.1415926535897932385)"},
+            {"RAD",     &radFunction,       -1,                   "#/(180/3.1415926535897932385)"},
+            {"ROUND",   &roundFunction,     -1,                   "(#-std::floor(#) < std::ceil(#)-# ? std::floor(#) : std::ceil(#))"},
+            {"FACULTY", &facultyFunction,   -1,                   0},
+            {"COS",     0,                  builtIns::angleCos,   0},
+            {"ACOS",    0,                  builtIns::angleAcos,  0},
+            {"COSH",    0,                  builtIns::angleCosh,  0},
+            {"SIN",     0,                  builtIns::angleSin,   0},
+            {"ASIN",    0,                  builtIns::angleAsin,  0},
+            {"SINH",    0,                  builtIns::angleSinh,  0},
+            {"TAN",     0,                  builtIns::angleTan,   0},
+            {"ATAN",    0,                  builtIns::angleAtan,  0},
+            {"TANH",    0,                  builtIns::angleTanh,  0},
+            {"AVG",     &avgFunction,       -1,                   0},
+            {"NCR",     &ncrFunction,       -1,                   0},
+            {"NPR",     &nprFunction,       -1,                   0},
+            {"LNFACT",  &lnFactFunction,    -1,                   0},
+            {"LNCR",    &lnCrFunction,      -1,                   0},
+            {"RAND",    &randFunction,      -1,                   0},
+            {"IF",      &ifFunction,        -1,                   0},
+            {"BENCH",   &benchFunction,     -1,                   0},
+            {"SOLVE",   &solveFunction,     -1,                   0},
+            {"DERIV",   &derivFunction,     -1,                   0},
+            {"SUM",     &sumFunction,       -1,                   0},
+            {"PRODUCT", &productFunction,   -1,                   0},
+            {"INTEGRATE", &integrateFunction, -1,                 0}
+        };
+        constexpr unsigned int functionCount = sizeof(functionTable) / sizeof(functionTable[0]);
+
+        // The perfect hash of the names:
+        // The name is hashed case insensitively with FNV-1a, so both forms of a name get the same hash, then the hash is
+        // multiplied by a constant and the highest bits are the slot. The constant is searched for at compile time,
+        // starting at the golden ratio, such that all names end up in a different slot.
+        const unsigned int slotBits = 8;
+        const unsigned int slotCount = 1u << slotBits;
+        static_assert(functionCount < slotCount / 4, "The slots are too full to find a perfect hash quickly");
+
+        // Returns the character in non-capital form
+        constexpr char lowerCase(const char c)
+        { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+        // Hashes the name case insensitively with 32-bit FNV-1a
+        constexpr unsigned int hashName(const char* name, const unsigned int hash = 2166136261u)
+        { return *name ? hashName(name + 1, ((hash ^ static_cast<unsigned char>(lowerCase(*name))) * 16777619u) & 0xffffffffu) : hash; }
+
+        // Get the slot of a hash, using the given multiplier
+        constexpr unsigned int slotOf(const unsigned int hash, const unsigned int multiplier)
+        { return ((hash * multiplier) & 0xffffffffu) >> (32 - slotBits); }
+
+        // Returns true if the function at index gets the same slot as any of the functions from other on
+        constexpr bool collides(const unsigned int multiplier, const unsigned int index, const unsigned int other)
+        {
+            return other < functionCount &&
+                   (slotOf(hashName(functionTable[index].name), multiplier) == slotOf(hashName(functionTable[other].name), multiplier) ||
+                    collides(multiplier, index, other + 1));
+        }
+
+        // Returns true if all functions from index on get a different slot
+        constexpr bool isPerfect(const unsigned int multiplier, const unsigned int index = 0)
+        { return index >= functionCount || (!collides(multiplier, index, index + 1) && isPerfect(multiplier, index + 1)); }
+
+        // Find the first multiplier from the given one on that gives a perfect hash
+        constexpr unsigned int findMultiplier(const unsigned int multiplier)
+        { return isPerfect(multiplier) ? multiplier : findMultiplier(multiplier + 2); }
+
+        constexpr unsigned int slotMultiplier = findMultiplier(0x9e3779b1u);
+
+        // The table from slot to index in functionTable, filled the first time it's needed
+        struct slotTable
+        {
+            static const unsigned char noFunction = 0xff;
+            static_assert(functionCount < noFunction, "Too many built-in functions for the slot table");
+
+            slotTable()
+            {
+                std::fill(slots, slots + slotCount, noFunction);
+                for(unsigned int i = 0; i < functionCount; ++i)
+                    slots[slotOf(hashName(functionTable[i].name), slotMultiplier)] = static_cast<unsigned char>(i);
+            }
+
+            unsigned char slots[slotCount];
+        };
+        const unsigned char slotTable::noFunction;
+
+        // Get the index in functionTable of the function with the given name, returns functionCount if there is none
+        // Only the capital and the non-capital form are accepted, not a mix of both
+        unsigned int findBuiltIn(const string& name)
+        {
+            static const slotTable table;
+            const unsigned char index = table.slots[slotOf(hashName(name.c_str()), slotMultiplier)];
+            if(index == slotTable::noFunction)
+                return functionCount;
+
+            // Compare the name to the capital and the non-capital form at once
+            const char* builtInName = functionTable[index].name;
+            bool capital = true, nonCapital = true;
+            string::const_iterator pos = name.begin();
+            for(; pos != name.end() && *builtInName; ++pos, ++builtInName)
+            {
+                capital = capital && *pos == *builtInName;
+                nonCapital = nonCapital && *pos == lowerCase(*builtInName);
+            }
+            return (pos == name.end() && !*builtInName && (capital || nonCapital)) ? index : functionCount;
+        }
+
+        // The goniometric functions for angles in degrees, the conversion factor is folded into the computation
+        const double radiansPerDegree = mathConstant::PI / 180;
+        const double degreesPerRadian = 180 / mathConstant::PI;
+        double cosDegrees(double x)     { return std::cos(x * radiansPerDegree); }
+        double acosDegrees(double x)    { return std::acos(x) * degreesPerRadian; }
+        double coshDegrees(double x)    { return std::cosh(x * radiansPerDegree); }
+        double sinDegrees(double x)     { return std::sin(x * radiansPerDegree); }
+        double asinDegrees(double x)    { return std::asin(x) * degreesPerRadian; }
+        double sinhDegrees(double x)    { return std::sinh(x * radiansPerDegree); }
+        double tanDegrees(double x)     { return std::tan(x * radiansPerDegree); }
+        double atanDegrees(double x)    { return std::atan(x) * degreesPerRadian; }
+        double tanhDegrees(double x)    { return std::tanh(x * radiansPerDegree); }
+
+        // The versions of the goniometric functions for both angle types, in the order of builtIns::angleFunction
+        struct angleKernels
+        {
+            double (*radians)(double);              // The function for angles in radians
+            double (*degrees)(double);              // The function for angles in degrees
+        };
+        const angleKernels angleFunctionKernels[builtIns::angleFunctionCount] =
+        {
+            {std::cos,  cosDegrees},
+            {std::acos, acosDegrees},
+            {std::cosh, coshDegrees},
+            {std::sin,  sinDegrees},
+            {std::asin, asinDegrees},
+            {std::sinh, sinhDegrees},
+            {std::tan,  tanDegrees},
+            {std::atan, atanDegrees},
+            {std::tanh, tanhDegrees}
+        };
+
+        // Get the name of a built-in function in non-capital form
+        string nonCapitalName(const char* name)
+        {
+            string out(name);
+            std::transform(out.begin(), out.end(), out.begin(), lowerCase);
+            return out;
+        }
+
+        // The factorials that are looked up, 170! is the largest one that's finite
+        const int factorialCount = 171;
+        // The rows of Pascal's triangle that are looked up, all binomial coefficients of row 67 still fit in 64 bits
+        const int binomialRows = 68;
+        // A binomial coefficient with more factors than this (after taking the smaller of k and n-k) or a product of more
+        // factors than this doesn't fit in a real, so combinatorics() doesn't have to calculate it
+        const int maxCombinatoricsFactors = 1100;
+        // The largest number of chosen factors whose logarithms are added by LNCR, more factors are calculated with the
+        // logarithm of the gamma function
+        const int maxLogFactors = 64;
+        // The ranges RAND picks integers from have to be smaller than 2^63, so their size fits in 64 bits
+        const real maxRandomRange = 9223372036854775808.0;
+
+        // The tables of factorials and binomial coefficients, filled the first time they're needed
+        struct combinatoricsTables
+        {
+            combinatoricsTables()
+            {
+                // The factorials are multiplied as exact decimals, so every entry is the real nearest to the factorial
+                decimal product(1);
+                factorials[0] = 1;
+                for(int n = 1; n < factorialCount; ++n)
+                {
+                    product *= decimal(n);
+                    factorials[n] = product.toReal();
+                }
+
+                // Row n of the triangle starts at index n*(n+1)/2
+                for(int n = 0; n < binomialRows; ++n)
+                {
+                    for(int k = 0; k <= n; ++k)
+                        binomials[n*(n+1)/2 + k] = (k == 0 || k == n) ? 1 : binomials[(n-1)*n/2 + k-1] + binomials[(n-1)*n/2 + k];
+                }
+            }
+
+            real factorials[factorialCount];                                // n!
+            unsigned long long binomials[binomialRows*(binomialRows+1)/2];  // n over k, row by row
+        };
+
+        // Get the tables
+        const combinatoricsTables& getTables()
+        {
+            static const combinatoricsTables tables;
+            return tables;
+        }
+
+        // The greatest common divisor, by Euclid's algorithm
+        unsigned long long gcd(unsigned long long a, unsigned long long b)
+        {
+            while(b != 0)
+            {
+                const unsigned long long rest = a % b;
+                a = b;
+                b = rest;
+            }
+            return a;
+        }
+
+        // Get the number of bits of a positive number
+        int bitLength(unsigned long long value)
+        {
+            int bits = 0;
+            for(; value != 0; value >>= 1)
+                ++bits;
+            return bits;
+        }
+
+        // Multiply a number of 32 bit limbs, least significant first, by a factor below 2^64
+        // The factor is multiplied in halves of 32 bits, so every partial product and its carry fit in 64 bits.
+        void multiplyLimbs(std::vector<uint32_t>& limbs, const uint64_t& factor)
+        {
+            const uint64_t halves[2] = {factor & 0xFFFFFFFF, factor >> 32};
+            std::vector<uint32_t> product(limbs.size() + 2, 0);
+            for(size_t half = 0; half < 2; ++half)
+            {
+                uint64_t carry = 0;
+                size_t j = 0;
+                for(; j < limbs.size(); ++j)
+                {
+                    carry += static_cast<uint64_t>(limbs[j]) * halves[half] + product[j + half];
+                    product[j + half] = static_cast<uint32_t>(carry);
+                    carry >>= 32;
+                }
+                for(j += half; carry != 0; ++j)
+                {
+                    carry += product[j];
+                    product[j] = static_cast<uint32_t>(carry);
+                    carry >>= 32;
+                }
+            }
+            while(product.size() > 1 && product.back() == 0)
+                product.pop_back();
+            limbs.swap(product);
+        }
+
+        // Calculate n!/((n-k)!*k!) exactly with 32 bit limbs, least significant first, if divide is true and n!/(n-k)! otherwise
+        // Returns the real nearest to it, for 0 <= k <= maxCombinatoricsFactors and k <= n
+        real exactCombinatorics(const long long& n, const int& k, const bool& divide)
+        {
+            // The numerators are multiplied in chunks below 2^64 and the denominators in chunks below 2^32, after the numerators
+            // up to n-k+i the product is n-k+i over i (or a product of i factors), so dividing by the denominators up to i is exact
+            const uint64_t numeratorLimit = static_cast<uint64_t>(1) << (64 - bitLength(n));
+            const uint64_t denominatorLimit = static_cast<uint64_t>(1) << (32 - bitLength(k));
+            std::vector<uint32_t> limbs(1, 1);
+            uint64_t numerator = 1, denominator = 1;
+            for(int i = 1; i <= k + 1; ++i)
+            {
+                if(i > k || numerator >= numeratorLimit || denominator >= denominatorLimit)
+                {
+                    multiplyLimbs(limbs, numerator);
+                    uint64_t rest = 0;
+                    for(size_t j = limbs.size(); j-- > 0;)
+                    {
+                        rest = (rest << 32) | limbs[j];
+                        limbs[j] = static_cast<uint32_t>(rest / denominator);
+                        rest %= denominator;
+                    }
+                    if(limbs.back() == 0)
+                        limbs.pop_back();
+                    numerator = denominator = 1;
+                }
+                numerator *= static_cast<uint64_t>(n - k + i);
+                if(divide)
+                    denominator *= static_cast<uint64_t>(i);
+            }
+
+            // Round once: the top 64 bits are exact in a long double, if any lower bit isn't 0 the lowest of them is set,
+            // so a tie between two reals is broken correctly
+            const size_t count = limbs.size();
+            if(count <= 2)
+                return static_cast<real>((count == 2 ? static_cast<uint64_t>(limbs[1]) << 32 : 0) | limbs[0]);
+            const int lead = 32 - bitLength(limbs[count-1]);
+            uint64_t top = (static_cast<uint64_t>(limbs[count-1]) << 32) | limbs[count-2];
+            uint32_t rest = limbs[count-3];
+            if(lead > 0)
+            {
+                top = (top << lead) | (rest >> (32 - lead));
+                rest <<= lead;
+            }
+            bool sticky = rest != 0;
+            for(size_t j = 0; j + 3 < count; ++j)
+                sticky |= limbs[j] != 0;
+            return static_cast<real>(std::ldexp(static_cast<long double>(top | (sticky ? 1 : 0)), static_cast<int>(count - 2) * 32 - lead));
+        }
+
+        // A product that's about twice as precise as a long double: the low part holds the rounding errors of the high part
+        struct preciseProduct
+        {
+            // Constructor
+            preciseProduct(const long double& value = 1) : high(value), low(0) {}
+
+            // Split a long double in two halves of 32 bits (Veltkamp's algorithm), so products of the halves are exact
+            static void split(const long double& value, long double& valueHigh, long double& valueLow)
+            {
+                const long double scaled = value * 4294967297.0L;   // 2^32 + 1
+                valueHigh = scaled - (scaled - value);
+                valueLow = value - valueHigh;
+            }
+            // Multiply two long doubles, product + error is exactly a * b (Dekker's algorithm)
+            static void exactProduct(const long double& a, const long double& b, long double& product, long double& error)
+            {
+                long double aHigh, aLow, bHigh, bLow;
+                split(a, aHigh, aLow);
+                split(b, bHigh, bLow);
+                product = a * b;
+                error = ((aHigh*bHigh - product) + aHigh*bLow + aLow*bHigh) + aLow*bLow;
+            }
+
+            long double high, low;                  // The value is high + low, |low| is at most half a unit of high
+        };
+
+        // Multiply a product by a factor, a long double is rounded and a preciseProduct keeps the error
+        void multiply(long double& product, const long double& factor)
+        { product *= factor; }
+        void multiply(preciseProduct& product, const long double& factor)
+        {
+            long double high, error;
+            preciseProduct::exactProduct(product.high, factor, high, error);
+            const long double low = product.low * factor + error;
+            product.high = high + low;
+            product.low = low - (product.high - high);
+        }
+        // Multiply a product by 2^exponent, which is exact
+        void scale(long double& product, const int& exponent)
+        { product = std::ldexp(product, exponent); }
+        void scale(preciseProduct& product, const int& exponent)
+        {
+            product.high = std::ldexp(product.high, exponent);
+            product.low = std::ldexp(product.low, exponent);
+        }
+        // Get the long double nearest to a product
+        long double approximate(const long double& product)     { return product; }
+        long double approximate(const preciseProduct& product)  { return product.high; }
+
+        // Multiply the factors n-k+i to n-k+k of combinatorics() into the numerator and the factors i to k into the denominator
+        // if divide is true. The factors are multiplied in chunks below 2^64 which are exact, operations counts the multiplications
+        // of the products. The numerator is scaled down by powers of 2 so it doesn't overflow, the actual numerator is
+        // numerator * 2^exponent. The denominator is at most k! which fits in a long double.
+        template <typename Product>
+        void combinatoricsProducts(const long long& n, const int& k, const bool& divide, int i, Product& numerator, Product& denominator, int& exponent, int& operations)
+        {
+            const int scaleBits = 8192;
+            const long double scaleLimit = std::ldexp(1.0L, scaleBits);
+            // A chunk below the limit can take another factor
+            const unsigned long long numeratorLimit = static_cast<unsigned long long>(1) << (64 - bitLength(n));
+            const unsigned long long denominatorLimit = static_cast<unsigned long long>(1) << (64 - bitLength(k));
+            unsigned long long numeratorChunk = 1, denominatorChunk = 1;
+            exponent = operations = 0;
+            for(; i <= k + 1; ++i)
+            {
+                if(i > k || numeratorChunk >= numeratorLimit)
+                {
+                    multiply(numerator, static_cast<long double>(numeratorChunk));
+                    numeratorChunk = 1;
+                    ++operations;
+                    if(approximate(numerator) > scaleLimit)
+                    {
+                        scale(numerator, -scaleBits);
+                        exponent += scaleBits;
+                    }
+                }
+                if(divide && (i > k || denominatorChunk >= denominatorLimit))
+                {
+                    multiply(denominator, static_cast<long double>(denominatorChunk));
+                    denominatorChunk = 1;
+                    ++operations;
+                }
+                if(i <= k)
+                {
+                    numeratorChunk *= static_cast<unsigned long long>(n - k + i);
+                    denominatorChunk *= static_cast<unsigned long long>(divide ? i : 1);
+                }
+            }
+        }
+
+        // Calculate n!/((n-k)!*k!) if divide is true and n!/(n-k)! otherwise, for 0 <= k <= n, rounded to the nearest real
+        // The result is exact as long as it fits in 64 bits. After that the factors are multiplied as long doubles, whose error
+        // is small enough to know the nearest real in most cases. Otherwise they're multiplied as preciseProducts, and only if
+        // the result is still too close to halfway between two reals it's calculated exactly.
+        real combinatorics(const long long& n, const long long& factors, const bool& divide)
+        {
+            if(factors > maxCombinatoricsFactors)
+                return std::numeric_limits<real>::infinity();
+            const int k = static_cast<int>(factors);
+
+            // The product (n-k+1)/1 * (n-k+2)/2 * ... is an integer after every factor, dividing by the gcd first keeps it exact
+            const unsigned long long largest = std::numeric_limits<unsigned long long>::max();
+            unsigned long long exact = 1;
+            int i = 1;
+            for(; i <= k; ++i)
+            {
+                const unsigned long long common = divide ? gcd(exact, i) : 1;
+                const unsigned long long reduced = exact / common;
+                const unsigned long long factor = static_cast<unsigned long long>(n - k + i) / (divide ? i / common : 1);
+                if(reduced > largest / factor)
+                    break;
+                exact = reduced * factor;
+            }
+            if(i > k)
+                return static_cast<real>(exact);
+
+            long double numerator = static_cast<long double>(exact), denominator = 1;
+            int exponent, operations;
+            combinatoricsProducts(n, k, divide, i, numerator, denominator, exponent, operations);
+            const long double quotient = numerator / denominator;
+            if(std::ilogb(quotient) + exponent > std::numeric_limits<real>::max_exponent)
+                return std::numeric_limits<real>::infinity();
+
+            // Every operation, including the ones of the bounds, is off by at most half a unit of the 64 bit mantissa. If the
+            // whole range the quotient can be in rounds to the same real that's the nearest one.
+            const long double error = std::ldexp(static_cast<long double>(operations + 4), -std::numeric_limits<long double>::digits);
+            const real low = static_cast<real>(std::ldexp(quotient * (1 - error), exponent));
+            const real high = static_cast<real>(std::ldexp(quotient * (1 + error), exponent));
+            if(low == high)
+                return low;
+
+            // The precise quotient is q + r, with the remainder of q = numerator / denominator calculated exactly
+            preciseProduct preciseNumerator, preciseDenominator;
+            combinatoricsProducts(n, k, divide, 1, preciseNumerator, preciseDenominator, exponent, operations);
+            const long double q = preciseNumerator.high / preciseDenominator.high;
+            long double product, productError;
+            preciseProduct::exactProduct(q, preciseDenominator.high, product, productError);
+            const long double r = (((preciseNumerator.high - product) - productError) + preciseNumerator.low - q * preciseDenominator.low) / preciseDenominator.high;
+            preciseProduct value(q + r);
+            value.low = r - (value.high - q);
+            scale(value, exponent);
+
+            // It rounds to the real nearest to its high part if it's clearly between the points halfway to the reals next to that one,
+            // the error of the precise products is far below the margin
+            const real nearest = static_cast<real>(value.high);
+            const long double below = (static_cast<long double>(nearest) + std::nextafter(nearest, real(0))) / 2;
+            const long double above = (static_cast<long double>(nearest) + std::nextafter(nearest, std::numeric_limits<real>::infinity())) / 2;
+            const long double margin = std::ldexp(value.high, -110);
+            if((value.high - below) + value.low > margin && (value.high - above) + value.low < -margin)
+                return nearest;
+            return exactCombinatorics(n, k, divide);
+        }
+    }
+
+    // builtIns:
+        // Public:
+            builtIns::builtIns(const angleType& angle)
+            : angleFunctions{ {std::cos, false}, {std::acos, false}, {std::cosh, false},
+                              {std::sin, false}, {std::asin, false}, {std::sinh, false},
+                              {std::tan, false}, {std::atan, false}, {std::tanh, false} },
+              currAngleType(angleRadians)
+            {
+                // Switch the goniometric functions to the angle type
+                setAngleType(angle);
+
+                // Set the built in variables
+                vars["pi"]  = mathConstant::PI;
+                vars["e"]   = mathConstant::E;
+                vars["phi"] = mathConstant::PHI;
+            }
+
+            void builtIns::addTo(calc& calculator) const
+            {
+                // Add the built-in functions to the calculator, in both forms
+                for(unsigned int i = 0; i < functionCount; ++i)
+                {
+                    mathFunction* function = getFunction(functionTable[i].name);
+                    calculator.setFunction(functionTable[i].name, function);
+                    calculator.setFunction(nonCapitalName(functionTable[i].name), function);
+                }
+
+                // Add the built-in variables to the calculator
+                for(varList::const_iterator pos = vars.begin(); pos != vars.end(); ++pos)
+                    calculator.setVar(pos->first, pos->second);
+            }
+
+            void builtIns::addTo(context& target) const
+            {
+                // Add the built-in functions to the context, in both forms
+                for(unsigned int i = 0; i < functionCount; ++i)
+                {
+                    mathFunction* function = getFunction(functionTable[i].name);
+                    target.setFunction(functionTable[i].name, function);
+                    target.setFunction(nonCapitalName(functionTable[i].name), function);
+                }
+
+                // Add the built-in variables to the context
+                for(varList::const_iterator pos = vars.begin(); pos != vars.end(); ++pos)
+                    target.setVar(pos->first, pos->second);
+            }
+
+            mathFunction* builtIns::getFunction(const string& name) const
+            {
+                const unsigned int index = findBuiltIn(name);
+                if(index == functionCount)
+                    return 0;
+                return functionTable[index].function ? functionTable[index].function : &angleFunctions[functionTable[index].angle];
+            }
+
+            const char* builtIns::getNativeCode(const string& name)
+            {
+                const unsigned int index = findBuiltIn(name);
+                return index == functionCount ? 0 : functionTable[index].nativeCode;
+            }
+
+            const char* builtIns::getBuiltInName(const mathFunction* function, const string& name, angleType* angle)
+            {
+                const unsigned int index = findBuiltIn(name);
+                if(index == functionCount || function == 0)
+                    return 0;
+                if(functionTable[index].function != 0)
+                    return functionTable[index].function == function ? functionTable[index].name : 0;
+
+                // A goniometric function is recognized by the kernel it's using, which tells the angle type as well
+                const nativeMathFunction<double (*)(double)>* native = dynamic_cast<const nativeMathFunction<double (*)(double)>*>(function);
+                if(angle == 0 || native == 0)
+                    return 0;
+                const angleKernels& kernels = angleFunctionKernels[functionTable[index].angle];
+                if(native->getFunction() == kernels.radians)
+                    *angle = angleRadians;
+                else if(native->getFunction() == kernels.degrees)
+                    *angle = angleDegrees;
+                else
+                    return 0;
+                return functionTable[index].name;
+            }
+
+            const varList& builtIns::getVars() const
+            { return vars; }
+
+            builtIns::angleType builtIns::getAngleType() const
+            { return currAngleType; }
+
+            void builtIns::setAngleType(const angleType& newType)
+            {
+                currAngleType = newType;
+                for(unsigned int i = 0; i < angleFunctionCount; ++i)
+                    angleFunctions[i].setFunction(newType == angleDegrees ? angleFunctionKernels[i].degrees : angleFunctionKernels[i].radians);
+            }
+
+    // benchmarkMathFunction:
+        // Public:
+            real benchmarkMathFunction::execute(const argList&, const string& name)
+            { throw calcError("The expression has to be passed unevaluated", calcError::invalidArguments, name); }
+
+            bool benchmarkMathFunction::takesExpressions() const
+            { return true; }
+
+            real benchmarkMathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                // The first argument is the expression, the optional second one the number of runs
+                if(expressions.size() < 1 || expressions.size() > 2)
+                {
+                    std::vector<real> extraRealInfo(2, expressions.size());
+                    extraRealInfo[1] = expressions.size() < 1 ? 1 : 2;
+                    throw calcError(expressions.size() < 1 ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+                real runs = 1000;
+                if(expressions.size() == 2)
+                {
+                    runs = context::compile(expressions[1], &env)->execute(env);
+                    if(std::floor(runs) != runs)
+                        throw calcError("Only integers allowed", calcError::invalidArguments, name);
+                    if(runs < 1 || runs > 1e9)
+                        throw calcError("Invalid argument", calcError::invalidArguments, std::vector<string>(1, name), std::vector<real>(1, runs));
+                }
+                const unsigned long long count = runs;
+
+                // Compile the expression once, after that every calculation executes the compiled expression like calc::calculate() does
+                const std::shared_ptr<const program> prog = context::compile(expressions[0], &env);
+
+                // Warm up with a tenth of the runs (at least one), those aren't measured
+                for(unsigned long long i = 0; i <= count / 10; ++i)
+                    prog->execute(env);
+
+                // Split the runs into at most 31 samples, so a single slow run (e.g. because of an interrupt) doesn't change the median
+                typedef std::chrono::steady_clock clock;
+                const unsigned int sampleCount = std::min<unsigned long long>(count, 31);
+                std::vector<real> samples;
+                unsigned long long done = 0;
+                for(unsigned int i = 0; i < sampleCount; ++i)
+                {
+                    const unsigned long long sampleRuns = (count - done) / (sampleCount - i);
+                    const clock::time_point start = clock::now();
+                    for(unsigned long long j = 0; j < sampleRuns; ++j)
+                        prog->execute(env);
+                    const clock::time_point stop = clock::now();
+                    samples.push_back(std::chrono::duration<real, std::nano>(stop - start).count() / sampleRuns);
+                    done += sampleRuns;
+                }
+
+                // Remember the spread of the samples, and return their median
+                std::sort(samples.begin(), samples.end());
+                const size_t middle = samples.size() / 2;
+                const result measured = {count, sampleCount, samples.size() % 2 ? samples[middle] : (samples[middle-1] + samples[middle]) / 2, samples.front(), samples.back()};
+                lastResult = measured;
+                hasLastResult = true;
+                return measured.median;
+            }
+
+            // Static:
+                bool benchmarkMathFunction::takeLastResult(result& out)
+                {
+                    if(!hasLastResult)
+                        return false;
+                    out = lastResult;
+                    hasLastResult = false;
+                    return true;
+                }
+
+                void benchmarkMathFunction::forgetLastResult()
+                { hasLastResult = false; }
+
+        // Private:
+            // Static:
+                thread_local bool benchmarkMathFunction::hasLastResult = false;
+                thread_local benchmarkMathFunction::result benchmarkMathFunction::lastResult;
+
+// Functions:
+    namespace mathFunctions
+    {
+        double rad(double deg)
+        { return deg/(180/mathConstant::PI); }
+
+        double deg(double rad)
+        { return rad*(180/mathConstant::PI); }
+
+        double round(double src)
+        { return (src-std::floor(src) < std::ceil(src)-src ? std::floor(src) : std::ceil(src)); }
+
+        double faculty(double n)
+        {
+            if(n<0)
+                throw calcError("Invalid argument!", calcError::invalidArguments, n);
+
+            // The factorials of integers are looked up, those of larger integers aren't finite
+            if(std::floor(n) == n)
+                return n < factorialCount ? getTables().factorials[static_cast<int>(n)] : std::numeric_limits<double>::infinity();
+            // Other numbers are multiplied by the numbers one less than them as long as those are larger than 1, which
+            // only takes a few steps before the result is infinite
+            double out = 1;
+            for(; n > 1 && out != std::numeric_limits<double>::infinity(); n -= 1)
+                out *= n;
+            return out;
+        }
+
+        real ncr(long long n, long long k)
+        {
+            if(n < k || k < 0)
+                return 0;
+            if(n < binomialRows)
+                return static_cast<real>(getTables().binomials[static_cast<int>(n*(n+1)/2 + k)]);
+            return combinatorics(n, std::min(k, n - k), true);
+        }
+
+        real npr(long long n, long long k)
+        {
+            if(n < k || k < 0)
+                return 0;
+            if(n < factorialCount)
+            {
+                // n!/(n-k)! is exact as long as n! is
+                const real* factorials = getTables().factorials;
+                if(factorials[n] < 9007199254740992.0)
+                    return factorials[n] / factorials[n - k];
+            }
+            return combinatorics(n, k, false);
+        }
+
+        real lnFact(real n)
+        {
+            if(n<0)
+                throw calcError("Invalid argument!", calcError::invalidArguments, n);
+            if(std::floor(n) == n && n < factorialCount)
+                return std::log(getTables().factorials[static_cast<int>(n)]);
+            return static_cast<real>(std::lgamma(static_cast<long double>(n) + 1));
+        }
+
+        real lnCr(real n, real k)
+        {
+            // Like NCR, there are no combinations if k isn't in the range [0, n]
+            if(n != n || k != k)
+                return std::numeric_limits<real>::quiet_NaN();
+            if(k < 0 || k > n)
+                return -std::numeric_limits<real>::infinity();
+
+            // Small rows of Pascal's triangle are looked up
+            const bool integers = std::floor(n) == n && std::floor(k) == k;
+            if(integers && n < binomialRows)
+                return std::log(static_cast<real>(getTables().binomials[static_cast<int>(n*(n+1)/2 + k)]));
+
+            // The difference of the logarithms of the gamma function loses digits if only a few are chosen, then the logarithms
+            // of the factors (n-k+1)/1 * (n-k+2)/2 * ... are added instead (which works for any n as long as k is an integer)
+            const long double x = n;
+            const long double chosen = integers ? std::min(k, n - k) : k;
+            if(std::floor(chosen) == chosen && chosen <= maxLogFactors)
+            {
+                long double sum = 0;
+                for(int i = 1; i <= chosen; ++i)
+                    sum += std::log((x - chosen + i) / i);
+                return static_cast<real>(sum);
+            }
+            const long double y = k;
+            return static_cast<real>(std::lgamma(x + 1) - std::lgamma(y + 1) - std::lgamma(x - y + 1));
+        }
+
+        real average(const argList& vars)
+        {
+            if(vars.size() == 0)
+            {
+                calcError err("Too less arguments", calcError::invalidArguments, vars.size());
+                err.extraRealInfo.push_back(1);
+                throw err;
+            }
+
+            real total = 0;
+            for(real arg : vars)
+                total += arg;
+            return total / vars.size();
+        }
+
+        real random(const argList& vars)
+        {
+            // The numbers come from the generator of the environment the expression is calculated in
+            randomGenerator& generator = randomGenerator::current();
+
+            // Look at the number of arguments, using that we decide how the function  should be executed
+            switch(vars.size())
+            {
+                // No arguments, just a random number between 0 and 1
+                case 0:
+                return generator.nextReal();
+
+                // One argument, being the maximum value to be returned
+                // So return a random integer between 0 and the argument (included)
+                case 1:
+                    if(vars[0] <= 0 || vars[0] >= maxRandomRange)
+                        throw calcError("Invalid argument!", calcError::invalidArguments);
+                return static_cast<real>(generator.nextBelow(static_cast<std::uint64_t>(vars[0]) + 1));
+
+                // Two arguments, a minimum and a maximum
+                // So return a random integer between the first and the second argument (both included)
+                case 2:
+                    if(vars[0] >= vars[1] || vars[1] - vars[0] >= maxRandomRange)
+                        throw calcError("Invalid argument!", calcError::invalidArguments);
+                return static_cast<real>(generator.nextBelow(static_cast<std::uint64_t>(vars[1] - vars[0]) + 1)) + vars[0];
+
+                // More arguments means an invalid argument count
+                default:
+                {
+                    calcError err("Too many arguments", calcError::invalidArguments, vars.size());
+                    err.extraRealInfo.push_back(2);
+                    throw err;
+                }
+                break;
+            }
+        }
+
+        real ifFunction(const argList& vars)
+        {
+            // Check whether the number of arguments is right
+            if(vars.size()<2)
+            {
+                calcError err("Too less arguments", calcError::invalidArguments, vars.size());
+                err.extraRealInfo.push_back(2);
+                throw err;
+            }
+
+            // If the first argument is not 0, the second argument is returned
+            // Otherwise the third argument is returned, the third argument defaults to zero
+            if(vars[0] != 0)
+                return vars[1];
+            else
+                return (vars.size() >= 3 ? vars[2] : 0);
+        }
+    }
+}
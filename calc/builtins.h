@@ -0,0 +1,167 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "types.h"
+#include "error.h"
+#include "mathfunction.h"
+#include "nativefunction.h"
+
+namespace calc
+{
+    // The set of built-in functions and variables of the calculator (cos, sin, RAND, pi, ...)
+    // Every function is registered in both capital and non-capital form, both names refer to the same function object.
+    // The names are looked up in a perfect hash table that's computed at compile time (see builtins.cpp),
+    // and none of the functions are allocated: they're either static or part of this object.
+    class builtIns
+    {
+        public:
+            // Enum that's used to identify the type of the angles
+            enum angleType {angleDegrees, angleRadians};
+            // Enum that's used to identify the built-in functions that depend on the angle type
+            enum angleFunction {angleCos, angleAcos, angleCosh, angleSin, angleAsin, angleSinh, angleTan, angleAtan, angleTanh,
+                                angleFunctionCount};
+
+            // Constructor, creates all built-in variables
+            builtIns(const angleType& angle = angleRadians);
+
+            // Add all built-in functions and variables to the given calculator
+            void addTo(calc& calculator) const;
+            // Add all built-in functions and variables to the given context
+            void addTo(context& target) const;
+
+            // Get the built-in function with the given name, in capital or non-capital form, returns 0 if there is none
+            mathFunction* getFunction(const string& name) const;
+            // Get the C++ expression that calculates the built-in function with the given name exactly like the function does, # stands for its argument
+            // This is used to export user defined functions to C++ (see nativeexport.h), returns 0 if the function can't be exported
+            // (because it has a different number of arguments than one, depends on the angle type, isn't pure or can throw errors)
+            static const char* getNativeCode(const string& name);
+            // Get the capital name of the built-in function with the given name if function is that built-in function, returns 0 otherwise
+            // The functions that depend on the angle type are only recognized if angle isn't 0, their current angle type is written to it.
+            // This is used by the number types that calculate some of the built-in functions themselves (see numberengine.h),
+            // a function replaced by the user isn't recognized.
+            static const char* getBuiltInName(const mathFunction* function, const string& name, angleType* angle = 0);
+            // Get the list of built-in variables
+            const varList& getVars() const;
+
+            // Get or set the angle type that's used by the goniometric functions
+            // Setting it switches the goniometric functions to a version for that angle type, the function objects stay the same
+            // so calculators and contexts the functions have been added to use the new angle type right away
+            angleType getAngleType() const;
+            void setAngleType(const angleType& newType);
+
+        private:
+            // Prevent copying:
+            builtIns& operator=(const builtIns& other);
+            builtIns(const builtIns& other);
+
+            // The functions that depend on the angle type, in the order of angleFunction
+            mutable nativeMathFunction<double (*)(double)> angleFunctions[angleFunctionCount];
+            // The built-in variables
+            varList vars;
+            // The current angle type
+            angleType currAngleType;
+    };
+
+    // The BENCH(expression, runs) function, it measures how long calculating the expression takes
+    // The expression is compiled once and then calculated runs times (1000 by default) after a warm-up, in the environment BENCH is called in.
+    // The runs are split into samples and the median of the samples is returned, in nanoseconds per calculation.
+    class benchmarkMathFunction : public mathFunction
+    {
+        public:
+            // The outcome of a benchmark, all times are in nanoseconds per calculation
+            struct result
+            {
+                unsigned long long runs;            // The number of measured calculations
+                unsigned int samples;               // The number of samples the runs were split into
+                real median;                        // The median of the samples, this is what BENCH() returns
+                real minimum;                       // The fastest sample
+                real maximum;                       // The slowest sample
+            };
+
+            // Constructor
+            constexpr benchmarkMathFunction(const bool& cleanUpNeeded = false) : mathFunction(cleanUpNeeded) {}
+
+            // Throws an error, the expression has to be passed unevaluated
+            virtual real execute(const argList& vars, const string& name);
+            // Measure the expression
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true, the arguments are passed unevaluated
+            virtual bool takesExpressions() const;
+
+            // Get the outcome of the last benchmark of the current thread and forget it, returns false if there is none
+            static bool takeLastResult(result& out);
+            // Forget the outcome of the last benchmark of the current thread
+            static void forgetLastResult();
+
+        private:
+            static thread_local bool hasLastResult;     // Whether lastResult holds a benchmark that hasn't been taken yet
+            static thread_local result lastResult;      // The outcome of the last benchmark
+    };
+
+    // Some constants
+    namespace mathConstant
+    {
+        const double PI     = 3.1415926535897932385;
+        const double E      = 2.718281828459;
+        const double PHI    = 1.618033988749895;
+    }
+
+    // Some built-in functions
+    namespace mathFunctions
+    {
+        // Convert the number of degrees to radians
+        double rad(double deg);
+        // Convert the number of radians to degrees
+        double deg(double rad);
+        // Rounds the number to the nearest integer
+        double round(double src);
+        // Returns the faculty of n, in other words: n!
+        // The factorials of integers are looked up, they're the real nearest to the exact factorial
+        double faculty(double n);
+        // Returns the number of combinations of k out of n
+        // Small ones are looked up, larger ones are exact as long as they fit in 64 bits and the real nearest to them otherwise
+        real ncr(long long n, long long k);
+        // Returns the number of permutations of k out of n, as precise as ncr()
+        real npr(long long n, long long k);
+        // Returns the natural logarithm of the faculty of n, which is the logarithm of the gamma function of n+1
+        // This is finite where the faculty itself isn't, so probabilities can be calculated with logarithms
+        real lnFact(real n);
+        // Returns the natural logarithm of the number of combinations of k out of n, -inf if there are none
+        // Numbers that aren't integers use the gamma function
+        real lnCr(real n, real k);
+
+        // Returns the average of the arguments, there has to be at least one
+        real average(const argList& vars);
+
+        // Returns a random argument, drawn from the generator of the current thread (see randomGenerator::current())
+        // What numbers are possible depends on the number of arguments:
+        //  0 =>    A random number in the range [0, 1) is returned
+        //  1 =>    A random integer in the range [0, firstArgument] is returned
+        //  2 =>    A random integer in the range [firstArgument, secondArgument] is returned
+        real random(const argList& vars);
+
+        // If the first argument is not 0, the second argument is returned
+        // Otherwise the third argument is returned, the third argument defaults to zero
+        real ifFunction(const argList& vars);
+    }
+}
+
+#endif // BUILTINS_H
@@ -18,6 +18,11 @@
 
 #include "calc.h"
 #include "calc_private.h"
+#include "compiler.h"
+#include "profiler.h"
+#include "decimal.h"
+#include "rational.h"
+#include "random.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -31,11 +36,12 @@ namespace calc
     // Public:
         // Constructor
         calc::calc(const string& expr, const bool& cleanFunctionsUp)
-        : currExpr(expr), expressionParsed(false), cleanFunctionsUp(cleanFunctionsUp) {}
+        : currExpr(expr), expressionParsed(false), cleanFunctionsUp(cleanFunctionsUp), compiledExpr(0), compileAttempted(false), lastResult() {}
 
         // Destructor, cleans up the functions if told to do so
         calc::~calc()
         {
+            delete compiledExpr;
             if(cleanFunctionsUp)
             {
                 for(functionList::iterator pos = calc::currFunctions.begin(); pos != calc::currFunctions.end(); ++pos)
@@ -55,6 +61,9 @@ namespace calc
             expressionParsed = false;
             errors.clear();
             tokens.clear();
+            delete compiledExpr;
+            compiledExpr = 0;
+            compileAttempted = false;
         }
 
         string calc::getExpression() const
@@ -100,35 +109,41 @@ namespace calc
         // Functions for the functions
         bool calc::deleteFunction(const string& name)
         {
-            if(calc::currFunctions[name]->cleanUpNeeded())
-                delete calc::currFunctions[name];
-            return calc::currFunctions.erase(name) != 0;
+            functionList::iterator pos = calc::currFunctions.find(name);
+            if(pos == calc::currFunctions.end())
+                return false;
+            if(pos->second->cleanUpNeeded())
+                delete pos->second;
+            calc::currFunctions.erase(name);
+            return true;
         }
 
         void calc::setFunction(const string& name, mathFunction* function)
         {
-            if(calc::currFunctions.count(name) && calc::currFunctions[name]->cleanUpNeeded())
-                delete calc::currFunctions[name];
-            calc::currFunctions[name] = function;
+            mathFunction*& slot = calc::currFunctions[name];
+            if(slot && slot->cleanUpNeeded())
+                delete slot;
+            slot = function;
         }
         mathFunction* calc::getFunction(const string& name)
         {
-            if(calc::currFunctions.count(name))
-                return calc::currFunctions[name];
-            return 0;
+            functionList::iterator pos = calc::currFunctions.find(name);
+            return pos != calc::currFunctions.end() ? pos->second : 0;
         }
         const mathFunction* calc::getFunction(const string& name) const
         {
-            if(calc::currFunctions.count(name))
-                return calc::currFunctions[name];
-            return 0;
+            functionList::const_iterator pos = calc::currFunctions.find(name);
+            return pos != calc::currFunctions.end() ? pos->second : 0;
         }
         bool calc::renameFunction(const string& oldName, const string& newName)
         {
-            if(calc::currFunctions.count(oldName) && !calc::currFunctions.count(newName))
+            functionList::iterator pos = calc::currFunctions.find(oldName);
+            if(pos != calc::currFunctions.end() && !calc::currFunctions.count(newName))
             {
-                calc::currFunctions[newName] = calc::currFunctions[oldName];
+                // Adding the new name may move the entries, so the function is taken out first
+                mathFunction* function = pos->second;
                 calc::currFunctions.erase(oldName);
+                calc::currFunctions[newName] = function;
                 return true;
             }
             return false;
@@ -152,9 +167,14 @@ namespace calc
 
         void calc::forceParse()
         {
-            // Clear all tokens and errors
+            CALC_PHASE(phaseLex);
+
+            // Clear all tokens and errors, and forget the compiled expression
             tokens.clear();
             errors.clear();
+            delete compiledExpr;
+            compiledExpr = 0;
+            compileAttempted = false;
 
             // Initialise some variables we'll need for parsing
             Token::Type currType = Token::tokenUnknown;                         // The type of the current token
@@ -308,6 +328,7 @@ namespace calc
                 tokens.push_back(Token(currType, buffer));
 
             // Search for errors, and add them to the error vector
+            CALC_COUNT(counterTokens, tokens.size());
             searchForErrors();
 
             // Remember that we parsed the expression
@@ -327,17 +348,163 @@ namespace calc
         }
 
         real calc::calculate()
+        {
+            CALC_PHASE(phaseEvaluate);
+            try
+            {
+                // Only compiled expressions calculate integers exactly
+                lastResult.exact = false;
+
+                // Check if parsing is needed
+                if(!expressionParsed)
+                    forceParse();
+
+                // Check if any errors where found while checking for errors
+                if(errors.size())
+                    throw errors[0];
+
+                // If the expression can't be compiled, interpret it
+                if(getProgram() == 0)
+                    return interpret();
+
+                try
+                {
+                    // Execute the compiled expression on the variables and functions of the calculator
+                    calcEnvironment env;
+                    return compiledExpr->execute(env, lastResult);
+                }
+                catch(calcError&)
+                { throw; }
+                catch(std::exception& exc)
+                { throw calcError("STL error occurred", calcError::unknown, exc.what()); }
+                catch(...)
+                { throw calcError("Unknown error occurred", calcError::unknown); }
+            }
+            catch(...)
+            {
+                CALC_PHASE_FAILED();
+                throw;
+            }
+        }
+
+        bool calc::getIntegerResult(integer& out) const
+        {
+            if(lastResult.exact)
+                out = lastResult.value;
+            return lastResult.exact;
+        }
+
+        const program* calc::getProgram()
+        {
+            calcEnvironment functions;
+            return getProgram(functions);
+        }
+
+        const program* calc::getProgram(environment& functions)
         {
             // Check if parsing is needed
             if(!expressionParsed)
                 forceParse();
 
-            // Check if any errors where found while checking for errors
-            if(errors.size())
-                throw errors[0];
+            // Compile the expression only once, and only if it doesn't contain any errors
+            if(compileAttempted || errors.size())
+                return compiledExpr;
+            compileAttempted = true;
+            CALC_PHASE(phaseCompile);
 
+            // Remove all whitespaces from the tokens
+            std::vector<Token> compileTokens;
+            for(std::vector<Token>::const_iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type != Token::tokenWhitespace)
+                    compileTokens.push_back(*pos);
+            }
+
+            // Compile the tokens, if that's impossible we'll interpret them
+            compiledExpr = new program();
+            CALC_COUNT(counterAllocations, 1);
+            try
+            {
+                compiler comp(*compiledExpr, functions);
+                compiledExpr->finish(comp.compile(compileTokens));
+            }
+            catch(compiler::notCompilable&)
+            {
+                delete compiledExpr;
+                compiledExpr = 0;
+            }
+            return compiledExpr;
+        }
+
+        bool calc::compiled() const
+        { return expressionParsed && compileAttempted; }
+
+        void calc::setInstrumentation(const bool& enabled)
+        { instrumentation::setEnabled(enabled); }
+
+        const instrumentation::statistics& calc::getStatistics()
+        { return instrumentation::getStatistics(); }
+
+        void calc::resetStatistics()
+        { instrumentation::reset(); }
+
+        void calc::setRandomSeed(const unsigned long long& seed)
+        { randomGenerator::shared().setSeed(seed); }
+
+        unsigned long long calc::getRandomSeed()
+        { return randomGenerator::shared().getSeed(); }
+
+    // Private:
+        // Static:
+            varList calc::currVars = varList();
+            functionList calc::currFunctions = functionList();
+
+        bool calc::findExpressionCall(std::vector<Token>& tokens, std::vector<Token>::iterator& start, std::vector<Token>::iterator& end, std::vector<string>& expressions, environment& functions)
+        {
+            // Find the start of the call
+            for(start = tokens.begin(); start != tokens.end(); ++start)
+            {
+                if(start->type != Token::tokenFunctionStart)
+                    continue;
+                const mathFunction* function = functions.findFunction(start->str[0] == '-' ? start->str.substr(1) : start->str);
+                if(function != 0 && function->takesExpressions())
+                    break;
+            }
+            if(start == tokens.end())
+                return false;
+
+            // Join the tokens of every argument, starting after the opening bracket of the call until the bracket that closes it
+            expressions.clear();
+            string expression;
+            unsigned int bracketsOpen = 0;
+            for(end = start+2; end != tokens.end(); ++end)
+            {
+                if(end->type == Token::tokenOpenBracket)
+                    ++bracketsOpen;
+                else if(end->type == Token::tokenCloseBracket && bracketsOpen-- == 0)
+                    break;
+                else if(end->type == Token::tokenComma && bracketsOpen == 0)
+                {
+                    expressions.push_back(expression);
+                    expression.clear();
+                    continue;
+                }
+                expression += end->str;
+            }
+            if(end == tokens.end())
+                return false;
+
+            // Make sure we don't forget to add the last argument
+            if(!expression.empty() || !expressions.empty())
+                expressions.push_back(expression);
+            return true;
+        }
+
+        real calc::interpret()
+        {
             // Backup all tokens, this backup needs to be restored when this function is done
             std::vector<Token> tokensBackup = tokens;
+            CALC_COUNT(counterAllocations, 1);
 
             try
             {
@@ -350,7 +517,9 @@ namespace calc
                         ++pos;
                 }
 
-                // Execute all tokens in the proper order
+                // Execute all tokens in the proper order, the functions that get their arguments unevaluated go first
+                // since the brackets in their arguments shouldn't be calculated
+                while(calcDoExpressionFunctions());
                 while(calcDoBrackets());
                 while(calcDoFunctions());
                 while(calcDoPowers());
@@ -407,13 +576,10 @@ namespace calc
             }
         }
 
-    // Private:
-        // Static:
-            varList calc::currVars = varList();
-            functionList calc::currFunctions = functionList();
-
         void calc::searchForErrors()
         {
+            CALC_PHASE(phaseValidate);
+
             // Check if the expression was empty, if it is report an error
             if(!tokens.size())
                 errors.push_back(calcError("Empty expression", calcError::emptyExpression));
@@ -605,6 +771,32 @@ namespace calc
         catch(...)
         { throw calcError("Unknown error occurred", calcError::unknown); }
 
+        bool calc::calcDoExpressionFunctions()
+        {
+            // Find the call, if there is none this function won't need to be called any more
+            // The call is only found if the function exists, so it doesn't have to be checked
+            calcEnvironment env;
+            std::vector<Token>::iterator start, end;
+            std::vector<string> expressions;
+            if(!findExpressionCall(tokens, start, end, expressions, env))
+                return false;
+
+            // Call the function with the expressions, they're calculated on the variables and functions of the calculator
+            const bool unaryMin = (start->str[0] == '-');
+            const string name = unaryMin ? start->str.substr(1) : start->str;
+            CALC_COUNT(counterFunctionCalls, 1);
+            real result;
+            {
+                CALC_PROFILE_CALL(name);
+                result = calc::currFunctions[name]->executeExpressions(expressions, name, env);
+            }
+
+            // Replace the token at the start of the function with the result of the function and remove all tokens untill the closing bracket (inclusive)
+            *start = Token(Token::tokenRealReal, "", result * (unaryMin ? -1 : 1));
+            tokens.erase(start+1, end+1);
+            return true;
+        }
+
         bool calc::calcDoBrackets()
         {
             // Initialise some variables needed for the handling of the brackets
@@ -652,9 +844,10 @@ namespace calc
             // We don't want the temporary calculator to clean the math functions up, so we pass false as the second argument
             // After that we replace the opening bracket by the result of it and remove all tokens after it
             calc tmp("", false);
+            CALC_COUNT(counterAllocations, 1);
             tmp.expressionParsed = true;
             tmp.tokens.insert(tmp.tokens.begin(), lastOpenBracket+1, pos);
-            *lastOpenBracket = Token(Token::tokenRealReal, "", tmp.calculate() * (lastOpenBracket->str[0] == '-' ? -1 : 1));
+            *lastOpenBracket = Token(Token::tokenRealReal, "", tmp.interpret() * (lastOpenBracket->str[0] == '-' ? -1 : 1));
             tokens.erase(lastOpenBracket+1, pos+1);
 
             // It might be necessary for this function to be called again
@@ -706,6 +899,7 @@ namespace calc
             // Create a temporary calculator to calculate the arguments of the function
             // We don't want the temporary calculator to clean the math functions up, so we pass false as the second argument
             calc tmp("", false);
+            CALC_COUNT(counterAllocations, 1);
             tmp.expressionParsed = true;
             argList functionVarList;
             bracketsOpen = 0;
@@ -721,7 +915,7 @@ namespace calc
                     --bracketsOpen;
                 else if(argPos->type == Token::tokenComma && bracketsOpen == 0)
                 {
-                    functionVarList.push_back(tmp.calculate());
+                    functionVarList.push_back(tmp.interpret());
                     tmp.tokens.clear();
                     continue;
                 }
@@ -729,10 +923,18 @@ namespace calc
             }
             // Make sure we don't forget to add the last argument
             if(tmp.tokens.size())
-                functionVarList.push_back(tmp.calculate());
+                functionVarList.push_back(tmp.interpret());
+
+            // Call the function, the name is overwritten by the result so the call is measured in a scope of its own
+            CALC_COUNT(counterFunctionCalls, 1);
+            real result;
+            {
+                CALC_PROFILE_CALL(functionStart->str);
+                result = calc::currFunctions[functionStart->str]->execute(functionVarList, functionStart->str);
+            }
 
             // Replace the token at the start of the function with the result of the function and remove all tokens untill the closing bracket (inclusive)
-            *functionStart = Token(Token::tokenRealReal, "", calc::currFunctions[functionStart->str]->execute(functionVarList, functionStart->str) * (unaryMin ? -1 : 1) );
+            *functionStart = Token(Token::tokenRealReal, "", result * (unaryMin ? -1 : 1) );
             tokens.erase(functionStart+1, pos+1);
 
             // It might be necessary to call this function again
@@ -925,15 +1127,35 @@ namespace calc
             return false;
         }
 
+    // calcEnvironment:
+        real* calcEnvironment::findVar(const string& name)
+        {
+            varList::iterator pos = calc::currVars.find(name);
+            return pos != calc::currVars.end() ? &pos->second : 0;
+        }
+
+        real* calcEnvironment::createVar(const string& name)
+        { return &calc::currVars[name]; }
+
+        mathFunction* calcEnvironment::findFunction(const string& name)
+        {
+            functionList::iterator pos = calc::currFunctions.find(name);
+            return pos != calc::currFunctions.end() ? pos->second : 0;
+        }
+
 // Functions:
     real str2real(const string& str, const bool& throwError)
+    { return str2number<real>(str, throwError); }
+
+    template <typename Number>
+    Number str2number(const string& str, const bool& throwError)
     {
-        // Determine the type of the real and parse it
+        // Determine the type of the number and parse it
         if(str.find("0x") == (str[0]=='-'))
-            return calcPrivate::hexStr2real(str, throwError);
+            return calcPrivate::hexStr2number<Number>(str, throwError);
         if(str.find('0') == (str[0]=='-') && str[str.find('0')+1]!='.')
-            return calcPrivate::octStr2real(str, throwError);
-        return calcPrivate::decStr2real(str, throwError);
+            return calcPrivate::octStr2number<Number>(str, throwError);
+        return calcPrivate::decStr2number<Number>(str, throwError);
     }
 
     real timestr2real(const string& str, const bool& throwError)
@@ -947,12 +1169,12 @@ namespace calc
         size_t pos = string::npos;                                              // The current position where a ':' is found
         while((pos=str.find(':', prevPos)) != string::npos)
         {
-            splittedString.push_back(calcPrivate::decStr2real(str.substr(prevPos, pos-prevPos), throwError));
+            splittedString.push_back(calcPrivate::decStr2number<real>(str.substr(prevPos, pos-prevPos), throwError));
             prevPos = pos+1;
         }
         // Make sure we don't miss the last real in the string
         if(prevPos < str.size())
-            splittedString.push_back(calcPrivate::decStr2real(str.substr(prevPos), throwError));
+            splittedString.push_back(calcPrivate::decStr2number<real>(str.substr(prevPos), throwError));
 
         // There can't be more than 3 reals (i.e. hours, minutes and seconds), if there are more than 3 something's wrong
         if(splittedString.size() > 3)
@@ -974,21 +1196,140 @@ namespace calc
         return out;
     }
 
+    bool str2integer(const string& str, integer& out)
+    {
+        // Determine the base like str2real() does, an octal number starts with a 0 (which is just a digit)
+        const bool negative = !str.empty() && str[0]=='-';
+        size_t pos = negative ? 1 : 0;
+        unsigned int base = 10;
+        if(str.compare(pos, 2, "0x") == 0)
+        {
+            base = 16;
+            pos += 2;
+        }
+        else if(pos < str.size() && str[pos]=='0')
+            base = 8;
+        if(pos == str.size())
+            return false;
+
+        // Add the digits one by one, the magnitude of a negative integer may be one larger than that of a positive one
+        typedef unsigned long long int magnitude;
+        const magnitude largest = static_cast<magnitude>(std::numeric_limits<integer>::max()) + (negative ? 1 : 0);
+        magnitude value = 0;
+        for(; pos < str.size(); ++pos)
+        {
+            unsigned int digit;
+            if(str[pos]>='0' && str[pos]<='9')
+                digit = str[pos]-'0';
+            else if(str[pos]>='a' && str[pos]<='f')
+                digit = str[pos]-'a'+10;
+            else if(str[pos]>='A' && str[pos]<='F')
+                digit = str[pos]-'A'+10;
+            else
+                return false;
+            if(digit >= base || value > (largest - digit) / base)
+                return false;
+            value = value * base + digit;
+        }
+        out = negative ? static_cast<integer>(0 - value) : static_cast<integer>(value);
+        return true;
+    }
+
     string real2str(const real& val, const realOutputType& outputType, const int& precision)
+    { return number2str<real>(val, outputType, precision); }
+
+    string real2str(const decimal& val, const realOutputType& outputType, const int& precision)
+    {
+        CALC_PHASE(phaseFormat);
+        try
+        { return val.toString(outputType, precision); }
+        catch(...)
+        {
+            CALC_PHASE_FAILED();
+            throw;
+        }
+    }
+
+    string real2str(const rational& val, const realOutputType& outputType, const int& precision)
+    {
+        CALC_PHASE(phaseFormat);
+        try
+        { return val.toString(outputType, precision); }
+        catch(...)
+        {
+            CALC_PHASE_FAILED();
+            throw;
+        }
+    }
+
+    template <typename Number>
+    string number2str(const Number& val, const realOutputType& outputType, const int& precision)
     {
-        // Determine the desired output type and call the right function
+        CALC_PHASE(phaseFormat);
+        try
+        {
+            // Determine the desired output type and call the right function
+            switch(outputType)
+            {
+                case outputType_time:
+                return calcPrivate::number2timeStr(val);
+                case outputType_bin:
+                return calcPrivate::number2binStr(val);
+                case outputType_oct:
+                return calcPrivate::number2octStr(val);
+                case outputType_hex:
+                return calcPrivate::number2hexStr(val);
+                default:
+                return calcPrivate::number2decStr(val, outputType, precision < 0 ? std::numeric_limits<Number>::digits10 : precision);
+            }
+        }
+        catch(...)
+        {
+            CALC_PHASE_FAILED();
+            throw;
+        }
+    }
+
+    string integer2str(const integer& val, const realOutputType& outputType, const int& precision)
+    {
+        // Only numbers in a base are written exactly
+        if(outputType != outputType_bin && outputType != outputType_oct && outputType != outputType_dec && outputType != outputType_hex)
+            return real2str(static_cast<real>(val), outputType, precision);
+        CALC_PHASE(phaseFormat);
+
+        // Write the magnitude in the right base, with a - in front of it if the integer is negative (like real2str() does)
+        const unsigned long long int magnitude = val < 0 ? 0 - static_cast<unsigned long long int>(val) : static_cast<unsigned long long int>(val);
+        std::ostringstream outstream;
+        if(val < 0)
+            outstream<<'-';
         switch(outputType)
         {
-            case outputType_time:
-            return calcPrivate::real2timeStr(val);
             case outputType_bin:
-            return calcPrivate::real2binStr(val);
+            {
+                string bits;
+                for(unsigned long long int rest = magnitude; rest != 0; rest /= 2)
+                    bits.insert(bits.begin(), static_cast<char>(rest % 2 + '0'));
+                outstream<<(bits.empty() ? "0" : bits);
+            }
+            break;
             case outputType_oct:
-            return calcPrivate::real2octStr(val);
+                outstream<<'0'<<std::oct<<magnitude;
+            break;
             case outputType_hex:
-            return calcPrivate::real2hexStr(val);
+                outstream<<"0x"<<std::hex<<magnitude;
+            break;
             default:
-            return calcPrivate::real2decStr(val, outputType, precision < 0 ? std::numeric_limits<real>::digits10 : precision);
+                outstream<<magnitude;
+            break;
         }
+        return outstream.str();
     }
+
+    // The number types of the engine, see numberengine.h
+    template real str2number<real>(const string& str, const bool& throwError);
+    template float str2number<float>(const string& str, const bool& throwError);
+    template long double str2number<long double>(const string& str, const bool& throwError);
+    template string number2str<real>(const real& val, const realOutputType& outputType, const int& precision);
+    template string number2str<float>(const float& val, const realOutputType& outputType, const int& precision);
+    template string number2str<long double>(const long double& val, const realOutputType& outputType, const int& precision);
 }
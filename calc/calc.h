@@ -28,6 +28,8 @@
 #include "error.h"
 #include "settinghandler.h"
 #include "mathfunction.h"
+#include "program.h"
+#include "instrumentation.h"
 
 namespace calc
 {
@@ -96,8 +98,39 @@ namespace calc
             // Set the current expression to newExpr and calculate the expression, this function will also parse the expression
             // Returns the result of the expression, if an error occurs while parsing or calculating an error is thrown
             real calculate(const string& newExpr);
+            // Get the result of the last calculation as an integer, returns false if it isn't an integer that's known exactly
+            // Integer arithmetic and the bitwise operators are calculated with integers in compiled expressions (see program::exactInteger),
+            // so their results are exact even if they're too large to be represented exactly by a real
+            bool getIntegerResult(integer& out) const;
+
+            // Get the compiled form of the current expression, this function will parse and compile the expression if needed
+            // Returns 0 if the expression contains errors or can't be compiled, calculate() interprets the expression in that case
+            const program* getProgram();
+            // Get the compiled form of the current expression like getProgram(), but the functions that get their arguments unevaluated
+            // are looked up in the given environment instead of the functions of the calculator
+            // The expression is only compiled once, by whichever of both is called first.
+            const program* getProgram(environment& functions);
+            // Whether the current expression has already been compiled (or found impossible to compile), so calculate() won't parse or compile it again
+            bool compiled() const;
+
+            // Enable or disable measuring the engine in the current thread, see instrumentation.h
+            static void setInstrumentation(const bool& enabled);
+            // Get the time spent in every phase and the counters of the current thread, since the last reset
+            static const instrumentation::statistics& getStatistics();
+            // Set the time spent in every phase and the counters of the current thread to 0
+            static void resetStatistics();
+
+            // Set the seed of the random numbers of RAND, which are shared by all instances like the variables
+            // The same seed gives the same numbers, without a seed they're different every time the program runs.
+            static void setRandomSeed(const unsigned long long& seed);
+            // Get the seed of the random numbers of RAND
+            static unsigned long long getRandomSeed();
 
         private:
+            // The compiler and environment need to access the tokens and the lists of variables and functions
+            friend class compiler;
+            friend class calcEnvironment;
+
             // Static:
                 // The list of all variables
                 static varList currVars;
@@ -127,7 +160,7 @@ namespace calc
                 Type type;
                 // A string containing some extra information about the token (for example: which operator it is)
                 string str;
-                // The value of a tokenRealReal
+                // The value of a tokenRealReal, while compiling this is the register holding the value
                 real val;
 
                 // Constructors to initialise all variables of the token
@@ -139,6 +172,7 @@ namespace calc
 
             // Calculator functions, these do the actual calculating
             // Every function returns true if it needs to be called another time and false when it's done
+                bool calcDoExpressionFunctions();
                 bool calcDoBrackets();
                 bool calcDoFunctions();
                 bool calcDoPowers();
@@ -155,6 +189,14 @@ namespace calc
             // Function to search for any errors, this is called after parsing
             void searchForErrors();
 
+            // Find the first call of a function that gets its arguments unevaluated (see mathFunction::takesExpressions()), the functions
+            // are looked up in the given environment. Start is set to its tokenFunctionStart, end to its closing bracket and the arguments
+            // are written back into expressions. Returns false if there is no such call
+            static bool findExpressionCall(std::vector<Token>& tokens, std::vector<Token>::iterator& start, std::vector<Token>::iterator& end, std::vector<string>& expressions, environment& functions);
+
+            // Calculate the tokens by executing all operations on them, this is used if the expression can't be compiled
+            real interpret();
+
             // Check whether the character is an operator
             bool isOperator(const char& chr) const;
             // Check whether the character can be part of a real value, firstStrPart should be the real as a string for as far as it's known
@@ -178,6 +220,21 @@ namespace calc
             std::vector<Token> tokens;
             // Whether the functions should be cleaned up or not in the destructor
             bool cleanFunctionsUp;
+            // The compiled expression, 0 if it isn't compiled (yet)
+            program* compiledExpr;
+            // Whether we tried to compile the current expression
+            bool compileAttempted;
+            // The result of the last calculation as an integer, see getIntegerResult()
+            program::exactInteger lastResult;
+    };
+
+    // The environment formed by the variables and functions of the calculator, which are shared by all instances of calc
+    class calcEnvironment : public environment
+    {
+        public:
+            real* findVar(const string& name);
+            real* createVar(const string& name);
+            mathFunction* findFunction(const string& name);
     };
 
     // Functions:
@@ -186,9 +243,28 @@ namespace calc
         // Converts the given string (str) containing a time (e.g. 2:31:12) to a real holding the number of seconds
         // If throwError is true this function will throw an error if something goes wrong
         real timestr2real(const string& str, const bool& throwError = false);
+        // Converts the given string (str) to an integer exactly, like str2real() does for reals
+        // Returns false if the string isn't an integer (e.g. it has a fractional part) or if the integer doesn't fit
+        bool str2integer(const string& str, integer& out);
         // Converts the given real (val) to a string, using the given format (outputType) and precision
         // If the precision is a negative number std::numeric_limits<real>::digits10 will be used
         string real2str(const real& val, const realOutputType& outputType = outputType_auto, const int& precision = -1);
+        // Converts the given decimal (val) to a string like real2str(), the binary, octal and hexadecimal types are written exactly
+        // If the precision is a negative number all digits of the precision of val will be used
+        string real2str(const decimal& val, const realOutputType& outputType = outputType_auto, const int& precision = -1);
+        // Converts the given rational (val) to a string like real2str(), exact numbers are written as a fraction by outputType_auto
+        // If the precision is a negative number std::numeric_limits<real>::digits10 will be used for the decimals of a fraction
+        string real2str(const rational& val, const realOutputType& outputType = outputType_auto, const int& precision = -1);
+        // Converts the given integer (val) to a string, the binary, octal, decimal and hexadecimal types are written exactly
+        // The other types are written like real2str() does
+        string integer2str(const integer& val, const realOutputType& outputType = outputType_auto, const int& precision = -1);
+
+        // The same conversions for the other number types of the engine (see numberengine.h), they're instantiated for real, float and long double
+        // Converts the given string (str) to a number, like str2real()
+        template <typename Number> Number str2number(const string& str, const bool& throwError = false);
+        // Converts the given number (val) to a string, like real2str()
+        // If the precision is a negative number std::numeric_limits<Number>::digits10 will be used
+        template <typename Number> string number2str(const Number& val, const realOutputType& outputType = outputType_auto, const int& precision = -1);
 }
 
 #endif // CALC_H
@@ -0,0 +1,72 @@
+# -------------------------------------------------
+# The calculator engine, shared by all targets
+# This file only depends on the standard library, so it can be used by targets without Qt as well
+# -------------------------------------------------
+CONFIG += c++11
+
+INCLUDEPATH += $$PWD/..
+
+# Build with "qmake CONFIG+=calc_no_instrumentation" to remove the timers and counters of instrumentation.h and the profiler of profiler.h
+calc_no_instrumentation: DEFINES += CALC_NO_INSTRUMENTATION
+# Build with "qmake CONFIG+=calc_no_jit" to never compile expressions to native code (see jit.h)
+calc_no_jit: DEFINES += CALC_NO_JIT
+
+# Plugins are loaded with dlopen() (see pluginloader.h)
+unix: LIBS += -ldl
+# Monte Carlo simulations and samples of functions are calculated by several threads (see montecarlo.h and sampler.h)
+CONFIG += thread
+
+SOURCES += $$PWD/calc.cpp \
+    $$PWD/settinghandler.cpp \
+    $$PWD/mathfunction.cpp \
+    $$PWD/calc_private.cpp \
+    $$PWD/compiler.cpp \
+    $$PWD/context.cpp \
+    $$PWD/instrumentation.cpp \
+    $$PWD/profiler.cpp \
+    $$PWD/pluginloader.cpp \
+    $$PWD/nativeexport.cpp \
+    $$PWD/program.cpp \
+    $$PWD/jit.cpp \
+    $$PWD/numberengine.cpp \
+    $$PWD/decimal.cpp \
+    $$PWD/rational.cpp \
+    $$PWD/random.cpp \
+    $$PWD/statistics.cpp \
+    $$PWD/montecarlo.cpp \
+    $$PWD/sampler.cpp \
+    $$PWD/solver.cpp \
+    $$PWD/gradient.cpp \
+    $$PWD/series.cpp \
+    $$PWD/quadrature.cpp \
+    $$PWD/builtins.cpp
+HEADERS += $$PWD/calc_private.h \
+    $$PWD/calc.h \
+    $$PWD/settinghandler.h \
+    $$PWD/types.h \
+    $$PWD/mathfunction.h \
+    $$PWD/nativefunction.h \
+    $$PWD/error.h \
+    $$PWD/compiler.h \
+    $$PWD/context.h \
+    $$PWD/instrumentation.h \
+    $$PWD/profiler.h \
+    $$PWD/plugin.h \
+    $$PWD/pluginloader.h \
+    $$PWD/nativeexport.h \
+    $$PWD/program.h \
+    $$PWD/jit.h \
+    $$PWD/numberengine.h \
+    $$PWD/decimal.h \
+    $$PWD/rational.h \
+    $$PWD/dual.h \
+    $$PWD/random.h \
+    $$PWD/statistics.h \
+    $$PWD/montecarlo.h \
+    $$PWD/sampler.h \
+    $$PWD/solver.h \
+    $$PWD/gradient.h \
+    $$PWD/series.h \
+    $$PWD/quadrature.h \
+    $$PWD/symboltable.h \
+    $$PWD/builtins.h
@@ -27,9 +27,10 @@ namespace calc
 {
     namespace calcPrivate
     {
-        real binStr2real(const string& str, const bool& throwError)
+        template <typename Number>
+        Number binStr2number(const string& str, const bool& throwError)
         {
-            real out = 0;                           // The result is stored in this variable
+            Number out = 0;                           // The result is stored in this variable
             unsigned short counter = 0;             // Counts the number of 1's and 0's that are parsed
 
             // Iterate through the string, from back to forth
@@ -38,7 +39,7 @@ namespace calc
                 // In case of a 1 or 0, we add it to out
                 // Otherwise, throw an error
                 if(*pos=='0' || *pos=='1')
-                    out += (*pos-'0') * std::pow(2, counter++);
+                    out += (*pos-'0') * std::pow(static_cast<Number>(2), counter++);
                 else if(throwError && *pos!='-')
                     throw calcError("Unknown token", calcError::unknownToken, *pos);
             }
@@ -51,9 +52,10 @@ namespace calc
             return out;
         }
 
-        real octStr2real(const string& str, const bool& throwError)
+        template <typename Number>
+        Number octStr2number(const string& str, const bool& throwError)
         {
-            real out = 0;                           // The result is stored in this variable
+            Number out = 0;                           // The result is stored in this variable
             unsigned short counter = 0;             // Counts the number of read ciphers
 
             // Iterate through the string, from back to forth
@@ -62,7 +64,7 @@ namespace calc
                 // If the current character is a octal cipher, we add it to out
                 // Otherwise, throw an error
                 if(*pos>='0' && *pos<='7')
-                    out += (*pos-'0') * pow(8, counter++);
+                    out += (*pos-'0') * std::pow(static_cast<Number>(8), counter++);
                 else if(throwError && *pos!='-')
                     throw calcError("Unknown token", calcError::unknownToken, *pos);
             }
@@ -75,12 +77,13 @@ namespace calc
             return out;
         }
 
-        real decStr2real(const string& str, const bool& throwError)
+        template <typename Number>
+        Number decStr2number(const string& str, const bool& throwError)
         {
-            real out = 0;                           // The result is stored in this variable
+            Number out = 0;                           // The result is stored in this variable
             bool dotEncounterd = false;             // Whether or not we've already encountered a dot (.)
             unsigned short counter = 0;             // Counts the number of read ciphers
-            real eValue = 0;                        // The value behind the E or e is stored in this variable (in case scientific notation is used: 1.23e45)
+            Number eValue = 0;                        // The value behind the E or e is stored in this variable (in case scientific notation is used: 1.23e45)
             bool negative = false;                  // Whether the value should be negative or not
 
             // Iterate through the string, from back to forth
@@ -88,7 +91,7 @@ namespace calc
             {
                 // If the current character is a decimal cipher, we add it to out
                 if(*pos>='0' && *pos<='9')
-                    out += (*pos-'0') * pow(10, counter++);
+                    out += (*pos-'0') * std::pow(static_cast<Number>(10), counter++);
                 // If the current character is a dot and we didn't encounter one yet
                 // We divide out by 10^counter, reset the counter and remember that we've encountered a dot
                 // If we had already encountered a dot, we'll just throw an error
@@ -96,7 +99,7 @@ namespace calc
                 {
                     if(!dotEncounterd)
                     {
-                        out /= pow(10, counter);
+                        out /= std::pow(static_cast<Number>(10), counter);
                         counter = 0;
                         dotEncounterd = true;
                         continue;
@@ -120,7 +123,7 @@ namespace calc
             }
 
             // Mulitply out by 10^eValue to apply the scientific notation
-            out *= pow(10, eValue);
+            out *= std::pow(static_cast<Number>(10), eValue);
 
             // If the value should be negative, make it negative
             if(negative)
@@ -130,9 +133,10 @@ namespace calc
             return out;
         }
 
-        real hexStr2real(const string& str, const bool& throwError)
+        template <typename Number>
+        Number hexStr2number(const string& str, const bool& throwError)
         {
-            real out = 0;                           // The result is stored in this variable
+            Number out = 0;                           // The result is stored in this variable
             unsigned short counter = 0;             // Counts the number of read ciphers
 
             // Iterate through the string, from back to forth
@@ -140,11 +144,11 @@ namespace calc
             {
                 // If the current character is a hexadecimal cipher, we add it to out
                 if(*pos>='0' && *pos<='9')
-                    out+=(*pos-'0')*pow(16, counter++);
+                    out+=(*pos-'0')*std::pow(static_cast<Number>(16), counter++);
                 else if(*pos>='a' && *pos<='f')
-                    out+=(*pos-'a'+10)*pow(16, counter++);
+                    out+=(*pos-'a'+10)*std::pow(static_cast<Number>(16), counter++);
                 else if(*pos>='A' && *pos<='F')
-                    out+=(*pos-'A'+10)*pow(16, counter++);
+                    out+=(*pos-'A'+10)*std::pow(static_cast<Number>(16), counter++);
                 // Any other character (-, x and X excluded) doesn't belong there
                 else if(throwError && *pos!='-' && *pos!='x' && *pos!='X')
                     throw calcError("Unknown token", calcError::unknownToken, *pos);
@@ -158,7 +162,8 @@ namespace calc
             return out;
         }
 
-        string real2timeStr(real val)
+        template <typename Number>
+        string number2timeStr(Number val)
         {
             // This string is going to contain the output
             string out;
@@ -175,7 +180,7 @@ namespace calc
             {
                 // If i is 0, x will be just the same as val
                 // If not it will be val / 60^i, rounded down
-                const real x = ( i==0 ? val : std::floor(val/std::pow(60, i)) );
+                const Number x = ( i==0 ? val : std::floor(val/std::pow(static_cast<Number>(60), i)) );
 
                 // If x is smaller than 10, add a 0 to the string
                 // to make make sure every part in the time-string is 2 digits (e.g. 02:05:15 and not 2:5:15)
@@ -183,23 +188,25 @@ namespace calc
                     out+='0';
                 // If i is 0, we also want to show some numbers behind the dot (milliseconds)
                 if(i==0)
-                    out+=real2decStr(x, outputType_dec, 3);
+                    out+=number2decStr(x, outputType_dec, 3);
                 // Otherwise just add x to the string and add a :
                 else
-                    out+=real2decStr(x, outputType_dec, 0)+':';
+                    out+=number2decStr(x, outputType_dec, 0)+':';
 
                 // Subtract x*60^i from val, this is the part of val we just added to the string
-                val -= x*std::pow(60, i);
+                val -= x*std::pow(static_cast<Number>(60), i);
             }
 
             // Return the result
             return out;
         }
 
-        string real2binStr(const real& val)
+        template <typename Number>
+        string number2binStr(const Number& val)
         {
             // If the value is too big to convert, throw an error
-            if(val > std::numeric_limits<unsigned long int>::max())
+            // The largest unsigned long rounds up to the next power of 2 as a Number, which is the first magnitude that doesn't fit
+            if(!((val < 0 ? -val : val) < static_cast<Number>(std::numeric_limits<unsigned long int>::max()) + 1))
                 throw overflowError(overflowError::bin);
 
             // If the value is 0, return "0"
@@ -221,10 +228,12 @@ namespace calc
             return (val<0 ? "-" : "")+out;
         }
 
-        string real2octStr(const real& val)
+        template <typename Number>
+        string number2octStr(const Number& val)
         {
             // If the value is too big to convert, throw an error
-            if(val>std::numeric_limits<unsigned long int>::max())
+            // The largest unsigned long rounds up to the next power of 2 as a Number, which is the first magnitude that doesn't fit
+            if(!((val < 0 ? -val : val) < static_cast<Number>(std::numeric_limits<unsigned long int>::max()) + 1))
                 throw overflowError(overflowError::oct);
 
             // Round the value to the nearest integer, and if it's negative make it positive
@@ -240,7 +249,8 @@ namespace calc
             return outstream.str();
         }
 
-        string real2decStr(const real& val, const realOutputType& outputType, const int& precision)
+        template <typename Number>
+        string number2decStr(const Number& val, const realOutputType& outputType, const int& precision)
         {
             // Create a std::ostringstream and set some flags to make sure the string is outputted in the way we want it to be
             // Then create a string from the stream, containing the number
@@ -310,10 +320,12 @@ namespace calc
                 return out.substr(0, zeroFromPos);
         }
 
-        string real2hexStr(const real& val)
+        template <typename Number>
+        string number2hexStr(const Number& val)
         {
             // If the value is too big to convert, throw an error
-            if(val>std::numeric_limits<unsigned long int>::max())
+            // The largest unsigned long rounds up to the next power of 2 as a Number, which is the first magnitude that doesn't fit
+            if(!((val < 0 ? -val : val) < static_cast<Number>(std::numeric_limits<unsigned long int>::max()) + 1))
                 throw overflowError(overflowError::hex);
 
             // Round the value to the nearest integer, and if it's negative make it positive
@@ -328,5 +340,21 @@ namespace calc
             outstream<<"0x"<<std::hex<<intVal;
             return outstream.str();
         }
+
+        // Instantiate the conversions for every number type of the engine
+#define CALC_INSTANTIATE_CONVERSIONS(Number) \
+        template Number binStr2number<Number>(const string& str, const bool& throwError); \
+        template Number octStr2number<Number>(const string& str, const bool& throwError); \
+        template Number decStr2number<Number>(const string& str, const bool& throwError); \
+        template Number hexStr2number<Number>(const string& str, const bool& throwError); \
+        template string number2binStr<Number>(const Number& val); \
+        template string number2octStr<Number>(const Number& val); \
+        template string number2decStr<Number>(const Number& val, const realOutputType& outputType, const int& precision); \
+        template string number2hexStr<Number>(const Number& val); \
+        template string number2timeStr<Number>(Number val);
+        CALC_INSTANTIATE_CONVERSIONS(real)
+        CALC_INSTANTIATE_CONVERSIONS(float)
+        CALC_INSTANTIATE_CONVERSIONS(long double)
+#undef CALC_INSTANTIATE_CONVERSIONS
     }
 }
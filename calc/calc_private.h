@@ -34,25 +34,27 @@ namespace calc
         inline bool isNameChar(const char& chr, const bool& firstChar)
         { return (chr=='_') || (firstChar ? std::isalpha(chr) : std::isalnum(chr)); }
 
-        // Converts a string containing a binary number to a real
-        real binStr2real(const string& str, const bool& throwError = false);
-        // Converts a string containing an octal number to a real
-        real octStr2real(const string& str, const bool& throwError = false);
-        // Converts a string containing a decimal number to a real
-        real decStr2real(const string& str, const bool& throwError = false);
-        // Converts a string containing a hexadecimal number to a real
-        real hexStr2real(const string& str, const bool& throwError = false);
-
-        // Converts a real to a string containing the binary number
-        string real2binStr(const real& val);
-        // Converts a real to a string containing the octal number
-        string real2octStr(const real& val);
-        // Converts a real to a string containing the decimal number
-        string real2decStr(const real& val, const realOutputType& outputType, const int& precision);
-        // Converts a real to a string containing the hexadecimal number
-        string real2hexStr(const real& val);
-        // Converts a real to a string containing it's value in time (1 is 1 sec)
-        string real2timeStr(real val);
+        // The conversions are templates on the number type, they're instantiated for real, float and long double (see numberengine.h)
+
+        // Converts a string containing a binary number to a number
+        template <typename Number> Number binStr2number(const string& str, const bool& throwError = false);
+        // Converts a string containing an octal number to a number
+        template <typename Number> Number octStr2number(const string& str, const bool& throwError = false);
+        // Converts a string containing a decimal number to a number
+        template <typename Number> Number decStr2number(const string& str, const bool& throwError = false);
+        // Converts a string containing a hexadecimal number to a number
+        template <typename Number> Number hexStr2number(const string& str, const bool& throwError = false);
+
+        // Converts a number to a string containing the binary number
+        template <typename Number> string number2binStr(const Number& val);
+        // Converts a number to a string containing the octal number
+        template <typename Number> string number2octStr(const Number& val);
+        // Converts a number to a string containing the decimal number
+        template <typename Number> string number2decStr(const Number& val, const realOutputType& outputType, const int& precision);
+        // Converts a number to a string containing the hexadecimal number
+        template <typename Number> string number2hexStr(const Number& val);
+        // Converts a number to a string containing it's value in time (1 is 1 sec)
+        template <typename Number> string number2timeStr(Number val);
     }
 }
 
@@ -0,0 +1,399 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "compiler.h"
+
+namespace calc
+{
+    // Public:
+        compiler::compiler(program& out, environment& functions)
+        : out(out), functions(functions) {}
+
+        unsigned int compiler::compile(std::vector<calc::Token> tokens)
+        {
+            // Compile all tokens in the same order as calc::calculate() executes them
+            while(compileExpressionFunctions(tokens));
+            while(compileBrackets(tokens));
+            while(compileFunctions(tokens));
+            while(compilePowers(tokens));
+            while(compileMultiply(tokens));
+            while(compilePlusmin(tokens));
+            while(compileCompare(tokens));
+            while(compileBitwise(tokens));
+            while(compileAssignments(tokens));
+
+            // An empty expression (e.g. "()") results in an error, let the interpreter report it
+            if(!tokens.size())
+                throw notCompilable();
+
+            // The remaining token holds the result
+            return value(tokens[0]);
+        }
+
+    // Private:
+        bool compiler::compileExpressionFunctions(std::vector<calc::Token>& tokens)
+        {
+            // Find the call exactly like calc::calcDoExpressionFunctions() does
+            std::vector<calc::Token>::iterator start, end;
+            std::vector<string> expressions;
+            if(!calc::findExpressionCall(tokens, start, end, expressions, functions))
+                return false;
+
+            // The existence of the function is checked first, then it's called with the expressions
+            const bool unaryMin = (start->str[0] == '-');
+            const unsigned int slot = out.functionSlot(unaryMin ? start->str.substr(1) : start->str);
+            out.emit(program::opCheckFunction, 0, slot);
+            unsigned int reg = out.newRegister();
+            out.emit(program::opCallExpressions, reg, slot, out.addExpressions(expressions));
+            if(unaryMin)
+            {
+                const unsigned int negated = out.newRegister();
+                out.emit(program::opNegate, negated, reg);
+                reg = negated;
+            }
+
+            // Replace the call by the register holding its value
+            *start = registerToken(reg);
+            tokens.erase(start+1, end+1);
+            return true;
+        }
+
+        bool compiler::compileBrackets(std::vector<calc::Token>& tokens)
+        {
+            // Find the bracket pair exactly like calc::calcDoBrackets() does
+            unsigned int bracketsOpen = 0;
+            bool functionOpen = false;
+            std::vector<calc::Token>::iterator pos = tokens.begin();
+            std::vector<calc::Token>::iterator lastOpenBracket = tokens.end();
+            std::vector<calc::Token>::const_iterator lastToken = tokens.end();
+            for(; pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOpenBracket)
+                {
+                    if(bracketsOpen == 0 && lastToken != tokens.end() && lastToken->type == calc::Token::tokenFunctionStart)
+                        functionOpen = true;
+                    else if(bracketsOpen++ == 0)
+                    {
+                        lastOpenBracket = pos;
+                        functionOpen = false;
+                    }
+                    lastToken = pos;
+                    continue;
+                }
+                if(!functionOpen && pos->type == calc::Token::tokenCloseBracket)
+                {
+                    lastToken = pos;
+                    if(--bracketsOpen == 0)
+                        break;
+                }
+                lastToken = pos;
+            }
+
+            // If we didn't find any opening brackets there is no need to call this function any more
+            if(lastOpenBracket == tokens.end())
+                return false;
+
+            // Compile the tokens between the brackets, negating the result if the bracket was preceded by an unary minus
+            unsigned int reg = compile(std::vector<calc::Token>(lastOpenBracket+1, pos));
+            if(lastOpenBracket->str[0] == '-')
+            {
+                const unsigned int negated = out.newRegister();
+                out.emit(program::opNegate, negated, reg);
+                reg = negated;
+            }
+
+            // Replace the brackets by the register holding their value
+            *lastOpenBracket = registerToken(reg);
+            tokens.erase(lastOpenBracket+1, pos+1);
+            return true;
+        }
+
+        bool compiler::compileFunctions(std::vector<calc::Token>& tokens)
+        {
+            // Find the function exactly like calc::calcDoFunctions() does
+            unsigned int bracketsOpen = 0;
+            std::vector<calc::Token>::iterator pos = tokens.begin();
+            std::vector<calc::Token>::iterator functionStart = tokens.end();
+            for(; pos!=tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenFunctionStart && functionStart == tokens.end())
+                {
+                    functionStart = pos++;
+                    ++bracketsOpen;
+                    continue;
+                }
+                else if(pos->type == calc::Token::tokenOpenBracket)
+                    ++bracketsOpen;
+                else if(pos->type == calc::Token::tokenCloseBracket && --bracketsOpen == 0)
+                    break;
+            }
+
+            // If no function is found, this function won't need to be called any more
+            if(functionStart == tokens.end())
+                return false;
+
+            // The existence of the function is checked before any of the arguments is calculated
+            const bool unaryMin = (functionStart->str[0] == '-');
+            const unsigned int slot = out.functionSlot(unaryMin ? functionStart->str.substr(1) : functionStart->str);
+            out.emit(program::opCheckFunction, 0, slot);
+
+            // Compile the arguments from left to right
+            std::vector<unsigned int> args;
+            std::vector<calc::Token> argTokens;
+            bracketsOpen = 0;
+            for(std::vector<calc::Token>::const_iterator argPos = functionStart+2; argPos != pos; ++argPos)
+            {
+                if(argPos->type == calc::Token::tokenOpenBracket)
+                    ++bracketsOpen;
+                else if(argPos->type == calc::Token::tokenCloseBracket)
+                    --bracketsOpen;
+                else if(argPos->type == calc::Token::tokenComma && bracketsOpen == 0)
+                {
+                    args.push_back(compile(argTokens));
+                    argTokens.clear();
+                    continue;
+                }
+                argTokens.push_back(*argPos);
+            }
+            if(argTokens.size())
+                args.push_back(compile(argTokens));
+
+            // Call the function, negating the result if the function was preceded by an unary minus
+            unsigned int reg = out.newRegister();
+            out.emit(program::opCall, reg, slot, args.size(), out.addArguments(args));
+            if(unaryMin)
+            {
+                const unsigned int negated = out.newRegister();
+                out.emit(program::opNegate, negated, reg);
+                reg = negated;
+            }
+
+            // Replace the function by the register holding its value
+            *functionStart = registerToken(reg);
+            tokens.erase(functionStart+1, pos+1);
+            return true;
+        }
+
+        bool compiler::compilePowers(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOperator && (pos->str=="^" || pos->str=="~"))
+                {
+                    // The first operand is read first, the checks on the operands are done by the instruction itself
+                    const unsigned int first = value(*(pos-1));
+                    const unsigned int second = value(*(pos+1));
+                    replace(tokens, pos, pos->str[0]=='^' ? program::opPower : program::opRoot, first, second);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool compiler::compileMultiply(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOperator)
+                {
+                    // calc::calcDoMultiply() reads the second operand of every operator it passes,
+                    // for an operator it doesn't handle this only matters if the operand is an unknown variable
+                    if(pos->str != "*" && pos->str != "%" && pos->str != "/")
+                    {
+                        check(*(pos+1));
+                        continue;
+                    }
+
+                    // The second operand is read first
+                    const unsigned int second = value(*(pos+1));
+                    if(pos->str == "*")
+                    {
+                        replace(tokens, pos, program::opMultiply, value(*(pos-1)), second);
+                        return true;
+                    }
+
+                    // A division by zero is reported before the first operand is read,
+                    // the division itself checks this as well so a separate check is only needed if reading the first operand can fail
+                    if(!isSafe(*(pos-1)))
+                        out.emit(program::opCheckDivisor, 0, second, pos->str == "%");
+                    replace(tokens, pos, pos->str == "/" ? program::opDivide : program::opModulo, value(*(pos-1)), second);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool compiler::compilePlusmin(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOperator && (pos->str == "+" || pos->str == "-"))
+                {
+                    const unsigned int second = value(*(pos+1));
+                    const unsigned int first = value(*(pos-1));
+                    replace(tokens, pos, pos->str[0] == '+' ? program::opAdd : program::opSubtract, first, second);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool compiler::compileCompare(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOperator && (pos->str==">" || pos->str=="<"))
+                {
+                    const unsigned int second = value(*(pos+1));
+                    const unsigned int first = value(*(pos-1));
+                    replace(tokens, pos, pos->str[0] == '>' ? program::opGreater : program::opLess, first, second);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool compiler::compileBitwise(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos->type == calc::Token::tokenOperator && (pos->str=="|" || pos->str=="&"))
+                {
+                    const unsigned int second = value(*(pos+1));
+                    const unsigned int first = value(*(pos-1));
+                    replace(tokens, pos, pos->str[0] == '|' ? program::opBitwiseOr : program::opBitwiseAnd, first, second);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool compiler::compileAssignments(std::vector<calc::Token>& tokens)
+        {
+            for(std::vector<calc::Token>::iterator pos = tokens.begin(); pos != tokens.end(); ++pos)
+            {
+                if(pos != tokens.begin() && pos->type == calc::Token::tokenAssignmentOperator)
+                {
+                    // Only assignments to a plain variable name are compiled, anything else is left to the interpreter
+                    const calc::Token& target = *(pos-1);
+                    if(target.type != calc::Token::tokenName || target.str[0] == '-')
+                        throw notCompilable();
+
+                    // Store the value in the variable, after this the variable is known to exist
+                    out.emit(program::opStore, 0, out.variableSlot(target.str), value(*(pos+1)));
+                    knownVars.insert(target.str);
+
+                    // Erase the assignment operator and the value behind it, letting the variable be the result of this operation
+                    tokens.erase(pos, pos+2);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        unsigned int compiler::value(const calc::Token& token)
+        {
+            switch(token.type)
+            {
+                // A register
+                case calc::Token::tokenRealReal:
+                return static_cast<unsigned int>(token.val);
+
+                // A number, this is converted right away
+                // Integers keep their exact value as well, which matters for integers that are too large to be exact as a real,
+                // and the literal is kept for the number types that are more precise than a real (see numberengine.h)
+                case calc::Token::tokenReal:
+                {
+                    const unsigned int reg = out.newRegister();
+                    const unsigned int constant = out.addConstant(token.str.find(':') != string::npos ? timestr2real(token.str) : str2real(token.str), token.str);
+                    integer exact;
+                    if(str2integer(token.str, exact))
+                        out.emit(program::opIntConstant, reg, constant, out.addInteger(exact));
+                    else
+                        out.emit(program::opConstant, reg, constant);
+                    return reg;
+                }
+
+                // A variable, possibly preceded by an unary minus
+                case calc::Token::tokenName:
+                {
+                    const bool unaryMin = (token.str[0]=='-');
+                    const string name = unaryMin ? token.str.substr(1) : token.str;
+                    unsigned int reg = out.newRegister();
+                    out.emit(program::opLoad, reg, out.variableSlot(name), out.addString(token.str));
+                    knownVars.insert(name);
+                    if(unaryMin)
+                    {
+                        const unsigned int negated = out.newRegister();
+                        out.emit(program::opNegate, negated, reg);
+                        reg = negated;
+                    }
+                    return reg;
+                }
+
+                // Anything else results in an error, let the interpreter report it
+                default:
+                throw notCompilable();
+            }
+        }
+
+        void compiler::check(const calc::Token& token)
+        {
+            // Only variables can fail to be read
+            if(isSafe(token))
+                return;
+            if(token.type != calc::Token::tokenName)
+                throw notCompilable();
+
+            // Check whether the variable exists
+            const string name = token.str[0]=='-' ? token.str.substr(1) : token.str;
+            out.emit(program::opCheck, 0, out.variableSlot(name), out.addString(token.str));
+            knownVars.insert(name);
+        }
+
+        void compiler::replace(std::vector<calc::Token>& tokens, std::vector<calc::Token>::iterator pos, const program::opcode& op, const unsigned int& first, const unsigned int& second)
+        {
+            // Emit the operation
+            const unsigned int reg = out.newRegister();
+            out.emit(op, reg, first, second);
+
+            // Replace the operator by the result and remove the operands
+            *pos = registerToken(reg);
+            pos = tokens.erase(pos-1);
+            tokens.erase(pos+1);
+        }
+
+        bool compiler::isSafe(const calc::Token& token) const
+        {
+            switch(token.type)
+            {
+                case calc::Token::tokenRealReal:
+                case calc::Token::tokenReal:
+                return true;
+
+                case calc::Token::tokenName:
+                return knownVars.count(token.str[0]=='-' ? token.str.substr(1) : token.str) != 0;
+
+                default:
+                return false;
+            }
+        }
+
+        calc::Token compiler::registerToken(const unsigned int& reg)
+        { return calc::Token(calc::Token::tokenRealReal, "", reg); }
+}
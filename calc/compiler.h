@@ -0,0 +1,75 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <set>
+#include "calc.h"
+#include "program.h"
+
+namespace calc
+{
+    // Turns the tokens of a calc into a program
+    // The compiler walks through the tokens exactly like calc::calculate() does, but instead of calculating the value of every
+    // operation it emits an instruction that will do so, the value in the token is replaced by the register holding the result.
+    // Tokens of the type tokenRealReal never come out of the parser, so here they are used to hold such a register.
+    class compiler
+    {
+        public:
+            // Thrown when the tokens contain something the compiler can't reproduce exactly, calc then interprets the tokens instead
+            struct notCompilable {};
+
+            // Constructor, the instructions will be added to out
+            // The functions that get their arguments unevaluated are looked up in the given environment, which has to outlive the compiler
+            compiler(program& out, environment& functions);
+
+            // Compile the tokens (without whitespaces) and return the register holding the result
+            unsigned int compile(std::vector<calc::Token> tokens);
+
+        private:
+            // Compile functions, the counterparts of calc::calcDoBrackets() etc.
+            // Every function returns true if it needs to be called another time and false when it's done
+                bool compileExpressionFunctions(std::vector<calc::Token>& tokens);
+                bool compileBrackets(std::vector<calc::Token>& tokens);
+                bool compileFunctions(std::vector<calc::Token>& tokens);
+                bool compilePowers(std::vector<calc::Token>& tokens);
+                bool compileMultiply(std::vector<calc::Token>& tokens);
+                bool compilePlusmin(std::vector<calc::Token>& tokens);
+                bool compileCompare(std::vector<calc::Token>& tokens);
+                bool compileBitwise(std::vector<calc::Token>& tokens);
+                bool compileAssignments(std::vector<calc::Token>& tokens);
+
+            // Emit the instructions for calc::tokenToValue() and return the register holding the value
+            unsigned int value(const calc::Token& token);
+            // Emit the instructions for a calc::tokenToValue() of which the value isn't used
+            void check(const calc::Token& token);
+            // Emit a binary operation on two registers and replace the three tokens around pos by its result
+            void replace(std::vector<calc::Token>& tokens, std::vector<calc::Token>::iterator pos, const program::opcode& op, const unsigned int& first, const unsigned int& second);
+            // Returns true if loading the token can't throw an error (i.e. it isn't an unknown variable)
+            bool isSafe(const calc::Token& token) const;
+            // Returns a token holding the given register
+            static calc::Token registerToken(const unsigned int& reg);
+
+            program& out;                           // The program the instructions are added to
+            environment& functions;                 // The environment the functions are looked up in
+            std::set<string> knownVars;             // Variables that are known to exist at this point in the program
+    };
+}
+
+#endif // COMPILER_H
@@ -0,0 +1,491 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "context.h"
+#include "calc.h"
+#include "builtins.h"
+#include "instrumentation.h"
+#include "profiler.h"
+#include "numberengine.h"
+#include <limits>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        // The environment expressions compiled without one look their functions up in, which has nothing but the built-in functions
+        class builtInEnvironment : public environment
+        {
+            public:
+                real* findVar(const string& name)
+                {
+                    varList::iterator pos = vars.find(name);
+                    return pos != vars.end() ? &pos->second : 0;
+                }
+                real* createVar(const string& name)
+                { return &vars[name]; }
+                mathFunction* findFunction(const string& name)
+                {
+                    static const builtIns functions;
+                    return functions.getFunction(name);
+                }
+
+            private:
+                varList vars;                                           // The variables that have been assigned
+        };
+    }
+
+    // A function defined by an expression, bound to the frame it's called in
+    class contextFrame::boundFunction : public mathFunction
+    {
+        public:
+            // Constructor
+            boundFunction(contextFrame& frame, const std::shared_ptr<const context::userFunction>& function)
+            : mathFunction(false), frame(frame), function(function) {}
+
+            // Execute the function
+            virtual real execute(const argList& vars, const string& name)
+            { return frame.call(*function, vars, name); }
+
+            // Calculate the expression with dual numbers
+            virtual bool differentiate(const argList& args, const argList& slopes, const string& name, real& value, real& derivative);
+
+        private:
+            contextFrame& frame;                                        // The frame the function is called in
+            std::shared_ptr<const context::userFunction> function;      // The function
+    };
+
+    // The environment of a function call, ARG0, ARG1, ... are the arguments and everything else comes from the frame
+    class contextFrame::argumentEnvironment : public environment
+    {
+        public:
+            // Constructor
+            argumentEnvironment(contextFrame& frame, const argList& args)
+            : frame(frame), args(args) {}
+
+            real* findVar(const string& name)
+            {
+                real* arg = argument(name);
+                return arg ? arg : frame.findVar(name);
+            }
+
+            real* createVar(const string& name)
+            {
+                real* arg = argument(name);
+                return arg ? arg : frame.createVar(name);
+            }
+
+            mathFunction* findFunction(const string& name)
+            { return frame.findFunction(name); }
+
+            randomGenerator* getRandomGenerator()
+            { return frame.getRandomGenerator(); }
+
+        private:
+            // Returns the argument with the given name, or 0 if the name isn't the name of an argument
+            real* argument(const string& name)
+            {
+                // The name should be ARG followed by the index of an argument, written like real2str() does
+                if(name.size() < 4 || name.compare(0, 3, "ARG") != 0 || (name[3] == '0' && name.size() > 4))
+                    return 0;
+                size_t index = 0;
+                for(size_t i = 3; i < name.size(); ++i)
+                {
+                    if(name[i] < '0' || name[i] > '9' || index > args.size())
+                        return 0;
+                    index = index*10 + (name[i]-'0');
+                }
+                return index < args.size() ? &args[index] : 0;
+            }
+
+            contextFrame& frame;                    // The frame of the call
+            argList args;                           // The arguments
+    };
+
+    // contextFrame::boundFunction:
+        // Public:
+            bool contextFrame::boundFunction::differentiate(const argList& args, const argList& slopes, const string& name, real& value, real& derivative)
+            {
+                // The value is calculated the normal way first, which throws the errors, so the expression is valid and doesn't call itself
+                value = frame.call(*function, args, name);
+                argumentEnvironment env(frame, args);
+                derivative = differentiateExpression(*function->prog, env, args, slopes);
+                return true;
+            }
+
+    // context:
+        // Public:
+            context::context()
+            : random(randomGenerator::unpredictableSeed()) {}
+
+            // Functions for the variables
+            void context::setVar(const string& name, const real& value)
+            { vars[name] = value; }
+
+            bool context::deleteVar(const string& name)
+            { return vars.erase(name) != 0; }
+
+            bool context::varExists(const string& name) const
+            { return vars.count(name) != 0; }
+
+            real context::getVar(const string& name) const
+            {
+                varList::const_iterator pos = vars.find(name);
+                return pos != vars.end() ? pos->second : 0;
+            }
+
+            const varList& context::getVars() const
+            { return vars; }
+
+            // Functions for the functions
+            void context::setFunction(const string& name, mathFunction* function)
+            {
+                dropCompiled(name);
+                userFunctions.erase(name);
+                nativeFunctions[name] = function;
+            }
+
+            void context::defineFunction(const string& name, const string& expression)
+            {
+                std::shared_ptr<userFunction> function(new userFunction());
+                function->expression = expression;
+                function->compiled = 0;
+
+                // Find the number of arguments in the expression, the same way userDefinedMathFunction does
+                function->argumentCount = 0;
+                while(function->argumentCount < std::numeric_limits<unsigned short>::max() && expression.find("ARG"+real2str(function->argumentCount)) != string::npos)
+                    ++function->argumentCount;
+
+                // Compile the expression, an invalid expression is reported when the function is called
+                try
+                {
+                    contextFrame functions(*this);
+                    function->prog = compile(expression, &functions);
+                }
+                catch(calcError&)
+                {}
+
+                dropCompiled(name);
+                nativeFunctions.erase(name);
+                userFunctions[name] = function;
+            }
+
+            bool context::deleteFunction(const string& name)
+            {
+                dropCompiled(name);
+                return (nativeFunctions.erase(name) + userFunctions.erase(name)) != 0;
+            }
+
+            bool context::functionExists(const string& name) const
+            { return nativeFunctions.count(name) != 0 || userFunctions.count(name) != 0; }
+
+            string context::getFunctionExpression(const string& name) const
+            {
+                std::map<string, std::shared_ptr<const userFunction> >::const_iterator pos = userFunctions.find(name);
+                return pos != userFunctions.end() ? pos->second->expression : "";
+            }
+
+            bool context::useCompiledFunction(const string& name, const string& expression, mathFunction* function)
+            {
+                std::map<string, std::shared_ptr<const userFunction> >::iterator pos = userFunctions.find(name);
+                if(pos == userFunctions.end() || pos->second->expression != expression)
+                    return false;
+
+                // The definition may be shared with copies of this context, so this context gets a copy of it
+                std::shared_ptr<userFunction> copy(new userFunction(*pos->second));
+                copy->compiled = function;
+                pos->second = copy;
+                return true;
+            }
+
+            std::vector<string> context::getFunctionNames() const
+            {
+                std::vector<string> out;
+                for(functionList::const_iterator pos = nativeFunctions.begin(); pos != nativeFunctions.end(); ++pos)
+                    out.push_back(pos->first);
+                for(std::map<string, std::shared_ptr<const userFunction> >::const_iterator pos = userFunctions.begin(); pos != userFunctions.end(); ++pos)
+                    out.push_back(pos->first);
+                std::sort(out.begin(), out.end());
+                return out;
+            }
+
+            std::shared_ptr<const program> context::compile(const string& expression, environment* functions)
+            {
+                // Parse the expression, throwing the first error if there is one
+                calc calculator(expression, false);
+                calculator.parse();
+                if(!calculator.isValidExpression())
+                    throw calculator.getParseErrors()->front();
+
+                // Only the interpreter of calc can handle expressions that can't be compiled, which isn't available in a context
+                builtInEnvironment builtInFunctions;
+                const program* prog = calculator.getProgram(functions ? *functions : builtInFunctions);
+                if(prog == 0)
+                    throw calcError("Invalid expression", calcError::invalidExpression, expression);
+                return std::shared_ptr<const program>(new program(*prog));
+            }
+
+            real context::evaluate(const string& expression)
+            {
+                contextFrame functions(*this);
+                return execute(*compile(expression, &functions));
+            }
+
+            real context::execute(const program& prog)
+            {
+                // Like calc, assignments done before an error occurred are kept
+                contextFrame frame(*this);
+                try
+                {
+                    const real out = frame.execute(prog);
+                    frame.commit(*this);
+                    return out;
+                }
+                catch(calcError&)
+                {
+                    frame.commit(*this);
+                    throw;
+                }
+            }
+
+            void context::setBackend(const std::shared_ptr<const numberBackend>& newBackend)
+            { backend = newBackend; }
+
+            const std::shared_ptr<const numberBackend>& context::getBackend() const
+            { return backend; }
+
+            string context::evaluateText(const string& expression, const realOutputType& outputType, const int& precision)
+            {
+                contextFrame functions(*this);
+                const std::shared_ptr<const program> prog = compile(expression, &functions);
+                if(!backend)
+                    return real2str(execute(*prog), outputType, precision);
+
+                // Like execute(), assignments done before an error occurred are kept
+                contextFrame frame(*this);
+                try
+                {
+                    const string out = frame.execute(*prog, *backend, outputType, precision);
+                    frame.commit(*this);
+                    return out;
+                }
+                catch(calcError&)
+                {
+                    frame.commit(*this);
+                    throw;
+                }
+            }
+
+            void context::setRandomSeed(const unsigned long long& seed)
+            { random.setSeed(seed); }
+
+            const randomGenerator& context::getRandom() const
+            { return random; }
+
+            void context::setRandom(const randomGenerator& generator)
+            { random = generator; }
+
+        // Private:
+            void context::dropCompiled(const string& name)
+            {
+                std::map<string, std::shared_ptr<const userFunction> >::iterator changed = userFunctions.find(name);
+                if(changed == userFunctions.end() || !changed->second->compiled)
+                    return;
+
+                // The definitions may be shared with copies of this context, so this context gets copies of them
+                for(std::map<string, std::shared_ptr<const userFunction> >::iterator pos = userFunctions.begin(); pos != userFunctions.end(); ++pos)
+                {
+                    if(!pos->second->compiled)
+                        continue;
+                    std::shared_ptr<userFunction> copy(new userFunction(*pos->second));
+                    copy->compiled = 0;
+                    pos->second = copy;
+                }
+            }
+
+    // contextFrame:
+        // Public:
+            contextFrame::contextFrame(const context& source)
+            : source(source), random(source.random), randomStream(false) {}
+
+            contextFrame::~contextFrame()
+            {
+                for(std::map<string, boundFunction*>::iterator pos = boundFunctions.begin(); pos != boundFunctions.end(); ++pos)
+                    delete pos->second;
+            }
+
+            real contextFrame::execute(const program& prog)
+            {
+                CALC_PHASE(phaseEvaluate);
+                try
+                { return prog.execute(*this); }
+                catch(calcError&)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw;
+                }
+                catch(std::exception& exc)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw calcError("STL error occurred", calcError::unknown, exc.what());
+                }
+                catch(...)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw calcError("Unknown error occurred", calcError::unknown);
+                }
+            }
+
+            string contextFrame::execute(const program& prog, const numberBackend& backend, const realOutputType& outputType, const int& precision)
+            {
+                CALC_PHASE(phaseEvaluate);
+                try
+                { return backend.execute(prog, *this, outputType, precision); }
+                catch(calcError&)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw;
+                }
+                catch(std::exception& exc)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw calcError("STL error occurred", calcError::unknown, exc.what());
+                }
+                catch(...)
+                {
+                    CALC_PHASE_FAILED();
+                    callStack.clear();
+                    throw calcError("Unknown error occurred", calcError::unknown);
+                }
+            }
+
+            void contextFrame::useRandomStream(const randomGenerator& stream)
+            {
+                random = stream;
+                randomStream = true;
+            }
+
+            const randomGenerator& contextFrame::getRandom() const
+            { return random; }
+
+            bool contextFrame::hasAssignments() const
+            { return !assigned.empty() || (!randomStream && random != source.random); }
+
+            void contextFrame::commit(context& target) const
+            {
+                for(std::set<string>::const_iterator pos = assigned.begin(); pos != assigned.end(); ++pos)
+                    target.setVar(*pos, values.find(*pos)->second);
+                if(!randomStream && random != source.random)
+                    target.random = random;
+            }
+
+            real* contextFrame::findVar(const string& name)
+            {
+                // Variables that have been used before are in the frame already
+                varList::iterator pos = values.find(name);
+                if(pos != values.end())
+                    return &pos->second;
+
+                // Otherwise copy them from the context, so they can't be changed through the pointer
+                varList::const_iterator sourcePos = source.vars.find(name);
+                if(sourcePos == source.vars.end())
+                    return 0;
+                return &(values[name] = sourcePos->second);
+            }
+
+            real* contextFrame::createVar(const string& name)
+            {
+                // Remember that the variable is assigned, its current value is copied from the context if it exists
+                assigned.insert(name);
+                real* var = findVar(name);
+                return var ? var : &values[name];
+            }
+
+            mathFunction* contextFrame::findFunction(const string& name)
+            {
+                // Functions implemented in C++ can be used right away
+                functionList::const_iterator nativePos = source.nativeFunctions.find(name);
+                if(nativePos != source.nativeFunctions.end())
+                    return nativePos->second;
+
+                // Functions defined by an expression are bound to this frame
+                std::map<string, boundFunction*>::const_iterator boundPos = boundFunctions.find(name);
+                if(boundPos != boundFunctions.end())
+                    return boundPos->second;
+                std::map<string, std::shared_ptr<const context::userFunction> >::const_iterator userPos = source.userFunctions.find(name);
+                if(userPos == source.userFunctions.end())
+                    return 0;
+                return boundFunctions[name] = new boundFunction(*this, userPos->second);
+            }
+
+            randomGenerator* contextFrame::getRandomGenerator()
+            { return &random; }
+
+        // Private:
+            real contextFrame::call(const context::userFunction& function, const argList& args, const string& name)
+            {
+                CALC_PHASE(phaseFunctionCall);
+
+                // Check if this function isn't (indirectly) calling itself
+                if(std::find(callStack.begin(), callStack.end(), name) != callStack.end())
+                    throw calcError("A function may not (indirectly) call itself", calcError::recursiveCall, name);
+
+                // Check if the numbers of arguments is right, if not throw an error
+                if(args.size() != function.argumentCount)
+                {
+                    std::vector<real> extraRealInfo(2, args.size());
+                    extraRealInfo[1] = function.argumentCount;
+                    throw calcError(args.size() < function.argumentCount ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+
+                // Throw an error if the expression is invalid
+                if(!function.prog)
+                {
+                    std::vector<string> extraStringInfo(2, function.expression);
+                    extraStringInfo[1] = name;
+                    throw calcError("Invalid expression in the function", calcError::invalidExpression, extraStringInfo);
+                }
+
+                // A compiled version gives the same results and errors, it never calls a function defined by an expression so it can't call itself
+                CALC_PROFILE_CACHE_HIT(true);
+                if(function.compiled)
+                    return function.compiled->execute(args, name);
+
+                // Execute the function with the arguments as its variables, it has been compiled when it was defined
+                // It's taken off the call stack again when it fails as well, functions like SOLVE() may continue after an error.
+                callStack.push_back(name);
+                argumentEnvironment env(*this, args);
+                try
+                {
+                    const real out = function.prog->execute(env);
+                    callStack.pop_back();
+                    return out;
+                }
+                catch(...)
+                {
+                    callStack.pop_back();
+                    throw;
+                }
+            }
+}
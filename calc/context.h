@@ -0,0 +1,179 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <map>
+#include <set>
+#include <memory>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "random.h"
+
+namespace calc
+{
+    class numberBackend;
+
+    // A set of variables and functions in which expressions can be evaluated
+    // Unlike the variables and functions of calc, which are shared by all instances, every context has its own.
+    // A context that isn't changed can be used by several threads at once, using a contextFrame for every thread.
+    // Copying a context is cheap enough to make a new version for every change, the function definitions are shared between the copies.
+    class context
+    {
+        public:
+            // Constructor, creates a context without any variables or functions
+            context();
+
+            // Set the value of a variable, the variable is created if it doesn't exist
+            void setVar(const string& name, const real& value);
+            // Delete a variable, returns true if the variable existed and is deleted
+            bool deleteVar(const string& name);
+            // Returns true if the variable exists
+            bool varExists(const string& name) const;
+            // Get the value of a variable, returns 0 if the variable doesn't exist
+            real getVar(const string& name) const;
+            // Get all variables
+            const varList& getVars() const;
+
+            // Set a function implemented in C++, the context doesn't take ownership of the function
+            // The function has to be thread-safe if the context is used by more than one thread
+            void setFunction(const string& name, mathFunction* function);
+            // Define a function by an expression, ARG0, ARG1, ... are its arguments
+            // Like a userDefinedMathFunction, an invalid expression only results in an error when the function is called
+            void defineFunction(const string& name, const string& expression);
+            // Delete a function, returns true if the function existed and is deleted
+            bool deleteFunction(const string& name);
+            // Returns true if the function exists
+            bool functionExists(const string& name) const;
+            // Get the expression of a function defined by defineFunction(), returns an empty string for any other function
+            string getFunctionExpression(const string& name) const;
+            // Let a function defined by defineFunction() be executed by a compiled version of its expression, e.g. a function exported to C++ (see nativeexport.h)
+            // Returns false and changes nothing if the function isn't defined by exactly the given expression
+            // Compiled versions may call each other directly, so changing or deleting a function that has one stops using all compiled versions
+            bool useCompiledFunction(const string& name, const string& expression, mathFunction* function);
+            // Get the names of all functions
+            std::vector<string> getFunctionNames() const;
+
+            // Compile an expression, if the expression contains errors the first one is thrown
+            // The functions that get their arguments unevaluated (like SUM()) are looked up in the given environment, or in the built-in
+            // functions if it's 0. A call of a function that doesn't exist at that point is compiled as a call with evaluated arguments.
+            static std::shared_ptr<const program> compile(const string& expression, environment* functions = 0);
+
+            // Evaluate an expression in this context, assignments change the variables of this context
+            // Returns the result of the expression, if an error occurs an error is thrown
+            real evaluate(const string& expression);
+            // Execute a compiled expression in this context, assignments change the variables of this context
+            real execute(const program& prog);
+
+            // Set the number type the expressions are evaluated with by evaluateText(), 0 for real (which is the default)
+            // The backend is shared with the copies of this context.
+            void setBackend(const std::shared_ptr<const numberBackend>& backend);
+            // Get the number type the expressions are evaluated with by evaluateText(), 0 for real
+            const std::shared_ptr<const numberBackend>& getBackend() const;
+            // Evaluate an expression in this context using its number type, returns the result written in the given format (see real2str())
+            // Assignments change the variables of this context, which are reals. If an error occurs an error is thrown.
+            string evaluateText(const string& expression, const realOutputType& outputType = outputType_auto, const int& precision = -1);
+
+            // Start the random numbers of RAND over with the given seed, the same seed gives the same numbers
+            // A new context gets a seed that's different every time, its copies continue with the same numbers.
+            void setRandomSeed(const unsigned long long& seed);
+            // Get the generator of the random numbers of RAND, e.g. to split streams off it (see contextFrame::useRandomStream())
+            const randomGenerator& getRandom() const;
+            // Set the generator of the random numbers of RAND, e.g. to continue after the streams that were split off it
+            void setRandom(const randomGenerator& generator);
+
+        private:
+            friend class contextFrame;
+
+            // A function defined by an expression
+            struct userFunction
+            {
+                string expression;                          // The expression
+                std::shared_ptr<const program> prog;        // The compiled expression, 0 if the expression is invalid
+                unsigned short argumentCount;               // The number of arguments
+                mathFunction* compiled;                     // The compiled version of the expression, 0 if there is none
+            };
+
+            // Stop using the compiled versions of all functions if the function with the given name has one, because it's going to be changed
+            void dropCompiled(const string& name);
+
+            varList vars;                                                       // The variables
+            functionList nativeFunctions;                                       // The functions implemented in C++
+            std::map<string, std::shared_ptr<const userFunction> > userFunctions;  // The functions defined by an expression
+            std::shared_ptr<const numberBackend> backend;                       // The number type of evaluateText(), 0 for real
+            randomGenerator random;                                             // The generator of RAND
+    };
+
+    // The environment in which programs are executed on a context
+    // The context itself is only read, the variables that are assigned are collected by the frame and can be written
+    // to a context later on using commit(). This way every thread can execute programs on the same context at once.
+    class contextFrame : public environment
+    {
+        public:
+            // Constructor, the context has to outlive the frame
+            contextFrame(const context& source);
+            // Destructor
+            ~contextFrame();
+
+            // Execute a program, returns the result or throws a calcError
+            real execute(const program& prog);
+            // Execute a program with the given number type, returns the result written in the given format or throws a calcError
+            string execute(const program& prog, const numberBackend& backend, const realOutputType& outputType, const int& precision);
+
+            // Let RAND draw from the given stream instead of a copy of the generator of the context, e.g. a stream split off it for
+            // every expression of a batch so the numbers don't depend on the order in which the expressions are calculated
+            // The stream isn't written back to the context by commit().
+            void useRandomStream(const randomGenerator& stream);
+            // Get the generator RAND draws from in this frame
+            const randomGenerator& getRandom() const;
+
+            // Returns true if any variable has been assigned, or RAND has drawn from the generator of the context
+            bool hasAssignments() const;
+            // Write the variables that have been assigned and the generator of the context, if RAND has drawn from it, to the given context
+            void commit(context& target) const;
+
+            // The environment:
+            real* findVar(const string& name);
+            real* createVar(const string& name);
+            mathFunction* findFunction(const string& name);
+            randomGenerator* getRandomGenerator();
+
+        private:
+            // Prevent copying:
+            contextFrame& operator=(const contextFrame& other);
+            contextFrame(const contextFrame& other);
+
+            class boundFunction;
+            class argumentEnvironment;
+
+            // Call a function defined by an expression
+            real call(const context::userFunction& function, const argList& args, const string& name);
+
+            const context& source;                                      // The context the frame reads from
+            varList values;                                             // The variables that have been read or assigned
+            std::set<string> assigned;                                  // The names of the variables that have been assigned
+            std::map<string, boundFunction*> boundFunctions;            // The functions defined by an expression, bound to this frame
+            std::vector<string> callStack;                              // The functions that are being called, to detect recursion
+            randomGenerator random;                                     // The generator RAND draws from
+            bool randomStream;                                          // Whether random is a stream set by useRandomStream()
+    };
+}
+
+#endif // CONTEXT_H
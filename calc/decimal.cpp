@@ -0,0 +1,1459 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "decimal.h"
+#include "calc.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        // The digits of a mantissa, in base 10^9 with the least significant digit first
+        typedef unsigned int limb;
+        typedef std::vector<limb> magnitude;
+        typedef unsigned long long int wide;
+        const limb base = 1000000000;
+
+        // Below this number of digits (in base 10^9) the schoolbook multiplication is faster than Karatsuba
+        const size_t karatsubaThreshold = 32;
+        // The number of extra decimal digits the functions are calculated with
+        const int guardDigits = 10;
+        // Remainders and integers in another base are only calculated for numbers with at most this many digits (in base 10^9)
+        const size_t maxExactLimbs = 1u << 16;
+        // Angles are only reduced exactly if they have at most this many decimal digits in front of the dot, since pi is needed with
+        // that many digits more. Larger angles are left to the real version.
+        const long long maxReductionDigits = 2000;
+
+        const limb powersOf10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+        // Returns the number of decimal digits of x, which isn't 0
+        int digitCount(limb x)
+        {
+            int count = 1;
+            while(x >= 10 && count < 9)
+            {
+                x /= 10;
+                ++count;
+            }
+            return count;
+        }
+
+        // Returns the number of decimal digits of the absolute value of x
+        int digitCount(const integer& x)
+        {
+            int count = 1;
+            for(wide rest = x < 0 ? 0 - static_cast<wide>(x) : static_cast<wide>(x); rest >= 10; rest /= 10)
+                ++count;
+            return count;
+        }
+
+        // Remove the zeros at the most significant end
+        void trim(magnitude& a)
+        {
+            while(!a.empty() && a.back() == 0)
+                a.pop_back();
+        }
+
+        // Compare two trimmed magnitudes, returns -1, 0 or 1
+        int compare(const magnitude& a, const magnitude& b)
+        {
+            if(a.size() != b.size())
+                return a.size() < b.size() ? -1 : 1;
+            for(size_t i = a.size(); i-- > 0;)
+            {
+                if(a[i] != b[i])
+                    return a[i] < b[i] ? -1 : 1;
+            }
+            return 0;
+        }
+
+        // Add b*base^shift to a
+        void addTo(magnitude& a, const limb* b, const size_t& count, const size_t& shift)
+        {
+            if(a.size() < count + shift)
+                a.resize(count + shift, 0);
+            limb carry = 0;
+            size_t i = 0;
+            for(; i < count; ++i)
+            {
+                limb sum = a[i + shift] + b[i] + carry;
+                carry = sum >= base ? 1 : 0;
+                a[i + shift] = sum - carry * base;
+            }
+            for(i += shift; carry != 0; ++i)
+            {
+                if(i == a.size())
+                    a.push_back(0);
+                limb sum = a[i] + carry;
+                carry = sum >= base ? 1 : 0;
+                a[i] = sum - carry * base;
+            }
+        }
+
+        void addTo(magnitude& a, const magnitude& b, const size_t& shift = 0)
+        { addTo(a, b.data(), b.size(), shift); }
+
+        // Subtract b*base^shift from a, which has to be at least as large
+        void subtractFrom(magnitude& a, const magnitude& b, const size_t& shift = 0)
+        {
+            limb borrow = 0;
+            size_t i = 0;
+            for(; i < b.size(); ++i)
+            {
+                const limb subtrahend = b[i] + borrow;
+                borrow = a[i + shift] < subtrahend ? 1 : 0;
+                a[i + shift] = a[i + shift] + borrow * base - subtrahend;
+            }
+            for(i += shift; borrow != 0; ++i)
+            {
+                borrow = a[i] == 0 ? 1 : 0;
+                a[i] = a[i] + borrow * base - 1;
+            }
+            trim(a);
+        }
+
+        // Multiply a by a single digit
+        void multiplySmall(magnitude& a, const limb& factor)
+        {
+            wide carry = 0;
+            for(size_t i = 0; i < a.size(); ++i)
+            {
+                const wide product = static_cast<wide>(a[i]) * factor + carry;
+                a[i] = static_cast<limb>(product % base);
+                carry = product / base;
+            }
+            if(carry != 0)
+                a.push_back(static_cast<limb>(carry));
+            trim(a);
+        }
+
+        // Divide a by a single digit, returns the remainder
+        limb divideSmall(magnitude& a, const limb& divisor)
+        {
+            wide remainder = 0;
+            for(size_t i = a.size(); i-- > 0;)
+            {
+                const wide current = remainder * base + a[i];
+                a[i] = static_cast<limb>(current / divisor);
+                remainder = current % divisor;
+            }
+            trim(a);
+            return static_cast<limb>(remainder);
+        }
+
+        // The schoolbook multiplication
+        magnitude multiplySchoolbook(const limb* a, const size_t& countA, const limb* b, const size_t& countB)
+        {
+            magnitude out(countA + countB, 0);
+            for(size_t i = 0; i < countA; ++i)
+            {
+                wide carry = 0;
+                const wide digit = a[i];
+                for(size_t j = 0; j < countB; ++j)
+                {
+                    const wide sum = out[i + j] + digit * b[j] + carry;
+                    out[i + j] = static_cast<limb>(sum % base);
+                    carry = sum / base;
+                }
+                out[i + countB] = static_cast<limb>(carry);
+            }
+            trim(out);
+            return out;
+        }
+
+        // Multiply two magnitudes, using the Karatsuba algorithm if both are large
+        magnitude multiply(const limb* a, size_t countA, const limb* b, size_t countB)
+        {
+            while(countA > 0 && a[countA - 1] == 0)
+                --countA;
+            while(countB > 0 && b[countB - 1] == 0)
+                --countB;
+            if(countA < countB)
+            {
+                std::swap(a, b);
+                std::swap(countA, countB);
+            }
+            if(countB == 0)
+                return magnitude();
+            if(countB < karatsubaThreshold)
+                return multiplySchoolbook(a, countA, b, countB);
+
+            // If a is much longer than b, a is multiplied in parts of the length of b
+            magnitude out;
+            if(countB * 2 <= countA)
+            {
+                for(size_t offset = 0; offset < countA; offset += countB)
+                    addTo(out, multiply(a + offset, std::min(countB, countA - offset), b, countB), offset);
+                trim(out);
+                return out;
+            }
+
+            // Otherwise both are split in a low and a high half: a = a1*B + a0 and b = b1*B + b0
+            // Then a*b = z2*B^2 + z1*B + z0, with z0 = a0*b0, z2 = a1*b1 and z1 = (a0+a1)*(b0+b1) - z0 - z2
+            const size_t half = countA / 2;
+            const magnitude z0 = multiply(a, half, b, half);
+            const magnitude z2 = multiply(a + half, countA - half, b + half, countB - half);
+            magnitude sumA(a, a + half), sumB(b, b + half);
+            addTo(sumA, a + half, countA - half, 0);
+            addTo(sumB, b + half, countB - half, 0);
+            magnitude z1 = multiply(sumA.data(), sumA.size(), sumB.data(), sumB.size());
+            subtractFrom(z1, z0);
+            subtractFrom(z1, z2);
+            out = z0;
+            addTo(out, z1, half);
+            addTo(out, z2, 2 * half);
+            trim(out);
+            return out;
+        }
+
+        magnitude multiply(const magnitude& a, const magnitude& b)
+        { return multiply(a.data(), a.size(), b.data(), b.size()); }
+
+        // Divide u by v (Knuth's algorithm D), v isn't 0
+        void divideMagnitudes(const magnitude& u, const magnitude& v, magnitude& quotient, magnitude& remainder)
+        {
+            if(compare(u, v) < 0)
+            {
+                quotient.clear();
+                remainder = u;
+                return;
+            }
+            if(v.size() == 1)
+            {
+                quotient = u;
+                const limb rest = divideSmall(quotient, v[0]);
+                remainder.assign(rest != 0 ? 1 : 0, rest);
+                return;
+            }
+
+            // Normalize, such that the most significant digit of the divisor is at least base/2
+            const limb factor = base / (v.back() + 1);
+            magnitude dividend(u), divisor(v);
+            multiplySmall(dividend, factor);
+            multiplySmall(divisor, factor);
+            const size_t n = divisor.size();
+            const size_t m = dividend.size() - n;
+            dividend.resize(dividend.size() + 1, 0);
+            quotient.assign(m + 1, 0);
+
+            // Determine the digits of the quotient one by one, from the most significant one on
+            for(size_t j = m + 1; j-- > 0;)
+            {
+                // Estimate the digit using the two most significant digits, the estimate is at most 2 too large
+                const wide numerator = static_cast<wide>(dividend[j + n]) * base + dividend[j + n - 1];
+                wide estimate = numerator / divisor[n - 1];
+                wide rest = numerator % divisor[n - 1];
+                while(estimate >= base || estimate * divisor[n - 2] > rest * base + dividend[j + n - 2])
+                {
+                    --estimate;
+                    rest += divisor[n - 1];
+                    if(rest >= base)
+                        break;
+                }
+
+                // Subtract estimate*divisor from the current part of the dividend
+                wide carry = 0;
+                long long borrow = 0;
+                for(size_t i = 0; i < n; ++i)
+                {
+                    const wide product = estimate * divisor[i] + carry;
+                    carry = product / base;
+                    long long difference = static_cast<long long>(dividend[i + j]) - static_cast<long long>(product % base) - borrow;
+                    borrow = difference < 0 ? 1 : 0;
+                    dividend[i + j] = static_cast<limb>(difference + borrow * base);
+                }
+                long long difference = static_cast<long long>(dividend[j + n]) - static_cast<long long>(carry) - borrow;
+
+                // If the estimate was still one too large, add the divisor back
+                if(difference < 0)
+                {
+                    --estimate;
+                    limb addCarry = 0;
+                    for(size_t i = 0; i < n; ++i)
+                    {
+                        limb sum = dividend[i + j] + divisor[i] + addCarry;
+                        addCarry = sum >= base ? 1 : 0;
+                        dividend[i + j] = sum - addCarry * base;
+                    }
+                    difference += base + addCarry;
+                    difference %= base;
+                }
+                dividend[j + n] = static_cast<limb>(difference);
+                quotient[j] = static_cast<limb>(estimate);
+            }
+            trim(quotient);
+
+            // Undo the normalization of the remainder
+            dividend.resize(n);
+            trim(dividend);
+            divideSmall(dividend, factor);
+            remainder.swap(dividend);
+        }
+
+        // Shift a magnitude by the given number of digits (in base 10^9) to the left
+        magnitude shifted(const magnitude& a, const size_t& shift)
+        {
+            magnitude out(shift, 0);
+            out.insert(out.end(), a.begin(), a.end());
+            return out;
+        }
+
+        // Write the digits of a magnitude in decimal, without the zeros at the end
+        string digitString(const magnitude& a)
+        {
+            string out;
+            char buffer[16];
+            for(size_t i = a.size(); i-- > 0;)
+            {
+                std::snprintf(buffer, sizeof(buffer), i + 1 == a.size() ? "%u" : "%09u", a[i]);
+                out += buffer;
+            }
+            out.erase(out.find_last_not_of('0') + 1);
+            return out;
+        }
+
+        // Round a string of decimal digits to the given number of digits, halfway cases away from zero
+        // If rounding adds a digit (e.g. 999 becomes 1000), top is increased
+        void roundDigitString(string& digits, const long long& keep, long long& top)
+        {
+            if(keep < 0 || digits.empty())
+            {
+                digits.clear();
+                return;
+            }
+            if(static_cast<size_t>(keep) >= digits.size())
+                return;
+            const bool up = digits[keep] >= '5';
+            digits.resize(keep);
+            if(up)
+            {
+                long long i = keep - 1;
+                for(; i >= 0 && digits[i] == '9'; --i)
+                    digits[i] = '0';
+                if(i >= 0)
+                    ++digits[i];
+                else
+                {
+                    digits.insert(digits.begin(), '1');
+                    ++top;
+                }
+            }
+            digits.erase(digits.find_last_not_of('0') + 1);
+        }
+
+        // Write the exponent of the scientific notation, like real2str() does: without a + sign and leading zeros, and not at all if it's 0
+        string exponentString(const long long& exponent)
+        {
+            if(exponent == 0)
+                return string();
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "e%lld", exponent);
+            return buffer;
+        }
+
+        // Protects the constants that have been calculated, which are kept for later use
+        struct constantCache
+        {
+            std::mutex mutex;                       // Protects everything below
+            decimal pi;                             // The most precise pi that has been calculated, exact 0 if none
+            decimal ln2;                            // The most precise ln(2)
+            decimal ln10;                           // The most precise ln(10)
+        };
+        constantCache& constants()
+        {
+            static constantCache cache;
+            return cache;
+        }
+    }
+
+    // decimal:
+        // Public:
+            const int decimal::defaultDigits;
+
+            decimal::decimal()
+            : type(finite), negative(false), exponent(0), digits(0) {}
+
+            decimal::decimal(const int& value)
+            { *this = fromInteger(value); }
+
+            decimal decimal::fromInteger(const integer& value, const int& digits)
+            {
+                decimal out;
+                out.negative = value < 0;
+                for(wide rest = value < 0 ? 0 - static_cast<wide>(value) : static_cast<wide>(value); rest != 0; rest /= base)
+                    out.mantissa.push_back(static_cast<limb>(rest % base));
+                out.normalize();
+                out.roundTo(digits);
+                out.digits = digits;
+                return out;
+            }
+
+            decimal decimal::fromReal(const real& value, const int& digits)
+            {
+                if(value != value)
+                    return notANumber();
+                if(value == std::numeric_limits<real>::infinity() || value == -std::numeric_limits<real>::infinity())
+                    return infinity(value < 0);
+
+                // Use the shortest notation with at most 17 digits that reads back as the same real
+                char buffer[48];
+                for(int precision = 15; precision <= 17; ++precision)
+                {
+                    std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+                    if(std::strtod(buffer, 0) == value)
+                        break;
+                }
+                return parse(buffer, digits);
+            }
+
+            decimal decimal::parse(const string& str, const int& digits)
+            {
+                decimal out;
+                const size_t start = (!str.empty() && str[0] == '-') ? 1 : 0;
+
+                // Hexadecimal and octal numbers are integers, the base is determined like str2real() does
+                if(str.find("0x") == start || (str.find('0') == start && str[start + 1] != '.'))
+                {
+                    const bool hex = str.find("0x") == start;
+                    for(size_t pos = start + (hex ? 2 : 1); pos < str.size(); ++pos)
+                    {
+                        limb digit;
+                        if(str[pos] >= '0' && str[pos] <= (hex ? '9' : '7'))
+                            digit = str[pos] - '0';
+                        else if(hex && str[pos] >= 'a' && str[pos] <= 'f')
+                            digit = str[pos] - 'a' + 10;
+                        else if(hex && str[pos] >= 'A' && str[pos] <= 'F')
+                            digit = str[pos] - 'A' + 10;
+                        else
+                            continue;
+                        multiplySmall(out.mantissa, hex ? 16 : 8);
+                        magnitude digitMagnitude(digit != 0 ? 1 : 0, digit);
+                        addTo(out.mantissa, digitMagnitude);
+                    }
+                }
+                // Other numbers consist of the digits, possibly with a dot, and the exponent of the scientific notation
+                else
+                {
+                    string significand;
+                    long long fractionDigits = 0, power = 0;
+                    bool dot = false, inExponent = false, negativeExponent = false;
+                    for(size_t pos = start; pos < str.size(); ++pos)
+                    {
+                        const char c = str[pos];
+                        if(c == 'e' || c == 'E')
+                            inExponent = true;
+                        else if(inExponent && c == '-')
+                            negativeExponent = true;
+                        else if(c >= '0' && c <= '9')
+                        {
+                            if(inExponent)
+                                power = std::min(power * 10 + (c - '0'), 1LL << 60);
+                            else
+                            {
+                                significand += c;
+                                fractionDigits += dot ? 1 : 0;
+                            }
+                        }
+                        else if(c == '.' && !inExponent)
+                            dot = true;
+                    }
+
+                    // Split the digits into digits in base 10^9, from the end on
+                    for(size_t end = significand.size(); end > 0; end = end > 9 ? end - 9 : 0)
+                    {
+                        const size_t begin = end > 9 ? end - 9 : 0;
+                        out.mantissa.push_back(static_cast<limb>(std::strtoul(significand.substr(begin, end - begin).c_str(), 0, 10)));
+                    }
+                    out.normalize();
+                    out = out.scaled((negativeExponent ? -power : power) - fractionDigits);
+                }
+                out.negative = start == 1;
+                out.normalize();
+                out.roundTo(digits);
+                out.digits = digits;
+                return out;
+            }
+
+            decimal decimal::notANumber()
+            {
+                decimal out;
+                out.type = nan;
+                return out;
+            }
+
+            decimal decimal::infinity(const bool& negative)
+            {
+                decimal out;
+                out.type = infinite;
+                out.negative = negative;
+                return out;
+            }
+
+            int decimal::getDigits() const
+            { return digits; }
+
+            decimal decimal::withDigits(const int& newDigits) const
+            {
+                decimal out(*this);
+                out.roundTo(newDigits);
+                out.digits = newDigits;
+                return out;
+            }
+
+            bool decimal::isNaN() const
+            { return type == nan; }
+
+            bool decimal::isInfinite() const
+            { return type == infinite; }
+
+            bool decimal::isZero() const
+            { return type == finite && mantissa.empty(); }
+
+            bool decimal::isNegative() const
+            { return negative; }
+
+            bool decimal::isInteger() const
+            { return type == finite && exponent >= 0; }
+
+            long long decimal::topDigit() const
+            { return 9 * (exponent + static_cast<long long>(mantissa.size()) - 1) + digitCount(mantissa.back()) - 1; }
+
+            long long decimal::fractionDigits() const
+            {
+                if(type != finite || mantissa.empty() || exponent >= 0)
+                    return 0;
+                // The lowest limb isn't 0, its zeros at the end don't count
+                long long out = -9 * exponent;
+                for(limb rest = mantissa[0]; rest % 10 == 0; rest /= 10)
+                    --out;
+                return out;
+            }
+
+            real decimal::toReal() const
+            {
+                if(type == nan)
+                    return std::numeric_limits<real>::quiet_NaN();
+                if(type == infinite)
+                    return negative ? -std::numeric_limits<real>::infinity() : std::numeric_limits<real>::infinity();
+                if(mantissa.empty())
+                    return 0;
+
+                // Let strtod() round the digits, 40 digits are plenty as long as the digits that are left out are remembered by a 1
+                string text = digitString(mantissa);
+                long long power = topDigit() - static_cast<long long>(text.size()) + 1;
+                if(text.size() > 40)
+                {
+                    power += text.size() - 41;
+                    text.resize(40);
+                    text += '1';
+                }
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "e%lld", power);
+                const real magnitudeValue = std::strtod((text + buffer).c_str(), 0);
+                return negative ? -magnitudeValue : magnitudeValue;
+            }
+
+            integer decimal::toInteger() const
+            {
+                const integer invalid = std::numeric_limits<integer>::min();
+                if(type != finite)
+                    return invalid;
+                if(mantissa.empty())
+                    return 0;
+                if(topDigit() >= 19)
+                    return invalid;
+
+                // Add the digits in front of the dot, then round using the first digit after the dot
+                wide value = 0;
+                for(long long position = exponent + static_cast<long long>(mantissa.size()) - 1; position >= 0; --position)
+                    value = value * base + (position >= exponent ? mantissa[position - exponent] : 0);
+                if(exponent < 0 && -exponent <= static_cast<long long>(mantissa.size()) && mantissa[-exponent - 1] >= base / 2)
+                    ++value;
+
+                const wide largest = static_cast<wide>(std::numeric_limits<integer>::max()) + (negative ? 1 : 0);
+                if(value > largest)
+                    return invalid;
+                return negative ? static_cast<integer>(0 - value) : static_cast<integer>(value);
+            }
+
+            string decimal::toString(const realOutputType& outputType, const int& precision) const
+            {
+                if(type == nan)
+                    return "nan";
+                if(type == infinite)
+                    return negative ? "-inf" : "inf";
+
+                // Times are written as reals
+                if(outputType == outputType_time)
+                    return real2str(toReal(), outputType, precision);
+
+                // Integers in another base are written exactly
+                if(outputType == outputType_bin || outputType == outputType_oct || outputType == outputType_hex)
+                {
+                    const decimal rounded = round(*this);
+                    if(rounded.exponent + rounded.mantissa.size() > maxExactLimbs)
+                        throw overflowError(outputType == outputType_bin ? overflowError::bin : outputType == outputType_oct ? overflowError::oct : overflowError::hex);
+
+                    // The digits are split off in chunks that fit in a digit in base 10^9
+                    const unsigned int radix = outputType == outputType_bin ? 2 : outputType == outputType_oct ? 8 : 16;
+                    const unsigned int chunkDigits = outputType == outputType_bin ? 29 : outputType == outputType_oct ? 9 : 7;
+                    limb chunk = 1;
+                    for(unsigned int i = 0; i < chunkDigits; ++i)
+                        chunk *= radix;
+                    magnitude rest = rounded.mantissa.empty() ? magnitude() : shifted(rounded.mantissa, rounded.exponent);
+                    string out;
+                    while(!rest.empty())
+                    {
+                        limb part = divideSmall(rest, chunk);
+                        for(unsigned int i = 0; i < chunkDigits && (part != 0 || !rest.empty()); ++i, part /= radix)
+                            out.insert(out.begin(), "0123456789abcdef"[part % radix]);
+                    }
+                    if(out.empty())
+                        out = "0";
+                    const string prefix = outputType == outputType_oct ? "0" : outputType == outputType_hex ? "0x" : "";
+                    return (rounded.negative ? "-" : "") + prefix + out;
+                }
+
+                // Otherwise the digits are rounded as a string, top is the position of the first digit (0 is in front of the dot)
+                const int wantedPrecision = precision >= 0 ? precision : std::max(digits > 0 ? digits : static_cast<int>(digitString(mantissa).size()), 1);
+                string significand = digitString(mantissa);
+                long long top = mantissa.empty() ? 0 : topDigit();
+                bool scientific = outputType == outputType_scientific;
+                long long decimals;
+                if(outputType == outputType_auto)
+                {
+                    // Like printf's %g: the precision is the number of significant digits, and the scientific notation is used for
+                    // numbers that are small or have more digits in front of the dot than the precision
+                    const int significantDigits = std::max(wantedPrecision, 1);
+                    roundDigitString(significand, significantDigits, top);
+                    scientific = !significand.empty() && (top < -4 || top >= significantDigits);
+                    decimals = scientific ? significantDigits - 1 : significantDigits - 1 - top;
+                }
+                else if(scientific)
+                {
+                    roundDigitString(significand, wantedPrecision + 1, top);
+                    decimals = wantedPrecision;
+                }
+                else
+                {
+                    roundDigitString(significand, top + 1 + wantedPrecision, top);
+                    decimals = wantedPrecision;
+                }
+                if(significand.empty())
+                    return "0";
+
+                // Write the digits in front of the dot, then the ones after it without the zeros at the end
+                const long long first = scientific ? 0 : top;
+                string out = negative ? "-" : "";
+                string fraction;
+                if(first < 0)
+                    out += '0';
+                for(long long position = first; position >= 0; --position)
+                {
+                    const long long index = top - (scientific ? top : 0) - position;
+                    out += index >= 0 && index < static_cast<long long>(significand.size()) ? significand[index] : '0';
+                }
+                for(long long position = -1; position >= -decimals; --position)
+                {
+                    const long long index = top - (scientific ? top : 0) - position;
+                    if(index >= static_cast<long long>(significand.size()))
+                        break;
+                    fraction += index >= 0 ? significand[index] : '0';
+                }
+                fraction.erase(fraction.find_last_not_of('0') + 1);
+                if(!fraction.empty())
+                    out += '.' + fraction;
+                return scientific ? out + exponentString(top) : out;
+            }
+
+            decimal decimal::operator-() const
+            {
+                decimal out(*this);
+                if(type != nan && !isZero())
+                    out.negative = !negative;
+                return out;
+            }
+
+            decimal decimal::operator+(const decimal& other) const
+            { return add(*this, other, false, digitsWith(other)); }
+
+            decimal decimal::operator-(const decimal& other) const
+            { return add(*this, other, true, digitsWith(other)); }
+
+            decimal decimal::operator*(const decimal& other) const
+            {
+                const int precision = digitsWith(other);
+                if(type == nan || other.type == nan || (type == infinite && other.isZero()) || (isZero() && other.type == infinite))
+                    return notANumber();
+                if(type == infinite || other.type == infinite)
+                    return infinity(negative != other.negative);
+
+                decimal out;
+                out.mantissa = multiply(mantissa, other.mantissa);
+                out.exponent = exponent + other.exponent;
+                out.negative = negative != other.negative;
+                out.normalize();
+                out.roundTo(precision);
+                out.digits = precision;
+                return out;
+            }
+
+            decimal decimal::operator/(const decimal& other) const
+            {
+                const int precision = digitsWith(other);
+                return divide(*this, other, precision, precision == 0);
+            }
+
+            decimal& decimal::operator+=(const decimal& other)
+            { return *this = *this + other; }
+
+            decimal& decimal::operator-=(const decimal& other)
+            { return *this = *this - other; }
+
+            decimal& decimal::operator*=(const decimal& other)
+            { return *this = *this * other; }
+
+            decimal& decimal::operator/=(const decimal& other)
+            { return *this = *this / other; }
+
+            bool decimal::operator==(const decimal& other) const
+            {
+                if(type == nan || other.type == nan)
+                    return false;
+                return negative == other.negative && compareMagnitudes(*this, other) == 0;
+            }
+
+            bool decimal::operator!=(const decimal& other) const
+            { return !(*this == other); }
+
+            bool decimal::operator<(const decimal& other) const
+            {
+                if(type == nan || other.type == nan)
+                    return false;
+                if(negative != other.negative)
+                    return negative;
+                const int comparison = compareMagnitudes(*this, other);
+                return negative ? comparison > 0 : comparison < 0;
+            }
+
+            bool decimal::operator>(const decimal& other) const
+            { return other < *this; }
+
+            bool decimal::operator<=(const decimal& other) const
+            { return *this < other || *this == other; }
+
+            bool decimal::operator>=(const decimal& other) const
+            { return other < *this || *this == other; }
+
+            decimal decimal::abs(const decimal& x)
+            {
+                decimal out(x);
+                if(out.type != nan)
+                    out.negative = false;
+                return out;
+            }
+
+            decimal decimal::floor(const decimal& x)
+            {
+                if(x.type != finite || x.isInteger())
+                    return x;
+
+                // Drop the digits after the dot, numbers below 0 are rounded down
+                decimal out(x);
+                const size_t fractionLimbs = static_cast<size_t>(-x.exponent);
+                out.mantissa.erase(out.mantissa.begin(), out.mantissa.begin() + std::min(fractionLimbs, out.mantissa.size()));
+                out.exponent = 0;
+                if(out.negative)
+                {
+                    const magnitude one(1, 1);
+                    addTo(out.mantissa, one);
+                }
+                out.normalize();
+                out.roundTo(out.digits);
+                return out;
+            }
+
+            decimal decimal::ceil(const decimal& x)
+            { return -floor(-x); }
+
+            decimal decimal::round(const decimal& x)
+            {
+                if(x.type != finite || x.isInteger())
+                    return x;
+                decimal half;
+                half.mantissa.assign(1, base / 2);
+                half.exponent = -1;
+                return floor(add(x, half, false, 0)).withDigits(x.digits);
+            }
+
+            decimal decimal::fmod(const decimal& a, const decimal& b)
+            {
+                const int precision = a.digitsWith(b);
+                if(a.type != finite || b.type == nan || b.isZero())
+                    return notANumber();
+                if(b.type == infinite || a.isZero())
+                    return a.withDigits(precision);
+
+                // Write both as integers, the remainder of those is exact
+                const long long lowest = std::min(a.exponent, b.exponent);
+                if(static_cast<unsigned long long>(a.exponent - lowest) + a.mantissa.size() > maxExactLimbs ||
+                   static_cast<unsigned long long>(b.exponent - lowest) + b.mantissa.size() > maxExactLimbs)
+                    return notANumber();
+                magnitude quotient;
+                decimal out;
+                divideMagnitudes(shifted(a.mantissa, a.exponent - lowest), shifted(b.mantissa, b.exponent - lowest), quotient, out.mantissa);
+                out.exponent = lowest;
+                out.negative = a.negative;
+                out.normalize();
+                out.roundTo(precision);
+                out.digits = precision;
+                return out;
+            }
+
+            decimal decimal::sqrt(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type == nan || (x.negative && !x.isZero()))
+                    return notANumber();
+                if(x.type == infinite || x.isZero())
+                    return x.withDigits(precision);
+
+                // Scale x by an even power of 10 to m in [1, 100), the root is the root of m scaled by half that power
+                const int working = precision + guardDigits;
+                const long long top = x.topDigit();
+                const long long halfPower = top >= 0 ? top / 2 : -((1 - top) / 2);
+                const decimal m = x.scaled(-2 * halfPower).withDigits(working);
+
+                // Newton's method doubles the number of correct digits every step, starting with those of a real
+                const decimal half = fromReal(0.5, working);
+                decimal root = fromReal(std::sqrt(m.toReal()), working);
+                for(int correct = 15; correct < 2 * working; correct *= 2)
+                    root = (root + m / root) * half;
+                return root.scaled(halfPower).withDigits(precision);
+            }
+
+            decimal decimal::exp(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type == nan)
+                    return x;
+                if(x.type == infinite)
+                    return x.negative ? decimal().withDigits(precision) : x;
+                if(x.isZero())
+                    return fromInteger(1, precision);
+
+                // Results that don't fit in the exponent are 0 or infinite
+                const real estimate = x.toReal();
+                if(std::abs(estimate) > 1e15)
+                    return x.negative ? decimal().withDigits(precision) : infinity();
+
+                // exp(x) = 10^n * exp(r) with r = x - n*ln(10) in [-1.2, 1.2]
+                const integer n = static_cast<integer>(std::floor(estimate / 2.302585092994045684 + 0.5));
+                const int nDigits = digitCount(n);
+                const int halvings = static_cast<int>(std::sqrt(static_cast<double>(precision))) + 2;
+                const int working = precision + guardDigits + halvings * 3 / 10;
+                decimal r = (x.withDigits(working + nDigits) - fromInteger(n, 0) * ln10(working + nDigits)).withDigits(working);
+
+                // Halve r a few times to make the Taylor series converge quickly, the result is squared that many times
+                const decimal half = fromReal(0.5, working);
+                for(int i = 0; i < halvings; ++i)
+                    r *= half;
+                decimal sum = fromInteger(1, working), term = sum;
+                for(integer i = 1; !term.isZero() && term.topDigit() >= -working - 2; ++i)
+                {
+                    term = term * r / fromInteger(i);
+                    sum += term;
+                }
+                for(int i = 0; i < halvings; ++i)
+                    sum *= sum;
+                return sum.scaled(n).withDigits(precision);
+            }
+
+            decimal decimal::log(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type == nan || (x.negative && !x.isZero()))
+                    return notANumber();
+                if(x.type == infinite)
+                    return x;
+                if(x.isZero())
+                    return infinity(true);
+
+                // Numbers close to 1 lose digits in the sum below, so they're calculated more precisely
+                const long long top = x.topDigit();
+                int working = precision + guardDigits;
+                if(top >= -1 && top <= 0)
+                {
+                    const decimal difference = add(x, fromInteger(1), true, 0);
+                    if(difference.isZero())
+                        return decimal().withDigits(precision);
+                    working += static_cast<int>(std::max(0LL, -difference.topDigit()));
+                }
+
+                // ln(x) = top*ln(10) + j*ln(2) + ln(m), with m = x/(10^top*2^j) in [0.7, 1.42]
+                // ln(m) = 2*atanh(z) with z = (m-1)/(m+1), |z| < 0.18, which is summed as a series
+                const int constantDigits = working + digitCount(static_cast<integer>(top));
+                decimal m = x.scaled(-top).withDigits(working);
+                const int j = static_cast<int>(std::floor(std::log(m.toReal()) / std::log(2.0) + 0.5));
+                m /= fromInteger(1 << j);
+                const decimal one = fromInteger(1, working);
+                const decimal z = (m - one) / (m + one);
+                const decimal z2 = z * z;
+                decimal sum = z, power = z;
+                for(integer i = 3; !power.isZero() && power.topDigit() >= z.topDigit() - working - 2; i += 2)
+                {
+                    power *= z2;
+                    sum += power / fromInteger(i);
+                }
+                decimal out = sum * fromInteger(2);
+                if(j != 0)
+                    out += fromInteger(j) * ln2(constantDigits);
+                if(top != 0)
+                    out += fromInteger(top) * ln10(constantDigits);
+                return out.withDigits(precision);
+            }
+
+            decimal decimal::log10(const decimal& x)
+            {
+                // Powers of 10 give an exact integer
+                const int precision = x.functionDigits();
+                if(x.type == finite && !x.negative && x.mantissa.size() == 1 && std::find(powersOf10, powersOf10 + 9, x.mantissa[0]) != powersOf10 + 9)
+                    return fromInteger(x.topDigit(), precision);
+                const int working = precision + guardDigits;
+                return (log(x.withDigits(working)) / ln10(working)).withDigits(precision);
+            }
+
+            decimal decimal::pow(const decimal& base, const decimal& exponent)
+            {
+                const int precision = base.digitsWith(exponent);
+                const int functionPrecision = precision > 0 ? precision : defaultDigits;
+                if(exponent.isZero())
+                    return fromInteger(1, precision);
+                if(base.type == nan || exponent.type == nan)
+                    return notANumber();
+
+                // Integer powers are calculated by repeated squaring, they're exact for exact numbers
+                if(exponent.isInteger() && exponent.topDigit() < 18 && base.type == finite)
+                {
+                    const integer n = exponent.toInteger();
+                    if(base.isZero())
+                        return n > 0 ? base.withDigits(precision) : infinity();
+                    const int working = precision > 0 ? precision + guardDigits + digitCount(n) : 0;
+                    decimal factor = base.withDigits(working), out = fromInteger(1, working);
+                    for(wide rest = n < 0 ? 0 - static_cast<wide>(n) : static_cast<wide>(n); rest != 0; rest /= 2)
+                    {
+                        if(rest % 2 == 1)
+                            out *= factor;
+                        if(rest > 1)
+                            factor *= factor;
+                    }
+                    if(n < 0)
+                        out = divide(fromInteger(1), out, functionPrecision + guardDigits, false);
+                    return out.withDigits(n < 0 ? functionPrecision : precision);
+                }
+
+                // The square root has its own function
+                if(exponent == fromReal(0.5, 0))
+                    return sqrt(base.withDigits(functionPrecision));
+
+                // The other cases that aren't base^exponent = exp(exponent*ln(base)) are left to the real version
+                if(base.type != finite || exponent.type != finite || base.isZero() || base.negative)
+                    return fromReal(std::pow(base.toReal(), exponent.toReal()), precision);
+
+                // The digits in front of the dot of exponent*ln(base) are lost in the exponential function, so more digits are needed
+                const real estimate = std::abs(exponent.toReal() * (static_cast<real>(base.topDigit()) + 1) * 2.302585092994046);
+                const int working = functionPrecision + guardDigits + (estimate >= 1 ? static_cast<int>(std::log10(estimate)) + 1 : 0);
+                return exp(exponent.withDigits(working) * log(base.withDigits(working))).withDigits(functionPrecision);
+            }
+
+            decimal decimal::sin(const decimal& x)
+            { return goniometric(x, 's', false); }
+
+            decimal decimal::cos(const decimal& x)
+            { return goniometric(x, 'c', false); }
+
+            decimal decimal::tan(const decimal& x)
+            { return goniometric(x, 't', false); }
+
+            decimal decimal::sinDegrees(const decimal& x)
+            { return goniometric(x, 's', true); }
+
+            decimal decimal::cosDegrees(const decimal& x)
+            { return goniometric(x, 'c', true); }
+
+            decimal decimal::tanDegrees(const decimal& x)
+            { return goniometric(x, 't', true); }
+
+            decimal decimal::asin(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type != finite || compareMagnitudes(x, fromInteger(1)) > 0)
+                    return notANumber();
+                if(x.isZero())
+                    return x.withDigits(precision);
+
+                // asin(x) = atan(x / sqrt(1-x^2)), 1-x^2 loses digits if x is close to 1 or -1
+                const decimal difference = add(fromInteger(1), abs(x), true, 0);
+                if(difference.isZero())
+                {
+                    const decimal halfPi = pi(precision + guardDigits) * fromReal(0.5, 0);
+                    return (x.negative ? -halfPi : halfPi).withDigits(precision);
+                }
+                const int working = precision + guardDigits + static_cast<int>(std::max(0LL, -difference.topDigit()));
+                const decimal y = x.withDigits(working);
+                return arcTangent(y / sqrt(fromInteger(1, working) - y * y), working).withDigits(precision);
+            }
+
+            decimal decimal::acos(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type != finite || compareMagnitudes(x, fromInteger(1)) > 0)
+                    return notANumber();
+                const int working = precision + guardDigits;
+                return (pi(working) * fromReal(0.5, 0) - asin(x.withDigits(working))).withDigits(precision);
+            }
+
+            decimal decimal::atan(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type == nan)
+                    return x;
+                if(x.type == infinite)
+                {
+                    const decimal halfPi = pi(precision) * fromReal(0.5, 0);
+                    return x.negative ? -halfPi : halfPi;
+                }
+                return arcTangent(x.withDigits(precision + guardDigits), precision + guardDigits).withDigits(precision);
+            }
+
+            decimal decimal::sinh(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type != finite || x.isZero())
+                    return x.withDigits(precision);
+
+                // exp(x) - exp(-x) loses as many digits as x has zeros after the dot
+                const int working = precision + guardDigits + static_cast<int>(std::max(0LL, -x.topDigit()));
+                const decimal ex = exp(x.withDigits(working));
+                return ((ex - fromInteger(1, working) / ex) * fromReal(0.5, 0)).withDigits(precision);
+            }
+
+            decimal decimal::cosh(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type != finite)
+                    return x.type == nan ? x : abs(x);
+                const int working = precision + guardDigits;
+                const decimal ex = exp(x.withDigits(working));
+                return ((ex + fromInteger(1, working) / ex) * fromReal(0.5, 0)).withDigits(precision);
+            }
+
+            decimal decimal::tanh(const decimal& x)
+            {
+                const int precision = x.functionDigits();
+                if(x.type == nan || x.isZero())
+                    return x.withDigits(precision);
+
+                // For large x the result is 1 or -1 up to the last digit
+                if(x.type == infinite || abs(x) > fromInteger(precision + guardDigits))
+                    return fromInteger(x.negative ? -1 : 1, precision);
+                const int working = precision + guardDigits + static_cast<int>(std::max(0LL, -x.topDigit()));
+                const decimal e2 = exp(x.withDigits(working) * fromInteger(2));
+                const decimal one = fromInteger(1, working);
+                return ((e2 - one) / (e2 + one)).withDigits(precision);
+            }
+
+            decimal decimal::pi(const int& digits)
+            {
+                // pi = 16*atan(1/5) - 4*atan(1/239)
+                constantCache& cache = constants();
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                if(cache.pi.digits < digits)
+                {
+                    const int working = digits + guardDigits;
+                    cache.pi = atanOfInverse(5, working) * fromInteger(16) - atanOfInverse(239, working) * fromInteger(4);
+                }
+                return cache.pi.withDigits(digits);
+            }
+
+            decimal decimal::e(const int& digits)
+            { return exp(fromInteger(1, digits)); }
+
+            decimal decimal::ln2(const int& digits)
+            {
+                // ln(2) = 2*atanh(1/3)
+                constantCache& cache = constants();
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                if(cache.ln2.digits < digits)
+                    cache.ln2 = atanhOfInverse(3, digits + guardDigits);
+                return cache.ln2.withDigits(digits);
+            }
+
+            decimal decimal::ln10(const int& digits)
+            {
+                // ln(10) = 3*ln(2) + ln(1.25) = 6*atanh(1/3) + 2*atanh(1/9)
+                constantCache& cache = constants();
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                if(cache.ln10.digits < digits)
+                {
+                    const int working = digits + guardDigits;
+                    cache.ln10 = atanhOfInverse(3, working) * fromInteger(3) + atanhOfInverse(9, working);
+                }
+                return cache.ln10.withDigits(digits);
+            }
+
+        // Private:
+            void decimal::normalize()
+            {
+                if(type != finite)
+                {
+                    mantissa.clear();
+                    exponent = 0;
+                    negative = negative && type == infinite;
+                    return;
+                }
+                trim(mantissa);
+                size_t zeros = 0;
+                while(zeros < mantissa.size() && mantissa[zeros] == 0)
+                    ++zeros;
+                mantissa.erase(mantissa.begin(), mantissa.begin() + zeros);
+                exponent += zeros;
+                if(mantissa.empty())
+                {
+                    exponent = 0;
+                    negative = false;
+                }
+            }
+
+            void decimal::roundTo(const int& newDigits)
+            {
+                if(newDigits <= 0 || type != finite || mantissa.empty())
+                    return;
+                const long long total = 9 * static_cast<long long>(mantissa.size() - 1) + digitCount(mantissa.back());
+                if(total <= newDigits)
+                    return;
+
+                // Drop the digits after the last one that's kept, halfway cases are rounded away from zero so only the first
+                // digit that's dropped matters
+                const long long drop = total - newDigits;
+                const size_t dropLimbs = static_cast<size_t>(drop / 9);
+                const int dropDigits = static_cast<int>(drop % 9);
+                bool up;
+                limb increment = 1;
+                if(dropDigits > 0)
+                {
+                    increment = powersOf10[dropDigits];
+                    const limb rest = mantissa[dropLimbs] % increment;
+                    up = rest >= increment / 2;
+                    mantissa[dropLimbs] -= rest;
+                }
+                else
+                    up = mantissa[dropLimbs - 1] >= base / 2;
+                mantissa.erase(mantissa.begin(), mantissa.begin() + dropLimbs);
+                exponent += dropLimbs;
+                if(up)
+                {
+                    const magnitude incrementMagnitude(1, increment);
+                    addTo(mantissa, incrementMagnitude);
+                }
+                normalize();
+            }
+
+            decimal decimal::scaled(const long long& power) const
+            {
+                if(type != finite || mantissa.empty())
+                    return *this;
+                long long limbs = power / 9, rest = power % 9;
+                if(rest < 0)
+                {
+                    rest += 9;
+                    --limbs;
+                }
+                decimal out(*this);
+                multiplySmall(out.mantissa, powersOf10[rest]);
+                out.exponent += limbs;
+                out.normalize();
+                return out;
+            }
+
+            int decimal::digitsWith(const decimal& other) const
+            { return std::max(digits, other.digits); }
+
+            int decimal::functionDigits() const
+            { return digits > 0 ? digits : defaultDigits; }
+
+            decimal decimal::add(const decimal& a, const decimal& b, const bool& negateB, const int& precision)
+            {
+                const bool negativeB = b.negative != negateB;
+                if(a.type == nan || b.type == nan)
+                    return notANumber();
+                if(a.type == infinite && b.type == infinite)
+                    return a.negative == negativeB ? a : notANumber();
+                if(a.type == infinite)
+                    return a;
+                if(b.type == infinite)
+                    return infinity(negativeB);
+
+                // Adding 0 only rounds the other number
+                decimal out;
+                if(b.isZero())
+                    out = a;
+                else if(a.isZero())
+                {
+                    out = b;
+                    out.negative = negativeB;
+                }
+                else
+                {
+                    // A number that's completely below the digits that are kept can only change the rounding, which only depends on the
+                    // first digit that's dropped. So it can be replaced by a single small digit, which avoids shifting huge mantissas.
+                    decimal first(a), second(b);
+                    second.negative = negativeB;
+                    if(precision > 0)
+                    {
+                        decimal& larger = compareMagnitudes(first, second) >= 0 ? first : second;
+                        decimal& smaller = &larger == &first ? second : first;
+                        const long long largerTop = larger.exponent + static_cast<long long>(larger.mantissa.size()) - 1;
+                        const long long lowest = std::min(larger.exponent, largerTop - precision / 9 - 3);
+                        if(smaller.exponent + static_cast<long long>(smaller.mantissa.size()) - 1 < lowest)
+                        {
+                            smaller.mantissa.assign(1, 1);
+                            smaller.exponent = lowest - 1;
+                        }
+                    }
+
+                    // Align the mantissas and add or subtract them
+                    const long long lowest = std::min(first.exponent, second.exponent);
+                    magnitude x = shifted(first.mantissa, first.exponent - lowest);
+                    magnitude y = shifted(second.mantissa, second.exponent - lowest);
+                    trim(x);
+                    trim(y);
+                    out.exponent = lowest;
+                    if(first.negative == second.negative)
+                    {
+                        addTo(x, y);
+                        out.mantissa.swap(x);
+                        out.negative = first.negative;
+                    }
+                    else if(compare(x, y) >= 0)
+                    {
+                        subtractFrom(x, y);
+                        out.mantissa.swap(x);
+                        out.negative = first.negative;
+                    }
+                    else
+                    {
+                        subtractFrom(y, x);
+                        out.mantissa.swap(y);
+                        out.negative = second.negative;
+                    }
+                }
+                out.normalize();
+                out.roundTo(precision);
+                out.digits = precision;
+                return out;
+            }
+
+            decimal decimal::divide(const decimal& a, const decimal& b, const int& precision, const bool& exact)
+            {
+                const int quotientDigits = precision > 0 ? precision : defaultDigits;
+                if(a.type == nan || b.type == nan || (a.type == infinite && b.type == infinite) || (a.isZero() && b.isZero()))
+                    return notANumber();
+                if(a.type == infinite || b.isZero())
+                    return infinity(a.negative != b.negative);
+                if(b.type == infinite || a.isZero())
+                    return decimal().withDigits(precision);
+
+                // Shift the dividend such that the quotient has more digits than needed, the remainder doesn't matter for the
+                // rounding because only the first digit that's dropped does
+                const long long wantedLimbs = quotientDigits / 9 + 2;
+                const long long shift = std::max(0LL, wantedLimbs + static_cast<long long>(b.mantissa.size()) - static_cast<long long>(a.mantissa.size()));
+                decimal out;
+                magnitude remainder;
+                divideMagnitudes(shifted(a.mantissa, shift), b.mantissa, out.mantissa, remainder);
+                out.exponent = a.exponent - shift - b.exponent;
+                out.negative = a.negative != b.negative;
+                out.normalize();
+                if(exact && remainder.empty())
+                    return out;
+                out.roundTo(quotientDigits);
+                out.digits = quotientDigits;
+                return out;
+            }
+
+            int decimal::compareMagnitudes(const decimal& a, const decimal& b)
+            {
+                if(a.type == infinite || b.type == infinite)
+                    return (a.type == infinite ? 1 : 0) - (b.type == infinite ? 1 : 0);
+                if(a.mantissa.empty() || b.mantissa.empty())
+                    return (a.mantissa.empty() ? 0 : 1) - (b.mantissa.empty() ? 0 : 1);
+
+                // Compare the position of the most significant digit, then the digits from there on
+                const long long topA = a.exponent + static_cast<long long>(a.mantissa.size());
+                const long long topB = b.exponent + static_cast<long long>(b.mantissa.size());
+                if(topA != topB)
+                    return topA < topB ? -1 : 1;
+                for(size_t i = 1; i <= std::max(a.mantissa.size(), b.mantissa.size()); ++i)
+                {
+                    const limb x = i <= a.mantissa.size() ? a.mantissa[a.mantissa.size() - i] : 0;
+                    const limb y = i <= b.mantissa.size() ? b.mantissa[b.mantissa.size() - i] : 0;
+                    if(x != y)
+                        return x < y ? -1 : 1;
+                }
+                return 0;
+            }
+
+            void decimal::sinCos(const decimal& x, const int& working, decimal* sine, decimal* cosine)
+            {
+                // The Taylor series of the sine, the cosine follows from it since |x| <= pi/4
+                decimal sum = x.withDigits(working);
+                if(!x.isZero())
+                {
+                    const decimal x2 = sum * sum;
+                    decimal term = sum;
+                    for(integer i = 2; !term.isZero() && term.topDigit() >= x.topDigit() - working - 2; i += 2)
+                    {
+                        term = -(term * x2) / fromInteger(i * (i + 1));
+                        sum += term;
+                    }
+                }
+                if(sine != 0)
+                    *sine = sum;
+                if(cosine != 0)
+                    *cosine = x.isZero() ? fromInteger(1, working) : sqrt(fromInteger(1, working) - sum * sum);
+            }
+
+            decimal decimal::sinOfQuadrant(const decimal& rest, const long long& quadrant, const bool& cosine, const int& working)
+            {
+                // sin(q*pi/2 + r) is sin(r), cos(r), -sin(r) or -cos(r) for q = 0, 1, 2, 3, and the cosine is a quadrant further
+                const long long q = (quadrant + (cosine ? 1 : 0)) % 4;
+                decimal out;
+                if(q % 2 == 0)
+                    sinCos(rest, working, &out, 0);
+                else
+                    sinCos(rest, working, 0, &out);
+                return q >= 2 ? -out : out;
+            }
+
+            decimal decimal::goniometric(const decimal& x, const char& function, const bool& degrees)
+            {
+                const int precision = x.functionDigits();
+                if(x.type != finite)
+                    return notANumber();
+                if(!x.isZero() && x.topDigit() >= maxReductionDigits)
+                {
+                    const real y = degrees ? x.toReal() * (3.14159265358979323846 / 180) : x.toReal();
+                    return fromReal(function == 's' ? std::sin(y) : function == 'c' ? std::cos(y) : std::tan(y), precision);
+                }
+
+                // x = q*pi/2 + r with |r| <= pi/4, the digits in front of the dot of x are needed for the remainder as well
+                // In degrees x = q*90 + r, which is exact, so e.g. sin(180) is exactly 0
+                const int integerDigits = static_cast<int>(x.isZero() ? 0 : std::max(0LL, x.topDigit() + 1));
+                int working = precision + guardDigits + integerDigits;
+                decimal q, rest;
+                for(int attempt = 0; attempt < 2; ++attempt)
+                {
+                    if(degrees)
+                    {
+                        q = round(divide(x, fromInteger(90), working, false)).withDigits(0);
+                        rest = add(x, q * fromInteger(90), true, 0);
+                        rest = rest.withDigits(working) * pi(working) / fromInteger(180);
+                        break;
+                    }
+                    const decimal halfPi = pi(working) * fromReal(0.5, 0);
+                    q = round(x.withDigits(working) / halfPi).withDigits(0);
+                    rest = (x.withDigits(working) - q * halfPi).withDigits(working);
+
+                    // If x is close to a multiple of pi/2 the remainder has lost digits, then it's calculated once more with more digits
+                    if(q.isZero() || rest.isZero())
+                        break;
+                    const long long correctDigits = working - integerDigits + rest.topDigit();
+                    if(correctDigits >= precision + guardDigits / 2)
+                        break;
+                    working += static_cast<int>(precision + guardDigits - correctDigits);
+                }
+                const long long quadrant = (fmod(q, fromInteger(4)).toInteger() + 4) % 4;
+
+                decimal out;
+                if(function == 's')
+                    out = sinOfQuadrant(rest, quadrant, false, working);
+                else if(function == 'c')
+                    out = sinOfQuadrant(rest, quadrant, true, working);
+                else
+                    out = divide(sinOfQuadrant(rest, quadrant, false, working), sinOfQuadrant(rest, quadrant, true, working), working, false);
+                return out.withDigits(precision);
+            }
+
+            decimal decimal::arcTangent(const decimal& x, const int& working)
+            {
+                if(x.isZero())
+                    return x;
+                if(x.negative)
+                    return -arcTangent(-x, working);
+
+                // atan(x) = pi/2 - atan(1/x) for x > 1
+                const decimal one = fromInteger(1, working);
+                if(x > one)
+                    return pi(working) * fromReal(0.5, 0) - arcTangent(one / x, working);
+
+                // atan(x) = 2*atan(x / (1 + sqrt(1+x^2))), which is applied 3 times before summing the series
+                decimal y = x.withDigits(working);
+                for(int i = 0; i < 3; ++i)
+                    y = y / (one + sqrt(one + y * y));
+                const decimal y2 = y * y;
+                decimal sum = y, power = y;
+                for(integer i = 3; !power.isZero() && power.topDigit() >= y.topDigit() - working - 2; i += 2)
+                {
+                    power = -(power * y2);
+                    sum += power / fromInteger(i);
+                }
+                return sum * fromInteger(8);
+            }
+
+            decimal decimal::atanhOfInverse(const limb& n, const int& working)
+            {
+                // 2*atanh(1/n) = 2 * sum 1/((2k+1)*n^(2k+1))
+                const decimal square = fromInteger(static_cast<integer>(n) * n);
+                decimal power = fromInteger(1, working) / fromInteger(n), sum = power;
+                for(integer i = 3; !power.isZero() && power.topDigit() >= -working - 2; i += 2)
+                {
+                    power /= square;
+                    sum += power / fromInteger(i);
+                }
+                return sum * fromInteger(2);
+            }
+
+            decimal decimal::atanOfInverse(const limb& n, const int& working)
+            {
+                // atan(1/n) = sum (-1)^k/((2k+1)*n^(2k+1))
+                const decimal square = fromInteger(static_cast<integer>(n) * n);
+                decimal power = fromInteger(1, working) / fromInteger(n), sum = power;
+                for(integer i = 3; !power.isZero() && power.topDigit() >= -working - 2; i += 2)
+                {
+                    power = -(power / square);
+                    sum += power / fromInteger(i);
+                }
+                return sum;
+            }
+}
@@ -0,0 +1,177 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <vector>
+#include "types.h"
+
+namespace calc
+{
+    // An arbitrary precision decimal floating point number
+    // The value is a sign, a mantissa of digits in base 10^9 and an exponent counting those digits. Every number knows
+    // its precision, the number of significant decimal digits it's rounded to, and the result of an operation is rounded
+    // to the largest precision of its operands (halfway cases are rounded away from zero, like money is).
+    // A precision of 0 means the number is exact, operations on exact numbers are exact too, except for divisions that
+    // don't end and the functions below, which use defaultDigits instead.
+    // Multiplications of large numbers use the Karatsuba algorithm. The functions are calculated with a few more digits than
+    // the precision, so they're correct to the last digit in nearly all cases.
+    class decimal
+    {
+        public:
+            // The precision that's used for numbers of which the precision isn't given
+            static const int defaultDigits = 50;
+
+            // Constructor, creates an exact 0
+            decimal();
+            // Constructor, creates an exact integer
+            explicit decimal(const int& value);
+
+            // Create a number from an integer, rounded to the given number of digits
+            static decimal fromInteger(const integer& value, const int& digits = 0);
+            // Create a number from a real, using the shortest decimal representation that reads back as the same real
+            static decimal fromReal(const real& value, const int& digits = defaultDigits);
+            // Read a number as written in an expression, e.g. 1.5e-3, 0x1F or 017 (see str2real()), rounded to the given number of digits
+            // Characters that don't belong in a number are skipped, the compiler checks the literals already
+            static decimal parse(const string& str, const int& digits = defaultDigits);
+            // Create NaN or infinity
+            static decimal notANumber();
+            static decimal infinity(const bool& negative = false);
+
+            // Get the precision of this number, 0 if it's exact
+            int getDigits() const;
+            // Returns a copy of this number rounded to the given number of digits, 0 makes it exact without changing its value
+            decimal withDigits(const int& digits) const;
+
+            bool isNaN() const;
+            bool isInfinite() const;
+            bool isZero() const;
+            bool isNegative() const;
+            // Returns true if the number is finite and has no fractional part
+            bool isInteger() const;
+            // Get the position of the most significant digit of a finite number that isn't 0, 0 for the digit in front of the dot
+            long long topDigit() const;
+            // Get the number of digits behind the dot of a finite number, 0 for integers
+            long long fractionDigits() const;
+
+            // Convert to the nearest real
+            real toReal() const;
+            // Round to the nearest integer, halfway cases away from zero
+            // Numbers that don't fit (and NaN) become the smallest integer, like the conversion of a real does on x86
+            integer toInteger() const;
+            // Write the number in the given format, like real2str() does for reals
+            // A negative precision writes all digits of the precision of the number
+            string toString(const realOutputType& outputType = outputType_auto, const int& precision = -1) const;
+
+            // Arithmetic:
+            decimal operator-() const;
+            decimal operator+(const decimal& other) const;
+            decimal operator-(const decimal& other) const;
+            decimal operator*(const decimal& other) const;
+            decimal operator/(const decimal& other) const;
+            decimal& operator+=(const decimal& other);
+            decimal& operator-=(const decimal& other);
+            decimal& operator*=(const decimal& other);
+            decimal& operator/=(const decimal& other);
+
+            // Comparison, NaN isn't equal to anything
+            bool operator==(const decimal& other) const;
+            bool operator!=(const decimal& other) const;
+            bool operator<(const decimal& other) const;
+            bool operator>(const decimal& other) const;
+            bool operator<=(const decimal& other) const;
+            bool operator>=(const decimal& other) const;
+
+            // Functions, like those of <cmath>:
+            static decimal abs(const decimal& x);
+            static decimal floor(const decimal& x);
+            static decimal ceil(const decimal& x);
+            // Rounds to the nearest integer, halfway cases are rounded up (like mathFunctions::round())
+            static decimal round(const decimal& x);
+            // The remainder of a/b, which has the sign of a
+            static decimal fmod(const decimal& a, const decimal& b);
+            static decimal sqrt(const decimal& x);
+            static decimal exp(const decimal& x);
+            static decimal log(const decimal& x);
+            static decimal log10(const decimal& x);
+            static decimal pow(const decimal& base, const decimal& exponent);
+            static decimal sin(const decimal& x);
+            static decimal cos(const decimal& x);
+            static decimal tan(const decimal& x);
+            static decimal asin(const decimal& x);
+            static decimal acos(const decimal& x);
+            static decimal atan(const decimal& x);
+            static decimal sinh(const decimal& x);
+            static decimal cosh(const decimal& x);
+            static decimal tanh(const decimal& x);
+            // The same goniometric functions for angles in degrees, which are reduced exactly
+            static decimal sinDegrees(const decimal& x);
+            static decimal cosDegrees(const decimal& x);
+            static decimal tanDegrees(const decimal& x);
+
+            // Constants, with the given number of digits
+            static decimal pi(const int& digits);
+            static decimal e(const int& digits);
+            static decimal ln2(const int& digits);
+            static decimal ln10(const int& digits);
+
+        private:
+            typedef unsigned int limb;
+            typedef std::vector<limb> magnitude;
+            enum kind {finite, nan, infinite};
+            static const limb base = 1000000000;
+
+            // Remove the zeros at both ends of the mantissa, and make 0 positive
+            void normalize();
+            // Round the mantissa to the given number of significant digits, nothing happens for 0 digits
+            void roundTo(const int& digits);
+            // Multiply by 10^power exactly
+            decimal scaled(const long long& power) const;
+            // The precision of an operation on this number and other
+            int digitsWith(const decimal& other) const;
+            // The precision of a function of this number
+            int functionDigits() const;
+
+            // Add a and b (or b negated) and round to the given number of digits
+            static decimal add(const decimal& a, const decimal& b, const bool& negateB, const int& digits);
+            // Divide a by b with the given number of digits, if exact is true the quotient stays exact when the division ends
+            static decimal divide(const decimal& a, const decimal& b, const int& digits, const bool& exact);
+            // Compare the absolute values, returns -1, 0 or 1
+            static int compareMagnitudes(const decimal& a, const decimal& b);
+            // The sine and cosine of x (in radians, |x| <= pi/4) with the given number of digits
+            static void sinCos(const decimal& x, const int& digits, decimal* sine, decimal* cosine);
+            // The sine (or cosine) of an angle that has been reduced to quadrant*pi/2 + rest
+            static decimal sinOfQuadrant(const decimal& rest, const long long& quadrant, const bool& cosine, const int& digits);
+            // The goniometric function of x in radians or degrees, function is 's', 'c' or 't'
+            static decimal goniometric(const decimal& x, const char& function, const bool& degrees);
+            // The arc tangent with the given number of digits
+            static decimal arcTangent(const decimal& x, const int& digits);
+            // 2*atanh(1/n) and atan(1/n) with the given number of digits, used for the constants
+            static decimal atanhOfInverse(const limb& n, const int& digits);
+            static decimal atanOfInverse(const limb& n, const int& digits);
+
+            kind type;                              // Whether the number is finite, NaN or infinite
+            bool negative;                          // Whether the number is negative
+            magnitude mantissa;                     // The digits in base 10^9, least significant first, empty for 0
+            long long exponent;                     // The value is mantissa * 10^(9*exponent)
+            int digits;                             // The precision, 0 if the number is exact
+    };
+}
+
+#endif // DECIMAL_H
@@ -0,0 +1,63 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef DUAL_H
+#define DUAL_H
+
+#include "types.h"
+
+namespace calc
+{
+    // A dual number, a value together with its derivative to one variable
+    // Every operation applies the chain rule, so calculating an expression with dual numbers gives its exact derivative along with
+    // its value (forward mode automatic differentiation). The comparisons only look at the values.
+    // numberEngine<dual> calculates compiled expressions this way (see numberTraits<dual> in numberengine.h).
+    class dual
+    {
+        public:
+            // Constructor, creates a constant 0
+            dual() : value(0), derivative(0) {}
+            // Constructor, creates a constant integer
+            explicit dual(const int& value) : value(value), derivative(0) {}
+            // Constructor, creates a number with the given value and derivative
+            dual(const real& value, const real& derivative) : value(value), derivative(derivative) {}
+
+            dual operator-() const
+            { return dual(-value, -derivative); }
+            dual operator+(const dual& other) const
+            { return dual(value + other.value, derivative + other.derivative); }
+            dual operator-(const dual& other) const
+            { return dual(value - other.value, derivative - other.derivative); }
+            dual operator*(const dual& other) const
+            { return dual(value * other.value, derivative * other.value + value * other.derivative); }
+            dual operator/(const dual& other) const
+            { return dual(value / other.value, (derivative * other.value - value * other.derivative) / (other.value * other.value)); }
+
+            bool operator==(const dual& other) const    { return value == other.value; }
+            bool operator!=(const dual& other) const    { return value != other.value; }
+            bool operator<(const dual& other) const     { return value < other.value; }
+            bool operator>(const dual& other) const     { return value > other.value; }
+            bool operator<=(const dual& other) const    { return value <= other.value; }
+            bool operator>=(const dual& other) const    { return value >= other.value; }
+
+            real value;                                 // The value
+            real derivative;                            // The derivative of the value to the variable
+    };
+}
+
+#endif // DUAL_H
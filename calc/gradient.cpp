@@ -0,0 +1,329 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "gradient.h"
+#include "numberengine.h"
+#include "context.h"
+#include "solver.h"
+#include "builtins.h"
+#include "random.h"
+#include <cmath>
+#include <limits>
+
+namespace calc
+{
+    namespace
+    {
+        // The entry of a register that hasn't been written yet
+        const unsigned int noEntry = std::numeric_limits<unsigned int>::max();
+
+        // Throws the error for a power with a negative base, or returns if there is nothing wrong, like program::execute() does
+        void checkPower(const real& base, const real& exponent, const bool& root)
+        {
+            if(base < 0)
+            {
+                if(root)
+                    throw calcError("No negative roots allowed", calcError::invalidOperands);
+                if(std::floor(exponent) != exponent)
+                    throw calcError("Only integer powers of negative numbers", calcError::invalidOperands);
+            }
+        }
+    }
+
+    // gradientTape:
+        // Public:
+            gradientTape::gradientTape()
+            {}
+
+            real gradientTape::calculate(const program& prog, environment& env, std::vector<real>& derivatives)
+            {
+                const std::vector<program::instruction>& instructions = prog.getInstructions();
+                const std::vector<string>& variables = prog.getVariables();
+                const std::vector<string>& functions = prog.getFunctions();
+                const std::vector<unsigned int>& arguments = prog.getArguments();
+                randomGenerator::scope random(env.getRandomGenerator());
+
+                // Every variable gets an entry at the start of the tape, its value is filled in when it's read
+                entries.clear();
+                operands.clear();
+                for(size_t slot = 0; slot < variables.size(); ++slot)
+                    record(0, true);
+                registers.assign(prog.getRegisterCount(), noEntry);
+                stored.assign(variables.size(), noEntry);
+                vars.assign(variables.size(), 0);
+                storedVars.assign(variables.size(), 0);
+                funcs.assign(functions.size(), 0);
+
+                // Execute the instructions one by one like program::execute() does, recording the derivatives of every result
+                // The instructions on integers do the same as those on reals
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    // The entries of the operands, read before the result is written because it may go into the same register
+                    const unsigned int left = instr->a < registers.size() ? registers[instr->a] : noEntry;
+                    const unsigned int right = instr->b < registers.size() ? registers[instr->b] : noEntry;
+                    switch(program::realOpcode(instr->op))
+                    {
+                        case program::opConstant:
+                            registers[instr->dest] = record(prog.getConstants()[instr->a]);
+                        break;
+
+                        case program::opLoad:
+                        case program::opCheck:
+                            // Variables are looked up once, a variable that has been assigned holds the entry of its value
+                            if(vars[instr->a] == 0)
+                            {
+                                if((vars[instr->a] = env.findVar(variables[instr->a])) == 0)
+                                    throw calcError("Unknown variable", calcError::unknownName, prog.getStrings()[instr->b]);
+                                entries[instr->a].value = *vars[instr->a];
+                            }
+                            if(instr->op == program::opLoad)
+                                registers[instr->dest] = stored[instr->a] != noEntry ? stored[instr->a] : instr->a;
+                        break;
+
+                        case program::opStore:
+                            // The environment is told about every variable that is assigned, even if it has been read already
+                            if(storedVars[instr->a] == 0)
+                                vars[instr->a] = storedVars[instr->a] = env.createVar(variables[instr->a]);
+                            *storedVars[instr->a] = entries[right].value;
+                            stored[instr->a] = right;
+                        break;
+
+                        case program::opNegate:
+                            registers[instr->dest] = record(-entries[left].value);
+                            depend(left, -1);
+                        break;
+
+                        case program::opPower:
+                        case program::opRoot:
+                        {
+                            // The derivatives are those of dual, once to the base and once to the exponent
+                            const real base = entries[left].value;
+                            const real exponent = entries[right].value;
+                            const bool root = (instr->op == program::opRoot);
+                            checkPower(base, exponent, root);
+                            const dual power = root ? dual(1) / dual(exponent, 1) : dual(exponent, 1);
+                            const dual toBase = numberTraits<dual>::power(dual(base, 1), dual(power.value, 0));
+                            const dual toExponent = numberTraits<dual>::power(dual(base, 0), power);
+                            registers[instr->dest] = record(toBase.value);
+                            depend(left, toBase.derivative);
+                            depend(right, toExponent.derivative);
+                        }
+                        break;
+
+                        case program::opCheckDivisor:
+                            if(entries[left].value == 0)
+                                throw calcError(instr->b ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, entries[left].value);
+                        break;
+
+                        case program::opMultiply:
+                        {
+                            const real a = entries[left].value;
+                            const real b = entries[right].value;
+                            registers[instr->dest] = record(a * b);
+                            depend(left, b);
+                            depend(right, a);
+                        }
+                        break;
+
+                        case program::opDivide:
+                        {
+                            const real b = entries[right].value;
+                            if(b == 0)
+                                throw calcError("Division by 0", calcError::invalidOperands, b);
+                            const real quotient = entries[left].value / b;
+                            registers[instr->dest] = record(quotient);
+                            depend(left, 1 / b);
+                            depend(right, -quotient / b);
+                        }
+                        break;
+
+                        case program::opModulo:
+                        {
+                            const real b = entries[right].value;
+                            if(b == 0)
+                                throw calcError("Modulo by 0", calcError::invalidOperands, b);
+                            const dual modulo = numberTraits<dual>::modulo(dual(entries[left].value, 0), dual(b, 1));
+                            registers[instr->dest] = record(modulo.value);
+                            depend(left, 1);
+                            depend(right, modulo.derivative);
+                        }
+                        break;
+
+                        case program::opAdd:
+                        case program::opSubtract:
+                        {
+                            const bool add = (program::realOpcode(instr->op) == program::opAdd);
+                            registers[instr->dest] = record(add ? entries[left].value + entries[right].value : entries[left].value - entries[right].value);
+                            depend(left, 1);
+                            depend(right, add ? 1 : -1);
+                        }
+                        break;
+
+                        // The comparisons and the bitwise operators are constant between their jumps
+                        case program::opGreater:
+                            registers[instr->dest] = record(entries[left].value > entries[right].value ? 1 : 0);
+                        break;
+
+                        case program::opLess:
+                            registers[instr->dest] = record(entries[left].value < entries[right].value ? 1 : 0);
+                        break;
+
+                        case program::opBitwiseOr:
+                        case program::opBitwiseAnd:
+                        {
+                            const integer a = floatTraits<real>::toInteger(entries[left].value);
+                            const integer b = floatTraits<real>::toInteger(entries[right].value);
+                            registers[instr->dest] = record(static_cast<real>(instr->op == program::opBitwiseOr ? (a | b) : (a & b)));
+                        }
+                        break;
+
+                        case program::opCheckFunction:
+                            if(funcs[instr->a] == 0 && (funcs[instr->a] = env.findFunction(functions[instr->a])) == 0)
+                                throw calcError("Unknown function", calcError::unknownName, functions[instr->a]);
+                        break;
+
+                        case program::opCall:
+                            registers[instr->dest] = call(funcs[instr->a], functions[instr->a], arguments, instr->c, instr->b);
+                        break;
+
+                        case program::opCallExpressions:
+                        {
+                            // Functions with unevaluated arguments are differentiated by numberEngine<dual>, to every variable that has been read
+                            const std::vector<string>& expressions = prog.getExpressions()[instr->b];
+                            mathFunction* function = funcs[instr->a];
+                            partials.assign(variables.size(), 0);
+                            real result = 0;
+                            bool called = false;
+                            for(size_t slot = 0; slot < variables.size(); ++slot)
+                            {
+                                if(vars[slot] == 0 || stored[slot] != noEntry)
+                                    continue;
+                                const dual out = numberEngine<dual>(numberTraits<dual>(variables[slot])).callExpressions(function, functions[instr->a], expressions, env);
+                                result = out.value;
+                                partials[slot] = out.derivative;
+                                called = true;
+                            }
+                            if(!called)
+                                result = numberEngine<dual>().callExpressions(function, functions[instr->a], expressions, env).value;
+                            registers[instr->dest] = record(result);
+                            for(unsigned int slot = 0; slot < variables.size(); ++slot)
+                                depend(slot, partials[slot]);
+                        }
+                        break;
+
+                        // The instructions on integers are turned into these by realOpcode()
+                        default:
+                        break;
+                    }
+                }
+
+                // Sweep backwards over the tape, every entry passes its derivative on to its operands
+                unsigned int result = registers[prog.getResultRegister()];
+                if(result == noEntry)
+                    result = record(0);
+                adjoints.assign(entries.size(), 0);
+                adjoints[result] = 1;
+                for(size_t i = entries.size(); i-- > variables.size(); )
+                {
+                    if(adjoints[i] == 0)
+                        continue;
+                    const entry& current = entries[i];
+                    for(unsigned int j = current.first; j < current.first + current.count; ++j)
+                        adjoints[operands[j].entry] += adjoints[i] * operands[j].derivative;
+                }
+                derivatives.assign(adjoints.begin(), adjoints.begin() + variables.size());
+                return entries[result].value;
+            }
+
+        // Private:
+            unsigned int gradientTape::record(const real& value, const bool& active)
+            {
+                const entry added = {value, static_cast<unsigned int>(operands.size()), 0, active};
+                entries.push_back(added);
+                return static_cast<unsigned int>(entries.size() - 1);
+            }
+
+            void gradientTape::depend(const unsigned int& operandEntry, const real& derivative)
+            {
+                if(!entries[operandEntry].active)
+                    return;
+                const operand added = {operandEntry, derivative};
+                operands.push_back(added);
+                ++entries.back().count;
+                entries.back().active = true;
+            }
+
+            unsigned int gradientTape::call(mathFunction* function, const string& name, const std::vector<unsigned int>& arguments, const unsigned int& first, const unsigned int& count)
+            {
+                // Every argument that depends on a variable needs a call with dual numbers to get the derivative to it
+                // RAND draws different numbers every call, so it's called once and has derivative 0 like it has for dual
+                const numberEngine<dual> engine;
+                const char* builtInName = builtIns::getBuiltInName(function, name);
+                const bool random = (builtInName != 0 && string(builtInName) == "RAND");
+                args.resize(count);
+                partials.assign(count, 0);
+                bool called = false;
+                real result = 0;
+                for(unsigned int i = 0; i < count; ++i)
+                    args[i] = dual(entries[registers[arguments[first + i]]].value, 0);
+                for(unsigned int i = 0; i < count && !random; ++i)
+                {
+                    if(!entries[registers[arguments[first + i]]].active)
+                        continue;
+                    args[i].derivative = 1;
+                    const dual out = engine.call(function, name, args, realArgs);
+                    args[i].derivative = 0;
+                    result = out.value;
+                    partials[i] = out.derivative;
+                    called = true;
+                }
+                if(!called)
+                    result = engine.call(function, name, args, realArgs).value;
+
+                const unsigned int added = record(result);
+                for(unsigned int i = 0; i < count; ++i)
+                    depend(registers[arguments[first + i]], partials[i]);
+                return added;
+            }
+
+    // derivativeMathFunction:
+        // Public:
+            real derivativeMathFunction::execute(const argList&, const string& name)
+            { throw calcError("The expression has to be passed unevaluated", calcError::invalidArguments, name); }
+
+            bool derivativeMathFunction::takesExpressions() const
+            { return true; }
+
+            real derivativeMathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                // The expression, the variable and optionally the value at which the derivative is taken
+                if(expressions.size() < 2 || expressions.size() > 3)
+                {
+                    std::vector<real> extraRealInfo(2, expressions.size());
+                    extraRealInfo[1] = expressions.size() < 2 ? 2 : 3;
+                    throw calcError(expressions.size() < 2 ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+                const std::shared_ptr<const program> prog = context::compile(expressions[0], &env);
+                const string variable = solverMathFunction::variableName(expressions[1], name, 2);
+                const numberEngine<dual> engine((numberTraits<dual>(variable)));
+                if(expressions.size() == 2)
+                    return engine.evaluate(*prog, env).derivative;
+                localEnvironment local(env, variable, context::compile(expressions[2], &env)->execute(env));
+                return engine.evaluate(*prog, local).derivative;
+            }
+}
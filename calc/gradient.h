@@ -0,0 +1,106 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef GRADIENT_H
+#define GRADIENT_H
+
+#include <vector>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "mathfunction.h"
+#include "dual.h"
+
+namespace calc
+{
+    // Calculates the derivatives of the result of a program to all of its variables at once (reverse mode automatic differentiation)
+    // The program is executed once, while every instruction is recorded on a tape together with the derivatives of its result to its
+    // operands. One sweep backwards over the tape then gives the derivatives to all variables, where numberEngine<dual> needs an
+    // execution for every variable. The derivatives are the same as those of numberEngine<dual>, functions are differentiated by
+    // numberEngine<dual>::call() once for every argument that depends on a variable, and those with unevaluated arguments (like SOLVE())
+    // once for every variable that has been read.
+    // The tape has an entry for every variable and every instruction, and it keeps its memory between calculations, so once it has
+    // grown to the size of the program nothing is allocated while recording. A tape may only be used by one thread at a time.
+    class gradientTape
+    {
+        public:
+            // Constructor
+            gradientTape();
+
+            // Execute the program and calculate the derivatives of its result, which is returned, or throws a calcError
+            // derivatives[slot] becomes the derivative to the variable in that slot (see program::getVariables()), variables that
+            // are assigned before they're read have derivative 0. Like numberEngine<dual>, the values are calculated with reals.
+            real calculate(const program& prog, environment& env, std::vector<real>& derivatives);
+
+        private:
+            // The derivative of an entry of the tape to one of its operands
+            struct operand
+            {
+                unsigned int entry;                 // The entry of the operand
+                real derivative;                    // The derivative to the operand
+            };
+
+            // An entry of the tape, i.e. a variable or the result of an instruction
+            struct entry
+            {
+                real value;                         // The value
+                unsigned int first;                 // The index of the first operand in operands
+                unsigned int count;                 // The number of operands, only operands that depend on a variable are recorded
+                bool active;                        // Whether the value depends on a variable
+            };
+
+            // Add an entry to the end of the tape, returns its index
+            unsigned int record(const real& value, const bool& active = false);
+            // Add an operand of the last entry, which is left out if it doesn't depend on a variable
+            void depend(const unsigned int& operandEntry, const real& derivative);
+            // Record a function call, the arguments are the registers arguments[first], arguments[first+1], ...
+            unsigned int call(mathFunction* function, const string& name, const std::vector<unsigned int>& arguments, const unsigned int& first, const unsigned int& count);
+
+            std::vector<entry> entries;             // The tape, the variables come first (by slot) and then the results of the instructions
+            std::vector<operand> operands;          // The operands of all entries
+            std::vector<unsigned int> registers;    // The entry held by every register
+            std::vector<unsigned int> stored;       // The entry assigned to every variable slot, if any
+            std::vector<real*> vars;                // The variables that have been looked up, by slot
+            std::vector<real*> storedVars;          // The variables that have been assigned, by slot
+            std::vector<mathFunction*> funcs;       // The functions that have been looked up, by slot
+            std::vector<dual> args;                 // The arguments of the current function call
+            argList realArgs;                       // The arguments of the current function call as reals
+            std::vector<real> partials;             // The derivatives of the current function call to its arguments or to the variables
+            std::vector<real> adjoints;             // The derivatives of the result to every entry
+    };
+
+    // The function DERIV(expression, variable) calculating the derivative of an expression to a variable, at its current value or at
+    // the value given as the third argument, in which case the variable is local like the one of SOLVE()
+    // The expression is calculated once with dual numbers (see numberEngine<dual>), so the derivative is exact for the built-in
+    // functions and the functions defined by an expression.
+    class derivativeMathFunction : public mathFunction
+    {
+        public:
+            // Constructor
+            constexpr derivativeMathFunction(const bool& cleanUpNeeded = false) : mathFunction(cleanUpNeeded) {}
+
+            // Throws an error, the expression has to be passed unevaluated
+            virtual real execute(const argList& vars, const string& name);
+            // Calculate the derivative
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true, the arguments are passed unevaluated
+            virtual bool takesExpressions() const;
+    };
+}
+
+#endif // GRADIENT_H
@@ -0,0 +1,107 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "instrumentation.h"
+#include <chrono>
+
+namespace calc
+{
+    namespace
+    {
+        // The current time in nanoseconds
+        unsigned long long now()
+        { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+    }
+
+    // instrumentation:
+        // Public:
+            unsigned long long instrumentation::statistics::totalNanoseconds() const
+            {
+                unsigned long long total = 0;
+                for(int i = 0; i < phaseCount; ++i)
+                    total += nanoseconds[i];
+                return total;
+            }
+
+            void instrumentation::setEnabled(const bool& enabled)
+            { current.enabled = enabled; }
+
+            bool instrumentation::isEnabled()
+            { return current.enabled; }
+
+            const instrumentation::statistics& instrumentation::getStatistics()
+            { return current.stats; }
+
+            void instrumentation::reset()
+            { current.stats = statistics(); }
+
+            const char* instrumentation::phaseName(const phase& which)
+            {
+                const char* names[phaseCount] = {"lex", "validate", "compile", "evaluate", "function call", "format"};
+                return which < phaseCount ? names[which] : "";
+            }
+
+            const char* instrumentation::counterName(const counter& which)
+            {
+                const char* names[counterCount] = {"tokens", "nodes", "function calls", "allocations", "exceptions"};
+                return which < counterCount ? names[which] : "";
+            }
+
+    // instrumentation::scopedPhase:
+        // Public:
+            void instrumentation::scopedPhase::failed()
+            {
+                if(!active)
+                    return;
+
+                // The error is only counted once, by the outermost phase it leaves
+                for(const scopedPhase* outer = parent; outer; outer = outer->parent)
+                {
+                    if(outer->which == which)
+                        return;
+                }
+                ++current.stats.counters[counterExceptions];
+            }
+
+        // Private:
+            void instrumentation::scopedPhase::begin()
+            {
+                // The time until now belongs to the phase we're in
+                start = now();
+                parent = current.innermost;
+                if(parent)
+                    current.stats.nanoseconds[parent->which] += start - parent->start;
+                current.innermost = this;
+                ++current.stats.entered[which];
+            }
+
+            void instrumentation::scopedPhase::end()
+            {
+                // The phase we were in continues from now on
+                const unsigned long long stop = now();
+                current.stats.nanoseconds[which] += stop - start;
+                if(parent)
+                    parent->start = stop;
+                current.innermost = parent;
+            }
+
+    // instrumentation:
+        // Private:
+            // Static:
+                thread_local instrumentation::threadState instrumentation::current;
+}
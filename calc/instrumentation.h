@@ -0,0 +1,149 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include "types.h"
+
+namespace calc
+{
+    // Measures where the engine spends its time, every thread is measured separately
+    // Nothing is measured until it's enabled with setEnabled(), after that the timers and counters of the current thread
+    // can be read using getStatistics(). Defining CALC_NO_INSTRUMENTATION removes the measurements from the engine entirely,
+    // the statistics are all 0 in that case.
+    class instrumentation
+    {
+        public:
+            // The phases of handling an expression
+            enum phase
+            {
+                phaseLex,                           // Splitting the expression into tokens
+                phaseValidate,                      // Searching the tokens for errors (searchForErrors())
+                phaseCompile,                       // Compiling the tokens
+                phaseEvaluate,                      // Calculating the expression
+                phaseFunctionCall,                  // Calling a user defined function, without the phases inside the call
+                phaseFormat,                        // Converting a result to a string (real2str())
+                phaseCount
+            };
+
+            // The things that are counted
+            enum counter
+            {
+                counterTokens,                      // The tokens found while lexing
+                counterNodes,                       // The instructions executed by compiled expressions
+                counterFunctionCalls,               // The calls of functions, both built-in and user defined
+                counterAllocations,                 // The heap objects created by the engine (compiled expressions, register buffers that don't fit
+                                                    // on the stack, and the token lists and calculators the interpreter creates)
+                counterExceptions,                  // The errors thrown by calculations and conversions
+                counterCount
+            };
+
+            // The measurements of a thread, everything is 0 when it's constructed
+            struct statistics
+            {
+                // Get the total time of all phases
+                unsigned long long totalNanoseconds() const;
+
+                unsigned long long nanoseconds[phaseCount] = {};    // The time spent in every phase, phases inside other phases aren't counted twice
+                unsigned long long entered[phaseCount] = {};        // The number of times every phase was entered
+                unsigned long long counters[counterCount] = {};     // The counters
+            };
+
+            // Enable or disable the measurements in the current thread
+            static void setEnabled(const bool& enabled);
+            // Returns true if the current thread is measured
+            static bool isEnabled();
+            // Get the measurements of the current thread
+            static const statistics& getStatistics();
+            // Set the measurements of the current thread to 0
+            static void reset();
+
+            // Get the name of a phase or counter, e.g. "lex" or "tokens"
+            static const char* phaseName(const phase& which);
+            static const char* counterName(const counter& which);
+
+            // Add to a counter, use CALC_COUNT() instead so the instrumentation can be removed
+            static void count(const counter& which, const unsigned long long& amount)
+            {
+                if(current.enabled)
+                    current.stats.counters[which] += amount;
+            }
+
+            // Measures the time spent in a phase during its lifetime, use CALC_PHASE() instead so the instrumentation can be removed
+            class scopedPhase
+            {
+                public:
+                    // Constructor, starts the phase and pauses the phase it's in
+                    scopedPhase(const phase& which)
+                    : which(which), active(current.enabled)
+                    {
+                        if(active)
+                            begin();
+                    }
+                    // Destructor, ends the phase and resumes the phase it's in
+                    ~scopedPhase()
+                    {
+                        if(active)
+                            end();
+                    }
+
+                    // Count an error leaving the phase, only the outermost phase of a kind counts it
+                    void failed();
+
+                private:
+                    // Prevent copying:
+                    scopedPhase& operator=(const scopedPhase& other);
+                    scopedPhase(const scopedPhase& other);
+
+                    // Start and end measuring the phase
+                    void begin();
+                    void end();
+
+                    phase which;                    // The phase that is measured
+                    bool active;                    // Whether the phase is measured
+                    scopedPhase* parent;            // The phase this phase is in
+                    unsigned long long start;       // The moment the phase (re)started running, in nanoseconds
+            };
+
+        private:
+            // The state of a thread, it needs no code to be initialised so it's cheap to access
+            struct threadState
+            {
+                bool enabled = false;               // Whether the thread is measured
+                statistics stats;                   // The measurements
+                scopedPhase* innermost = 0;         // The phase that is running
+            };
+
+            // The state of the current thread
+            static thread_local threadState current;
+    };
+}
+
+// Macros to measure a phase (only one per scope), to count an error leaving it and to add to a counter
+#ifdef CALC_NO_INSTRUMENTATION
+#   define CALC_PHASE(which)
+#   define CALC_PHASE_FAILED()
+#   define CALC_COUNT(which, amount)
+#else
+#   define CALC_PHASE(which)            ::calc::instrumentation::scopedPhase calcPhase(::calc::instrumentation::which)
+#   define CALC_PHASE_FAILED()          calcPhase.failed()
+#   define CALC_COUNT(which, amount)    ::calc::instrumentation::count(::calc::instrumentation::which, amount)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,328 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "jit.h"
+#ifdef CALC_JIT
+#   include <vector>
+#   include <initializer_list>
+#   include <cstring>
+#   include <stdint.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+namespace calc
+{
+#ifdef CALC_JIT
+    namespace
+    {
+        // Writes x86-64 machine code into a buffer
+        // While the code runs rbx points to the registers of the program, r14 to the looked up variables,
+        // r12 holds the state and r13 the program, which are passed on to the step function. Only rax and xmm0-xmm2 are used
+        // as scratch registers, so the values of the program always live in memory and the step function can see them.
+        class emitter
+        {
+            public:
+                // The SSE2 instructions with a register and a memory operand used by the code
+                enum sseOp
+                {
+                    sseLoad = 0x10,                 // movsd xmm, [mem]
+                    sseStore = 0x11,                // movsd [mem], xmm
+                    sseAdd = 0x58,                  // addsd xmm, [mem]
+                    sseMultiply = 0x59,             // mulsd xmm, [mem]
+                    sseSubtract = 0x5c,             // subsd xmm, [mem]
+                    sseDivide = 0x5e                // divsd xmm, [mem]
+                };
+
+                // The conditions of jumps
+                enum condition
+                {
+                    always,                         // jmp
+                    ifEqual,                        // je
+                    ifNotEqual,                     // jne
+                    ifParity                        // jp, i.e. the comparison was unordered (NaN)
+                };
+
+                // Get the code written so far
+                const std::vector<unsigned char>& getCode() const
+                { return code; }
+
+                // Save the callee saved registers and set up the registers described above
+                void prologue()
+                {
+                    bytes({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56});         // push rbx, r12, r13, r14
+                    bytes({0x48, 0x83, 0xec, 0x08});                         // sub rsp, 8 (align the stack for calls)
+                    bytes({0x48, 0x89, 0xfb});                               // mov rbx, rdi
+                    bytes({0x49, 0x89, 0xf6});                               // mov r14, rsi
+                    bytes({0x49, 0x89, 0xd4});                               // mov r12, rdx
+                    bytes({0x49, 0x89, 0xcd});                               // mov r13, rcx
+                }
+
+                // Restore the callee saved registers and return status
+                void epilogue(const uint32_t& status)
+                {
+                    byte(0xb8);                                              // mov eax, status
+                    dword(status);
+                    bytes({0x48, 0x83, 0xc4, 0x08});                         // add rsp, 8
+                    bytes({0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3}); // pop r14, r13, r12, rbx; ret
+                }
+
+                // op xmm, [rbx + 8*reg] (or the other way around for sseStore), reg is a register of the program
+                void sse(const sseOp& op, const unsigned int& xmm, const unsigned int& reg)
+                {
+                    bytes({0xf2, 0x0f, static_cast<unsigned char>(op), static_cast<unsigned char>(0x83 | (xmm << 3))});
+                    dword(reg * 8);
+                }
+
+                // mov rax, value; mov [rbx + 8*reg], rax
+                void storeConstant(const unsigned int& reg, const real& value)
+                {
+                    loadRax(value);
+                    bytes({0x48, 0x89, 0x83});
+                    dword(reg * 8);
+                }
+
+                // mov rax, value; movq xmm, rax
+                void loadConstant(const unsigned int& xmm, const real& value)
+                {
+                    loadRax(value);
+                    bytes({0x66, 0x48, 0x0f, 0x6e, static_cast<unsigned char>(0xc0 | (xmm << 3))});
+                }
+
+                // mov rax, [r14 + 8*slot]; test rax, rax, so the flags tell whether the variable has been looked up
+                void loadVariablePointer(const unsigned int& slot)
+                {
+                    bytes({0x49, 0x8b, 0x86});
+                    dword(slot * 8);
+                    bytes({0x48, 0x85, 0xc0});
+                }
+
+                // movsd xmm0, [rax]
+                void loadVariable()
+                { bytes({0xf2, 0x0f, 0x10, 0x00}); }
+
+                // xorpd xmm0, xmm1
+                void xorXmm1()
+                { bytes({0x66, 0x0f, 0x57, 0xc1}); }
+
+                // divsd xmm0, xmm1
+                void divideXmm1()
+                { bytes({0xf2, 0x0f, 0x5e, 0xc1}); }
+
+                // xorpd xmm2, xmm2; ucomisd xmm1, xmm2, so the flags tell whether xmm1 is 0
+                void compareXmm1ToZero()
+                { bytes({0x66, 0x0f, 0x57, 0xd2, 0x66, 0x0f, 0x2e, 0xca}); }
+
+                // ucomisd xmm0, [rbx + 8*reg]; seta al; movzx eax, al; cvtsi2sd xmm0, eax
+                // So xmm0 becomes 1 if it's greater than the register, and 0 otherwise (also if either is NaN)
+                void greaterThan(const unsigned int& reg)
+                {
+                    bytes({0x66, 0x0f, 0x2e, 0x83});
+                    dword(reg * 8);
+                    bytes({0x0f, 0x97, 0xc0, 0x0f, 0xb6, 0xc0, 0xf2, 0x0f, 0x2a, 0xc0});
+                }
+
+                // Call the step function for the instruction at index, jumps to failed if it returns something else than 0
+                void callStep(const jitCode::stepFunction& step, const unsigned int& index, std::vector<size_t>& failed)
+                {
+                    bytes({0x4c, 0x89, 0xe7, 0x4c, 0x89, 0xee});             // mov rdi, r12; mov rsi, r13
+                    byte(0xba);                                              // mov edx, index
+                    dword(index);
+                    bytes({0x48, 0xb8});                                     // mov rax, step
+                    qword(reinterpret_cast<uint64_t>(step));
+                    bytes({0xff, 0xd0, 0x85, 0xc0});                         // call rax; test eax, eax
+                    failed.push_back(jump(ifNotEqual));
+                }
+
+                // Jump to a position that's set later on by bind(), returns the jump
+                size_t jump(const condition& when)
+                {
+                    if(when == always)
+                        byte(0xe9);
+                    else
+                        bytes({0x0f, static_cast<unsigned char>(when == ifEqual ? 0x84 : (when == ifNotEqual ? 0x85 : 0x8a))});
+                    dword(0);
+                    return code.size();
+                }
+
+                // Let a jump go to the current position
+                void bind(const size_t& jump)
+                {
+                    const uint32_t offset = static_cast<uint32_t>(code.size() - jump);
+                    std::memcpy(&code[jump - 4], &offset, 4);
+                }
+
+            private:
+                // mov rax, value
+                void loadRax(const real& value)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, 8);
+                    bytes({0x48, 0xb8});
+                    qword(bits);
+                }
+
+                // Write bytes, the numbers are written in little endian order
+                void byte(const unsigned char& value)
+                { code.push_back(value); }
+                void bytes(std::initializer_list<unsigned char> values)
+                { code.insert(code.end(), values.begin(), values.end()); }
+                void dword(const uint32_t& value)
+                {
+                    for(unsigned int i = 0; i < 4; ++i)
+                        byte(static_cast<unsigned char>(value >> (8 * i)));
+                }
+                void qword(const uint64_t& value)
+                {
+                    dword(static_cast<uint32_t>(value));
+                    dword(static_cast<uint32_t>(value >> 32));
+                }
+
+                std::vector<unsigned char> code;    // The code
+        };
+    }
+#endif
+
+    // jitCode:
+        // Public:
+            jitCode::~jitCode()
+            {
+#ifdef CALC_JIT
+                munmap(memory, size);
+#endif
+            }
+
+            jitCode* jitCode::compile(const program& prog, const stepFunction& step)
+            {
+#ifdef CALC_JIT
+                // The displacements of the registers and variables have to fit in 32 bits
+                const std::vector<program::instruction>& instructions = prog.getInstructions();
+                const std::vector<real>& constants = prog.getConstants();
+                if(prog.getRegisterCount() >= (1u << 28) || prog.getVariables().size() >= (1u << 28))
+                    return 0;
+
+                emitter out;
+                std::vector<size_t> failed;
+                out.prologue();
+                for(unsigned int i = 0; i < instructions.size(); ++i)
+                {
+                    const program::instruction& instr = instructions[i];
+                    switch(instr.op)
+                    {
+                        case program::opConstant:
+                            out.storeConstant(instr.dest, constants[instr.a]);
+                        break;
+
+                        case program::opLoad:
+                        {
+                            // Variables are only looked up by the step function, after that their value is read directly
+                            out.loadVariablePointer(instr.a);
+                            const size_t notFound = out.jump(emitter::ifEqual);
+                            out.loadVariable();
+                            out.sse(emitter::sseStore, 0, instr.dest);
+                            const size_t done = out.jump(emitter::always);
+                            out.bind(notFound);
+                            out.callStep(step, i, failed);
+                            out.bind(done);
+                        }
+                        break;
+
+                        case program::opNegate:
+                            // a * -1 flips the sign bit, compilers turn the multiplication of the interpreter into the same (also for NaN)
+                            out.sse(emitter::sseLoad, 0, instr.a);
+                            out.loadConstant(1, -0.0);
+                            out.xorXmm1();
+                            out.sse(emitter::sseStore, 0, instr.dest);
+                        break;
+
+                        case program::opMultiply:
+                        case program::opAdd:
+                        case program::opSubtract:
+                            out.sse(emitter::sseLoad, 0, instr.a);
+                            out.sse(instr.op == program::opMultiply ? emitter::sseMultiply : (instr.op == program::opAdd ? emitter::sseAdd : emitter::sseSubtract), 0, instr.b);
+                            out.sse(emitter::sseStore, 0, instr.dest);
+                        break;
+
+                        case program::opDivide:
+                        case program::opCheckDivisor:
+                        {
+                            // A divisor of 0 is handed to the step function, which throws the error
+                            out.sse(emitter::sseLoad, 1, instr.op == program::opDivide ? instr.b : instr.a);
+                            out.compareXmm1ToZero();
+                            const size_t unordered = out.jump(emitter::ifParity);
+                            const size_t nonZero = out.jump(emitter::ifNotEqual);
+                            out.callStep(step, i, failed);
+                            const size_t done = out.jump(emitter::always);
+                            out.bind(unordered);
+                            out.bind(nonZero);
+                            if(instr.op == program::opDivide)
+                            {
+                                out.sse(emitter::sseLoad, 0, instr.a);
+                                out.divideXmm1();
+                                out.sse(emitter::sseStore, 0, instr.dest);
+                            }
+                            out.bind(done);
+                        }
+                        break;
+
+                        case program::opGreater:
+                        case program::opLess:
+                            // a < b is b > a
+                            out.sse(emitter::sseLoad, 0, instr.op == program::opGreater ? instr.a : instr.b);
+                            out.greaterThan(instr.op == program::opGreater ? instr.b : instr.a);
+                            out.sse(emitter::sseStore, 0, instr.dest);
+                        break;
+
+                        default:
+                            out.callStep(step, i, failed);
+                        break;
+                    }
+                }
+                out.epilogue(0);
+                for(std::vector<size_t>::const_iterator pos = failed.begin(); pos != failed.end(); ++pos)
+                    out.bind(*pos);
+                out.epilogue(1);
+
+                // Copy the code into memory of its own, which is made executable (and read only) afterwards
+                const std::vector<unsigned char>& code = out.getCode();
+                const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                const size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+                void* memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(memory == MAP_FAILED)
+                    return 0;
+                std::memcpy(memory, &code[0], code.size());
+                if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+                {
+                    munmap(memory, size);
+                    return 0;
+                }
+                return new jitCode(memory, size);
+#else
+                static_cast<void>(prog);
+                static_cast<void>(step);
+                return 0;
+#endif
+            }
+
+            int jitCode::run(real* registers, real** vars, void* state, const program* prog) const
+            { return entry(registers, vars, state, prog); }
+
+        // Private:
+            jitCode::jitCode(void* memory, const std::size_t& size)
+            : memory(memory), size(size), entry(reinterpret_cast<entryPoint>(memory)) {}
+}
@@ -0,0 +1,76 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include "types.h"
+#include "program.h"
+
+// Native code is only made on x86-64 with the System V calling convention (Linux, the BSDs and macOS)
+// Build with "qmake CONFIG+=calc_no_jit" (defining CALC_NO_JIT) to always use the interpreter of program
+#if !defined(CALC_NO_JIT) && (defined(__x86_64__) || defined(_M_X64)) && !defined(_WIN32)
+#   define CALC_JIT
+#endif
+
+namespace calc
+{
+    // The machine code of a program, living in its own executable memory
+    //
+    // The code does the arithmetic of the program (constants, +, -, *, /, negation, comparisons, divisor checks and
+    // loading variables that have been looked up already) with scalar SSE2 instructions, on the registers of the program in memory.
+    // Every other instruction (looking up variables and functions, assignments, function calls, powers, roots, modulo and the
+    // bitwise operators), and every instruction that throws an error, is handed back to the interpreter of program through a
+    // step function that executes that single instruction. So the results and errors are exactly those of the interpreter.
+    class jitCode
+    {
+        public:
+            // Executes the instruction at index of prog for native code, returns 0 if it succeeded
+            // It may not throw, errors have to be kept in state
+            typedef int (*stepFunction)(void* state, const program* prog, unsigned int index);
+
+            // Destructor, frees the executable memory
+            ~jitCode();
+
+            // Compile a program, returns 0 if there is no support for the platform or the memory couldn't be made executable
+            // The step function is called for every instruction the code doesn't do itself.
+            static jitCode* compile(const program& prog, const stepFunction& step);
+
+            // Execute the code on the registers and looked up variables (by slot, 0 if not looked up yet) of an execution of prog
+            // Returns 0 if it succeeded, or 1 if the step function failed, which stops the execution
+            int run(real* registers, real** vars, void* state, const program* prog) const;
+
+        private:
+            // The signature of the code
+            typedef int (*entryPoint)(real* registers, real** vars, void* state, const program* prog);
+
+            // Constructor, takes ownership of the executable memory
+            jitCode(void* memory, const std::size_t& size);
+
+            // Prevent copying:
+            jitCode& operator=(const jitCode& other);
+            jitCode(const jitCode& other);
+
+            void* memory;                           // The executable memory holding the code
+            std::size_t size;                       // The size of the memory
+            entryPoint entry;                       // The start of the code
+    };
+}
+
+#endif // JIT_H
@@ -18,6 +18,10 @@
 
 #include "mathfunction.h"
 #include "calc.h"
+#include "context.h"
+#include "instrumentation.h"
+#include "profiler.h"
+#include "numberengine.h"
 #include <limits>
 #include <algorithm>
 
@@ -25,19 +29,53 @@ namespace calc
 {
     // mathFunction:
         // Public:
-            mathFunction::mathFunction(const bool& cleanUpNeeded)
-            : cleanMeUp(cleanUpNeeded) {}
+            mathFunction::~mathFunction()
+            {}
 
             void mathFunction::setCleanUpNeeded(const bool& newCleanUpNeeded)
             { cleanMeUp = newCleanUpNeeded; }
             bool mathFunction::cleanUpNeeded() const
             { return cleanMeUp; }
 
+            real mathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                argList args;
+                for(std::vector<string>::const_iterator pos = expressions.begin(); pos != expressions.end(); ++pos)
+                    args.push_back(context::compile(*pos, &env)->execute(env));
+                return execute(args, name);
+            }
+
+            bool mathFunction::supportsBatch() const
+            { return false; }
+
+            bool mathFunction::executeBatch(const real* const*, const size_t&, const size_t&, real*, const string&)
+            { return false; }
+
+            bool mathFunction::differentiate(const argList&, const argList&, const string&, real&, real&)
+            { return false; }
+
+            bool mathFunction::takesExpressions() const
+            { return false; }
+
+        // Protected:
+            real mathFunction::differentiateExpression(const program& prog, environment& env, const argList& args, const argList& slopes)
+            {
+                // The arguments are bound to the variable slots of ARG0, ARG1, ... as dual numbers, their slopes are the derivatives
+                const std::vector<string>& variables = prog.getVariables();
+                std::vector<dual> arguments(args.size());
+                std::vector<const dual*> columns(variables.size(), 0);
+                for(size_t i = 0; i < args.size(); ++i)
+                {
+                    arguments[i] = dual(args[i], slopes[i]);
+                    const std::vector<string>::const_iterator pos = std::find(variables.begin(), variables.end(), "ARG"+real2str(i));
+                    if(pos != variables.end())
+                        columns[pos - variables.begin()] = &arguments[i];
+                }
+                return numberEngine<dual>().evaluate(prog, env, columns).derivative;
+            }
+
     // preDefinedMathFunction:
         // Public:
-            preDefinedMathFunction::preDefinedMathFunction(const function& initFunction, const bool& cleanUpNeeded)
-            : mathFunction(cleanUpNeeded), currFunc(initFunction){}
-
             void preDefinedMathFunction::setFunction(const function& newFunction)
             { currFunc = newFunction; }
 
@@ -61,9 +99,6 @@ namespace calc
 
     // cppMathFunction:
         // Public:
-            cppMathFunction::cppMathFunction(const function& initFunction, const bool& cleanUpNeeded)
-            : mathFunction(cleanUpNeeded), currFunc(initFunction){}
-
             void cppMathFunction::setFunction(const function& newFunction)
             { currFunc = newFunction; }
 
@@ -93,20 +128,27 @@ namespace calc
     // userDefinedMathFunction:
         // Public:
             userDefinedMathFunction::userDefinedMathFunction(const string& expression, const bool& cleanUpNeeded)
-            : mathFunction(cleanUpNeeded), calculator(new calc(expression, false)) {}
+            : mathFunction(cleanUpNeeded), calculator(new calc(expression, false)), compiled(0) {}
 
             userDefinedMathFunction::~userDefinedMathFunction()
             { delete calculator; }
 
             void userDefinedMathFunction::setExpression(const string& newExpression)
             {
-                // Change the expression of the calculator
+                // Change the expression of the calculator, a compiled version of the old expression can't be used any more
                 calculator->setExpression(newExpression);
+                compiled = 0;
             }
 
             string userDefinedMathFunction::getExpression() const
             { return calculator->getExpression(); }
 
+            void userDefinedMathFunction::setCompiled(mathFunction* function)
+            { compiled = function; }
+
+            mathFunction* userDefinedMathFunction::getCompiled() const
+            { return compiled; }
+
             bool userDefinedMathFunction::isValidExpression()
             {
                 // If the expression isn't parsed yet, parse it
@@ -118,12 +160,17 @@ namespace calc
 
             real userDefinedMathFunction::execute(const argList& vars, const string& name)
             {
+                CALC_PHASE(phaseFunctionCall);
+
+                // A compiled version gives the same results and errors, it never calls an interpreted function so it can't call itself
+                if(compiled)
+                    return compiled->execute(vars, name);
+
                 // Check if this function isn't (indirectly) calling itself
+                // Every function takes itself off the call stack again, also when it fails, because functions like SOLVE() may
+                // continue after an error. The functions still calling it have to find the call stack as they left it.
                 if(std::find(userDefinedMathFunction::callStack.begin(), userDefinedMathFunction::callStack.end(), name) != userDefinedMathFunction::callStack.end())
-                {
-                    userDefinedMathFunction::callStack.clear();
                     throw calcError("A function may not (indirectly) call itself", calcError::recursiveCall, name);
-                }
                 userDefinedMathFunction::callStack.push_back(name);
 
                 // Find the number of arguments in the expression
@@ -135,8 +182,8 @@ namespace calc
                 // Check if the numbers of arguments is right, if not throw an error
                 if(vars.size()<argumentCount)
                 {
-                    // Clear the call stack
-                    userDefinedMathFunction::callStack.clear();
+                    // This function is done executing, pop it from the call stack
+                    userDefinedMathFunction::callStack.pop_back();
 
                     // Throw the error
                     std::vector<real> extraRealInfo(2, vars.size());
@@ -145,8 +192,8 @@ namespace calc
                 }
                 if(vars.size()>argumentCount)
                 {
-                    // Clear the call stack
-                    userDefinedMathFunction::callStack.clear();
+                    // This function is done executing, pop it from the call stack
+                    userDefinedMathFunction::callStack.pop_back();
 
                     // Throw the error
                     std::vector<real> extraRealInfo(2, vars.size());
@@ -154,14 +201,15 @@ namespace calc
                     throw calcError("Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
                 }
 
-                // Parse the expression (if it isn't parsed yet)
+                // Parse the expression (if it isn't parsed yet), the call is a cache hit if it has been parsed and compiled before
+                CALC_PROFILE_CACHE_HIT(calculator->compiled());
                 calculator->parse();
 
                 // Throw an error if the expression is invalid
                 if(!calculator->isValidExpression())
                 {
-                    // Clear the call stack
-                    userDefinedMathFunction::callStack.clear();
+                    // This function is done executing, pop it from the call stack
+                    userDefinedMathFunction::callStack.pop_back();
 
                     // Throw the error
                     std::vector<string> extraStringInfo(2, calculator->getExpression());
@@ -194,10 +242,10 @@ namespace calc
                     // Return the result
                     return out;
                 }
-                catch(calcError&)
+                catch(...)
                 {
-                    // Clear the call stack
-                    userDefinedMathFunction::callStack.clear();
+                    // This function is done executing, pop it from the call stack
+                    userDefinedMathFunction::callStack.pop_back();
 
                     // Put the original values back
                     for(varList::const_iterator pos = originalVars.begin(); pos != originalVars.end(); ++pos)
@@ -208,6 +256,20 @@ namespace calc
                 }
             }
 
+            bool userDefinedMathFunction::differentiate(const argList& args, const argList& slopes, const string& name, real& value, real& derivative)
+            {
+                // The value is calculated the normal way first, which throws the errors (e.g. of a function calling itself)
+                value = execute(args, name);
+
+                // Expressions that can't be compiled are differentiated by central differences
+                const program* prog = calculator->getProgram();
+                if(prog == 0)
+                    return false;
+                calcEnvironment env;
+                derivative = differentiateExpression(*prog, env, args, slopes);
+                return true;
+            }
+
         // Private:
             // Static:
                 std::list<string> userDefinedMathFunction::callStack = std::list<string>();
@@ -28,8 +28,10 @@ namespace calc
     class mathFunction
     {
         public:
-            // Constructor
-            mathFunction(const bool& cleanUpNeeded);
+            // Constructor, constexpr so functions with static storage are initialized before any code runs
+            constexpr mathFunction(const bool& cleanUpNeeded) : cleanMeUp(cleanUpNeeded) {}
+            // Destructor
+            virtual ~mathFunction();
 
             // Sets whether this object should be cleaned up by its parent, i.e. that it should be deleted when its parent is done with it
             void setCleanUpNeeded(const bool& newCleanUpNeeded);
@@ -38,8 +40,29 @@ namespace calc
 
             // Execute the function
             virtual real execute(const argList& vars, const string& name) = 0;
+            // Execute the function with its arguments unevaluated, the expressions are calculated in the given environment
+            // By default all expressions are calculated from left to right and the results are passed to execute()
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true if the function can calculate a block of rows at once using executeBatch(), false by default
+            virtual bool supportsBatch() const;
+            // Execute the function for a block of rows at once, args[i][row] is argument i of the given row
+            // Returns false if any of the rows failed, then execute() is called for every row instead,
+            // so the errors are reported for the right rows
+            virtual bool executeBatch(const real* const* args, const size_t& argCount, const size_t& rowCount, real* results, const string& name);
+            // Calculate the function along with its derivative, the arguments change by the given slopes (e.g. 1 for one of them and 0 for the others)
+            // Returns false if the function can't differentiate itself, which it can't by default, then it's differentiated by central differences
+            // (see numberEngine<dual>). Functions defined by an expression differentiate it exactly, errors are thrown like execute() does.
+            virtual bool differentiate(const argList& args, const argList& slopes, const string& name, real& value, real& derivative);
+
+            // Returns true if the function gets its arguments unevaluated, i.e. it's called using executeExpressions(), false by default
+            // The compiler looks the function up when an expression is compiled, a compiled expression keeps calling it the same way.
+            virtual bool takesExpressions() const;
 
         protected:
+            // Calculate the derivative of an expression in which ARG0, ARG1, ... are the arguments, which change by the given slopes
+            // The other variables are found in the given environment and don't change, see differentiate()
+            static real differentiateExpression(const program& prog, environment& env, const argList& args, const argList& slopes);
+
             // Whether this function should be cleaned up by its parent
             bool cleanMeUp;
     };
@@ -51,7 +74,8 @@ namespace calc
             typedef real (*function)(const argList&);
 
             // Constructor
-            preDefinedMathFunction(const function& initFunction, const bool& cleanUpNeeded = false);
+            constexpr preDefinedMathFunction(const function& initFunction, const bool& cleanUpNeeded = false)
+            : mathFunction(cleanUpNeeded), currFunc(initFunction) {}
 
             // Change the function
             void setFunction(const function& newFunction);
@@ -71,7 +95,8 @@ namespace calc
             typedef double (*function)(double);
 
             // Constructor
-            cppMathFunction(const function& initFunction, const bool& cleanUpNeeded = false);
+            constexpr cppMathFunction(const function& initFunction, const bool& cleanUpNeeded = false)
+            : mathFunction(cleanUpNeeded), currFunc(initFunction) {}
 
             // Change the function
             void setFunction(const function& newFunction);
@@ -96,12 +121,19 @@ namespace calc
             void setExpression(const string& newExpression);
             // Get the current expression
             string getExpression() const;
+            // Let a compiled version of the expression execute this function, e.g. a function exported to C++ (see nativeexport.h)
+            // It's used until the expression is changed, 0 goes back to interpreting the expression
+            void setCompiled(mathFunction* function);
+            // Get the compiled version of the expression, returns 0 if the expression is interpreted
+            mathFunction* getCompiled() const;
 
             // Check if the current expression is valid
             bool isValidExpression();
 
             // Execute the expression
             virtual real execute(const argList& vars, const string& name);
+            // Calculate the expression with dual numbers, if it can be compiled
+            virtual bool differentiate(const argList& args, const argList& slopes, const string& name, real& value, real& derivative);
 
         private:
             // Static member to filter out functions that (indirectly) call themselfs
@@ -109,6 +141,8 @@ namespace calc
 
             // The calculator holding the expression, needed to calculate the expression
             calc* calculator;
+            // The compiled version of the expression, 0 if there is none
+            mathFunction* compiled;
     };
 }
 
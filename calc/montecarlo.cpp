@@ -0,0 +1,184 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "montecarlo.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace calc
+{
+    namespace
+    {
+        // The fewest samples of a chunk, so the threads don't spend their time on starting chunks
+        const size_t minChunkSize = 1024;
+        // The most chunks a simulation is divided into, which limits the memory used for their statistics
+        const size_t maxChunkCount = 4096;
+
+        // The statistics of the samples of a chunk
+        struct chunkResult
+        {
+            chunkResult()
+            : skipped(0), errorCount(0) {}
+
+            runningStatistics statistics;           // The count, mean, variance, minimum and maximum of the results
+            size_t skipped;                         // The number of results that aren't finite numbers
+            size_t errorCount;                      // The number of samples that failed
+            calcError firstError;                   // The error of the first sample that failed
+        };
+    }
+
+    // monteCarlo:
+        // Public:
+            monteCarlo::monteCarlo(const size_t& threadCount)
+            : threadCount(threadCount)
+            {
+                const real defaultProbabilities[] = {0.05, 0.25, 0.5, 0.75, 0.95};
+                probabilities.assign(defaultProbabilities, defaultProbabilities + 5);
+            }
+
+            void monteCarlo::setProbabilities(const std::vector<real>& newProbabilities)
+            {
+                for(size_t i = 0; i < newProbabilities.size(); ++i)
+                {
+                    if(!(newProbabilities[i] >= 0 && newProbabilities[i] <= 1))
+                        throw calcError("Invalid argument!", calcError::invalidArguments, newProbabilities[i]);
+                }
+                probabilities = newProbabilities;
+            }
+
+            const std::vector<real>& monteCarlo::getProbabilities() const
+            { return probabilities; }
+
+            monteCarlo::summary monteCarlo::run(const context& definitions, const program& prog, const size_t& sampleCount, randomGenerator& random) const
+            {
+                // The chunks only depend on the number of samples, every chunk gets its own stream
+                const size_t chunkSize = std::max(minChunkSize, (sampleCount + maxChunkCount - 1) / maxChunkCount);
+                const size_t chunkCount = (sampleCount + chunkSize - 1) / chunkSize;
+                std::vector<randomGenerator> streams;
+                streams.reserve(chunkCount);
+                for(size_t i = 0; i < chunkCount; ++i)
+                    streams.push_back(random.split());
+                std::vector<chunkResult> results(chunkCount);
+
+                // The counts of the quantiles can be added in any order, so every thread counts its own results
+                quantileEstimator quantiles(probabilities);
+                std::mutex quantilesMutex;
+
+                // Every thread takes the next chunk until all are done
+                // A chunk of which every sample failed, or an unexpected exception, stops the simulation
+                std::atomic<size_t> nextChunk(0);
+                std::exception_ptr failure;
+                std::atomic<bool> failed(false);
+                std::atomic<bool> stopped(false);
+                auto worker = [&]()
+                {
+                    quantileEstimator threadQuantiles(probabilities);
+                    try
+                    {
+                        while(!failed && !stopped)
+                        {
+                            // A chunk that's taken is always finished, so the chunks that are done are the first ones
+                            const size_t chunk = nextChunk++;
+                            if(chunk >= chunkCount)
+                                break;
+                            chunkResult& result = results[chunk];
+                            contextFrame frame(definitions);
+                            frame.useRandomStream(streams[chunk]);
+                            const size_t first = chunk * chunkSize;
+                            const size_t end = std::min(sampleCount, first + chunkSize);
+                            for(size_t sample = first; sample < end; ++sample)
+                            {
+                                try
+                                {
+                                    const real value = frame.execute(prog);
+                                    if(std::isfinite(value))
+                                    {
+                                        result.statistics.add(value);
+                                        threadQuantiles.add(value);
+                                    }
+                                    else
+                                        ++result.skipped;
+                                }
+                                catch(calcError& err)
+                                {
+                                    if(result.errorCount++ == 0)
+                                        result.firstError = err;
+                                }
+                            }
+                            if(result.errorCount == end - first)
+                                stopped = true;
+                        }
+                    }
+                    catch(...)
+                    {
+                        if(!failed.exchange(true))
+                            failure = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> lock(quantilesMutex);
+                    quantiles.merge(threadQuantiles);
+                };
+
+                // The current thread is one of the threads
+                size_t threads = threadCount > 0 ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+                threads = std::min(threads, std::max<size_t>(chunkCount, 1));
+                std::vector<std::thread> helpers;
+                for(size_t i = 1; i < threads; ++i)
+                    helpers.push_back(std::thread(worker));
+                worker();
+                for(size_t i = 0; i < helpers.size(); ++i)
+                    helpers[i].join();
+                if(failure)
+                    std::rethrow_exception(failure);
+
+                // The first chunk that failed completely is the same for any number of threads, since the chunks that are done are the first ones
+                for(size_t i = 0; i < chunkCount; ++i)
+                {
+                    if(results[i].errorCount > 0 && results[i].errorCount == std::min(chunkSize, sampleCount - i * chunkSize))
+                        throw results[i].firstError;
+                }
+
+                // Merge the statistics of the chunks in their order
+                summary out;
+                out.samples = sampleCount;
+                out.skipped = 0;
+                out.errorCount = 0;
+                for(size_t i = 0; i < chunkCount; ++i)
+                {
+                    out.statistics.merge(results[i].statistics);
+                    out.skipped += results[i].skipped;
+                    if(out.errorCount == 0 && results[i].errorCount > 0)
+                        out.firstError = results[i].firstError;
+                    out.errorCount += results[i].errorCount;
+                }
+                out.quantiles = quantiles.getQuantiles();
+                return out;
+            }
+
+            monteCarlo::summary monteCarlo::run(context& definitions, const program& prog, const size_t& sampleCount) const
+            {
+                // The context continues after the streams that were split off
+                randomGenerator random = definitions.getRandom();
+                summary out = run(static_cast<const context&>(definitions), prog, sampleCount, random);
+                definitions.setRandom(random);
+                return out;
+            }
+}
@@ -0,0 +1,75 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <vector>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "context.h"
+#include "random.h"
+#include "statistics.h"
+
+namespace calc
+{
+    // Calculates an expression containing RAND many times on all processors, and collects the statistics of the results (Monte Carlo simulation)
+    // The samples are divided into chunks, every chunk is calculated in its own frame and draws from its own stream of random numbers.
+    // The streams are split off in the order of the chunks and their statistics are merged in that order, so the results only depend
+    // on the generator and the number of samples, not on the number of threads. The samples aren't stored, only their statistics:
+    // the mean and variance are collected with Welford's algorithm and the quantiles are estimated by quantileEstimator.
+    class monteCarlo
+    {
+        public:
+            // The statistics of the results of a simulation
+            struct summary
+            {
+                size_t samples;                             // The number of samples that were calculated
+                runningStatistics statistics;               // The count, mean, variance, minimum and maximum of the results
+                std::vector<real> quantiles;                // The estimated quantiles of the results, in the order of the probabilities
+                size_t skipped;                             // The number of results that aren't finite numbers, they're left out of the statistics
+                size_t errorCount;                          // The number of samples that couldn't be calculated
+                calcError firstError;                       // The error of the first sample that failed, only valid if errorCount isn't 0
+            };
+
+            // Constructor, the samples are calculated by the given number of threads, 0 for one per processor
+            // The quantiles of the default probabilities are estimated: 5%, 25%, 50%, 75% and 95%.
+            monteCarlo(const size_t& threadCount = 0);
+
+            // Set the probabilities of the quantiles that are estimated, they have to be between 0 and 1
+            // Throws a calcError if one of them isn't.
+            void setProbabilities(const std::vector<real>& newProbabilities);
+            // Get the probabilities of the quantiles that are estimated
+            const std::vector<real>& getProbabilities() const;
+
+            // Execute the program sampleCount times on the context, the streams of random numbers are split off the given generator
+            // Assignments only last for the chunk they're made in, they aren't written to the context.
+            // If every sample of a chunk fails, e.g. because the expression uses an unknown function, the simulation stops
+            // and the error of its first sample is thrown.
+            summary run(const context& definitions, const program& prog, const size_t& sampleCount, randomGenerator& random) const;
+            // Execute the program sampleCount times on the context, the streams are split off the generator of the context
+            summary run(context& definitions, const program& prog, const size_t& sampleCount) const;
+
+        private:
+            size_t threadCount;                         // The number of threads, 0 for one per processor
+            std::vector<real> probabilities;            // The probabilities of the quantiles
+    };
+}
+
+#endif // MONTECARLO_H
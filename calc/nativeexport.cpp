@@ -0,0 +1,564 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "nativeexport.h"
+#include "calc.h"
+#include "builtins.h"
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+namespace calc
+{
+    namespace
+    {
+        // The code of the plugin that doesn't depend on the functions, written before them
+        const char* sourceHeader =
+            "#include <cmath>\n"
+            "#include \"plugin.h\"\n"
+            "\n"
+            "namespace\n"
+            "{\n"
+            "    // Calculate a function for a single row\n"
+            "    template <int (*Function)(const double*, double*)>\n"
+            "    int scalar(const double* args, size_t, double* result, void*)\n"
+            "    { return Function(args, result); }\n"
+            "\n"
+            "    // Calculate a function for every row, stopping at the first error\n"
+            "    template <int (*Function)(const double*, double*), size_t ArgumentCount>\n"
+            "    int batch(const double* const* args, size_t, size_t rowCount, double* results, void*)\n"
+            "    {\n"
+            "        double row[ArgumentCount + 1];\n"
+            "        for(size_t i = 0; i < rowCount; ++i)\n"
+            "        {\n"
+            "            for(size_t j = 0; j < ArgumentCount; ++j)\n"
+            "                row[j] = args[j][i];\n"
+            "            const int status = Function(row, &results[i]);\n"
+            "            if(status != DALC_PLUGIN_OK)\n"
+            "                return status;\n"
+            "        }\n"
+            "        return DALC_PLUGIN_OK;\n"
+            "    }\n"
+            "\n"
+            "    // Report a division or modulo by 0, the divisor is the result so it's known whether it was 0 or -0\n"
+            "    int divisionByZero(const double divisor, double* result, const int status)\n"
+            "    {\n"
+            "        *result = divisor;\n"
+            "        return status;\n"
+            "    }\n"
+            "\n"
+            "    // The integer value of a register, integers are calculated exactly as long as they fit in a long long\n"
+            "    struct exactInteger\n"
+            "    {\n"
+            "        long long value;\n"
+            "        bool exact;\n"
+            "    };\n"
+            "\n"
+            "    // The integer operations, they return false if the result doesn't fit\n"
+            "    const long long largest = 9223372036854775807LL, smallest = -9223372036854775807LL - 1;\n"
+            "    inline bool negate(const long long a, const long long, long long& out)\n"
+            "    { return a != smallest && (out = -a, true); }\n"
+            "    inline bool add(const long long a, const long long b, long long& out)\n"
+            "    { return !((b > 0 && a > largest - b) || (b < 0 && a < smallest - b)) && (out = a + b, true); }\n"
+            "    inline bool subtract(const long long a, const long long b, long long& out)\n"
+            "    { return !((b < 0 && a > largest + b) || (b > 0 && a < smallest + b)) && (out = a - b, true); }\n"
+            "    inline bool multiply(const long long a, const long long b, long long& out)\n"
+            "    {\n"
+            "        const unsigned long long first = a < 0 ? 0 - static_cast<unsigned long long>(a) : a, second = b < 0 ? 0 - static_cast<unsigned long long>(b) : b;\n"
+            "        if(first != 0 && second > 18446744073709551615ULL / first)\n"
+            "            return false;\n"
+            "        const unsigned long long product = first * second;\n"
+            "        const bool negative = (a < 0) != (b < 0);\n"
+            "        if(product > static_cast<unsigned long long>(largest) + (negative ? 1 : 0))\n"
+            "            return false;\n"
+            "        out = negative ? static_cast<long long>(0 - product) : static_cast<long long>(product);\n"
+            "        return true;\n"
+            "    }\n"
+            "    inline bool modulo(const long long a, const long long b, long long& out)\n"
+            "    { return b != 0 && (out = b == -1 ? 0 : a % b, true); }\n"
+            "    inline bool greater(const long long a, const long long b, long long& out)\n"
+            "    { return out = a > b, true; }\n"
+            "    inline bool less(const long long a, const long long b, long long& out)\n"
+            "    { return out = a < b, true; }\n"
+            "\n"
+            "    // Calculate an integer operation exactly if possible, otherwise the result is the same operation on doubles (realResult)\n"
+            "    // A result of 0 is taken from realResult as well, so it has the right sign\n"
+            "    template <bool (*Operation)(long long, long long, long long&)>\n"
+            "    inline void integerOperation(const exactInteger a, const exactInteger b, const double realResult, double& dest, exactInteger& intDest)\n"
+            "    {\n"
+            "        long long value = 0;\n"
+            "        intDest.exact = a.exact && b.exact && Operation(a.value, b.value, value);\n"
+            "        if(intDest.exact)\n"
+            "            intDest.value = value;\n"
+            "        dest = intDest.exact && value != 0 ? static_cast<double>(value) : realResult;\n"
+            "    }\n"
+            "\n"
+            "    // Get an operand of a bitwise operator, its exact value if it has one and the value rounded to an integer otherwise\n"
+            "    inline long long bitwiseOperand(const double value, const exactInteger intValue, const bool hasInteger)\n"
+            "    { return hasInteger && intValue.exact ? intValue.value : static_cast<long long>(std::round(value)); }\n";
+
+        // Get the index of the argument with the given name (ARG0, ARG1, ...), returns -1 if it isn't one of the arguments
+        int argumentIndex(const string& name, const unsigned short& argumentCount)
+        {
+            for(unsigned short i = 0; i < argumentCount; ++i)
+            {
+                if(name == "ARG"+real2str(i))
+                    return i;
+            }
+            return -1;
+        }
+
+        // Get the name of a register in the C++ code
+        string registerName(const unsigned int& reg)
+        {
+            std::ostringstream out;
+            out<<"r["<<reg<<']';
+            return out.str();
+        }
+
+        // Get the name of the integer value of a register in the C++ code
+        string integerName(const unsigned int& reg)
+        {
+            std::ostringstream out;
+            out<<"n["<<reg<<']';
+            return out.str();
+        }
+
+        // Get a C++ literal of an integer, the smallest one can't be written directly
+        string integerLiteral(const integer& value)
+        {
+            std::ostringstream out;
+            if(value == std::numeric_limits<integer>::min())
+                out<<'('<<(value + 1)<<"LL - 1)";
+            else
+                out<<value<<"LL";
+            return out.str();
+        }
+
+        // Get the name of the C++ function calculating the user defined function with the given index
+        string functionName(const size_t& index)
+        {
+            std::ostringstream out;
+            out<<"function"<<index;
+            return out.str();
+        }
+    }
+
+    // nativeExporter:
+        // Public:
+            nativeExporter::nativeExporter(const settingHandler& settings)
+            {
+                // Compile every user defined function, the names of their settings start with an 'f'
+                for(settingHandler::const_iterator pos = settings.begin(); pos != settings.end(); ++pos)
+                {
+                    if(pos->first.size() < 2 || pos->first[0] != 'f')
+                        continue;
+                    function& func = functions[pos->first.substr(1)];
+                    func.expression = pos->second;
+
+                    // Find the number of arguments in the expression, the same way userDefinedMathFunction does
+                    func.argumentCount = 0;
+                    while(func.argumentCount < std::numeric_limits<unsigned short>::max() && func.expression.find("ARG"+real2str(func.argumentCount)) != string::npos)
+                        ++func.argumentCount;
+
+                    // Only expressions that are compiled by the calculator can be exported
+                    calc calculator(func.expression, false);
+                    calculator.parse();
+                    const program* prog = calculator.isValidExpression() ? calculator.getProgram() : 0;
+                    if(!calculator.isValidExpression())
+                        func.problem = "The expression is invalid";
+                    else if(!prog)
+                        func.problem = "The expression can't be compiled";
+                    else
+                        func.prog = *prog;
+                }
+
+                // Check what the functions do once all of them are known, and then the functions they call,
+                // which also gives the order in which they're written
+                for(functionMap::iterator pos = functions.begin(); pos != functions.end(); ++pos)
+                {
+                    if(pos->second.problem.empty())
+                        checkFunction(pos->second);
+                }
+                std::map<string, int> state;
+                for(functionMap::const_iterator pos = functions.begin(); pos != functions.end(); ++pos)
+                    checkCalls(pos->first, state);
+            }
+
+            std::vector<string> nativeExporter::getExportable() const
+            { return order; }
+
+            std::vector<string> nativeExporter::writeSource(std::ostream& out, const string& pluginName) const
+            {
+                // Explain where the file comes from and how to build it
+                out<<"// The plugin "<<stringLiteral(pluginName)<<", exported by Dalculator from user defined functions\n"
+                   <<"// Build it without optimizations that change floating point math, so it gives exactly the same results as the calculator:\n"
+                   <<"//     c++ -std=c++11 -O2 -ffp-contract=off -fno-builtin -fPIC -shared -I<directory of plugin.h> <this file> -o <plugin>.so\n"
+                   <<"\n"
+                   <<sourceHeader;
+
+                // Write the functions, every function after the functions it calls
+                std::map<string, size_t> indices;
+                for(size_t i = 0; i < order.size(); ++i)
+                {
+                    indices[order[i]] = i;
+                    out<<'\n';
+                    writeFunction(out, order[i], functions.find(order[i])->second, indices);
+                }
+
+                // Write the description of the plugin
+                if(order.size())
+                {
+                    out<<"\n"
+                       <<"    // The functions of the plugin\n"
+                       <<"    const dalc_plugin_function functions[] =\n"
+                       <<"    {\n";
+                    for(size_t i = 0; i < order.size(); ++i)
+                    {
+                        const function& func = functions.find(order[i])->second;
+                        out<<"        {"<<stringLiteral(order[i])<<", "<<func.argumentCount<<", "<<func.argumentCount<<", "
+                           <<"scalar<"<<functionName(i)<<">, batch<"<<functionName(i)<<", "<<func.argumentCount<<">, 0, "
+                           <<stringLiteral(func.expression)<<'}'<<(i+1 < order.size() ? "," : "")<<'\n';
+                    }
+                    out<<"    };\n";
+                }
+                out<<"\n"
+                   <<"    // The plugin\n"
+                   <<"    const dalc_plugin plugin = {DALC_PLUGIN_ABI_VERSION, "<<stringLiteral(pluginName)<<", \"1\", "
+                   <<(order.size() ? "functions" : "0")<<", "<<order.size()<<"};\n"
+                   <<"}\n"
+                   <<"\n"
+                   <<"DALC_PLUGIN_DEFINE(plugin)\n";
+
+                // Report the functions that couldn't be exported
+                std::vector<string> messages;
+                for(functionMap::const_iterator pos = functions.begin(); pos != functions.end(); ++pos)
+                {
+                    if(!pos->second.problem.empty())
+                        messages.push_back(pos->first+": "+pos->second.problem);
+                }
+                return messages;
+            }
+
+            std::vector<string> nativeExporter::saveSource(const string& fileName, const string& pluginName) const
+            {
+                std::ofstream file(fileName.c_str());
+                if(!file)
+                    throw fileError(fileName, fileError::action_opening);
+                const std::vector<string> messages = writeSource(file, pluginName);
+                file.close();
+                if(!file)
+                    throw fileError(fileName, fileError::action_writing);
+                return messages;
+            }
+
+        // Private:
+            void nativeExporter::checkFunction(function& func) const
+            {
+                const std::vector<program::instruction>& instructions = func.prog.getInstructions();
+                const std::vector<string>& variables = func.prog.getVariables();
+                const std::vector<string>& callNames = func.prog.getFunctions();
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    switch(instr->op)
+                    {
+                        // Only the arguments can be used, other variables can change between calls
+                        case program::opLoad:
+                        case program::opCheck:
+                            if(argumentIndex(variables[instr->a], func.argumentCount) < 0)
+                            {
+                                func.problem = "It uses the variable "+variables[instr->a];
+                                return;
+                            }
+                        break;
+
+                        case program::opStore:
+                            func.problem = "It assigns a value to "+variables[instr->a];
+                        return;
+
+                        case program::opCallExpressions:
+                            func.problem = "It calls "+callNames[instr->a]+", which can't be exported";
+                        return;
+
+                        // User defined functions can be called if they can be exported too, built-in functions if they have a C++ counterpart
+                        case program::opCall:
+                        {
+                            const string& name = callNames[instr->a];
+                            functionMap::const_iterator callee = functions.find(name);
+                            if(callee != functions.end() && callee->second.argumentCount != instr->b)
+                            {
+                                func.problem = "It calls "+name+" with a wrong number of arguments";
+                                return;
+                            }
+                            if(callee == functions.end() && (!builtIns::getNativeCode(name) || instr->b != 1))
+                            {
+                                func.problem = "It calls "+name+", which can't be exported";
+                                return;
+                            }
+                            if(callee != functions.end())
+                                func.callees.push_back(name);
+                        }
+                        break;
+
+                        default:
+                        break;
+                    }
+                }
+            }
+
+            void nativeExporter::checkCalls(const string& name, std::map<string, int>& state)
+            {
+                // A function that's already being checked calls itself, the calculator doesn't allow that
+                function& func = functions[name];
+                int& currState = state[name];
+                if(currState == 2)
+                    return;
+                if(currState == 1)
+                {
+                    func.problem = "It (indirectly) calls itself";
+                    return;
+                }
+
+                // Check the functions it calls first, it can only be exported if they can be exported
+                currState = 1;
+                for(std::vector<string>::const_iterator callee = func.callees.begin(); callee != func.callees.end(); ++callee)
+                {
+                    checkCalls(*callee, state);
+                    if(func.problem.empty() && !functions[*callee].problem.empty())
+                        func.problem = "It calls "+*callee+", which can't be exported";
+                }
+                currState = 2;
+                if(func.problem.empty())
+                    order.push_back(name);
+            }
+
+            void nativeExporter::writeFunction(std::ostream& out, const string& name, const function& func, const std::map<string, size_t>& indices) const
+            {
+                const std::vector<program::instruction>& instructions = func.prog.getInstructions();
+                const std::vector<string>& variables = func.prog.getVariables();
+                const std::vector<string>& callNames = func.prog.getFunctions();
+                const std::vector<unsigned int>& arguments = func.prog.getArguments();
+
+                out<<"    // "<<stringLiteral(name)<<" = "<<stringLiteral(func.expression)<<'\n'
+                   <<"    int "<<functionName(indices.find(name)->second)<<"(const double*"<<(func.argumentCount ? " args" : "")<<", double* result)\n"
+                   <<"    {\n"
+                   <<"        double r["<<func.prog.getRegisterCount()<<"];\n";
+
+                // The integer values of the registers are only needed if any instruction reads them, the result of the plugin is a double anyway
+                bool usesIntegers = false;
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end() && !usesIntegers; ++instr)
+                    usesIntegers = instr->op != program::opIntConstant && (program::realOpcode(instr->op) != instr->op || instr->op == program::opBitwiseOr || instr->op == program::opBitwiseAnd);
+                if(usesIntegers)
+                    out<<"        exactInteger n["<<func.prog.getRegisterCount()<<"] = {};\n";
+
+                // Every instruction does exactly what program::execute() does
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    const string dest = registerName(instr->dest), a = registerName(instr->a), b = registerName(instr->b);
+                    const string intDest = integerName(instr->dest), intA = integerName(instr->a), intB = integerName(instr->b);
+                    switch(instr->op)
+                    {
+                        case program::opConstant:
+                            out<<"        "<<dest<<" = "<<realLiteral(func.prog.getConstants()[instr->a])<<";\n";
+                        break;
+
+                        case program::opLoad:
+                            out<<"        "<<dest<<" = args["<<argumentIndex(variables[instr->a], func.argumentCount)<<"];\n";
+                        break;
+
+                        case program::opNegate:
+                            out<<"        "<<dest<<" = "<<a<<" * -1;\n";
+                        break;
+
+                        case program::opPower:
+                            out<<"        if("<<a<<" < 0 && std::floor("<<b<<") != "<<b<<")\n"
+                               <<"            return DALC_PLUGIN_ERROR_NEGATIVE_POWER;\n"
+                               <<"        "<<dest<<" = std::pow("<<a<<", "<<b<<");\n";
+                        break;
+
+                        case program::opRoot:
+                            out<<"        if("<<a<<" < 0)\n"
+                               <<"            return DALC_PLUGIN_ERROR_NEGATIVE_ROOT;\n"
+                               <<"        "<<dest<<" = std::pow("<<a<<", 1/"<<b<<");\n";
+                        break;
+
+                        case program::opCheckDivisor:
+                            out<<"        if("<<a<<" == 0)\n"
+                               <<"            return divisionByZero("<<a<<", result, "<<(instr->b ? "DALC_PLUGIN_ERROR_MODULO_BY_ZERO" : "DALC_PLUGIN_ERROR_DIVISION_BY_ZERO")<<");\n";
+                        break;
+
+                        case program::opMultiply:
+                            out<<"        "<<dest<<" = "<<a<<" * "<<b<<";\n";
+                        break;
+
+                        case program::opDivide:
+                            out<<"        if("<<b<<" == 0)\n"
+                               <<"            return divisionByZero("<<b<<", result, DALC_PLUGIN_ERROR_DIVISION_BY_ZERO);\n"
+                               <<"        "<<dest<<" = "<<a<<" / "<<b<<";\n";
+                        break;
+
+                        case program::opModulo:
+                            out<<"        if("<<b<<" == 0)\n"
+                               <<"            return divisionByZero("<<b<<", result, DALC_PLUGIN_ERROR_MODULO_BY_ZERO);\n"
+                               <<"        "<<dest<<" = std::fmod("<<a<<", "<<b<<");\n";
+                        break;
+
+                        case program::opAdd:
+                            out<<"        "<<dest<<" = "<<a<<" + "<<b<<";\n";
+                        break;
+
+                        case program::opSubtract:
+                            out<<"        "<<dest<<" = "<<a<<" - "<<b<<";\n";
+                        break;
+
+                        case program::opGreater:
+                            out<<"        "<<dest<<" = "<<a<<" > "<<b<<";\n";
+                        break;
+
+                        case program::opLess:
+                            out<<"        "<<dest<<" = "<<a<<" < "<<b<<";\n";
+                        break;
+
+                        case program::opBitwiseOr:
+                        case program::opBitwiseAnd:
+                            out<<"        "<<intDest<<".value = bitwiseOperand("<<a<<", "<<intA<<", "<<((instr->c & 1) ? "true" : "false")<<") "
+                               <<(instr->op == program::opBitwiseOr ? '|' : '&')<<" bitwiseOperand("<<b<<", "<<intB<<", "<<((instr->c & 2) ? "true" : "false")<<");\n"
+                               <<"        "<<intDest<<".exact = true;\n"
+                               <<"        "<<dest<<" = static_cast<double>("<<intDest<<".value);\n";
+                        break;
+
+                        case program::opIntConstant:
+                            out<<"        "<<dest<<" = "<<realLiteral(func.prog.getConstants()[instr->a])<<";\n";
+                            if(usesIntegers)
+                            {
+                                out<<"        "<<intDest<<".value = "<<integerLiteral(func.prog.getIntegers()[instr->b])<<";\n"
+                                   <<"        "<<intDest<<".exact = true;\n";
+                            }
+                        break;
+
+                        case program::opIntNegate:
+                            out<<"        integerOperation<negate>("<<intA<<", "<<intA<<", "<<a<<" * -1, "<<dest<<", "<<intDest<<");\n";
+                        break;
+
+                        case program::opIntModulo:
+                            out<<"        if("<<b<<" == 0)\n"
+                               <<"            return divisionByZero("<<b<<", result, DALC_PLUGIN_ERROR_MODULO_BY_ZERO);\n"
+                               <<"        integerOperation<modulo>("<<intA<<", "<<intB<<", std::fmod("<<a<<", "<<b<<"), "<<dest<<", "<<intDest<<");\n";
+                        break;
+
+                        case program::opIntAdd:
+                        case program::opIntSubtract:
+                        case program::opIntMultiply:
+                        case program::opIntGreater:
+                        case program::opIntLess:
+                        {
+                            const char* operation = instr->op == program::opIntAdd ? "add" : instr->op == program::opIntSubtract ? "subtract" :
+                                                    instr->op == program::opIntMultiply ? "multiply" : instr->op == program::opIntGreater ? "greater" : "less";
+                            const char* realOperator = instr->op == program::opIntAdd ? " + " : instr->op == program::opIntSubtract ? " - " :
+                                                       instr->op == program::opIntMultiply ? " * " : instr->op == program::opIntGreater ? " > " : " < ";
+                            out<<"        integerOperation<"<<operation<<">("<<intA<<", "<<intB<<", "<<a<<realOperator<<b<<", "<<dest<<", "<<intDest<<");\n";
+                        }
+                        break;
+
+                        case program::opCall:
+                        {
+                            const string& callee = callNames[instr->a];
+                            std::map<string, size_t>::const_iterator index = indices.find(callee);
+                            if(index == indices.end())
+                            {
+                                // A built-in function, its code uses # for the argument
+                                string code = builtIns::getNativeCode(callee);
+                                const string arg = registerName(arguments[instr->c]);
+                                for(size_t pos = code.find('#'); pos != string::npos; pos = code.find('#', pos + arg.size()))
+                                    code.replace(pos, 1, arg);
+                                out<<"        "<<dest<<" = "<<code<<";\n";
+                                break;
+                            }
+
+                            // An exported function, which returns an error instead of throwing it, its result may be part of the error
+                            out<<"        {\n";
+                            if(instr->b)
+                            {
+                                out<<"            const double callArgs[] = {";
+                                for(unsigned int i = 0; i < instr->b; ++i)
+                                    out<<(i ? ", " : "")<<registerName(arguments[instr->c + i]);
+                                out<<"};\n";
+                            }
+                            out<<"            const int status = "<<functionName(index->second)<<"("<<(instr->b ? "callArgs" : "0")<<", &"<<dest<<");\n"
+                               <<"            if(status != DALC_PLUGIN_OK)\n"
+                               <<"            {\n"
+                               <<"                *result = "<<dest<<";\n"
+                               <<"                return status;\n"
+                               <<"            }\n"
+                               <<"        }\n";
+                        }
+                        break;
+
+                        // The arguments and the functions always exist, and stores and unevaluated arguments can't be exported
+                        case program::opCheck:
+                        case program::opCheckFunction:
+                        case program::opStore:
+                        case program::opCallExpressions:
+                        break;
+                    }
+                }
+
+                out<<"        *result = "<<registerName(func.prog.getResultRegister())<<";\n"
+                   <<"        return DALC_PLUGIN_OK;\n"
+                   <<"    }\n";
+            }
+
+            // Static:
+                string nativeExporter::realLiteral(const real& value)
+                {
+                    if(value != value)
+                        return "NAN";
+                    if(value == std::numeric_limits<real>::infinity())
+                        return "HUGE_VAL";
+                    if(value == -std::numeric_limits<real>::infinity())
+                        return "-HUGE_VAL";
+
+                    // 17 significant digits are enough to get exactly the same double back
+                    std::ostringstream out;
+                    out.precision(std::numeric_limits<real>::max_digits10);
+                    out<<value;
+                    string literal = out.str();
+                    if(literal.find_first_of(".e") == string::npos)
+                        literal += ".0";
+                    return literal;
+                }
+
+                string nativeExporter::stringLiteral(const string& str)
+                {
+                    // Quotes, backslashes and question marks (which could form trigraphs) are escaped, other special characters are written in octal
+                    std::ostringstream out;
+                    out<<'"';
+                    for(string::const_iterator pos = str.begin(); pos != str.end(); ++pos)
+                    {
+                        const unsigned char chr = *pos;
+                        if(chr == '"' || chr == '\\' || chr == '?')
+                            out<<'\\'<<chr;
+                        else if(chr < 32 || chr > 126)
+                            out<<'\\'<<static_cast<char>('0' + (chr >> 6))<<static_cast<char>('0' + ((chr >> 3) & 7))<<static_cast<char>('0' + (chr & 7));
+                        else
+                            out<<chr;
+                    }
+                    out<<'"';
+                    return out.str();
+                }
+}
@@ -0,0 +1,80 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef NATIVEEXPORT_H
+#define NATIVEEXPORT_H
+
+#include <ostream>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "settinghandler.h"
+
+namespace calc
+{
+    // Exports user defined functions to C++, as the source of a plugin (see plugin.h) that calculates them without the interpreter
+    // Every function is translated from its compiled form (see program.h) one instruction at a time, so the plugin gives exactly
+    // the same results and errors as the calculator, as long as it's built without optimizations that change floating point math:
+    //     c++ -std=c++11 -O2 -ffp-contract=off -fno-builtin -fPIC -shared -I<directory of plugin.h> functions.cpp -o functions.so
+    // Only functions that use nothing but their arguments, the operators, built-in functions with a C++ counterpart
+    // (see builtIns::getNativeCode()) and other exported functions can be exported, all other functions stay interpreted.
+    // Once loaded, the plugin is used in place of the definitions it was exported from, see pluginLoader::useCompiled().
+    class nativeExporter
+    {
+        public:
+            // Constructor, takes the user defined functions from the settings
+            nativeExporter(const settingHandler& settings);
+
+            // Get the names of the functions that can be exported
+            std::vector<string> getExportable() const;
+            // Write the source of the plugin with the given name, returns a message for every function that can't be exported
+            std::vector<string> writeSource(std::ostream& out, const string& pluginName) const;
+            // Write the source of the plugin to a file, throws a fileError if the file couldn't be written
+            std::vector<string> saveSource(const string& fileName, const string& pluginName) const;
+
+        private:
+            // A user defined function
+            struct function
+            {
+                string expression;                  // The expression
+                unsigned short argumentCount;       // The number of arguments
+                program prog;                       // The compiled expression
+                string problem;                     // Why it can't be exported, empty if it can
+                std::vector<string> callees;        // The user defined functions it calls
+            };
+            typedef std::map<string, function> functionMap;
+
+            // Check whether a function can be exported on its own, i.e. without looking at the functions it calls
+            void checkFunction(function& func) const;
+            // Check whether a function and the functions it calls can be exported, if so it's added to order after the functions it calls
+            // state holds 1 for functions that are being checked and 2 for functions that have been checked
+            void checkCalls(const string& name, std::map<string, int>& state);
+            // Write the C++ function calculating a user defined function, indices holds the index of every function that has been written
+            void writeFunction(std::ostream& out, const string& name, const function& func, const std::map<string, size_t>& indices) const;
+
+            // Convert a value to a C++ literal giving exactly the same value
+            static string realLiteral(const real& value);
+            // Convert a string to a C++ string literal
+            static string stringLiteral(const string& str);
+
+            functionMap functions;                  // The user defined functions
+            std::vector<string> order;              // The functions that can be exported, every function after the functions it calls
+    };
+}
+
+#endif // NATIVEEXPORT_H
@@ -0,0 +1,164 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef NATIVEFUNCTION_H
+#define NATIVEFUNCTION_H
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include "types.h"
+#include "error.h"
+#include "mathfunction.h"
+
+namespace calc
+{
+    // Helpers for nativeMathFunction, they find out what a callable takes and returns
+    namespace native
+    {
+        // A list of the indices 0, 1, ..., Count-1, used to expand the arguments of a call
+        template <unsigned int... Indices> struct indexList {};
+        template <unsigned int Count, unsigned int... Indices> struct makeIndexList : makeIndexList<Count - 1, Count - 1, Indices...> {};
+        template <unsigned int... Indices> struct makeIndexList<0, Indices...> { typedef indexList<Indices...> type; };
+
+        // The signature of a callable as a function pointer type, this gives the types of its arguments
+        // Function pointers and classes with a single operator() (like lambdas) are supported
+        template <typename Function> struct signature : signature<decltype(&Function::operator())> {};
+        template <typename Result, typename... Args> struct signature<Result (*)(Args...)>
+        {
+            typedef Result (*type)(Args...);
+            static const unsigned int arity = sizeof...(Args);
+        };
+        template <typename Class, typename Result, typename... Args> struct signature<Result (Class::*)(Args...)> : signature<Result (*)(Args...)> {};
+        template <typename Class, typename Result, typename... Args> struct signature<Result (Class::*)(Args...) const> : signature<Result (*)(Args...)> {};
+
+        // Convert a value of the calculator to an argument of type T
+        // Floating point arguments take the value as it is, integer arguments only accept integers that fit in T
+        // The largest value of a 64 bit type rounds up to a power of 2 as a real, so the values from the next integer on are refused.
+        template <typename T>
+        T toArgument(const real& value, std::false_type)
+        { return static_cast<T>(value); }
+        template <typename T>
+        T toArgument(const real& value, std::true_type)
+        {
+            if(std::floor(value) != value)
+                throw calcError("Only integers allowed", calcError::invalidArguments);
+            if(value < static_cast<real>(std::numeric_limits<T>::min()) || value >= static_cast<real>(std::numeric_limits<T>::max()) + 1)
+                throw calcError("Invalid argument!", calcError::invalidArguments, value);
+            return static_cast<T>(value);
+        }
+        template <typename T>
+        typename std::decay<T>::type toArgument(const real& value)
+        {
+            typedef typename std::decay<T>::type type;
+            return toArgument<type>(value, std::integral_constant<bool, std::is_integral<type>::value && !std::is_same<type, bool>::value>());
+        }
+    }
+
+    // A member function bound to an object, so it can be called like a normal function by nativeMathFunction
+    template <typename Method> class boundMethod;
+    template <typename Class, typename Result, typename... Args>
+    class boundMethod<Result (Class::*)(Args...)>
+    {
+        public:
+            // Typedef what a method is
+            typedef Result (Class::*method)(Args...);
+
+            // Constructor
+            constexpr boundMethod(const method& function, Class* obj)
+            : function(function), obj(obj) {}
+
+            // Call the member function on the object
+            Result operator()(Args... args) const
+            { return (obj->*function)(args...); }
+
+        private:
+            method function;                        // The member function
+            Class* obj;                             // The object it's called on
+    };
+
+    // A math function calling a C++ function, or an object with an operator() (like a lambda or a boundMethod)
+    // The number of arguments is taken from the function, so the function itself doesn't have to check it: calls with
+    // a different number of arguments throw the usual invalidArguments error. The arguments are read straight from the
+    // argument list of the call, without copying them. Arguments of an integer type only accept integers, an error is thrown otherwise.
+    //
+    // E.g. to add a function hypot(x, y):
+    //     calculator.setFunction("hypot", makeNativeFunction([](real x, real y) { return std::sqrt(x*x + y*y); }));
+    template <typename Function>
+    class nativeMathFunction : public mathFunction
+    {
+        public:
+            // The number of arguments the function takes
+            static const unsigned int arity = native::signature<Function>::arity;
+
+            // Constructor
+            constexpr nativeMathFunction(const Function& initFunction, const bool& cleanUpNeeded = false)
+            : mathFunction(cleanUpNeeded), currFunc(initFunction) {}
+
+            // Change the function
+            void setFunction(const Function& newFunction)
+            { currFunc = newFunction; }
+            // Get the function
+            const Function& getFunction() const
+            { return currFunc; }
+
+            // Execute this function
+            virtual real execute(const argList& vars, const string& name)
+            {
+                try
+                {
+                    // Check the number of arguments
+                    if(vars.size() != arity)
+                    {
+                        std::vector<real> extraRealInfo(2, vars.size());
+                        extraRealInfo[1] = arity;
+                        throw calcError(vars.size() < arity ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(), extraRealInfo);
+                    }
+
+                    // Execute the function using the given arguments
+                    return call(vars, typename native::makeIndexList<arity>::type(), typename native::signature<Function>::type());
+                }
+                catch(calcError& err)
+                {
+                    if(err.type == calcError::invalidArguments)
+                        err.extraStringInfo.push_back(name);
+                    throw err;
+                }
+                catch(...)
+                { throw calcError("Unknown error", calcError::unknown); }
+            }
+
+        private:
+            // Call the function, converting every argument to the type of its parameter
+            // The last argument is only used to find out the types of the parameters
+            template <unsigned int... Indices, typename Result, typename... Args>
+            real call(const argList& vars, native::indexList<Indices...>, Result (*)(Args...))
+            { return static_cast<real>(currFunc(native::toArgument<Args>(vars[Indices])...)); }
+
+            // The function to be executed by execute()
+            Function currFunc;
+    };
+
+    // Create a native math function on the heap, it's marked to be cleaned up so a calc deletes it when it's replaced or deleted
+    // (a context doesn't take ownership of its functions, so there it has to be deleted by the caller)
+    template <typename Function>
+    nativeMathFunction<typename std::decay<Function>::type>* makeNativeFunction(const Function& function)
+    { return new nativeMathFunction<typename std::decay<Function>::type>(function, true); }
+}
+
+#endif // NATIVEFUNCTION_H
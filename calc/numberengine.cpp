@@ -0,0 +1,1006 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "numberengine.h"
+#include "calc.h"
+#include "builtins.h"
+#include "mathfunction.h"
+#include "instrumentation.h"
+#include "profiler.h"
+#include "random.h"
+#include <limits>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        // The error for an unknown variable, mentioning the given string of the program
+        calcError unknownVariable(const program& prog, const unsigned int& stringIndex)
+        { return calcError("Unknown variable", calcError::unknownName, prog.getStrings()[stringIndex]); }
+
+        // The error for an unknown function
+        calcError unknownFunction(const program& prog, const unsigned int& slot)
+        { return calcError("Unknown function", calcError::unknownName, prog.getFunctions()[slot]); }
+
+        // Mark a row of executeBlock() as failed because of the given error, its result is set to NaN
+        template <typename Number>
+        void failRow(const size_t& row, const calcError& error, const Number& notANumber, Number* out, char* failed, std::vector<program::rowError>& errors)
+        {
+            failed[row] = 1;
+            out[row] = notANumber;
+            CALC_COUNT(counterExceptions, 1);
+            program::rowError err = {row, error};
+            errors.push_back(err);
+        }
+
+        // Mark all rows of executeBlock() that didn't fail yet as failed because of the given error
+        template <typename Number>
+        void failRows(const size_t& rowCount, const calcError& error, const Number& notANumber, Number* out, char* failed, std::vector<program::rowError>& errors)
+        {
+            for(size_t row = 0; row < rowCount; ++row)
+            {
+                if(!failed[row])
+                    failRow(row, error, notANumber, out, failed, errors);
+            }
+        }
+
+        // The number of degrees in a radian, as precise as a long double
+        const long double degreesPerRadian = 180 / 3.14159265358979323846264338327950288L;
+
+        // The product of the integers from first to last, with the given number of digits
+        decimal product(const integer& first, const integer& last, const int& digits)
+        {
+            // A few more digits make up for rounding every step, the result is exact as long as it fits
+            const int working = digits + 20;
+            decimal out = decimal::fromInteger(1, working);
+            for(integer i = first; i <= last; ++i)
+                out *= decimal::fromInteger(i);
+            return out.withDigits(digits);
+        }
+
+        // The largest number of factors FACULTY, NCR and NPR calculate as a product
+        const integer maxFactors = 1000000;
+        // The largest number of factors FACULTY multiplies exactly for a fraction
+        const integer maxFractionFactors = 1000;
+    }
+
+    // floatTraits:
+        template <typename Float>
+        integer floatTraits<Float>::toInteger(const Float& value)
+        {
+            // Numbers that don't fit (and NaN) become the smallest integer, which is what the conversion of a real gives on x86
+            const Float rounded = std::round(value);
+            if(!(rounded >= static_cast<Float>(std::numeric_limits<integer>::min()) && rounded < -static_cast<Float>(std::numeric_limits<integer>::min())))
+                return std::numeric_limits<integer>::min();
+            return static_cast<integer>(rounded);
+        }
+
+        template <typename Float>
+        Float floatTraits<Float>::parse(const string& literal)
+        { return str2number<Float>(literal); }
+
+        template <typename Float>
+        string floatTraits<Float>::format(const Float& value, const realOutputType& outputType, const int& precision)
+        { return number2str<Float>(value, outputType, precision); }
+
+        template <typename Float>
+        bool floatTraits<Float>::callFunction(const char* name, const builtIns::angleType&, const std::vector<Float>& args, Float& result)
+        {
+            // Only the functions of a single argument are calculated here, the real versions report a wrong number of arguments
+            if(args.size() != 1)
+                return false;
+            const Float& x = args[0];
+            const string function(name);
+            if(function == "ABS")
+                result = std::abs(x);
+            else if(function == "CEIL")
+                result = std::ceil(x);
+            else if(function == "FLOOR")
+                result = std::floor(x);
+            else if(function == "ROUND")
+                result = (x-std::floor(x) < std::ceil(x)-x ? std::floor(x) : std::ceil(x));
+            else if(function == "EXP")
+                result = std::exp(x);
+            else if(function == "LOG")
+                result = std::log(x);
+            else if(function == "LOG10")
+                result = std::log10(x);
+            else if(function == "DEG")
+                result = x*static_cast<Float>(degreesPerRadian);
+            else if(function == "RAD")
+                result = x/static_cast<Float>(degreesPerRadian);
+            else
+                return false;
+            return true;
+        }
+
+    // numberTraits<decimal>:
+        decimal numberTraits<decimal>::fromVariable(const string& name, const real& value) const
+        {
+            // The built-in constants are replaced by precise ones, as long as they still have their built-in value
+            if(name == "pi" && value == mathConstant::PI)
+                return decimal::pi(digits);
+            if(name == "e" && value == mathConstant::E)
+                return decimal::e(digits);
+            if(name == "phi" && value == mathConstant::PHI)
+            {
+                const decimal one = decimal::fromInteger(1, digits + 10);
+                return ((one + decimal::sqrt(decimal::fromInteger(5, digits + 10))) / decimal::fromInteger(2)).withDigits(digits);
+            }
+            return fromReal(value);
+        }
+
+        string numberTraits<decimal>::format(const decimal& value, const realOutputType& outputType, const int& precision)
+        { return real2str(value, outputType, precision); }
+
+        bool numberTraits<decimal>::callFunction(const char* name, const builtIns::angleType& angle, const std::vector<decimal>& args, decimal& result) const
+        {
+            // The functions of more than one argument, a wrong number of arguments is left to the real versions which report it
+            const string function(name);
+            if(function == "AVG" && !args.empty())
+            {
+                decimal total = decimal::fromInteger(0, digits + 10);
+                for(size_t i = 0; i < args.size(); ++i)
+                    total += args[i];
+                result = (total / decimal::fromInteger(args.size())).withDigits(digits);
+                return true;
+            }
+            if(function == "IF" && args.size() >= 2)
+            {
+                result = args[0] != decimal() ? args[1] : (args.size() >= 3 ? args[2] : fromInteger(0));
+                return true;
+            }
+            if((function == "NCR" || function == "NPR") && args.size() == 2)
+            {
+                // Only integers that fit in an int are accepted, like the real versions do
+                const integer n = args[0].toInteger(), k = args[1].toInteger();
+                const integer largest = std::numeric_limits<int>::max();
+                if(!args[0].isInteger() || !args[1].isInteger() || n > largest || n < -largest || k > largest || k < -largest)
+                    return false;
+                if(n < k || k < 0)
+                {
+                    result = fromInteger(0);
+                    return true;
+                }
+                // n!/(n-k)! and n!/(k!(n-k)!), using the smallest of k and n-k for the latter
+                const integer factors = function == "NPR" ? k : std::min(k, n - k);
+                if(factors > maxFactors)
+                    return false;
+                result = product(n - factors + 1, n, digits + 10);
+                if(function == "NCR")
+                    result /= product(1, factors, digits + 10);
+                result = result.withDigits(digits);
+                return true;
+            }
+
+            // The functions of a single argument
+            if(args.size() != 1)
+                return false;
+            const decimal& x = args[0];
+            const bool degrees = angle == builtIns::angleDegrees;
+            const int working = digits + 10;
+            if(function == "ABS")
+                result = decimal::abs(x);
+            else if(function == "CEIL")
+                result = decimal::ceil(x);
+            else if(function == "FLOOR")
+                result = decimal::floor(x);
+            else if(function == "ROUND")
+                result = decimal::round(x);
+            else if(function == "EXP")
+                result = decimal::exp(x);
+            else if(function == "LOG")
+                result = decimal::log(x);
+            else if(function == "LOG10")
+                result = decimal::log10(x);
+            else if(function == "DEG")
+                result = (x.withDigits(working) * decimal::fromInteger(180) / decimal::pi(working)).withDigits(digits);
+            else if(function == "RAD")
+                result = (x.withDigits(working) * decimal::pi(working) / decimal::fromInteger(180)).withDigits(digits);
+            else if(function == "FACULTY")
+            {
+                // Negative numbers and fractions are left to the real version
+                if(!x.isInteger() || x.isNegative() || x > decimal::fromInteger(maxFactors))
+                    return false;
+                result = product(2, x.toInteger(), digits);
+            }
+            else if(function == "SIN")
+                result = degrees ? decimal::sinDegrees(x) : decimal::sin(x);
+            else if(function == "COS")
+                result = degrees ? decimal::cosDegrees(x) : decimal::cos(x);
+            else if(function == "TAN")
+                result = degrees ? decimal::tanDegrees(x) : decimal::tan(x);
+            else if(function == "ASIN" || function == "ACOS" || function == "ATAN")
+            {
+                const decimal y = x.withDigits(degrees ? working : digits);
+                result = function == "ASIN" ? decimal::asin(y) : function == "ACOS" ? decimal::acos(y) : decimal::atan(y);
+                if(degrees)
+                    result = (result * decimal::fromInteger(180) / decimal::pi(working)).withDigits(digits);
+            }
+            else if(function == "SINH" || function == "COSH" || function == "TANH")
+            {
+                // Like the real versions, these convert degrees to radians as well
+                const decimal y = degrees ? (x.withDigits(working) * decimal::pi(working) / decimal::fromInteger(180)).withDigits(digits) : x;
+                result = function == "SINH" ? decimal::sinh(y) : function == "COSH" ? decimal::cosh(y) : decimal::tanh(y);
+            }
+            else
+                return false;
+            return true;
+        }
+
+    // numberTraits<rational>:
+        rational numberTraits<rational>::fromReal(const real& value)
+        {
+            // The results of functions calculated with reals are only trusted to be exact if they're integers
+            if(std::floor(value) == value && std::abs(value) <= static_cast<real>(integer(1) << std::numeric_limits<real>::digits))
+                return rational::fromInteger(static_cast<integer>(value));
+            return rational::approximation(value);
+        }
+
+        rational numberTraits<rational>::fromVariable(const string& name, const real& value)
+        {
+            // The built-in constants aren't fractions
+            if((name == "pi" && value == mathConstant::PI) || (name == "e" && value == mathConstant::E) || (name == "phi" && value == mathConstant::PHI))
+                return rational::approximation(value);
+            return rational::fromReal(value);
+        }
+
+        string numberTraits<rational>::format(const rational& value, const realOutputType& outputType, const int& precision)
+        { return real2str(value, outputType, precision); }
+
+        bool numberTraits<rational>::callFunction(const char* name, const builtIns::angleType&, const std::vector<rational>& args, rational& result)
+        {
+            // The functions of more than one argument, a wrong number of arguments is left to the real versions which report it
+            const string function(name);
+            if(function == "AVG" && !args.empty())
+            {
+                rational total;
+                for(size_t i = 0; i < args.size(); ++i)
+                    total += args[i];
+                result = total / rational::fromInteger(args.size());
+                return true;
+            }
+            if(function == "IF" && args.size() >= 2)
+            {
+                result = args[0] != rational() ? args[1] : (args.size() >= 3 ? args[2] : rational());
+                return true;
+            }
+            if((function == "NCR" || function == "NPR") && args.size() == 2)
+            {
+                // Only integers that fit in an int are accepted, like the real versions do
+                const integer n = args[0].toInteger(), k = args[1].toInteger();
+                const integer largest = std::numeric_limits<int>::max();
+                if(!args[0].isExact() || !args[1].isExact() || !args[0].isInteger() || !args[1].isInteger() ||
+                   n > largest || n < -largest || k > largest || k < -largest)
+                    return false;
+                if(n < k || k < 0)
+                {
+                    result = rational();
+                    return true;
+                }
+                // n!/(n-k)! and n!/(k!(n-k)!), using the smallest of k and n-k for the latter
+                const integer factors = function == "NPR" ? k : std::min(k, n - k);
+                if(factors > maxFactors)
+                    return false;
+                result = rational::product(n - factors + 1, n);
+                if(function == "NCR")
+                    result /= rational::product(1, factors);
+                // Products that are too large to be exact are approximated by the logarithm of the gamma function
+                if(!result.isExact())
+                {
+                    const real logarithm = std::lgamma(static_cast<real>(n) + 1) - std::lgamma(static_cast<real>(n - factors) + 1);
+                    result = rational::approximation(std::exp(function == "NCR" ? logarithm - std::lgamma(static_cast<real>(factors) + 1) : logarithm));
+                }
+                return true;
+            }
+
+            // The functions of a single argument
+            if(args.size() != 1)
+                return false;
+            const rational& x = args[0];
+            if(function == "ABS")
+                result = rational::abs(x);
+            else if(function == "CEIL")
+                result = rational::ceil(x);
+            else if(function == "FLOOR")
+                result = rational::floor(x);
+            else if(function == "ROUND")
+                result = rational::round(x);
+            else if(function == "FACULTY")
+            {
+                // Negative numbers and approximations are left to the real version
+                if(!x.isExact() || x.isNegative() || x > rational::fromInteger(maxFactors))
+                    return false;
+                if(x.isInteger())
+                    result = rational::product(2, x.toInteger());
+                // Like the real version, a fraction is multiplied by the fractions one less than it as long as they're larger than 1
+                else
+                {
+                    if(x > rational::fromInteger(maxFractionFactors))
+                        return false;
+                    result = rational(1);
+                    for(rational factor = x; factor > rational(1); factor -= rational(1))
+                        result *= factor;
+                }
+            }
+            else
+                return false;
+            return true;
+        }
+
+    // numberTraits<dual>:
+        string numberTraits<dual>::format(const dual& value, const realOutputType& outputType, const int& precision)
+        { return real2str(value.value, outputType, precision); }
+
+        dual numberTraits<dual>::power(const dual& base, const dual& exponent)
+        {
+            // d(a^b) = b*a^(b-1)*da + a^b*ln(a)*db, the second part only counts if the exponent changes
+            const real value = std::pow(base.value, exponent.value);
+            real derivative = 0;
+            if(base.derivative != 0 && exponent.value != 0)
+                derivative += exponent.value * std::pow(base.value, exponent.value - 1) * base.derivative;
+            if(exponent.derivative != 0 && value != 0)
+                derivative += value * std::log(base.value) * exponent.derivative;
+            return dual(value, derivative);
+        }
+
+        dual numberTraits<dual>::modulo(const dual& a, const dual& b)
+        {
+            // a % b = a - trunc(a/b)*b, where trunc(a/b) is a constant between its jumps
+            const real value = std::fmod(a.value, b.value);
+            return dual(value, a.derivative - std::trunc(a.value / b.value) * b.derivative);
+        }
+
+        bool numberTraits<dual>::callFunction(const char* name, const builtIns::angleType& angle, const std::vector<dual>& args, dual& result)
+        {
+            const string function(name);
+
+            // The functions of several arguments
+            if(function == "AVG" && !args.empty())
+            {
+                result = dual(0);
+                for(size_t i = 0; i < args.size(); ++i)
+                    result = result + args[i];
+                result = result / dual(static_cast<int>(args.size()));
+                return true;
+            }
+            if(function == "IF" && (args.size() == 2 || args.size() == 3))
+            {
+                result = args[0].value != 0 ? args[1] : (args.size() == 3 ? args[2] : dual(0));
+                return true;
+            }
+
+            // The functions of a single argument, the real versions report a wrong number of arguments
+            if(args.size() != 1)
+                return false;
+            const real x = args[0].value;
+            const real dx = args[0].derivative;
+
+            // The goniometric functions in degrees convert their argument or result the same way their real versions do
+            const bool degrees = (angle == builtIns::angleDegrees);
+            const real in = degrees ? mathConstant::PI / 180 : 1;
+            const real out = degrees ? 180 / mathConstant::PI : 1;
+            if(function == "COS")
+                result = dual(std::cos(x * in), -std::sin(x * in) * in * dx);
+            else if(function == "SIN")
+                result = dual(std::sin(x * in), std::cos(x * in) * in * dx);
+            else if(function == "TAN")
+            {
+                const real tan = std::tan(x * in);
+                result = dual(tan, (1 + tan * tan) * in * dx);
+            }
+            else if(function == "COSH")
+                result = dual(std::cosh(x * in), std::sinh(x * in) * in * dx);
+            else if(function == "SINH")
+                result = dual(std::sinh(x * in), std::cosh(x * in) * in * dx);
+            else if(function == "TANH")
+            {
+                const real tanh = std::tanh(x * in);
+                result = dual(tanh, (1 - tanh * tanh) * in * dx);
+            }
+            else if(function == "ACOS")
+                result = dual(std::acos(x) * out, -out / std::sqrt(1 - x * x) * dx);
+            else if(function == "ASIN")
+                result = dual(std::asin(x) * out, out / std::sqrt(1 - x * x) * dx);
+            else if(function == "ATAN")
+                result = dual(std::atan(x) * out, out / (1 + x * x) * dx);
+            else
+            {
+                // The other functions get their value from the real traits
+                real value = 0;
+                if(!floatTraits<real>::callFunction(name, angle, std::vector<real>(1, x), value))
+                    return false;
+                real slope = 0;
+                if(function == "ABS")
+                    slope = x > 0 ? 1 : (x < 0 ? -1 : 0);
+                else if(function == "EXP")
+                    slope = value;
+                else if(function == "LOG")
+                    slope = 1 / x;
+                else if(function == "LOG10")
+                    slope = 1 / (x * std::log(static_cast<real>(10)));
+                else if(function == "DEG")
+                    slope = static_cast<real>(degreesPerRadian);
+                else if(function == "RAD")
+                    slope = 1 / static_cast<real>(degreesPerRadian);
+                // CEIL, FLOOR and ROUND are constant between their jumps
+                result = dual(value, dx != 0 ? slope * dx : 0);
+            }
+            return true;
+        }
+
+    // numberBackend:
+        // Public:
+            numberBackend::~numberBackend()
+            {}
+
+            std::shared_ptr<const numberBackend> numberBackend::create(const string& name, const int& digits)
+            {
+                if(name == numberTraits<float>::getName())
+                    return std::shared_ptr<const numberBackend>(new numberEngine<float>());
+                if(name == numberTraits<double>::getName())
+                    return std::shared_ptr<const numberBackend>(new numberEngine<double>());
+                if(name == numberTraits<long double>::getName())
+                    return std::shared_ptr<const numberBackend>(new numberEngine<long double>());
+                if(name == numberTraits<decimal>::getName())
+                    return std::shared_ptr<const numberBackend>(new numberEngine<decimal>(numberTraits<decimal>(digits > 0 ? digits : decimal::defaultDigits)));
+                if(name == numberTraits<rational>::getName())
+                    return std::shared_ptr<const numberBackend>(new numberEngine<rational>());
+                return std::shared_ptr<const numberBackend>();
+            }
+
+    // numberEngine:
+        // Public:
+            template <typename Number>
+            numberEngine<Number>::numberEngine(const traits& numberType)
+            : numberType(numberType) {}
+
+            template <typename Number>
+            string numberEngine<Number>::getName() const
+            { return numberType.getName(); }
+
+            template <typename Number>
+            string numberEngine<Number>::execute(const program& prog, environment& env, const realOutputType& outputType, const int& precision) const
+            { return numberType.format(evaluate(prog, env), outputType, precision); }
+
+            template <typename Number>
+            Number numberEngine<Number>::evaluate(const program& prog, environment& env) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+                return evaluateRow(prog, env, 0, 0);
+            }
+
+            template <typename Number>
+            Number numberEngine<Number>::evaluate(const program& prog, environment& env, const std::vector<const Number*>& columns) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+                return evaluateRow(prog, env, &columns, 0);
+            }
+
+            template <typename Number>
+            void numberEngine<Number>::executeBlock(const program& prog, environment& env, const std::vector<const Number*>& columns, const size_t& rowCount, Number* out, char* failed, std::vector<program::rowError>& errors) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+
+                const Number notANumber = numberType.fromReal(std::numeric_limits<real>::quiet_NaN());
+
+                // A program that assigns to variables has to see the assignments of the previous rows, so it's executed row by row
+                if(prog.hasStores())
+                {
+                    for(size_t row = 0; row < rowCount; ++row)
+                    {
+                        if(failed[row])
+                            continue;
+                        try
+                        { out[row] = evaluateRow(prog, env, &columns, row); }
+                        catch(calcError& err)
+                        { failRow(row, err, notANumber, out, failed, errors); }
+                        catch(std::exception& exc)
+                        { failRow(row, calcError("STL error occurred", calcError::unknown, exc.what()), notANumber, out, failed, errors); }
+                        catch(...)
+                        { failRow(row, calcError("Unknown error occurred", calcError::unknown), notANumber, out, failed, errors); }
+                    }
+                    return;
+                }
+
+                // Otherwise the rows are executed in blocks of at most blockSize rows
+                std::vector<const Number*> blockColumns(columns.size(), 0);
+                for(size_t first = 0; first < rowCount; first += program::blockSize)
+                {
+                    for(size_t i = 0; i < columns.size(); ++i)
+                        blockColumns[i] = columns[i] ? columns[i] + first : 0;
+                    const size_t count = std::min(program::blockSize, rowCount - first);
+                    const size_t errorsBefore = errors.size();
+                    executeVectorized(prog, env, blockColumns, count, out + first, failed + first, errors);
+                    for(size_t i = errorsBefore; i < errors.size(); ++i)
+                        errors[i].row += first;
+                }
+            }
+
+            template <typename Number>
+            Number numberEngine<Number>::call(mathFunction* function, const string& name, const std::vector<Number>& args, argList& realArgs) const
+            {
+                CALC_COUNT(counterFunctionCalls, 1);
+                CALC_PROFILE_CALL(name);
+
+                // The built-in functions the number type calculates itself
+                builtIns::angleType angle = builtIns::angleRadians;
+                const char* builtInName = builtIns::getBuiltInName(function, name, &angle);
+                Number result(0);
+                if(builtInName != 0 && numberType.callFunction(builtInName, angle, args, result))
+                    return result;
+
+                // All other functions calculate with reals
+                realArgs.resize(args.size());
+                for(size_t i = 0; i < args.size(); ++i)
+                    realArgs[i] = numberType.toReal(args[i]);
+                return numberType.fromReal(function->execute(realArgs, name));
+            }
+
+            template <typename Number>
+            Number numberEngine<Number>::callExpressions(mathFunction* function, const string& name, const std::vector<string>& expressions, environment& env) const
+            {
+                CALC_COUNT(counterFunctionCalls, 1);
+                CALC_PROFILE_CALL(name);
+                return numberType.fromReal(function->executeExpressions(expressions, name, env));
+            }
+
+        // Private:
+            template <typename Number>
+            Number numberEngine<Number>::evaluateRow(const program& prog, environment& env, const std::vector<const Number*>* columns, const size_t& row) const
+            {
+                const std::vector<program::instruction>& instructions = prog.getInstructions();
+                const std::vector<string>& variables = prog.getVariables();
+                const std::vector<string>& functions = prog.getFunctions();
+                const std::vector<unsigned int>& arguments = prog.getArguments();
+
+                // The registers, variables and functions of this execution
+                // Variables that are assigned keep their precise value in assigned, their real value is written to the environment
+                std::vector<Number> reg(prog.getRegisterCount(), Number(0));
+                std::vector<real*> vars(variables.size(), 0);
+                std::vector<real*> storedVars(variables.size(), 0);
+                std::vector<Number> assigned(variables.size(), Number(0));
+                std::vector<mathFunction*> funcs(functions.size(), 0);
+                std::vector<Number> args;
+                argList realArgs;
+                CALC_COUNT(counterAllocations, 5);
+
+                // Execute the instructions one by one, the instructions on integers do the same as those on reals
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    switch(program::realOpcode(instr->op))
+                    {
+                        case program::opConstant:
+                            reg[instr->dest] = constant(prog, *instr);
+                        break;
+
+                        case program::opLoad:
+                        case program::opCheck:
+                            // Variables bound to a column always exist
+                            if(columns != 0 && (*columns)[instr->a] != 0)
+                            {
+                                if(instr->op == program::opLoad)
+                                    reg[instr->dest] = (*columns)[instr->a][row];
+                                break;
+                            }
+
+                            // Other variables are looked up once
+                            if(vars[instr->a] == 0 && (vars[instr->a] = env.findVar(variables[instr->a])) == 0)
+                                throw unknownVariable(prog, instr->b);
+                            if(instr->op == program::opLoad)
+                                reg[instr->dest] = storedVars[instr->a] ? assigned[instr->a] : numberType.fromVariable(variables[instr->a], *vars[instr->a]);
+                        break;
+
+                        case program::opStore:
+                            // The environment is told about every variable that is assigned, even if it has been read already
+                            if(storedVars[instr->a] == 0)
+                                vars[instr->a] = storedVars[instr->a] = env.createVar(variables[instr->a]);
+                            *storedVars[instr->a] = numberType.toReal(reg[instr->b]);
+                            assigned[instr->a] = reg[instr->b];
+                        break;
+
+                        case program::opNegate:
+                            reg[instr->dest] = reg[instr->a] * Number(-1);
+                        break;
+
+                        case program::opPower:
+                        case program::opRoot:
+                            checkPower(reg[instr->a], reg[instr->b], instr->op == program::opRoot);
+                            reg[instr->dest] = numberType.power(reg[instr->a], instr->op == program::opPower ? reg[instr->b] : Number(1)/reg[instr->b]);
+                        break;
+
+                        case program::opCheckDivisor:
+                            if(reg[instr->a] == Number(0))
+                                throw calcError(instr->b ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, numberType.toReal(reg[instr->a]));
+                        break;
+
+                        case program::opMultiply:
+                            reg[instr->dest] = reg[instr->a] * reg[instr->b];
+                        break;
+
+                        case program::opDivide:
+                            if(reg[instr->b] == Number(0))
+                                throw calcError("Division by 0", calcError::invalidOperands, numberType.toReal(reg[instr->b]));
+                            reg[instr->dest] = reg[instr->a] / reg[instr->b];
+                        break;
+
+                        case program::opModulo:
+                            if(reg[instr->b] == Number(0))
+                                throw calcError("Modulo by 0", calcError::invalidOperands, numberType.toReal(reg[instr->b]));
+                            reg[instr->dest] = numberType.modulo(reg[instr->a], reg[instr->b]);
+                        break;
+
+                        case program::opAdd:
+                            reg[instr->dest] = reg[instr->a] + reg[instr->b];
+                        break;
+
+                        case program::opSubtract:
+                            reg[instr->dest] = reg[instr->a] - reg[instr->b];
+                        break;
+
+                        case program::opGreater:
+                            reg[instr->dest] = Number(reg[instr->a] > reg[instr->b] ? 1 : 0);
+                        break;
+
+                        case program::opLess:
+                            reg[instr->dest] = Number(reg[instr->a] < reg[instr->b] ? 1 : 0);
+                        break;
+
+                        case program::opBitwiseOr:
+                        case program::opBitwiseAnd:
+                        {
+                            const integer a = numberType.toInteger(reg[instr->a]);
+                            const integer b = numberType.toInteger(reg[instr->b]);
+                            reg[instr->dest] = numberType.fromInteger(instr->op == program::opBitwiseOr ? (a | b) : (a & b));
+                        }
+                        break;
+
+                        case program::opCheckFunction:
+                            if(funcs[instr->a] == 0 && (funcs[instr->a] = env.findFunction(functions[instr->a])) == 0)
+                                throw unknownFunction(prog, instr->a);
+                        break;
+
+                        case program::opCall:
+                            args.resize(instr->b);
+                            for(unsigned int i = 0; i < instr->b; ++i)
+                                args[i] = reg[arguments[instr->c + i]];
+                            reg[instr->dest] = call(funcs[instr->a], functions[instr->a], args, realArgs);
+                        break;
+
+                        case program::opCallExpressions:
+                            reg[instr->dest] = callExpressions(funcs[instr->a], functions[instr->a], prog.getExpressions()[instr->b], env);
+                        break;
+
+                        // The instructions on integers are turned into these by realOpcode()
+                        default:
+                        break;
+                    }
+                }
+
+                CALC_COUNT(counterNodes, instructions.size());
+                return reg[prog.getResultRegister()];
+            }
+
+            template <typename Number>
+            void numberEngine<Number>::executeVectorized(const program& prog, environment& env, const std::vector<const Number*>& columns, const size_t& rowCount, Number* out, char* failed, std::vector<program::rowError>& errors) const
+            {
+                const std::vector<program::instruction>& instructions = prog.getInstructions();
+                const std::vector<string>& variables = prog.getVariables();
+                const std::vector<string>& functions = prog.getFunctions();
+                const std::vector<unsigned int>& arguments = prog.getArguments();
+                const unsigned int registerCount = prog.getRegisterCount();
+                const size_t blockSize = program::blockSize;
+                const Number notANumber = numberType.fromReal(std::numeric_limits<real>::quiet_NaN());
+
+                // Every register holds a value for every row
+                std::vector<Number> registers(registerCount * blockSize, Number(0));
+                std::vector<mathFunction*> funcs(functions.size(), 0);
+                std::vector<Number> args;
+                argList realArgs;
+                CALC_COUNT(counterAllocations, 1);
+                CALC_COUNT(counterNodes, instructions.size() * rowCount);
+
+                // Execute the instructions one by one, every instruction is executed for all rows before going to the next one
+                // An error only stops the row it occurred in, the other rows just continue
+                for(std::vector<program::instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    // The rows of the registers used by the instruction, operands that aren't registers point to the first register (and aren't used)
+                    Number* dest = &registers[(instr->dest < registerCount ? instr->dest : 0) * blockSize];
+                    const Number* a = &registers[(instr->a < registerCount ? instr->a : 0) * blockSize];
+                    const Number* b = &registers[(instr->b < registerCount ? instr->b : 0) * blockSize];
+                    switch(program::realOpcode(instr->op))
+                    {
+                        case program::opConstant:
+                            std::fill(dest, dest + rowCount, constant(prog, *instr));
+                        break;
+
+                        case program::opLoad:
+                        case program::opCheck:
+                        {
+                            // Variables bound to a column always exist
+                            if(columns[instr->a] != 0)
+                            {
+                                if(instr->op == program::opLoad)
+                                    std::copy(columns[instr->a], columns[instr->a] + rowCount, dest);
+                                break;
+                            }
+
+                            // Other variables have the same value for every row
+                            const real* var = env.findVar(variables[instr->a]);
+                            if(var == 0)
+                                failRows(rowCount, unknownVariable(prog, instr->b), notANumber, out, failed, errors);
+                            else if(instr->op == program::opLoad)
+                                std::fill(dest, dest + rowCount, numberType.fromVariable(variables[instr->a], *var));
+                        }
+                        break;
+
+                        case program::opNegate:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] * Number(-1);
+                        break;
+
+                        case program::opPower:
+                        case program::opRoot:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(failed[i])
+                                    continue;
+                                try
+                                {
+                                    checkPower(a[i], b[i], instr->op == program::opRoot);
+                                    dest[i] = numberType.power(a[i], instr->op == program::opPower ? b[i] : Number(1)/b[i]);
+                                }
+                                catch(calcError& err)
+                                { failRow(i, err, notANumber, out, failed, errors); }
+                            }
+                        break;
+
+                        case program::opCheckDivisor:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(a[i] == Number(0) && !failed[i])
+                                    failRow(i, calcError(instr->b ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, numberType.toReal(a[i])), notANumber, out, failed, errors);
+                            }
+                        break;
+
+                        case program::opMultiply:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] * b[i];
+                        break;
+
+                        case program::opDivide:
+                        case program::opModulo:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(b[i] == Number(0) && !failed[i])
+                                    failRow(i, calcError(instr->op == program::opDivide ? "Division by 0" : "Modulo by 0", calcError::invalidOperands, numberType.toReal(b[i])), notANumber, out, failed, errors);
+                            }
+                            if(instr->op == program::opDivide)
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = a[i] / b[i];
+                            }
+                            else
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = failed[i] ? notANumber : numberType.modulo(a[i], b[i]);
+                            }
+                        break;
+
+                        case program::opAdd:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] + b[i];
+                        break;
+
+                        case program::opSubtract:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] - b[i];
+                        break;
+
+                        case program::opGreater:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = Number(a[i] > b[i] ? 1 : 0);
+                        break;
+
+                        case program::opLess:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = Number(a[i] < b[i] ? 1 : 0);
+                        break;
+
+                        case program::opBitwiseOr:
+                        case program::opBitwiseAnd:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                // The rows that failed may hold anything, which shouldn't be rounded to an integer
+                                const integer first = failed[i] ? 0 : numberType.toInteger(a[i]);
+                                const integer second = failed[i] ? 0 : numberType.toInteger(b[i]);
+                                dest[i] = numberType.fromInteger(instr->op == program::opBitwiseOr ? (first | second) : (first & second));
+                            }
+                        break;
+
+                        case program::opCheckFunction:
+                            if((funcs[instr->a] = env.findFunction(functions[instr->a])) == 0)
+                                failRows(rowCount, unknownFunction(prog, instr->a), notANumber, out, failed, errors);
+                        break;
+
+                        case program::opCall:
+                            // The function is called row by row, skipping the rows that already failed
+                            args.resize(instr->b);
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(failed[i])
+                                    continue;
+                                for(unsigned int j = 0; j < instr->b; ++j)
+                                    args[j] = registers[arguments[instr->c + j] * blockSize + i];
+                                try
+                                { dest[i] = call(funcs[instr->a], functions[instr->a], args, realArgs); }
+                                catch(calcError& err)
+                                { failRow(i, err, notANumber, out, failed, errors); }
+                                catch(std::exception& exc)
+                                { failRow(i, calcError("STL error occurred", calcError::unknown, exc.what()), notANumber, out, failed, errors); }
+                                catch(...)
+                                { failRow(i, calcError("Unknown error occurred", calcError::unknown), notANumber, out, failed, errors); }
+                            }
+                        break;
+
+                        // Stores and calls with unevaluated arguments never get here, see executeBlock()
+                        default:
+                        break;
+                    }
+                }
+
+                // Copy the results of the rows that didn't fail
+                const Number* results = &registers[prog.getResultRegister() * blockSize];
+                for(size_t i = 0; i < rowCount; ++i)
+                {
+                    if(!failed[i])
+                        out[i] = results[i];
+                }
+            }
+
+            template <typename Number>
+            Number numberEngine<Number>::constant(const program& prog, const program::instruction& instr) const
+            {
+                // Integers are exact already, other numbers are read from their literal unless it's a time (which is a real anyway)
+                if(instr.op == program::opIntConstant)
+                    return numberType.fromInteger(prog.getIntegers()[instr.b]);
+                const string& literal = prog.getLiterals()[instr.a];
+                if(literal.empty() || literal.find(':') != string::npos)
+                    return numberType.fromReal(prog.getConstants()[instr.a]);
+                return numberType.parse(literal);
+            }
+
+            template <typename Number>
+            void numberEngine<Number>::checkPower(const Number& base, const Number& exponent, const bool& root) const
+            {
+                // Only allow integer powers of negative numbers
+                if(base < Number(0))
+                {
+                    if(root)
+                        throw calcError("No negative roots allowed", calcError::invalidOperands);
+                    if(!numberType.isInteger(exponent))
+                        throw calcError("Only integer powers of negative numbers", calcError::invalidOperands);
+                }
+            }
+
+    // numberEngine<dual>:
+        // Public:
+            template <>
+            dual numberEngine<dual>::call(mathFunction* function, const string& name, const std::vector<dual>& args, argList& realArgs) const
+            {
+                CALC_COUNT(counterFunctionCalls, 1);
+                CALC_PROFILE_CALL(name);
+
+                // The built-in functions dual differentiates itself
+                builtIns::angleType angle = builtIns::angleRadians;
+                const char* builtInName = builtIns::getBuiltInName(function, name, &angle);
+                dual result(0);
+                if(builtInName != 0 && numberType.callFunction(builtInName, angle, args, result))
+                    return result;
+
+                // All other functions calculate their value with reals
+                realArgs.resize(args.size());
+                argList slopes(args.size());
+                bool changes = false;
+                for(size_t i = 0; i < args.size(); ++i)
+                {
+                    realArgs[i] = args[i].value;
+                    slopes[i] = args[i].derivative;
+                    changes = changes || slopes[i] != 0;
+                }
+
+                // Functions that can differentiate themselves do, e.g. those defined by an expression
+                real value = 0;
+                real derivative = 0;
+                if(changes && function->differentiate(realArgs, slopes, name, value, derivative))
+                    return dual(value, derivative);
+                value = function->execute(realArgs, name);
+
+                // The derivative of the others is the sum of the central differences to the arguments that change, RAND draws different numbers every call
+                if(!changes || (builtInName != 0 && string(builtInName) == "RAND"))
+                    return dual(value, 0);
+                for(size_t i = 0; i < args.size(); ++i)
+                {
+                    if(args[i].derivative == 0)
+                        continue;
+
+                    // The step balances the error of the approximation against rounding, and is exactly representable around the argument
+                    const real x = args[i].value;
+                    const real step = std::cbrt(std::numeric_limits<real>::epsilon()) * std::max(std::fabs(x), static_cast<real>(1));
+                    argList shifted(realArgs);
+                    shifted[i] = x + step;
+                    const real above = shifted[i];
+                    try
+                    {
+                        const real up = function->execute(shifted, name);
+                        shifted[i] = x - step;
+                        const real below = shifted[i];
+                        const real down = function->execute(shifted, name);
+                        derivative += (up - down) / (above - below) * args[i].derivative;
+                    }
+                    catch(calcError&)
+                    {
+                        // The function can't be calculated on both sides, e.g. at the edge of its domain
+                        derivative = std::numeric_limits<real>::quiet_NaN();
+                    }
+                }
+                return dual(value, derivative);
+            }
+
+            template <>
+            dual numberEngine<dual>::callExpressions(mathFunction* function, const string& name, const std::vector<string>& expressions, environment& env) const
+            {
+                CALC_COUNT(counterFunctionCalls, 1);
+                CALC_PROFILE_CALL(name);
+                const real value = function->executeExpressions(expressions, name, env);
+
+                // Only a variable that exists can change
+                const char* builtInName = builtIns::getBuiltInName(function, name);
+                const real* variable = numberType.variable.empty() ? 0 : env.findVar(numberType.variable);
+                if(variable == 0 || (builtInName != 0 && string(builtInName) == "BENCH"))
+                    return dual(value, 0);
+
+                // The same step as for the other functions (see call())
+                const real x = *variable;
+                const real step = std::cbrt(std::numeric_limits<real>::epsilon()) * std::max(std::fabs(x), static_cast<real>(1));
+                localEnvironment shifted(env, numberType.variable, x + step);
+                const real above = shifted.getValue();
+                try
+                {
+                    const real up = function->executeExpressions(expressions, name, shifted);
+                    shifted.setValue(x - step);
+                    const real below = shifted.getValue();
+                    const real down = function->executeExpressions(expressions, name, shifted);
+                    return dual(value, (up - down) / (above - below));
+                }
+                catch(calcError&)
+                { return dual(value, std::numeric_limits<real>::quiet_NaN()); }
+            }
+
+    // The number types the engine is instantiated for
+    template struct floatTraits<float>;
+    template struct floatTraits<double>;
+    template struct floatTraits<long double>;
+    template class numberEngine<float>;
+    template class numberEngine<double>;
+    template class numberEngine<long double>;
+    template class numberEngine<decimal>;
+    template class numberEngine<rational>;
+    template class numberEngine<dual>;
+}
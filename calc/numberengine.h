@@ -0,0 +1,233 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef NUMBERENGINE_H
+#define NUMBERENGINE_H
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "builtins.h"
+#include "decimal.h"
+#include "rational.h"
+#include "dual.h"
+
+namespace calc
+{
+    // Tells numberEngine how to calculate with a number type
+    // The arithmetic and comparison operators of the number type are used directly, and it has to be constructible from an int.
+    // Everything else is done by the functions of its specialization, which may be static or use state of the traits object:
+    //     const char* getName() const                                      The name of the number type
+    //     Number fromReal(const real& value) const                         Convert a real to the number type
+    //     real toReal(const Number& value) const                           Convert a number to a real
+    //     Number fromInteger(const integer& value) const                   Convert an integer to the number type
+    //     Number fromVariable(const string& name, const real& value) const Convert the value of a variable, which lets the number type use
+    //                                                                      more precise values for the built-in constants
+    //     integer toInteger(const Number& value) const                     Round a number to the nearest integer, for the bitwise operators
+    //     bool isInteger(const Number& value) const                        Returns true if the number is an integer
+    //     Number parse(const string& literal) const                        Read a number as written in an expression (see str2real())
+    //     string format(const Number& value, const realOutputType& outputType, const int& precision) const
+    //                                                                      Write a number (see real2str())
+    //     Number power(const Number& base, const Number& exponent) const   The power operator, the base is checked already
+    //     Number modulo(const Number& a, const Number& b) const            The modulo operator, b isn't 0
+    //     bool callFunction(const char* name, const builtIns::angleType& angle, const std::vector<Number>& args, Number& result) const
+    //                                                                      Calculate the built-in function with the given capital name (see
+    //                                                                      builtIns::getBuiltInName()), the goniometric functions use the given
+    //                                                                      angle type. Returns false to let the real version do it.
+    template <typename Number> struct numberTraits;
+
+    // The traits of the floating point types, they calculate the built-in functions that don't depend on the angle type themselves
+    template <typename Float>
+    struct floatTraits
+    {
+        static Float fromReal(const real& value)                { return static_cast<Float>(value); }
+        static real toReal(const Float& value)                  { return static_cast<real>(value); }
+        static Float fromInteger(const integer& value)          { return static_cast<Float>(value); }
+        static Float fromVariable(const string&, const real& value) { return static_cast<Float>(value); }
+        static integer toInteger(const Float& value);
+        static bool isInteger(const Float& value)               { return std::floor(value) == value; }
+        static Float parse(const string& literal);
+        static string format(const Float& value, const realOutputType& outputType, const int& precision);
+        static Float power(const Float& base, const Float& exponent) { return std::pow(base, exponent); }
+        static Float modulo(const Float& a, const Float& b)     { return std::fmod(a, b); }
+        static bool callFunction(const char* name, const builtIns::angleType& angle, const std::vector<Float>& args, Float& result);
+    };
+    template <> struct numberTraits<float> : floatTraits<float>
+    { static const char* getName() { return "float"; } };
+    template <> struct numberTraits<double> : floatTraits<double>
+    { static const char* getName() { return "double"; } };
+    template <> struct numberTraits<long double> : floatTraits<long double>
+    { static const char* getName() { return "long double"; } };
+
+    // The traits of decimal, every number is rounded to the precision of the traits (see numberBackend::create())
+    // The built-in functions are calculated as decimals, except RAND and BENCH. FACULTY, NCR and NPR of integers are exact
+    // as long as the result fits in the precision, and pi, e and phi are as precise as the other numbers.
+    template <>
+    struct numberTraits<decimal>
+    {
+        // Constructor, the precision is the number of significant digits
+        numberTraits(const int& digits = decimal::defaultDigits) : digits(digits) {}
+
+        static const char* getName()                            { return "decimal"; }
+        decimal fromReal(const real& value) const               { return decimal::fromReal(value, digits); }
+        static real toReal(const decimal& value)                { return value.toReal(); }
+        decimal fromInteger(const integer& value) const         { return decimal::fromInteger(value, digits); }
+        decimal fromVariable(const string& name, const real& value) const;
+        static integer toInteger(const decimal& value)          { return value.toInteger(); }
+        static bool isInteger(const decimal& value)             { return value.isInteger(); }
+        decimal parse(const string& literal) const              { return decimal::parse(literal, digits); }
+        static string format(const decimal& value, const realOutputType& outputType, const int& precision);
+        static decimal power(const decimal& base, const decimal& exponent) { return decimal::pow(base, exponent); }
+        static decimal modulo(const decimal& a, const decimal& b) { return decimal::fmod(a, b); }
+        bool callFunction(const char* name, const builtIns::angleType& angle, const std::vector<decimal>& args, decimal& result) const;
+
+        int digits;                                             // The precision
+    };
+
+    // The traits of rational, numbers stay exact fractions as long as they can (see rational)
+    // ABS, CEIL, FLOOR, ROUND, AVG and IF are calculated exactly, and so are FACULTY, NCR and NPR unless the result gets too large.
+    // The other functions calculate with reals, their results are exact if they're integers and approximations otherwise, so
+    // the transcendental functions give approximations. The values of variables are exact if they're short decimals (like 0.1).
+    template <>
+    struct numberTraits<rational>
+    {
+        static const char* getName()                            { return "rational"; }
+        static rational fromReal(const real& value);
+        static real toReal(const rational& value)               { return value.toReal(); }
+        static rational fromInteger(const integer& value)       { return rational::fromInteger(value); }
+        static rational fromVariable(const string& name, const real& value);
+        static integer toInteger(const rational& value)         { return value.toInteger(); }
+        static bool isInteger(const rational& value)            { return value.isInteger(); }
+        static rational parse(const string& literal)            { return rational::parse(literal); }
+        static string format(const rational& value, const realOutputType& outputType, const int& precision);
+        static rational power(const rational& base, const rational& exponent) { return rational::pow(base, exponent); }
+        static rational modulo(const rational& a, const rational& b) { return rational::fmod(a, b); }
+        static bool callFunction(const char* name, const builtIns::angleType& angle, const std::vector<rational>& args, rational& result);
+    };
+
+    // The traits of dual, which calculate the derivative to one variable along with the value (see dual.h)
+    // The variable with the given name has derivative 1, all other variables and the constants have derivative 0. The values are
+    // calculated exactly like real does. The built-in functions are differentiated exactly, except FACULTY, LNFACT, LNCR, NCR and NPR,
+    // which are differentiated by central differences like all other functions that can't differentiate themselves (e.g. those of a
+    // plugin, see mathFunction::differentiate()). Functions defined by an expression are differentiated exactly. RAND has derivative 0. Assignments keep their derivative for the rest of the program, but the environment only gets their value.
+    template <>
+    struct numberTraits<dual>
+    {
+        // Constructor, the derivatives are taken to the variable with the given name
+        numberTraits(const string& variable = string()) : variable(variable) {}
+
+        static const char* getName()                            { return "dual"; }
+        static dual fromReal(const real& value)                 { return dual(value, 0); }
+        static real toReal(const dual& value)                   { return value.value; }
+        static dual fromInteger(const integer& value)           { return dual(static_cast<real>(value), 0); }
+        dual fromVariable(const string& name, const real& value) const { return dual(value, name == variable ? 1 : 0); }
+        static integer toInteger(const dual& value)             { return floatTraits<real>::toInteger(value.value); }
+        static bool isInteger(const dual& value)                { return floatTraits<real>::isInteger(value.value); }
+        static dual parse(const string& literal)                { return dual(floatTraits<real>::parse(literal), 0); }
+        static string format(const dual& value, const realOutputType& outputType, const int& precision);
+        static dual power(const dual& base, const dual& exponent);
+        static dual modulo(const dual& a, const dual& b);
+        static bool callFunction(const char* name, const builtIns::angleType& angle, const std::vector<dual>& args, dual& result);
+
+        string variable;                                        // The name of the variable the derivatives are taken to
+    };
+
+    // A number type the programs of a context can be executed with, instead of real (see context::setBackend())
+    // A backend doesn't change, so it can be shared by contexts and used by several threads at once.
+    class numberBackend
+    {
+        public:
+            // Destructor
+            virtual ~numberBackend();
+
+            // Get the name of the number type
+            virtual string getName() const = 0;
+            // Execute the program with this number type, returns the result written in the given format (like real2str())
+            // Throws a calcError if an error occurs
+            virtual string execute(const program& prog, environment& env, const realOutputType& outputType = outputType_auto, const int& precision = -1) const = 0;
+
+            // Create the backend of a number type by its name ("float", "double", "long double", "decimal" or "rational"), returns 0 if there is none
+            // The decimals get the given number of significant digits, or decimal::defaultDigits if it isn't positive
+            static std::shared_ptr<const numberBackend> create(const string& name, const int& digits = 0);
+    };
+
+    // Executes programs with another number type than real
+    // The instructions do the same as those of program::execute(), the values of the registers are of the given number type.
+    // The constants are read from their literals, so they're as precise as the number type. The variables of the environment
+    // and the arguments and results of functions are reals, they're converted, except for the built-in functions the number type
+    // calculates itself. Variables that are assigned keep their precise value for the rest of the program.
+    // It's instantiated for float, double, long double, decimal, rational and dual, float is useful for blocks of rows (see executeBlock()).
+    template <typename Number>
+    class numberEngine : public numberBackend
+    {
+        public:
+            // The traits of the number type
+            typedef numberTraits<Number> traits;
+
+            // Constructor
+            numberEngine(const traits& numberType = traits());
+
+            // Get the name of the number type
+            string getName() const;
+            // Execute the program, returns the result written in the given format
+            string execute(const program& prog, environment& env, const realOutputType& outputType = outputType_auto, const int& precision = -1) const;
+
+            // Execute the program, returns the result or throws a calcError
+            Number evaluate(const program& prog, environment& env) const;
+            // Execute the program, taking the values of the variables that have a column (i.e. columns[slot] isn't 0) from that column
+            Number evaluate(const program& prog, environment& env, const std::vector<const Number*>& columns) const;
+            // Execute the program for rowCount rows at once, like program::executeBlock() does
+            // Every instruction is executed for a block of rows at once, which the compiler can turn into vector instructions.
+            void executeBlock(const program& prog, environment& env, const std::vector<const Number*>& columns, const size_t& rowCount, Number* out, char* failed, std::vector<program::rowError>& errors) const;
+            // Call a function, converting the arguments and result unless the number type calculates the function itself
+            Number call(mathFunction* function, const string& name, const std::vector<Number>& args, argList& realArgs) const;
+            // Call a function with unevaluated arguments, the result is converted
+            Number callExpressions(mathFunction* function, const string& name, const std::vector<string>& expressions, environment& env) const;
+
+        private:
+            // Execute the program for one row, taking the values of the variables in columns (if any) from the given row
+            Number evaluateRow(const program& prog, environment& env, const std::vector<const Number*>* columns, const size_t& row) const;
+            // Execute the program for a block of at most program::blockSize rows, one instruction at a time for all rows
+            void executeVectorized(const program& prog, environment& env, const std::vector<const Number*>& columns, const size_t& rowCount, Number* out, char* failed, std::vector<program::rowError>& errors) const;
+            // Get the value of a constant of the program
+            Number constant(const program& prog, const program::instruction& instr) const;
+            // Throws the error for a power with a negative base, or returns if there is nothing wrong
+            void checkPower(const Number& base, const Number& exponent, const bool& root) const;
+
+            traits numberType;                      // The traits of the number type
+    };
+
+    // The functions dual doesn't differentiate itself differentiate themselves, or are differentiated by central differences
+    template <> dual numberEngine<dual>::call(mathFunction* function, const string& name, const std::vector<dual>& args, argList& realArgs) const;
+    // Functions with unevaluated arguments are differentiated by central differences to the variable, which is local to the calls
+    // BENCH has derivative 0, because it measures time.
+    template <> dual numberEngine<dual>::callExpressions(mathFunction* function, const string& name, const std::vector<string>& expressions, environment& env) const;
+
+    // The number types the engine is instantiated for
+    extern template class numberEngine<float>;
+    extern template class numberEngine<double>;
+    extern template class numberEngine<long double>;
+    extern template class numberEngine<decimal>;
+    extern template class numberEngine<rational>;
+    extern template class numberEngine<dual>;
+}
+
+#endif // NUMBERENGINE_H
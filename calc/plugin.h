@@ -0,0 +1,122 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+/*
+ * The interface between Dalculator and plugins, shared libraries adding math functions implemented in C or C++
+ *
+ * A plugin exports a single function with C linkage, named dalc_plugin_entry (see DALC_PLUGIN_DEFINE below).
+ * The calculator calls it once after loading the library, it returns a description of the plugin and its functions.
+ * The description, the names and the user data have to stay valid until the library is unloaded.
+ *
+ * Only C types are used, so the plugin doesn't have to be built with the same compiler or standard library.
+ * The version of this interface is raised whenever the layout of the structures changes. The calculator asks the entry point
+ * for its own version first and then for the older versions it still loads, a plugin returns NULL for the versions it wasn't
+ * built for. Version 1 is still loaded: its dalc_plugin_function ends at user_data, without the expression added by version 2.
+ *
+ * The functions may be called by several threads at once, and shouldn't have side effects.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The version of this interface */
+#define DALC_PLUGIN_ABI_VERSION 2
+
+/* The statuses returned by the functions of a plugin */
+#define DALC_PLUGIN_OK              0   /* Succeeded */
+#define DALC_PLUGIN_ERROR           1   /* The calculation failed */
+#define DALC_PLUGIN_ERROR_ARGUMENT  2   /* One of the arguments is invalid, e.g. outside the domain of the function */
+
+/* The errors of the operators, these give the same errors as the operators of the calculator */
+/* For a division or modulo by 0 the result is set to the divisor, which is either 0 or -0 */
+#define DALC_PLUGIN_ERROR_DIVISION_BY_ZERO  3   /* A division by 0 */
+#define DALC_PLUGIN_ERROR_MODULO_BY_ZERO    4   /* A modulo by 0 */
+#define DALC_PLUGIN_ERROR_NEGATIVE_ROOT     5   /* A root of a negative number */
+#define DALC_PLUGIN_ERROR_NEGATIVE_POWER    6   /* A power of a negative number with an exponent that isn't an integer */
+
+/*
+ * Calculates the function for a single set of arguments, args holds arg_count arguments
+ * The number of arguments has already been checked against min_args and max_args.
+ * Writes the result to *result and returns DALC_PLUGIN_OK, or returns one of the errors.
+ */
+typedef int (*dalc_plugin_scalar)(const double* args, size_t arg_count, double* result, void* user_data);
+
+/*
+ * Calculates the function for row_count rows at once, args[i][row] is argument i of a row
+ * Writes the result of every row to results[row] and returns DALC_PLUGIN_OK. If any of the rows fails an error is returned,
+ * the calculator then calls the scalar function for every row instead to find out which rows failed.
+ */
+typedef int (*dalc_plugin_batch)(const double* const* args, size_t arg_count, size_t row_count, double* results, void* user_data);
+
+/* A function of a plugin */
+typedef struct dalc_plugin_function
+{
+    const char* name;               /* The name used in expressions, letters, digits and underscores */
+    int min_args;                   /* The minimal number of arguments */
+    int max_args;                   /* The maximal number of arguments, -1 for no maximum */
+    dalc_plugin_scalar scalar;      /* Calculates a single row, required */
+    dalc_plugin_batch batch;        /* Calculates a block of rows, may be NULL */
+    void* user_data;                /* Passed to scalar and batch */
+    const char* expression;         /* NULL, unless the function is a user defined function exported to C++ (see nativeexport.h): */
+                                    /* then it's the expression it was exported from, and it's only used in place of that definition */
+} dalc_plugin_function;
+
+/* The description of a plugin */
+typedef struct dalc_plugin
+{
+    unsigned int abi_version;                   /* DALC_PLUGIN_ABI_VERSION */
+    const char* name;                           /* The name of the plugin */
+    const char* version;                        /* The version of the plugin */
+    const dalc_plugin_function* functions;      /* The functions */
+    size_t function_count;                      /* The number of functions */
+} dalc_plugin;
+
+/* The entry point of a plugin, host_abi_version is the version of the calculator, NULL may be returned to refuse it */
+typedef const dalc_plugin* (*dalc_plugin_entry_point)(unsigned int host_abi_version);
+
+/* The name of the entry point */
+#define DALC_PLUGIN_ENTRY_NAME "dalc_plugin_entry"
+
+/* Defines the entry point of a plugin, returning the given dalc_plugin */
+#if defined(_WIN32)
+#   define DALC_PLUGIN_EXPORT __declspec(dllexport)
+#elif defined(__GNUC__)
+#   define DALC_PLUGIN_EXPORT __attribute__((visibility("default")))
+#else
+#   define DALC_PLUGIN_EXPORT
+#endif
+#ifdef __cplusplus
+#   define DALC_PLUGIN_LINKAGE extern "C"
+#else
+#   define DALC_PLUGIN_LINKAGE
+#endif
+#define DALC_PLUGIN_DEFINE(plugin) \
+    DALC_PLUGIN_LINKAGE DALC_PLUGIN_EXPORT const dalc_plugin* dalc_plugin_entry(unsigned int host_abi_version) \
+    { return host_abi_version == DALC_PLUGIN_ABI_VERSION ? &(plugin) : NULL; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLUGIN_H */
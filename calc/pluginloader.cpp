@@ -0,0 +1,392 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "pluginloader.h"
+#include "calc.h"
+#include "context.h"
+#include "mathfunction.h"
+#include <algorithm>
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <dlfcn.h>
+#   include <dirent.h>
+#endif
+
+namespace calc
+{
+    namespace
+    {
+        // Open a shared library, returns 0 and sets error if it couldn't be opened
+        void* openLibrary(const string& fileName, string& error)
+        {
+#ifdef _WIN32
+            void* library = reinterpret_cast<void*>(LoadLibraryA(fileName.c_str()));
+            if(!library)
+                error = "Couldn't open the library";
+#else
+            void* library = dlopen(fileName.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if(!library)
+                error = dlerror();
+#endif
+            return library;
+        }
+
+        // Find the entry point of a plugin in a shared library, returns 0 if there is none
+        dalc_plugin_entry_point findEntryPoint(void* library)
+        {
+#ifdef _WIN32
+            return reinterpret_cast<dalc_plugin_entry_point>(GetProcAddress(reinterpret_cast<HMODULE>(library), DALC_PLUGIN_ENTRY_NAME));
+#else
+            return reinterpret_cast<dalc_plugin_entry_point>(dlsym(library, DALC_PLUGIN_ENTRY_NAME));
+#endif
+        }
+
+        // Close a shared library
+        void closeLibrary(void* library)
+        {
+#ifdef _WIN32
+            FreeLibrary(reinterpret_cast<HMODULE>(library));
+#else
+            dlclose(library);
+#endif
+        }
+
+        // Get the names of the files in a directory, returns false if the directory couldn't be opened
+        bool listDirectory(const string& directory, std::vector<string>& files)
+        {
+#ifdef _WIN32
+            WIN32_FIND_DATAA found;
+            HANDLE search = FindFirstFileA((directory+"\\*").c_str(), &found);
+            if(search == INVALID_HANDLE_VALUE)
+                return false;
+            do
+            {
+                if(!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                    files.push_back(found.cFileName);
+            } while(FindNextFileA(search, &found));
+            FindClose(search);
+#else
+            DIR* dir = opendir(directory.c_str());
+            if(!dir)
+                return false;
+            while(dirent* entry = readdir(dir))
+                files.push_back(entry->d_name);
+            closedir(dir);
+#endif
+            return true;
+        }
+
+        // Returns true if the file name has the extension of a shared library
+        bool isLibraryName(const string& fileName)
+        {
+            const char* extensions[] = {".so", ".dylib", ".dll"};
+            for(const char* extension : extensions)
+            {
+                const string ext(extension);
+                if(fileName.size() > ext.size() && fileName.compare(fileName.size() - ext.size(), ext.size(), ext) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        // The oldest version of the plugin interface that is still loaded
+        const unsigned int oldestPluginVersion = 1;
+
+        // A function of a plugin made for version 1 of the interface, which didn't have the expression of exported functions yet
+        struct pluginFunctionVersion1
+        {
+            const char* name;
+            int min_args;
+            int max_args;
+            dalc_plugin_scalar scalar;
+            dalc_plugin_batch batch;
+            void* user_data;
+        };
+
+        // Returns true if the name can be used as the name of a function in an expression
+        bool isValidName(const char* name)
+        {
+            if(!name || !*name || (*name >= '0' && *name <= '9'))
+                return false;
+            for(; *name; ++name)
+            {
+                if(!((*name >= 'a' && *name <= 'z') || (*name >= 'A' && *name <= 'Z') || (*name >= '0' && *name <= '9') || *name == '_'))
+                    return false;
+            }
+            return true;
+        }
+
+        // Throws the error matching a status returned by a plugin, if it isn't DALC_PLUGIN_OK
+        void checkStatus(const int& status, const real& result, const string& name)
+        {
+            if(status == DALC_PLUGIN_OK)
+                return;
+            // The errors of the operators are the same errors the calculator would throw
+            switch(status)
+            {
+                case DALC_PLUGIN_ERROR_ARGUMENT:
+                    throw calcError("Invalid argument!", calcError::invalidArguments, name);
+                case DALC_PLUGIN_ERROR_DIVISION_BY_ZERO:
+                    throw calcError("Division by 0", calcError::invalidOperands, result);
+                case DALC_PLUGIN_ERROR_MODULO_BY_ZERO:
+                    throw calcError("Modulo by 0", calcError::invalidOperands, result);
+                case DALC_PLUGIN_ERROR_NEGATIVE_ROOT:
+                    throw calcError("No negative roots allowed", calcError::invalidOperands);
+                case DALC_PLUGIN_ERROR_NEGATIVE_POWER:
+                    throw calcError("Only integer powers of negative numbers", calcError::invalidOperands);
+            }
+            throw calcError("The function couldn't be executed", calcError::unknown, name);
+        }
+    }
+
+    // pluginMathFunction:
+        // Public:
+            pluginMathFunction::pluginMathFunction(const dalc_plugin_function& function)
+            : mathFunction(false), function(function) {}
+
+            real pluginMathFunction::execute(const argList& vars, const string& name)
+            {
+                // Check the number of arguments
+                if(!acceptsArguments(vars.size()))
+                {
+                    std::vector<real> extraRealInfo(2, vars.size());
+                    extraRealInfo[1] = static_cast<int>(vars.size()) < function.min_args ? function.min_args : function.max_args;
+                    throw calcError(static_cast<int>(vars.size()) < function.min_args ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+
+                // Call the function of the plugin
+                real result = 0;
+                const int status = function.scalar(vars.empty() ? 0 : &vars[0], vars.size(), &result, function.user_data);
+                checkStatus(status, result, name);
+                return result;
+            }
+
+            bool pluginMathFunction::supportsBatch() const
+            { return function.batch != 0; }
+
+            bool pluginMathFunction::executeBatch(const real* const* args, const size_t& argCount, const size_t& rowCount, real* results, const string&)
+            {
+                // A wrong number of arguments is reported by execute()
+                if(!function.batch || !acceptsArguments(argCount))
+                    return false;
+                return function.batch(args, argCount, rowCount, results, function.user_data) == DALC_PLUGIN_OK;
+            }
+
+            string pluginMathFunction::getName() const
+            { return function.name; }
+
+            string pluginMathFunction::getExpression() const
+            { return function.expression ? function.expression : ""; }
+
+        // Private:
+            bool pluginMathFunction::acceptsArguments(const size_t& argCount) const
+            { return static_cast<int>(argCount) >= function.min_args && (function.max_args < 0 || static_cast<int>(argCount) <= function.max_args); }
+
+    // pluginLoader:
+        // Public:
+            pluginLoader::pluginLoader()
+            {}
+
+            pluginLoader::~pluginLoader()
+            {
+                // Delete the functions before the libraries holding their descriptions are unloaded
+                functions.clear();
+                for(std::vector<std::unique_ptr<plugin> >::reverse_iterator pos = plugins.rbegin(); pos != plugins.rend(); ++pos)
+                {
+                    (*pos)->functions.clear();
+                    closeLibrary((*pos)->library);
+                }
+            }
+
+            void pluginLoader::load(const string& fileName)
+            {
+                // Every file is only loaded once
+                for(std::vector<std::unique_ptr<plugin> >::const_iterator pos = plugins.begin(); pos != plugins.end(); ++pos)
+                {
+                    if((*pos)->info.fileName == fileName)
+                        return;
+                }
+
+                // Open the library and ask it for the description of the plugin
+                string error;
+                void* library = openLibrary(fileName, error);
+                if(!library)
+                    throw parseError(error, fileName);
+                // Plugins made for an older version of the interface refuse the current version, so they're asked for the older versions
+                const dalc_plugin_entry_point entryPoint = findEntryPoint(library);
+                const dalc_plugin* description = 0;
+                for(unsigned int version = DALC_PLUGIN_ABI_VERSION; entryPoint && !description && version >= oldestPluginVersion; --version)
+                    description = entryPoint(version);
+                if(!description || description->abi_version < oldestPluginVersion || description->abi_version > DALC_PLUGIN_ABI_VERSION)
+                {
+                    closeLibrary(library);
+                    throw parseError(entryPoint ? "The plugin was made for another version of Dalculator" : "Not a plugin of Dalculator", fileName);
+                }
+
+                // The functions of version 1 are converted to the current layout, without an expression
+                const dalc_plugin_function* described = description->functions;
+                std::vector<dalc_plugin_function> converted;
+                if(description->abi_version == 1)
+                {
+                    const pluginFunctionVersion1* old = reinterpret_cast<const pluginFunctionVersion1*>(description->functions);
+                    for(size_t i = 0; i < description->function_count; ++i)
+                    {
+                        const dalc_plugin_function function = {old[i].name, old[i].min_args, old[i].max_args, old[i].scalar, old[i].batch, old[i].user_data, 0};
+                        converted.push_back(function);
+                    }
+                    described = converted.data();
+                }
+
+                // Check all functions before any of them is added
+                for(size_t i = 0; i < description->function_count; ++i)
+                {
+                    const dalc_plugin_function& function = described[i];
+                    if(!isValidName(function.name) || !function.scalar || function.min_args < 0 || (function.max_args >= 0 && function.max_args < function.min_args))
+                    {
+                        closeLibrary(library);
+                        throw parseError("The plugin has an invalid function", fileName);
+                    }
+                }
+
+                // Remember the plugin and add its functions
+                std::unique_ptr<plugin> loaded(new plugin());
+                loaded->library = library;
+                loaded->info.fileName = fileName;
+                loaded->info.name = description->name ? description->name : "";
+                loaded->info.version = description->version ? description->version : "";
+                loaded->converted.swap(converted);
+                for(size_t i = 0; i < description->function_count; ++i)
+                {
+                    loaded->functions.push_back(std::unique_ptr<pluginMathFunction>(new pluginMathFunction(described[i])));
+                    loaded->info.functions.push_back(described[i].name);
+                    if(!described[i].expression)
+                        functions[described[i].name] = loaded->functions.back().get();
+                }
+                plugins.push_back(std::move(loaded));
+            }
+
+            std::vector<string> pluginLoader::loadDirectory(const string& directory)
+            {
+                std::vector<string> errors;
+                std::vector<string> files;
+                if(!listDirectory(directory, files))
+                    return errors;
+
+                // Load the libraries in alphabetical order, so it's clear which plugin wins if two of them have a function with the same name
+                std::sort(files.begin(), files.end());
+                for(std::vector<string>::const_iterator pos = files.begin(); pos != files.end(); ++pos)
+                {
+                    if(!isLibraryName(*pos))
+                        continue;
+                    try
+                    { load(directory+'/'+*pos); }
+                    catch(parseError& err)
+                    { errors.push_back(err.extraData+": "+err.msg); }
+                }
+                return errors;
+            }
+
+            void pluginLoader::addTo(calc& calculator) const
+            {
+                for(functionList::const_iterator pos = functions.begin(); pos != functions.end(); ++pos)
+                    calculator.setFunction(pos->first, pos->second);
+            }
+
+            void pluginLoader::addTo(context& target) const
+            {
+                for(functionList::const_iterator pos = functions.begin(); pos != functions.end(); ++pos)
+                    target.setFunction(pos->first, pos->second);
+            }
+
+            void pluginLoader::useCompiled(calc& calculator) const
+            {
+                for(std::vector<std::unique_ptr<plugin> >::const_iterator loaded = plugins.begin(); loaded != plugins.end(); ++loaded)
+                {
+                    // Check whether all exported functions of the plugin are still defined the same way
+                    bool upToDate = true;
+                    for(std::vector<std::unique_ptr<pluginMathFunction> >::const_iterator pos = (*loaded)->functions.begin(); pos != (*loaded)->functions.end(); ++pos)
+                    {
+                        if((*pos)->getExpression().empty())
+                            continue;
+                        const userDefinedMathFunction* definition = dynamic_cast<const userDefinedMathFunction*>(calculator.getFunction((*pos)->getName()));
+                        upToDate = upToDate && definition && definition->getExpression() == (*pos)->getExpression();
+                    }
+
+                    // Use them if they are
+                    if(upToDate)
+                    {
+                        for(std::vector<std::unique_ptr<pluginMathFunction> >::const_iterator pos = (*loaded)->functions.begin(); pos != (*loaded)->functions.end(); ++pos)
+                        {
+                            if(!(*pos)->getExpression().empty())
+                                dynamic_cast<userDefinedMathFunction*>(calculator.getFunction((*pos)->getName()))->setCompiled(pos->get());
+                        }
+                        continue;
+                    }
+
+                    // Otherwise stop using them, also by functions that have been renamed
+                    const functionList* current = calculator.getFunctions();
+                    for(functionList::const_iterator pos = current->begin(); pos != current->end(); ++pos)
+                    {
+                        userDefinedMathFunction* definition = dynamic_cast<userDefinedMathFunction*>(pos->second);
+                        if(!definition || !definition->getCompiled())
+                            continue;
+                        for(std::vector<std::unique_ptr<pluginMathFunction> >::const_iterator compiled = (*loaded)->functions.begin(); compiled != (*loaded)->functions.end(); ++compiled)
+                        {
+                            if(definition->getCompiled() == compiled->get())
+                                definition->setCompiled(0);
+                        }
+                    }
+                }
+            }
+
+            void pluginLoader::useCompiled(context& target) const
+            {
+                for(std::vector<std::unique_ptr<plugin> >::const_iterator loaded = plugins.begin(); loaded != plugins.end(); ++loaded)
+                {
+                    // Check whether all exported functions of the plugin are still defined the same way
+                    bool upToDate = true;
+                    for(std::vector<std::unique_ptr<pluginMathFunction> >::const_iterator pos = (*loaded)->functions.begin(); pos != (*loaded)->functions.end(); ++pos)
+                    {
+                        if(!(*pos)->getExpression().empty())
+                            upToDate = upToDate && target.getFunctionExpression((*pos)->getName()) == (*pos)->getExpression();
+                    }
+
+                    // Changing a function of a context stops using all compiled functions already, so there's nothing to undo
+                    for(std::vector<std::unique_ptr<pluginMathFunction> >::const_iterator pos = (*loaded)->functions.begin(); upToDate && pos != (*loaded)->functions.end(); ++pos)
+                    {
+                        if(!(*pos)->getExpression().empty())
+                            target.useCompiledFunction((*pos)->getName(), (*pos)->getExpression(), pos->get());
+                    }
+                }
+            }
+
+            mathFunction* pluginLoader::getFunction(const string& name) const
+            {
+                functionList::const_iterator pos = functions.find(name);
+                return pos != functions.end() ? pos->second : 0;
+            }
+
+            std::vector<pluginLoader::pluginInfo> pluginLoader::getPlugins() const
+            {
+                std::vector<pluginInfo> out;
+                for(std::vector<std::unique_ptr<plugin> >::const_iterator pos = plugins.begin(); pos != plugins.end(); ++pos)
+                    out.push_back((*pos)->info);
+                return out;
+            }
+}
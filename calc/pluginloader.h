@@ -0,0 +1,121 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef PLUGINLOADER_H
+#define PLUGINLOADER_H
+
+#include <vector>
+#include <memory>
+#include "types.h"
+#include "error.h"
+#include "mathfunction.h"
+#include "plugin.h"
+
+namespace calc
+{
+    // A math function of a plugin, it calls the functions of the plugin through the C interface of plugin.h
+    class pluginMathFunction : public mathFunction
+    {
+        public:
+            // Constructor, the description has to outlive this function
+            pluginMathFunction(const dalc_plugin_function& function);
+
+            // Execute this function
+            virtual real execute(const argList& vars, const string& name);
+            // Returns true if the plugin has a batch version of the function
+            virtual bool supportsBatch() const;
+            // Execute the batch version of the function
+            virtual bool executeBatch(const real* const* args, const size_t& argCount, const size_t& rowCount, real* results, const string& name);
+
+            // Get the name of the function in the plugin
+            string getName() const;
+            // Get the expression this function was exported from, returns an empty string if it isn't an exported user defined function
+            string getExpression() const;
+
+        private:
+            // Returns true if the function accepts the given number of arguments
+            bool acceptsArguments(const size_t& argCount) const;
+
+            // The description of the function, owned by the plugin
+            const dalc_plugin_function& function;
+    };
+
+    // Loads plugins, shared libraries that add math functions (see plugin.h), and keeps them loaded
+    // The functions of all plugins can be added to a calculator or a context, like the built-in functions.
+    // If several plugins have a function with the same name, the plugin that was loaded last wins.
+    // Functions exported from user defined functions (see nativeexport.h) aren't added, they replace the definitions they were exported from.
+    class pluginLoader
+    {
+        public:
+            // The description of a loaded plugin
+            struct pluginInfo
+            {
+                string fileName;                    // The file the plugin was loaded from
+                string name;                        // The name of the plugin
+                string version;                     // The version of the plugin
+                std::vector<string> functions;      // The names of its functions
+            };
+
+            // Constructor
+            pluginLoader();
+            // Destructor, unloads all plugins, their functions may not be used any more after this
+            ~pluginLoader();
+
+            // Load a plugin, nothing happens if it's already loaded
+            // A parseError holding the reason and the file name is thrown if the library couldn't be opened or isn't a valid plugin
+            void load(const string& fileName);
+            // Load all plugins in a directory, i.e. all files with the extension of shared libraries (.so, .dylib or .dll)
+            // Returns a message for every file that couldn't be loaded, a directory that doesn't exist is just empty
+            std::vector<string> loadDirectory(const string& directory);
+
+            // Add the functions of all plugins to the given calculator
+            void addTo(calc& calculator) const;
+            // Add the functions of all plugins to the given context
+            void addTo(context& target) const;
+            // Let the user defined functions of the calculator be executed by the functions exported from them, if there are any
+            // The functions of a plugin call each other directly, so they're only used if all of them are still defined by the same expressions.
+            // Call this again whenever a user defined function has been changed, renamed or deleted.
+            void useCompiled(calc& calculator) const;
+            // Let the functions of the context defined by an expression be executed by the functions exported from them, see useCompiled(calc&)
+            void useCompiled(context& target) const;
+
+            // Get the function of a plugin with the given name, returns 0 if there is none
+            mathFunction* getFunction(const string& name) const;
+            // Get the descriptions of all loaded plugins, in the order they were loaded
+            std::vector<pluginInfo> getPlugins() const;
+
+        private:
+            // Prevent copying:
+            pluginLoader& operator=(const pluginLoader& other);
+            pluginLoader(const pluginLoader& other);
+
+            // A loaded plugin
+            struct plugin
+            {
+                pluginInfo info;                                            // Its description
+                void* library;                                              // The handle of the shared library
+                std::vector<std::unique_ptr<pluginMathFunction> > functions;   // Its functions
+                std::vector<dalc_plugin_function> converted;                // The descriptions of its functions if it was made for version 1, in the current layout
+            };
+
+            std::vector<std::unique_ptr<plugin> > plugins;                  // The loaded plugins
+            functionList functions;                                         // The functions of all plugins by name, without the exported user defined functions
+    };
+}
+
+#endif // PLUGINLOADER_H
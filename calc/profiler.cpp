@@ -0,0 +1,233 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "profiler.h"
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+
+namespace calc
+{
+    namespace
+    {
+        // The current time in nanoseconds
+        unsigned long long now()
+        { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+        // The measurements of all threads, protected by a single mutex since they're only touched while profiling
+        struct profileState
+        {
+            std::mutex mutex;                               // Protects everything below
+            profiler::profileList profiles;                 // The measurements of every function
+            std::vector<profiler::traceEvent> trace;        // The calls kept for the trace
+            size_t traceLimit = 1000000;                    // The maximum number of calls in the trace
+            unsigned long long dropped = 0;                 // The calls that didn't fit in the trace
+            unsigned long long epoch = now();               // The moment of the last reset, the start of the trace
+        };
+
+        // Get the state, it's created the first time it's needed so it can be used while other static objects are constructed
+        profileState& state()
+        {
+            static profileState instance;
+            return instance;
+        }
+
+        // Get the number of the current thread in the trace
+        unsigned int threadNumber()
+        {
+            static std::atomic<unsigned int> threadCount(0);
+            static thread_local unsigned int number = 0;
+            if(number == 0)
+                number = ++threadCount;
+            return number;
+        }
+
+        // Write a string as a JSON string
+        void writeJsonString(std::ostream& out, const string& str)
+        {
+            out<<'"';
+            for(string::const_iterator pos = str.begin(); pos != str.end(); ++pos)
+            {
+                if(*pos == '"' || *pos == '\\')
+                    out<<'\\'<<*pos;
+                else if(static_cast<unsigned char>(*pos) < 0x20)
+                    out<<"\\u00"<<"0123456789abcdef"[*pos >> 4]<<"0123456789abcdef"[*pos & 0xF];
+                else
+                    out<<*pos;
+            }
+            out<<'"';
+        }
+
+        // Write a number of nanoseconds as microseconds, with three decimals
+        void writeMicroseconds(std::ostream& out, const unsigned long long& nanoseconds)
+        { out<<nanoseconds / 1000<<'.'<<std::setw(3)<<std::setfill('0')<<nanoseconds % 1000<<std::setfill(' '); }
+    }
+
+    // profiler:
+        // Public:
+            // Static:
+                void profiler::setEnabled(const bool& enable)
+                { enabled.store(enable, std::memory_order_relaxed); }
+
+                void profiler::reset()
+                {
+                    profileState& profile = state();
+                    std::lock_guard<std::mutex> lock(profile.mutex);
+                    profile.profiles.clear();
+                    profile.trace.clear();
+                    profile.dropped = 0;
+                    profile.epoch = now();
+                }
+
+                void profiler::setTraceLimit(const size_t& events)
+                {
+                    profileState& profile = state();
+                    std::lock_guard<std::mutex> lock(profile.mutex);
+                    profile.traceLimit = events;
+                }
+
+                profiler::profileList profiler::getProfiles()
+                {
+                    profileState& profile = state();
+                    std::lock_guard<std::mutex> lock(profile.mutex);
+                    return profile.profiles;
+                }
+
+                std::vector<profiler::traceEvent> profiler::getTrace()
+                {
+                    profileState& profile = state();
+                    std::lock_guard<std::mutex> lock(profile.mutex);
+                    return profile.trace;
+                }
+
+                unsigned long long profiler::getDroppedEvents()
+                {
+                    profileState& profile = state();
+                    std::lock_guard<std::mutex> lock(profile.mutex);
+                    return profile.dropped;
+                }
+
+                void profiler::writeReport(std::ostream& out)
+                {
+                    // Sort the functions by their exclusive time, the most expensive first
+                    const profileList profiles = getProfiles();
+                    std::vector<profileList::const_iterator> order;
+                    unsigned long long total = 0;
+                    size_t nameWidth = 8;
+                    for(profileList::const_iterator pos = profiles.begin(); pos != profiles.end(); ++pos)
+                    {
+                        order.push_back(pos);
+                        total += pos->second.exclusiveNanoseconds;
+                        nameWidth = std::max(nameWidth, pos->first.size());
+                    }
+                    std::stable_sort(order.begin(), order.end(), [](const profileList::const_iterator& a, const profileList::const_iterator& b)
+                    { return a->second.exclusiveNanoseconds > b->second.exclusiveNanoseconds; });
+
+                    // Write the header and a line for every function
+                    const std::ios::fmtflags flags = out.flags();
+                    const std::streamsize precision = out.precision();
+                    out<<std::left<<std::setw(nameWidth)<<"function"<<std::right
+                       <<std::setw(12)<<"calls"<<std::setw(12)<<"cache hits"
+                       <<std::setw(18)<<"inclusive (us)"<<std::setw(18)<<"exclusive (us)"<<std::setw(8)<<"excl %"
+                       <<std::setw(14)<<"ns per call"<<'\n';
+                    for(std::vector<profileList::const_iterator>::const_iterator pos = order.begin(); pos != order.end(); ++pos)
+                    {
+                        const functionProfile& function = (*pos)->second;
+                        out<<std::left<<std::setw(nameWidth)<<(*pos)->first<<std::right
+                           <<std::setw(12)<<function.calls<<std::setw(12)<<function.cacheHits<<std::setw(18 - 4);
+                        writeMicroseconds(out, function.inclusiveNanoseconds);
+                        out<<std::setw(18 - 4);
+                        writeMicroseconds(out, function.exclusiveNanoseconds);
+                        out<<std::setw(7)<<std::fixed<<std::setprecision(1)<<(total ? 100.0 * function.exclusiveNanoseconds / total : 0.0)<<'%'
+                           <<std::setw(14)<<(function.calls ? function.inclusiveNanoseconds / function.calls : 0)<<'\n';
+                    }
+
+                    out.flags(flags);
+                    out.precision(precision);
+
+                    // Mention the calls that are missing from the trace, so nobody is surprised by it
+                    const unsigned long long dropped = getDroppedEvents();
+                    if(dropped)
+                        out<<dropped<<" call(s) weren't kept for the trace\n";
+                }
+
+                void profiler::writeChromeTrace(std::ostream& out)
+                {
+                    // Every call is a complete event ("X"), with its start and duration in microseconds
+                    const std::vector<traceEvent> trace = getTrace();
+                    out<<"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+                    for(std::vector<traceEvent>::const_iterator pos = trace.begin(); pos != trace.end(); ++pos)
+                    {
+                        out<<(pos == trace.begin() ? "\n" : ",\n")<<"{\"name\":";
+                        writeJsonString(out, pos->name);
+                        out<<",\"cat\":\"function\",\"ph\":\"X\",\"pid\":1,\"tid\":"<<pos->thread<<",\"ts\":";
+                        writeMicroseconds(out, pos->start);
+                        out<<",\"dur\":";
+                        writeMicroseconds(out, pos->duration);
+                        out<<'}';
+                    }
+                    out<<"\n]}\n";
+                }
+
+        // Private:
+            // Static:
+                std::atomic<bool> profiler::enabled(false);
+                thread_local profiler::scopedCall* profiler::innermost = 0;
+
+    // profiler::scopedCall:
+        // Private:
+            void profiler::scopedCall::begin()
+            {
+                hit = false;
+                children = 0;
+                parent = innermost;
+                innermost = this;
+                start = now();
+            }
+
+            void profiler::scopedCall::end()
+            {
+                // The time of this call counts as time spent in calls for the call it's made from
+                const unsigned long long stop = now();
+                const unsigned long long duration = stop - start;
+                innermost = parent;
+                if(parent)
+                    parent->children += duration;
+
+                profileState& profile = state();
+                const unsigned int thread = threadNumber();
+                std::lock_guard<std::mutex> lock(profile.mutex);
+                functionProfile& function = profile.profiles[name];
+                ++function.calls;
+                function.cacheHits += hit;
+                function.inclusiveNanoseconds += duration;
+                function.exclusiveNanoseconds += duration - std::min(children, duration);
+
+                // Keep the call for the trace, calls that started before the last reset start at 0
+                if(profile.trace.size() < profile.traceLimit)
+                {
+                    const traceEvent event = {name, start > profile.epoch ? start - profile.epoch : 0, duration, thread};
+                    profile.trace.push_back(event);
+                }
+                else
+                    ++profile.dropped;
+            }
+}
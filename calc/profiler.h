@@ -0,0 +1,135 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <iosfwd>
+#include "types.h"
+
+namespace calc
+{
+    // Measures the calls of every function, both built-in and user defined, in all threads together
+    // Nothing is measured until it's enabled with setEnabled(), after that every call made by a compiled expression or by the interpreter
+    // is counted and timed. The measurements can be read using getProfiles(), or written as a flat report or as a trace that can be
+    // opened in chrome://tracing or Perfetto. Defining CALC_NO_INSTRUMENTATION removes the profiler from the engine entirely.
+    class profiler
+    {
+        public:
+            // The measurements of a single function
+            struct functionProfile
+            {
+                unsigned long long calls = 0;                   // The number of calls
+                unsigned long long cacheHits = 0;               // The calls of user defined functions that reused the already compiled expression
+                unsigned long long inclusiveNanoseconds = 0;    // The time spent in the calls, including the functions called by them
+                unsigned long long exclusiveNanoseconds = 0;    // The time spent in the calls, without the functions called by them
+            };
+            typedef std::map<string, functionProfile> profileList;
+
+            // A single call, as written to the trace
+            struct traceEvent
+            {
+                string name;                                    // The name of the function
+                unsigned long long start;                       // When the call started, in nanoseconds since the last reset
+                unsigned long long duration;                    // How long the call took, in nanoseconds
+                unsigned int thread;                            // The thread that made the call, threads are numbered from 1
+            };
+
+            // Enable or disable the profiler, this affects all threads
+            static void setEnabled(const bool& enabled);
+            // Returns true if function calls are measured
+            static bool isEnabled()
+            { return enabled.load(std::memory_order_relaxed); }
+            // Forget all measurements
+            static void reset();
+
+            // Set the maximum number of calls that are kept for the trace (1000000 by default), later calls are still measured but not traced
+            static void setTraceLimit(const size_t& events);
+            // Get the measurements of all functions that have been called
+            static profileList getProfiles();
+            // Get the calls kept for the trace, in the order in which they ended
+            static std::vector<traceEvent> getTrace();
+            // Get the number of calls that weren't kept for the trace because the limit was reached
+            static unsigned long long getDroppedEvents();
+
+            // Write a table with a line for every function, the most expensive function (by exclusive time) first
+            static void writeReport(std::ostream& out);
+            // Write the trace in the Chrome trace event format (JSON)
+            static void writeChromeTrace(std::ostream& out);
+
+            // Set whether the current call is a cache hit, use CALC_PROFILE_CACHE_HIT() instead so the profiler can be removed
+            static void setCacheHit(const bool& hit)
+            {
+                if(innermost)
+                    innermost->hit = hit;
+            }
+
+            // Measures a function call during its lifetime, use CALC_PROFILE_CALL() instead so the profiler can be removed
+            class scopedCall
+            {
+                public:
+                    // Constructor, starts measuring a call of the given function, the name has to outlive the object
+                    scopedCall(const string& name)
+                    : name(name), active(isEnabled())
+                    {
+                        if(active)
+                            begin();
+                    }
+                    // Destructor, ends measuring the call
+                    ~scopedCall()
+                    {
+                        if(active)
+                            end();
+                    }
+
+                private:
+                    // Prevent copying:
+                    scopedCall& operator=(const scopedCall& other);
+                    scopedCall(const scopedCall& other);
+
+                    // Start and end measuring the call
+                    void begin();
+                    void end();
+
+                    friend class profiler;
+
+                    const string& name;                 // The name of the function
+                    bool active;                        // Whether the call is measured
+                    bool hit;                           // Whether the call was a cache hit
+                    scopedCall* parent;                 // The call this call is made from
+                    unsigned long long start;           // When the call started, in nanoseconds
+                    unsigned long long children;        // The time spent in the calls made from this call, in nanoseconds
+            };
+
+        private:
+            static std::atomic<bool> enabled;                   // Whether function calls are measured
+            static thread_local scopedCall* innermost;          // The call that is running in the current thread
+    };
+}
+
+// Macros to measure a function call (only one per scope) and to mark it as a cache hit
+#ifdef CALC_NO_INSTRUMENTATION
+#   define CALC_PROFILE_CALL(name)
+#   define CALC_PROFILE_CACHE_HIT(hit)
+#else
+#   define CALC_PROFILE_CALL(name)      ::calc::profiler::scopedCall calcProfiledCall(name)
+#   define CALC_PROFILE_CACHE_HIT(hit)  ::calc::profiler::setCacheHit(hit)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,1127 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "program.h"
+#include "mathfunction.h"
+#include "instrumentation.h"
+#include "profiler.h"
+#include "jit.h"
+#include "random.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        // A buffer that lives on the stack as long as it's small enough, which saves an allocation for most programs
+        template <typename T, size_t N>
+        class scratchBuffer
+        {
+            public:
+                // Constructor, creates a buffer of the given size with all elements set to value
+                scratchBuffer(const size_t& size, const T& value)
+                : heap(size > N ? size : 0, value), data(size > N ? &heap[0] : local)
+                { std::fill(local, local + (size > N ? 0 : size), value); }
+
+                // Access the elements
+                T& operator[](const size_t& index)
+                { return data[index]; }
+
+            private:
+                // Prevent copying:
+                scratchBuffer& operator=(const scratchBuffer& other);
+                scratchBuffer(const scratchBuffer& other);
+
+                T local[N];                         // The buffer on the stack
+                std::vector<T> heap;                // The buffer on the heap, used if the stack buffer is too small
+                T* data;                            // Points to the buffer that is used
+        };
+
+        // The largest integer that every smaller integer can be represented exactly by a real, 2^53
+        const real largestExactInteger = 9007199254740992.0;
+
+        // Calculate an integer instruction on two integers, returns false if the result doesn't fit in an integer
+        bool integerOperation(const program::opcode& op, const integer& a, const integer& b, integer& out)
+        {
+            const integer largest = std::numeric_limits<integer>::max(), smallest = std::numeric_limits<integer>::min();
+            switch(op)
+            {
+                case program::opIntNegate:
+                    if(a == smallest)
+                        return false;
+                    out = -a;
+                return true;
+
+                case program::opIntAdd:
+                    if((b > 0 && a > largest - b) || (b < 0 && a < smallest - b))
+                        return false;
+                    out = a + b;
+                return true;
+
+                case program::opIntSubtract:
+                    if((b < 0 && a > largest + b) || (b > 0 && a < smallest + b))
+                        return false;
+                    out = a - b;
+                return true;
+
+                case program::opIntMultiply:
+                {
+                    // Multiply the magnitudes, then check whether the product fits with its sign
+                    typedef unsigned long long int magnitude;
+                    const magnitude first = a < 0 ? 0 - static_cast<magnitude>(a) : static_cast<magnitude>(a);
+                    const magnitude second = b < 0 ? 0 - static_cast<magnitude>(b) : static_cast<magnitude>(b);
+                    if(first != 0 && second > std::numeric_limits<magnitude>::max() / first)
+                        return false;
+                    const magnitude product = first * second;
+                    const bool negative = (a < 0) != (b < 0);
+                    if(product > static_cast<magnitude>(largest) + (negative ? 1 : 0))
+                        return false;
+                    out = negative ? static_cast<integer>(0 - product) : static_cast<integer>(product);
+                }
+                return true;
+
+                case program::opIntModulo:
+                    // Like fmod() the result has the sign of a, a divisor of 0 has already been reported
+                    if(b == 0)
+                        return false;
+                    out = b == -1 ? 0 : a % b;
+                return true;
+
+                case program::opIntGreater:
+                    out = a > b;
+                return true;
+
+                case program::opIntLess:
+                    out = a < b;
+                return true;
+
+                default:
+                return false;
+            }
+        }
+
+        // Calculate an instruction on reals, which is what an integer instruction does if it can't be calculated exactly
+        real realOperation(const program::opcode& op, const real& a, const real& b)
+        {
+            switch(program::realOpcode(op))
+            {
+                case program::opNegate:
+                return a * -1;
+                case program::opAdd:
+                return a + b;
+                case program::opSubtract:
+                return a - b;
+                case program::opMultiply:
+                return a * b;
+                case program::opModulo:
+                return std::fmod(a, b);
+                case program::opGreater:
+                return a > b;
+                case program::opLess:
+                return a < b;
+                default:
+                return 0;
+            }
+        }
+
+        // Calculate an integer instruction, exactly if both operands are exact and the result fits
+        // The operands are copies, because the destination may be one of them. A result of 0 gets its real value from the
+        // calculation on reals, so it keeps the sign it would have had (e.g. -0 for 0 * -1).
+        inline void calculateInteger(const program::opcode& op, const real a, const real b, const program::exactInteger intA, const program::exactInteger intB, real& dest, program::exactInteger& intDest)
+        {
+            integer value;
+            if(intA.exact && (intB.exact || op == program::opIntNegate) && integerOperation(op, intA.value, intB.value, value))
+            {
+                intDest.value = value;
+                intDest.exact = true;
+                dest = value != 0 ? static_cast<real>(value) : realOperation(op, a, b);
+            }
+            else
+            {
+                intDest.exact = false;
+                dest = realOperation(op, a, b);
+            }
+        }
+
+        // Get an operand of a bitwise operator, its exact integer value if it has one and the value rounded to an integer otherwise
+        inline integer bitwiseOperand(const real& value, const program::exactInteger& intValue, const bool& hasInteger)
+        { return hasInteger && intValue.exact ? intValue.value : static_cast<integer>(round(value)); }
+    }
+
+    // environment:
+        environment::~environment()
+        {}
+
+        randomGenerator* environment::getRandomGenerator()
+        { return 0; }
+
+    // localEnvironment:
+        localEnvironment::localEnvironment(environment& enclosing, const string& name, const real& value)
+        : enclosing(enclosing), name(name), value(value) {}
+
+        const string& localEnvironment::getName() const
+        { return name; }
+
+        real localEnvironment::getValue() const
+        { return value; }
+
+        void localEnvironment::setValue(const real& newValue)
+        { value = newValue; }
+
+        real* localEnvironment::findVar(const string& varName)
+        { return varName == name ? &value : enclosing.findVar(varName); }
+
+        real* localEnvironment::createVar(const string& varName)
+        { return varName == name ? &value : enclosing.createVar(varName); }
+
+        mathFunction* localEnvironment::findFunction(const string& functionName)
+        { return enclosing.findFunction(functionName); }
+
+        randomGenerator* localEnvironment::getRandomGenerator()
+        { return enclosing.getRandomGenerator(); }
+
+    // program:
+        // Public:
+            const size_t program::blockSize;
+            const unsigned int program::defaultJitThreshold;
+
+            program::program()
+            : registerCount(0), result(0), stores(false), usesIntegers(false), integerResult(false) {}
+
+            // Functions used to build the program
+            unsigned int program::newRegister()
+            { return registerCount++; }
+
+            unsigned int program::addConstant(const real& value, const string& literal)
+            {
+                constants.push_back(value);
+                literals.push_back(literal);
+                return constants.size()-1;
+            }
+
+            unsigned int program::addInteger(const integer& value)
+            {
+                integers.push_back(value);
+                return integers.size()-1;
+            }
+
+            unsigned int program::variableSlot(const string& name)
+            {
+                // Every variable has one slot, no matter how often it's used
+                std::vector<string>::const_iterator pos = std::find(variables.begin(), variables.end(), name);
+                if(pos != variables.end())
+                    return pos - variables.begin();
+                variables.push_back(name);
+                return variables.size()-1;
+            }
+
+            unsigned int program::functionSlot(const string& name)
+            {
+                // Every function has one slot, no matter how often it's called
+                std::vector<string>::const_iterator pos = std::find(functions.begin(), functions.end(), name);
+                if(pos != functions.end())
+                    return pos - functions.begin();
+                functions.push_back(name);
+                return functions.size()-1;
+            }
+
+            unsigned int program::addString(const string& str)
+            {
+                strings.push_back(str);
+                return strings.size()-1;
+            }
+
+            unsigned int program::addArguments(const std::vector<unsigned int>& registers)
+            {
+                arguments.insert(arguments.end(), registers.begin(), registers.end());
+                return arguments.size() - registers.size();
+            }
+
+            unsigned int program::addExpressions(const std::vector<string>& args)
+            {
+                expressions.push_back(args);
+                return expressions.size()-1;
+            }
+
+            void program::emit(const opcode& op, const unsigned int& dest, const unsigned int& a, const unsigned int& b, const unsigned int& c)
+            {
+                instruction instr = {op, dest, a, b, c};
+                instructions.push_back(instr);
+                if(op == opStore || op == opCallExpressions)
+                    stores = true;
+            }
+
+            void program::finish(const unsigned int& resultRegister)
+            {
+                // While building every instruction got a new register, now we let registers that are no longer needed be reused
+                // First find out when every register is read for the last time (the result is read at the very end)
+                const size_t never = std::numeric_limits<size_t>::max();
+                std::vector<size_t> lastUse(registerCount, never);
+                std::vector<unsigned int*> sources;
+                for(size_t i = 0; i < instructions.size(); ++i)
+                {
+                    sources.clear();
+                    sourceRegisters(instructions[i], sources);
+                    for(size_t j = 0; j < sources.size(); ++j)
+                        lastUse[*sources[j]] = i;
+                }
+                lastUse[resultRegister] = instructions.size();
+
+                // Then walk through the instructions giving every result the first free register,
+                // a register becomes free after the instruction that reads it for the last time
+                std::vector<unsigned int> mapping(registerCount, 0);
+                std::vector<unsigned int> freeRegisters;
+                unsigned int packedCount = 0;
+                for(size_t i = 0; i < instructions.size(); ++i)
+                {
+                    sources.clear();
+                    sourceRegisters(instructions[i], sources);
+                    for(size_t j = 0; j < sources.size(); ++j)
+                    {
+                        const unsigned int reg = *sources[j];
+                        *sources[j] = mapping[reg];
+                        if(lastUse[reg] == i)
+                        {
+                            freeRegisters.push_back(mapping[reg]);
+                            lastUse[reg] = never;           // The same register may be read twice by one instruction
+                        }
+                    }
+                    if(writesRegister(instructions[i].op))
+                    {
+                        const unsigned int reg = instructions[i].dest;
+                        if(freeRegisters.size())
+                        {
+                            mapping[reg] = freeRegisters.back();
+                            freeRegisters.pop_back();
+                        }
+                        else
+                            mapping[reg] = packedCount++;
+                        instructions[i].dest = mapping[reg];
+
+                        // A result that is never read can be overwritten right away
+                        if(lastUse[reg] == never)
+                            freeRegisters.push_back(mapping[reg]);
+                    }
+                }
+
+                // Remember the packed registers
+                result = mapping[resultRegister];
+                registerCount = std::max(packedCount, 1u);
+
+                // Now every register is known, find the integers
+                inferIntegers();
+            }
+
+            // Inspection
+            const std::vector<program::instruction>& program::getInstructions() const
+            { return instructions; }
+
+            const std::vector<string>& program::getVariables() const
+            { return variables; }
+
+            const std::vector<string>& program::getFunctions() const
+            { return functions; }
+
+            const std::vector<real>& program::getConstants() const
+            { return constants; }
+
+            const std::vector<string>& program::getLiterals() const
+            { return literals; }
+
+            const std::vector<integer>& program::getIntegers() const
+            { return integers; }
+
+            const std::vector<string>& program::getStrings() const
+            { return strings; }
+
+            const std::vector<std::vector<string> >& program::getExpressions() const
+            { return expressions; }
+
+            const std::vector<unsigned int>& program::getArguments() const
+            { return arguments; }
+
+            unsigned int program::getRegisterCount() const
+            { return registerCount; }
+
+            unsigned int program::getResultRegister() const
+            { return result; }
+
+            bool program::hasStores() const
+            { return stores; }
+
+            // Execution
+            real program::execute(environment& env) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+#ifdef CALC_JIT
+                // Programs that are executed often enough get native code
+                if(const jitCode* code = native.get(*this))
+                    return executeNative(env, *code, 0);
+#endif
+                return executeRow(env, 0, 0);
+            }
+
+            real program::execute(environment& env, exactInteger& exact) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+#ifdef CALC_JIT
+                if(const jitCode* code = native.get(*this))
+                    return executeNative(env, *code, &exact);
+#endif
+                return executeRow(env, 0, 0, &exact);
+            }
+
+            void program::executeBlock(environment& env, const std::vector<const real*>& columns, const size_t& rowCount, real* out, char* failed, std::vector<rowError>& errors) const
+            {
+                randomGenerator::scope random(env.getRandomGenerator());
+
+                // A program that assigns to variables has to see the assignments of the previous rows, so it's executed row by row
+                if(stores)
+                {
+                    for(size_t row = 0; row < rowCount; ++row)
+                    {
+                        if(failed[row])
+                            continue;
+                        try
+                        { out[row] = executeRow(env, &columns, row); }
+                        catch(calcError& err)
+                        { failRow(row, err, out, failed, errors); }
+                        catch(std::exception& exc)
+                        { failRow(row, calcError("STL error occurred", calcError::unknown, exc.what()), out, failed, errors); }
+                        catch(...)
+                        { failRow(row, calcError("Unknown error occurred", calcError::unknown), out, failed, errors); }
+                    }
+                    return;
+                }
+
+                // Otherwise the rows are executed in blocks of at most blockSize rows
+                std::vector<const real*> blockColumns(columns.size(), 0);
+                for(size_t first = 0; first < rowCount; first += blockSize)
+                {
+                    for(size_t i = 0; i < columns.size(); ++i)
+                        blockColumns[i] = columns[i] ? columns[i] + first : 0;
+                    const size_t count = std::min(blockSize, rowCount - first);
+                    const size_t errorsBefore = errors.size();
+                    executeVectorized(env, blockColumns, count, out + first, failed + first, errors);
+                    for(size_t i = errorsBefore; i < errors.size(); ++i)
+                        errors[i].row += first;
+                }
+            }
+
+            void program::setJitThreshold(const unsigned int& executions)
+            { jitThreshold = executions; }
+
+            program::opcode program::realOpcode(const opcode& op)
+            {
+                switch(op)
+                {
+                    case opIntConstant:
+                    return opConstant;
+                    case opIntNegate:
+                    return opNegate;
+                    case opIntAdd:
+                    return opAdd;
+                    case opIntSubtract:
+                    return opSubtract;
+                    case opIntMultiply:
+                    return opMultiply;
+                    case opIntModulo:
+                    return opModulo;
+                    case opIntGreater:
+                    return opGreater;
+                    case opIntLess:
+                    return opLess;
+                    default:
+                    return op;
+                }
+            }
+
+        // Private:
+            // Static:
+                std::atomic<unsigned int> program::jitThreshold(program::defaultJitThreshold);
+
+            inline void program::step(const instruction& instr, frame& state) const
+            {
+                switch(instr.op)
+                {
+                    case opConstant:
+                        state.reg[instr.dest] = constants[instr.a];
+                    break;
+
+                    case opLoad:
+                        // Variables bound to a column always exist
+                        if(state.columns != 0 && (*state.columns)[instr.a] != 0)
+                        {
+                            state.reg[instr.dest] = (*state.columns)[instr.a][state.row];
+                            break;
+                        }
+
+                        // Other variables are looked up once
+                        if(state.vars[instr.a] == 0 && (state.vars[instr.a] = state.env.findVar(variables[instr.a])) == 0)
+                            throwUnknownVariable(instr.b);
+                        state.reg[instr.dest] = *state.vars[instr.a];
+                    break;
+
+                    case opCheck:
+                        if((state.columns == 0 || (*state.columns)[instr.a] == 0) && state.vars[instr.a] == 0 && (state.vars[instr.a] = state.env.findVar(variables[instr.a])) == 0)
+                            throwUnknownVariable(instr.b);
+                    break;
+
+                    case opStore:
+                        // The environment is told about every variable that is assigned, even if it has been read already
+                        if(state.storedVars[instr.a] == 0)
+                            state.vars[instr.a] = state.storedVars[instr.a] = state.env.createVar(variables[instr.a]);
+                        *state.storedVars[instr.a] = state.reg[instr.b];
+                    break;
+
+                    case opNegate:
+                        state.reg[instr.dest] = state.reg[instr.a] * -1;
+                    break;
+
+                    case opPower:
+                    case opRoot:
+                        checkPower(state.reg[instr.a], state.reg[instr.b], instr.op == opRoot);
+                        state.reg[instr.dest] = std::pow(state.reg[instr.a], instr.op == opPower ? state.reg[instr.b] : 1/state.reg[instr.b]);
+                    break;
+
+                    case opCheckDivisor:
+                        if(state.reg[instr.a] == 0)
+                            throw calcError(instr.b ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, state.reg[instr.a]);
+                    break;
+
+                    case opMultiply:
+                        state.reg[instr.dest] = state.reg[instr.a] * state.reg[instr.b];
+                    break;
+
+                    case opDivide:
+                        if(state.reg[instr.b] == 0)
+                            throw calcError("Division by 0", calcError::invalidOperands, state.reg[instr.b]);
+                        state.reg[instr.dest] = state.reg[instr.a] / state.reg[instr.b];
+                    break;
+
+                    case opModulo:
+                        if(state.reg[instr.b] == 0)
+                            throw calcError("Modulo by 0", calcError::invalidOperands, state.reg[instr.b]);
+                        state.reg[instr.dest] = std::fmod(state.reg[instr.a], state.reg[instr.b]);
+                    break;
+
+                    case opAdd:
+                        state.reg[instr.dest] = state.reg[instr.a] + state.reg[instr.b];
+                    break;
+
+                    case opSubtract:
+                        state.reg[instr.dest] = state.reg[instr.a] - state.reg[instr.b];
+                    break;
+
+                    case opGreater:
+                        state.reg[instr.dest] = state.reg[instr.a] > state.reg[instr.b];
+                    break;
+
+                    case opLess:
+                        state.reg[instr.dest] = state.reg[instr.a] < state.reg[instr.b];
+                    break;
+
+                    case opBitwiseOr:
+                    case opBitwiseAnd:
+                    {
+                        const integer a = bitwiseOperand(state.reg[instr.a], state.ints[instr.a], (instr.c & 1) != 0);
+                        const integer b = bitwiseOperand(state.reg[instr.b], state.ints[instr.b], (instr.c & 2) != 0);
+                        state.ints[instr.dest].value = instr.op == opBitwiseOr ? (a | b) : (a & b);
+                        state.ints[instr.dest].exact = true;
+                        state.reg[instr.dest] = static_cast<real>(state.ints[instr.dest].value);
+                    }
+                    break;
+
+                    case opCheckFunction:
+                        if(state.funcs[instr.a] == 0 && (state.funcs[instr.a] = state.env.findFunction(functions[instr.a])) == 0)
+                            throwUnknownFunction(instr.a);
+                    break;
+
+                    case opCall:
+                    {
+                        state.args.resize(instr.b);
+                        for(unsigned int i = 0; i < instr.b; ++i)
+                            state.args[i] = state.reg[arguments[instr.c + i]];
+                        CALC_COUNT(counterFunctionCalls, 1);
+                        CALC_PROFILE_CALL(functions[instr.a]);
+                        state.reg[instr.dest] = state.funcs[instr.a]->execute(state.args, functions[instr.a]);
+                    }
+                    break;
+
+                    case opCallExpressions:
+                    {
+                        CALC_COUNT(counterFunctionCalls, 1);
+                        CALC_PROFILE_CALL(functions[instr.a]);
+                        state.reg[instr.dest] = state.funcs[instr.a]->executeExpressions(expressions[instr.b], functions[instr.a], state.env);
+                    }
+                    break;
+
+                    case opIntConstant:
+                        state.reg[instr.dest] = constants[instr.a];
+                        state.ints[instr.dest].value = integers[instr.b];
+                        state.ints[instr.dest].exact = true;
+                    break;
+
+                    case opIntNegate:
+                    case opIntAdd:
+                    case opIntSubtract:
+                    case opIntMultiply:
+                    case opIntModulo:
+                    case opIntGreater:
+                    case opIntLess:
+                        if(instr.op == opIntModulo && state.reg[instr.b] == 0)
+                            throw calcError("Modulo by 0", calcError::invalidOperands, state.reg[instr.b]);
+                        calculateInteger(instr.op, state.reg[instr.a], state.reg[instr.b], state.ints[instr.a], state.ints[instr.b], state.reg[instr.dest], state.ints[instr.dest]);
+                    break;
+                }
+            }
+
+            real program::executeRow(environment& env, const std::vector<const real*>* columns, const size_t& row, exactInteger* exact) const
+            {
+                // The registers, variables and functions of this execution, the integer values are only needed if they're used
+                scratchBuffer<real, 32> reg(registerCount, 0);
+                scratchBuffer<exactInteger, 32> ints(usesIntegers ? registerCount : 0, exactInteger());
+                scratchBuffer<real*, 16> vars(variables.size(), 0);
+                scratchBuffer<real*, 16> storedVars(variables.size(), 0);
+                scratchBuffer<mathFunction*, 8> funcs(functions.size(), 0);
+                frame state = {env, columns, row, &reg[0], &vars[0], &storedVars[0], &funcs[0], &ints[0], argList(), std::exception_ptr()};
+
+                // Execute the instructions one by one
+                for(std::vector<instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                    step(*instr, state);
+
+                // Return the result, registers that didn't fit on the stack were allocated on the heap
+                CALC_COUNT(counterNodes, instructions.size());
+                CALC_COUNT(counterAllocations, (registerCount > 32) * (usesIntegers ? 2 : 1) + (variables.size() > 16) * 2 + (functions.size() > 8));
+                if(exact)
+                    *exact = integerResult ? ints[result] : exactInteger();
+                return reg[result];
+            }
+
+            real program::executeNative(environment& env, const jitCode& code, exactInteger* exact) const
+            {
+                // The same state as executeRow(), the native code works on the registers and variables directly
+                scratchBuffer<real, 32> reg(registerCount, 0);
+                scratchBuffer<exactInteger, 32> ints(usesIntegers ? registerCount : 0, exactInteger());
+                scratchBuffer<real*, 16> vars(variables.size(), 0);
+                scratchBuffer<real*, 16> storedVars(variables.size(), 0);
+                scratchBuffer<mathFunction*, 8> funcs(functions.size(), 0);
+                frame state = {env, 0, 0, &reg[0], &vars[0], &storedVars[0], &funcs[0], &ints[0], argList(), std::exception_ptr()};
+
+                // Errors can't pass through the native code, so jitStep() keeps them and they're thrown here
+                if(code.run(state.reg, state.vars, &state, this))
+                    std::rethrow_exception(state.error);
+
+                CALC_COUNT(counterNodes, instructions.size());
+                CALC_COUNT(counterAllocations, (registerCount > 32) * (usesIntegers ? 2 : 1) + (variables.size() > 16) * 2 + (functions.size() > 8));
+                if(exact)
+                    *exact = integerResult ? ints[result] : exactInteger();
+                return reg[result];
+            }
+
+            int program::jitStep(void* state, const program* prog, unsigned int index)
+            {
+                frame& current = *static_cast<frame*>(state);
+                try
+                {
+                    prog->step(prog->instructions[index], current);
+                    return 0;
+                }
+                catch(...)
+                {
+                    current.error = std::current_exception();
+                    return 1;
+                }
+            }
+
+            void program::executeVectorized(environment& env, const std::vector<const real*>& columns, const size_t& rowCount, real* out, char* failed, std::vector<rowError>& errors) const
+            {
+                // Every register holds a value for every row, and an integer value if the program uses them
+                std::vector<real> registers(registerCount * blockSize, 0);
+                std::vector<exactInteger> intRegisters(usesIntegers ? registerCount * blockSize : 0, exactInteger());
+                std::vector<mathFunction*> funcs(functions.size(), 0);
+                argList args;
+                std::vector<const real*> batchArgs;
+                std::vector<real> batchResults;
+                CALC_COUNT(counterAllocations, 1);
+                CALC_COUNT(counterNodes, instructions.size() * rowCount);
+
+                // Execute the instructions one by one, every instruction is executed for all rows before going to the next one
+                // An error only stops the row it occurred in, the other rows just continue
+                for(std::vector<instruction>::const_iterator instr = instructions.begin(); instr != instructions.end(); ++instr)
+                {
+                    // The rows of the registers used by the instruction, operands that aren't registers point to the first register (and aren't used)
+                    const size_t destRow = (instr->dest < registerCount ? instr->dest : 0) * blockSize;
+                    const size_t aRow = (instr->a < registerCount ? instr->a : 0) * blockSize;
+                    const size_t bRow = (instr->b < registerCount ? instr->b : 0) * blockSize;
+                    real* dest = &registers[destRow];
+                    const real* a = &registers[aRow];
+                    const real* b = &registers[bRow];
+                    exactInteger* intDest = usesIntegers ? &intRegisters[destRow] : 0;
+                    const exactInteger* intA = usesIntegers ? &intRegisters[aRow] : 0;
+                    const exactInteger* intB = usesIntegers ? &intRegisters[bRow] : 0;
+                    switch(instr->op)
+                    {
+                        case opConstant:
+                            std::fill(dest, dest + rowCount, constants[instr->a]);
+                        break;
+
+                        case opLoad:
+                        case opCheck:
+                        {
+                            // Variables bound to a column always exist
+                            if(columns[instr->a] != 0)
+                            {
+                                if(instr->op == opLoad)
+                                    std::copy(columns[instr->a], columns[instr->a] + rowCount, dest);
+                                break;
+                            }
+
+                            // Other variables have the same value for every row
+                            const real* var = env.findVar(variables[instr->a]);
+                            if(var == 0)
+                            {
+                                try
+                                { throwUnknownVariable(instr->b); }
+                                catch(calcError& err)
+                                { failRows(rowCount, err, out, failed, errors); }
+                                break;
+                            }
+                            if(instr->op == opLoad)
+                                std::fill(dest, dest + rowCount, *var);
+                        }
+                        break;
+
+                        case opNegate:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] * -1;
+                        break;
+
+                        case opPower:
+                        case opRoot:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(a[i] < 0 && !failed[i])
+                                {
+                                    try
+                                    { checkPower(a[i], b[i], instr->op == opRoot); }
+                                    catch(calcError& err)
+                                    { failRow(i, err, out, failed, errors); }
+                                }
+                            }
+                            if(instr->op == opPower)
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = std::pow(a[i], b[i]);
+                            }
+                            else
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = std::pow(a[i], 1/b[i]);
+                            }
+                        break;
+
+                        case opCheckDivisor:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(a[i] == 0 && !failed[i])
+                                    failRow(i, calcError(instr->b ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, a[i]), out, failed, errors);
+                            }
+                        break;
+
+                        case opMultiply:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] * b[i];
+                        break;
+
+                        case opDivide:
+                        case opModulo:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(b[i] == 0 && !failed[i])
+                                    failRow(i, calcError(instr->op == opModulo ? "Modulo by 0" : "Division by 0", calcError::invalidOperands, b[i]), out, failed, errors);
+                            }
+                            if(instr->op == opDivide)
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = a[i] / b[i];
+                            }
+                            else
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                    dest[i] = std::fmod(a[i], b[i]);
+                            }
+                        break;
+
+                        case opAdd:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] + b[i];
+                        break;
+
+                        case opSubtract:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] - b[i];
+                        break;
+
+                        case opGreater:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] > b[i];
+                        break;
+
+                        case opLess:
+                            for(size_t i = 0; i < rowCount; ++i)
+                                dest[i] = a[i] < b[i];
+                        break;
+
+                        case opBitwiseOr:
+                        case opBitwiseAnd:
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                // The rows that failed may hold anything, which shouldn't be rounded to an integer
+                                const integer first = failed[i] ? 0 : bitwiseOperand(a[i], intA[i], (instr->c & 1) != 0);
+                                const integer second = failed[i] ? 0 : bitwiseOperand(b[i], intB[i], (instr->c & 2) != 0);
+                                intDest[i].value = instr->op == opBitwiseOr ? (first | second) : (first & second);
+                                intDest[i].exact = true;
+                                dest[i] = static_cast<real>(intDest[i].value);
+                            }
+                        break;
+
+                        case opIntConstant:
+                        {
+                            const exactInteger value = {integers[instr->b], true};
+                            std::fill(dest, dest + rowCount, constants[instr->a]);
+                            std::fill(intDest, intDest + rowCount, value);
+                        }
+                        break;
+
+                        case opIntNegate:
+                        case opIntAdd:
+                        case opIntSubtract:
+                        case opIntMultiply:
+                        case opIntModulo:
+                        case opIntGreater:
+                        case opIntLess:
+                            if(instr->op == opIntModulo)
+                            {
+                                for(size_t i = 0; i < rowCount; ++i)
+                                {
+                                    if(b[i] == 0 && !failed[i])
+                                        failRow(i, calcError("Modulo by 0", calcError::invalidOperands, b[i]), out, failed, errors);
+                                }
+                            }
+                            for(size_t i = 0; i < rowCount; ++i)
+                                calculateInteger(instr->op, a[i], b[i], intA[i], intB[i], dest[i], intDest[i]);
+                        break;
+
+                        case opCheckFunction:
+                            if((funcs[instr->a] = env.findFunction(functions[instr->a])) == 0)
+                            {
+                                try
+                                { throwUnknownFunction(instr->a); }
+                                catch(calcError& err)
+                                { failRows(rowCount, err, out, failed, errors); }
+                            }
+                        break;
+
+                        case opCall:
+                        {
+                            // If the function doesn't exist every row has failed already, just like when every row failed before the call
+                            if(funcs[instr->a] == 0 || std::find(failed, failed + rowCount, 0) == failed + rowCount)
+                                break;
+
+                            // Functions that can calculate a whole block are called once, the rows that already failed are calculated too
+                            // but their results are ignored. The results are written to a buffer of their own, because the destination
+                            // may be one of the arguments and the rows have to be called one by one if the block fails.
+                            if(funcs[instr->a]->supportsBatch())
+                            {
+                                batchArgs.resize(instr->b);
+                                for(unsigned int j = 0; j < instr->b; ++j)
+                                    batchArgs[j] = &registers[arguments[instr->c + j] * blockSize];
+                                batchResults.resize(blockSize);
+                                bool batched;
+                                {
+                                    CALC_PROFILE_CALL(functions[instr->a]);
+                                    batched = funcs[instr->a]->executeBatch(batchArgs.data(), instr->b, rowCount, batchResults.data(), functions[instr->a]);
+                                }
+                                if(batched)
+                                {
+                                    CALC_COUNT(counterFunctionCalls, 1);
+                                    std::copy(batchResults.begin(), batchResults.begin() + rowCount, dest);
+                                    break;
+                                }
+                            }
+
+                            // Otherwise the function is called row by row, skipping the rows that already failed
+                            args.resize(instr->b);
+                            for(size_t i = 0; i < rowCount; ++i)
+                            {
+                                if(failed[i])
+                                    continue;
+                                for(unsigned int j = 0; j < instr->b; ++j)
+                                    args[j] = registers[arguments[instr->c + j] * blockSize + i];
+                                CALC_COUNT(counterFunctionCalls, 1);
+                                try
+                                {
+                                    CALC_PROFILE_CALL(functions[instr->a]);
+                                    dest[i] = funcs[instr->a]->execute(args, functions[instr->a]);
+                                }
+                                catch(calcError& err)
+                                { failRow(i, err, out, failed, errors); }
+                                catch(std::exception& exc)
+                                { failRow(i, calcError("STL error occurred", calcError::unknown, exc.what()), out, failed, errors); }
+                                catch(...)
+                                { failRow(i, calcError("Unknown error occurred", calcError::unknown), out, failed, errors); }
+                            }
+                        }
+                        break;
+
+                        // Stores and calls with unevaluated arguments never get here, see executeBlock()
+                        case opStore:
+                        case opCallExpressions:
+                        break;
+                    }
+                }
+
+                // Copy the results of the rows that didn't fail
+                const real* results = &registers[result * blockSize];
+                for(size_t i = 0; i < rowCount; ++i)
+                {
+                    if(!failed[i])
+                        out[i] = results[i];
+                }
+            }
+
+            void program::sourceRegisters(instruction& instr, std::vector<unsigned int*>& sources)
+            {
+                switch(instr.op)
+                {
+                    case opConstant:
+                    case opIntConstant:
+                    case opLoad:
+                    case opCheck:
+                    case opCheckFunction:
+                    case opCallExpressions:
+                    break;
+
+                    case opStore:
+                        sources.push_back(&instr.b);
+                    break;
+
+                    case opNegate:
+                    case opIntNegate:
+                    case opCheckDivisor:
+                        sources.push_back(&instr.a);
+                    break;
+
+                    case opCall:
+                        for(unsigned int i = 0; i < instr.b; ++i)
+                            sources.push_back(&arguments[instr.c + i]);
+                    break;
+
+                    default:
+                        sources.push_back(&instr.a);
+                        sources.push_back(&instr.b);
+                    break;
+                }
+            }
+
+            void program::inferIntegers()
+            {
+                // Walk through the instructions, remembering which registers hold an integer and which instruction wrote them
+                std::vector<char> integral(registerCount, 0);
+                std::vector<size_t> writer(registerCount, 0);
+                std::vector<char> usedAsInteger(instructions.size(), 0);
+                for(size_t i = 0; i < instructions.size(); ++i)
+                {
+                    instruction& instr = instructions[i];
+                    bool isIntegral = false;
+                    switch(instr.op)
+                    {
+                        case opConstant:
+                            // Small integers are exact as a real too, larger integers were made opIntConstant by the compiler
+                            isIntegral = std::floor(constants[instr.a]) == constants[instr.a] && std::fabs(constants[instr.a]) <= largestExactInteger;
+                        break;
+
+                        case opIntConstant:
+                            isIntegral = true;
+                        break;
+
+                        case opNegate:
+                            if(integral[instr.a])
+                            {
+                                instr.op = opIntNegate;
+                                usedAsInteger[writer[instr.a]] = 1;
+                                isIntegral = true;
+                            }
+                        break;
+
+                        case opMultiply:
+                        case opModulo:
+                        case opAdd:
+                        case opSubtract:
+                        case opGreater:
+                        case opLess:
+                            if(integral[instr.a] && integral[instr.b])
+                            {
+                                instr.op = instr.op == opMultiply ? opIntMultiply : instr.op == opModulo ? opIntModulo : instr.op == opAdd ? opIntAdd :
+                                           instr.op == opSubtract ? opIntSubtract : instr.op == opGreater ? opIntGreater : opIntLess;
+                                usedAsInteger[writer[instr.a]] = usedAsInteger[writer[instr.b]] = 1;
+                                isIntegral = true;
+                            }
+                        break;
+
+                        case opBitwiseOr:
+                        case opBitwiseAnd:
+                            // The result of a bitwise operator is always an integer, the operands that are integers are used exactly
+                            instr.c = (integral[instr.a] ? 1 : 0) | (integral[instr.b] ? 2 : 0);
+                            if(integral[instr.a])
+                                usedAsInteger[writer[instr.a]] = 1;
+                            if(integral[instr.b])
+                                usedAsInteger[writer[instr.b]] = 1;
+                            isIntegral = true;
+                        break;
+
+                        default:
+                        break;
+                    }
+                    if(writesRegister(instr.op))
+                    {
+                        integral[instr.dest] = isIntegral;
+                        writer[instr.dest] = i;
+                    }
+                }
+                integerResult = integral[result] != 0;
+
+                // Constants only need their integer value if an integer instruction uses them (or if they're the result)
+                if(integerResult)
+                    usedAsInteger[writer[result]] = 1;
+                usesIntegers = false;
+                for(size_t i = 0; i < instructions.size(); ++i)
+                {
+                    instruction& instr = instructions[i];
+                    if(instr.op == opConstant && usedAsInteger[i])
+                    {
+                        instr.op = opIntConstant;
+                        instr.b = addInteger(static_cast<integer>(constants[instr.a]));
+                    }
+                    else if(instr.op == opIntConstant && !usedAsInteger[i])
+                        instr.op = opConstant;
+                    usesIntegers = usesIntegers || realOpcode(instr.op) != instr.op || instr.op == opBitwiseOr || instr.op == opBitwiseAnd;
+                }
+            }
+
+            bool program::writesRegister(const opcode& op)
+            { return op != opCheck && op != opStore && op != opCheckDivisor && op != opCheckFunction; }
+
+            void program::throwUnknownVariable(const unsigned int& stringIndex) const
+            { throw calcError("Unknown variable", calcError::unknownName, strings[stringIndex]); }
+
+            void program::throwUnknownFunction(const unsigned int& slot) const
+            { throw calcError("Unknown function", calcError::unknownName, functions[slot]); }
+
+            void program::checkPower(const real& base, const real& exponent, const bool& root)
+            {
+                // Only allow integer powers of negative numbers
+                if(base < 0)
+                {
+                    if(root)
+                        throw calcError("No negative roots allowed", calcError::invalidOperands);
+                    if(std::floor(exponent) != exponent)
+                        throw calcError("Only integer powers of negative numbers", calcError::invalidOperands);
+                }
+            }
+
+            void program::failRow(const size_t& row, const calcError& error, real* out, char* failed, std::vector<rowError>& errors)
+            {
+                failed[row] = 1;
+                out[row] = std::numeric_limits<real>::quiet_NaN();
+                CALC_COUNT(counterExceptions, 1);
+                rowError err = {row, error};
+                errors.push_back(err);
+            }
+
+            void program::failRows(const size_t& rowCount, const calcError& error, real* out, char* failed, std::vector<rowError>& errors)
+            {
+                for(size_t row = 0; row < rowCount; ++row)
+                {
+                    if(!failed[row])
+                        failRow(row, error, out, failed, errors);
+                }
+            }
+
+    // program::nativeTier:
+        // Public:
+            program::nativeTier::nativeTier()
+            : executions(0), code(0), failed(false) {}
+
+            program::nativeTier::nativeTier(const nativeTier&)
+            : executions(0), code(0), failed(false) {}
+
+            program::nativeTier::~nativeTier()
+            {
+#ifdef CALC_JIT
+                delete code.load();
+#endif
+            }
+
+            program::nativeTier& program::nativeTier::operator=(const nativeTier&)
+            {
+                // The program has been replaced, so its native code is useless
+#ifdef CALC_JIT
+                delete code.exchange(0);
+#endif
+                executions = 0;
+                failed = false;
+                return *this;
+            }
+
+            const jitCode* program::nativeTier::get(const program& prog)
+            {
+                // Most executions find the native code, or a counter that hasn't reached the threshold
+                // The counter is only used to decide when to compile, so increments that get lost between threads don't matter
+                const jitCode* current = code.load(std::memory_order_acquire);
+                if(current || failed.load(std::memory_order_relaxed))
+                    return current;
+                const unsigned int threshold = jitThreshold.load(std::memory_order_relaxed);
+                const unsigned int count = executions.load(std::memory_order_relaxed);
+                if(threshold == 0 || count + 1 < threshold)
+                {
+                    if(threshold != 0)
+                        executions.store(count + 1, std::memory_order_relaxed);
+                    return 0;
+                }
+
+#ifdef CALC_JIT
+                // Compile the program once, other threads executing it at the same time wait for the native code
+                std::lock_guard<std::mutex> lock(compiling);
+                current = code.load(std::memory_order_acquire);
+                if(!current && !failed.load(std::memory_order_relaxed))
+                {
+                    current = jitCode::compile(prog, &program::jitStep);
+                    failed.store(current == 0, std::memory_order_relaxed);
+                    code.store(current, std::memory_order_release);
+                }
+                return current;
+#else
+                static_cast<void>(prog);
+                return 0;
+#endif
+            }
+}
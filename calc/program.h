@@ -0,0 +1,316 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include "types.h"
+#include "error.h"
+
+namespace calc
+{
+    class randomGenerator;
+
+    // The place where a program finds its variables and functions
+    class environment
+    {
+        public:
+            // Destructor
+            virtual ~environment();
+
+            // Get a pointer to the value of a variable, returns 0 if the variable doesn't exist
+            // The pointer has to stay valid for as long as the program is executing
+            virtual real* findVar(const string& name) = 0;
+            // Get a pointer to the value of a variable that is going to be assigned, the variable is created if it doesn't exist
+            // If the variable has been found by findVar() before, this has to return the same pointer
+            virtual real* createVar(const string& name) = 0;
+            // Get the function with the given name, returns 0 if the function doesn't exist
+            virtual mathFunction* findFunction(const string& name) = 0;
+            // Get the generator RAND draws its numbers from while a program is executed in this environment
+            // Returns 0 by default, which leaves it to the generator of the current thread (see randomGenerator::current())
+            virtual randomGenerator* getRandomGenerator();
+    };
+
+    // An environment in which one variable has a value of its own, while everything else is found in the enclosing environment
+    // This is the local scope of functions that calculate an expression for many values of a variable, like SOLVE(), so the
+    // variable with the same name in the enclosing environment (if any) isn't changed.
+    class localEnvironment : public environment
+    {
+        public:
+            // Constructor, the enclosing environment has to outlive this one
+            localEnvironment(environment& enclosing, const string& name, const real& value = 0);
+
+            // Get the name of the local variable
+            const string& getName() const;
+            // Get or set the value of the local variable
+            real getValue() const;
+            void setValue(const real& newValue);
+
+            // The environment:
+            real* findVar(const string& name);
+            real* createVar(const string& name);
+            mathFunction* findFunction(const string& name);
+            randomGenerator* getRandomGenerator();
+
+        private:
+            environment& enclosing;                 // The environment everything but the local variable is found in
+            string name;                            // The name of the local variable
+            real value;                             // The value of the local variable
+    };
+
+    class jitCode;
+
+    // A compiled expression, this is a list of instructions that each write their result into a register
+    // The instructions are in exactly the order in which the interpreter of calc would do the same work,
+    // so variables are read, functions are called and errors are thrown at the same moments.
+    class program
+    {
+        public:
+            // The operations an instruction can do
+            enum opcode
+            {
+                opConstant,                         // dest = constants[a]
+                opLoad,                             // dest = variable a, throws an error mentioning strings[b] if it doesn't exist
+                opCheck,                            // Throws an error mentioning strings[b] if variable a doesn't exist
+                opStore,                            // variable a = b, the variable is created if it doesn't exist
+                opNegate,                           // dest = a * -1
+                opPower,                            // dest = a ^ b
+                opRoot,                             // dest = a ~ b
+                opCheckDivisor,                     // Throws the division by zero error (modulo if b is 1) if a is 0
+                opMultiply,                         // dest = a * b
+                opDivide,                           // dest = a / b
+                opModulo,                           // dest = a % b
+                opAdd,                              // dest = a + b
+                opSubtract,                         // dest = a - b
+                opGreater,                          // dest = a > b
+                opLess,                             // dest = a < b
+                opBitwiseOr,                        // dest = a | b, c tells which operands hold an integer (bit 0 for a, bit 1 for b)
+                opBitwiseAnd,                       // dest = a & b, c tells which operands hold an integer (bit 0 for a, bit 1 for b)
+                opCheckFunction,                    // Throws an error if function a doesn't exist
+                opCall,                             // dest = function a, using the b arguments in the registers arguments[c], arguments[c+1], ...
+                opCallExpressions,                  // dest = function a, using the unevaluated expressions in expressions[b]
+
+                // The instructions on integers (see exactInteger), finish() makes them out of the instructions above
+                opIntConstant,                      // dest = constants[a], which is exactly integers[b]
+                opIntNegate,                        // dest = a * -1
+                opIntAdd,                           // dest = a + b
+                opIntSubtract,                      // dest = a - b
+                opIntMultiply,                      // dest = a * b
+                opIntModulo,                        // dest = a % b
+                opIntGreater,                       // dest = a > b
+                opIntLess                           // dest = a < b
+            };
+
+            // A single instruction
+            struct instruction
+            {
+                opcode op;                          // What the instruction does
+                unsigned int dest;                  // The register the result is written to
+                unsigned int a;                     // The first operand, see opcode
+                unsigned int b;                     // The second operand, see opcode
+                unsigned int c;                     // The third operand, see opcode
+            };
+
+            // The integer value of a register
+            // Registers that provably hold an integer (integer constants, and the results of the bitwise operators and of integer
+            // instructions on integers) keep their value as an integer next to their real value, so they're calculated exactly.
+            // If the result of an integer instruction doesn't fit it isn't exact, the real value is used from then on.
+            struct exactInteger
+            {
+                integer value;                      // The value
+                bool exact;                         // Whether value is exact, otherwise only the real value can be used
+            };
+
+            // An error that occurred in one of the rows evaluated by executeBlock()
+            struct rowError
+            {
+                size_t row;                         // The row in which the error occurred
+                calcError error;                    // The error itself
+            };
+
+            // The number of rows that executeBlock() handles at once
+            static const size_t blockSize = 256;
+            // The default number of executions by execute() after which a program is compiled to native code (see jit.h)
+            static const unsigned int defaultJitThreshold = 1000;
+
+            // Constructor, creates an empty program
+            program();
+
+            // Functions used to build the program:
+                // Get a new register
+                unsigned int newRegister();
+                // Add a constant, returns its index
+                // The literal is the constant as written in the expression, so other number types can read it at their own precision
+                unsigned int addConstant(const real& value, const string& literal = string());
+                // Add an integer constant, returns its index
+                unsigned int addInteger(const integer& value);
+                // Get the slot of a variable, returns its index
+                unsigned int variableSlot(const string& name);
+                // Get the slot of a function, returns its index
+                unsigned int functionSlot(const string& name);
+                // Add a string that's used in error messages, returns its index
+                unsigned int addString(const string& str);
+                // Add a list of argument registers, returns the index of the first one
+                unsigned int addArguments(const std::vector<unsigned int>& registers);
+                // Add the unevaluated arguments of a function call, returns their index
+                unsigned int addExpressions(const std::vector<string>& args);
+                // Add an instruction at the end of the program
+                void emit(const opcode& op, const unsigned int& dest = 0, const unsigned int& a = 0, const unsigned int& b = 0, const unsigned int& c = 0);
+                // Set the register holding the result, this finishes the program, packs the registers and finds the integers
+                void finish(const unsigned int& resultRegister);
+
+            // Get the instructions
+            const std::vector<instruction>& getInstructions() const;
+            // Get the names of all variables used by the program, the index in this list is the slot of the variable
+            const std::vector<string>& getVariables() const;
+            // Get the names of all functions used by the program, the index in this list is the slot of the function
+            const std::vector<string>& getFunctions() const;
+            // Get the constants, see opConstant
+            const std::vector<real>& getConstants() const;
+            // Get the literals of the constants, by the index of the constant, empty if the constant has no literal
+            const std::vector<string>& getLiterals() const;
+            // Get the integer constants, see opIntConstant
+            const std::vector<integer>& getIntegers() const;
+            // Get the strings used in error messages, see opLoad
+            const std::vector<string>& getStrings() const;
+            // Get the unevaluated arguments of the calls with unevaluated arguments, see opCallExpressions
+            const std::vector<std::vector<string> >& getExpressions() const;
+            // Get the argument registers of all function calls, see opCall
+            const std::vector<unsigned int>& getArguments() const;
+            // Get the number of registers the program needs
+            unsigned int getRegisterCount() const;
+            // Get the register holding the result
+            unsigned int getResultRegister() const;
+            // Returns true if the program assigns values to variables (or calls a function with unevaluated arguments, which might do so)
+            bool hasStores() const;
+
+            // Execute the program, returns the result or throws a calcError
+            real execute(environment& env) const;
+            // Execute the program, also giving the result as an integer, which is only exact if it's known exactly
+            real execute(environment& env, exactInteger& exact) const;
+
+            // Execute the program for rowCount rows at once, writing the result of every row into out
+            // Variable slots that have a column in columns (i.e. columns[slot] isn't 0) take their value from that column,
+            // all other variables are looked up in the environment. Functions are called once for every row.
+            // Rows for which failed[row] is already set are skipped, rows in which an error occurs get failed[row] set
+            // and their error added to errors. A program that assigns to variables is executed row by row.
+            void executeBlock(environment& env, const std::vector<const real*>& columns, const size_t& rowCount, real* out, char* failed, std::vector<rowError>& errors) const;
+
+            // Set after how many executions by execute() a program is compiled to native code, 0 turns the native code off
+            // Programs that already have native code keep using it. Without support for the platform (see jit.h) this does nothing.
+            static void setJitThreshold(const unsigned int& executions);
+
+            // Get the opcode that does the same as the given opcode on reals, i.e. opAdd for opIntAdd
+            static opcode realOpcode(const opcode& op);
+
+        private:
+            // The state of a single execution of the program, by executeRow() or by native code
+            struct frame
+            {
+                environment& env;                           // The environment
+                const std::vector<const real*>* columns;    // The columns of the variables, 0 if there are none
+                size_t row;                                 // The row taken from the columns
+                real* reg;                                  // The registers
+                real** vars;                                // The variables that have been looked up, by slot
+                real** storedVars;                          // The variables that have been assigned, by slot
+                mathFunction** funcs;                       // The functions that have been looked up, by slot
+                exactInteger* ints;                         // The integer values of the registers
+                argList args;                               // The arguments of the current function call
+                std::exception_ptr error;                   // The error that stopped the native code
+            };
+
+            // The native code of a program, made by jitCode::compile() once the program has been executed often enough
+            // Copies of a program start counting again, without native code.
+            class nativeTier
+            {
+                public:
+                    // Constructors and destructor
+                    nativeTier();
+                    nativeTier(const nativeTier& other);
+                    ~nativeTier();
+                    // Assignment operator, forgets the native code
+                    nativeTier& operator=(const nativeTier& other);
+
+                    // Count an execution of prog, returns its native code or 0 if it doesn't have any (yet)
+                    const jitCode* get(const program& prog);
+
+                private:
+                    std::atomic<unsigned int> executions;   // The number of executions counted so far
+                    std::atomic<const jitCode*> code;       // The native code, 0 if it hasn't been made
+                    std::atomic<bool> failed;               // Whether making the native code failed
+                    std::mutex compiling;                   // Locked while the native code is made
+            };
+
+            // Execute a single instruction
+            void step(const instruction& instr, frame& state) const;
+            // Called by native code to execute the instruction at index, returns 1 if it threw an error (which is kept in the frame) and 0 otherwise
+            static int jitStep(void* state, const program* prog, unsigned int index);
+            // Execute the program using its native code
+            real executeNative(environment& env, const jitCode& code, exactInteger* exact) const;
+
+            // Turn the instructions on integers into integer instructions, see exactInteger
+            void inferIntegers();
+
+            // Execute the program for one row, taking the values of the variables in columns (if any) from the given row
+            // The integer value of the result is written to exact, if it isn't 0
+            real executeRow(environment& env, const std::vector<const real*>* columns, const size_t& row, exactInteger* exact = 0) const;
+            // Execute the program for a block of at most blockSize rows, one instruction at a time for all rows
+            void executeVectorized(environment& env, const std::vector<const real*>& columns, const size_t& rowCount, real* out, char* failed, std::vector<rowError>& errors) const;
+
+            // Add pointers to the registers read by the instruction to sources
+            void sourceRegisters(instruction& instr, std::vector<unsigned int*>& sources);
+            // Returns true if instructions with the given opcode write their result into a register
+            static bool writesRegister(const opcode& op);
+
+            // Mark a row of executeBlock() as failed because of the given error
+            static void failRow(const size_t& row, const calcError& error, real* out, char* failed, std::vector<rowError>& errors);
+            // Mark all rows of executeBlock() that didn't fail yet as failed because of the given error
+            static void failRows(const size_t& rowCount, const calcError& error, real* out, char* failed, std::vector<rowError>& errors);
+
+            // Throws the error for an unknown variable, mentioning the given string
+            void throwUnknownVariable(const unsigned int& stringIndex) const;
+            // Throws the error for an unknown function
+            void throwUnknownFunction(const unsigned int& slot) const;
+            // Throws the error for a power with a negative base, or returns if there is nothing wrong
+            static void checkPower(const real& base, const real& exponent, const bool& root);
+
+            std::vector<instruction> instructions;      // The instructions
+            std::vector<real> constants;                // The constants
+            std::vector<string> literals;               // The literals of the constants
+            std::vector<integer> integers;              // The integer constants
+            std::vector<string> variables;              // The names of the variables, by slot
+            std::vector<string> functions;              // The names of the functions, by slot
+            std::vector<string> strings;                // Strings used in error messages
+            std::vector<unsigned int> arguments;        // The argument registers of all function calls
+            std::vector<std::vector<string> > expressions;  // The unevaluated arguments of the calls of opCallExpressions
+            unsigned int registerCount;                 // The number of registers
+            unsigned int result;                        // The register holding the result
+            bool stores;                                // Whether the program assigns values to variables
+            bool usesIntegers;                          // Whether any instruction uses the integer values of the registers
+            bool integerResult;                         // Whether the result register holds an integer
+            mutable nativeTier native;                  // The native code, made while the program is executed
+
+            static std::atomic<unsigned int> jitThreshold;  // The number of executions after which programs get native code
+    };
+}
+
+#endif // PROGRAM_H
@@ -0,0 +1,228 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "quadrature.h"
+#include "context.h"
+#include "solver.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace calc
+{
+    namespace
+    {
+        // The 15 point Kronrod rule, by the points from the end of the interval to its center, for an interval from -1 to 1
+        // Every second point is also one of the 7 point Gauss rule.
+        const unsigned int kronrodPoints = 8;
+        const real kronrodNodes[kronrodPoints] =
+        {
+            0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+            0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+            0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+            0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+        };
+        const real kronrodWeights[kronrodPoints] =
+        {
+            0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+            0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+            0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+            0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+        };
+        // The weights of the Gauss rule, for the points 1, 3, 5 and 7 of the Kronrod rule
+        const real gaussWeights[kronrodPoints / 2] =
+        {
+            0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+            0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+        };
+        // The number of points of an interval, the center is the last one
+        const unsigned int intervalPoints = 2 * kronrodPoints - 1;
+    }
+
+    // quadrature:
+        // Public:
+            constexpr real quadrature::defaultTolerance;
+            const size_t quadrature::maxIntervals;
+
+            quadrature::quadrature(const program& prog, const string& variable, environment& env, const real& tolerance)
+            : loop(prog, variable, env), tolerance(tolerance), error(0) {}
+
+            real quadrature::integrate(const real& low, const real& high)
+            {
+                error = 0;
+                if(low == high)
+                    return 0;
+
+                // Every round the intervals with the largest errors are halved, until the total error is small enough
+                std::vector<interval> intervals(1);
+                intervals[0].low = low;
+                intervals[0].high = high;
+                std::vector<interval> halved(intervals);
+                intervals.clear();
+                while(true)
+                {
+                    estimate(halved);
+                    intervals.insert(intervals.end(), halved.begin(), halved.end());
+                    halved.clear();
+
+                    compensatedSum integral, absolute;
+                    real total = 0;
+                    for(std::vector<interval>::const_iterator pos = intervals.begin(); pos != intervals.end(); ++pos)
+                    {
+                        integral.add(pos->integral);
+                        absolute.add(pos->absolute);
+                        total += pos->error;
+                    }
+                    error = total;
+                    const real allowed = tolerance * absolute.get();
+                    if(total <= allowed)
+                        return integral.get();
+                    if(!std::isfinite(total) || intervals.size() >= maxIntervals)
+                        throw calcError("No convergence", calcError::invalidArguments, integral.get());
+
+                    // Halve the intervals with the largest errors until the error of the others is at most half of what's allowed
+                    // An interval that's too small to halve stays, if that's all there is the tolerance can't be reached
+                    std::sort(intervals.begin(), intervals.end(), [](const interval& a, const interval& b)
+                    { return a.error > b.error; });
+                    std::vector<interval> kept;
+                    for(std::vector<interval>::const_iterator pos = intervals.begin(); pos != intervals.end(); ++pos)
+                    {
+                        const real center = pos->low + (pos->high - pos->low) / 2;
+                        const bool halve = (total > allowed / 2 && intervals.size() + halved.size() / 2 < maxIntervals && center != pos->low && center != pos->high);
+                        if(!halve)
+                        {
+                            kept.push_back(*pos);
+                            continue;
+                        }
+                        total -= pos->error;
+                        interval half = *pos;
+                        half.high = center;
+                        halved.push_back(half);
+                        half.low = center;
+                        half.high = pos->high;
+                        halved.push_back(half);
+                    }
+                    if(halved.empty())
+                        throw calcError("No convergence", calcError::invalidArguments, integral.get());
+                    intervals.swap(kept);
+                }
+            }
+
+            real quadrature::getError() const
+            { return error; }
+
+            size_t quadrature::getEvaluations() const
+            { return loop.getEvaluations(); }
+
+        // Private:
+            void quadrature::estimate(std::vector<interval>& intervals)
+            {
+                // The points of every interval, the points on both sides of the center come in pairs
+                points.resize(intervals.size() * intervalPoints);
+                values.resize(points.size());
+                for(size_t i = 0; i < intervals.size(); ++i)
+                {
+                    const real center = (intervals[i].low + intervals[i].high) / 2;
+                    const real halfLength = (intervals[i].high - intervals[i].low) / 2;
+                    real* point = &points[i * intervalPoints];
+                    for(unsigned int j = 0; j + 1 < kronrodPoints; ++j)
+                    {
+                        point[2 * j] = center - halfLength * kronrodNodes[j];
+                        point[2 * j + 1] = center + halfLength * kronrodNodes[j];
+                    }
+                    point[intervalPoints - 1] = center;
+                }
+                loop.calculate(&points[0], points.size(), &values[0]);
+
+                // The rules, and the error estimate of QUADPACK
+                const real epsilon = std::numeric_limits<real>::epsilon();
+                for(size_t i = 0; i < intervals.size(); ++i)
+                {
+                    const real halfLength = (intervals[i].high - intervals[i].low) / 2;
+                    const real* value = &values[i * intervalPoints];
+                    const real centerValue = value[intervalPoints - 1];
+                    real kronrod = kronrodWeights[kronrodPoints - 1] * centerValue;
+                    real gauss = gaussWeights[kronrodPoints / 2 - 1] * centerValue;
+                    real absolute = kronrodWeights[kronrodPoints - 1] * std::fabs(centerValue);
+                    for(unsigned int j = 0; j + 1 < kronrodPoints; ++j)
+                    {
+                        const real pair = value[2 * j] + value[2 * j + 1];
+                        kronrod += kronrodWeights[j] * pair;
+                        absolute += kronrodWeights[j] * (std::fabs(value[2 * j]) + std::fabs(value[2 * j + 1]));
+                        if(j % 2 == 1)
+                            gauss += gaussWeights[j / 2] * pair;
+                    }
+
+                    // The deviation of the expression from its mean scales the difference between both rules
+                    const real mean = kronrod / 2;
+                    real deviation = kronrodWeights[kronrodPoints - 1] * std::fabs(centerValue - mean);
+                    for(unsigned int j = 0; j + 1 < kronrodPoints; ++j)
+                        deviation += kronrodWeights[j] * (std::fabs(value[2 * j] - mean) + std::fabs(value[2 * j + 1] - mean));
+                    real difference = std::fabs((kronrod - gauss) * halfLength);
+                    deviation *= std::fabs(halfLength);
+                    if(deviation != 0 && difference != 0)
+                        difference = deviation * std::min(static_cast<real>(1), std::pow(200 * difference / deviation, static_cast<real>(1.5)));
+                    absolute *= std::fabs(halfLength);
+                    if(absolute > std::numeric_limits<real>::min() / (50 * epsilon))
+                        difference = std::max(50 * epsilon * absolute, difference);
+
+                    intervals[i].integral = kronrod * halfLength;
+                    intervals[i].error = difference;
+                    intervals[i].absolute = absolute;
+                }
+            }
+
+    // integralMathFunction:
+        // Public:
+            real integralMathFunction::execute(const argList&, const string& name)
+            { throw calcError("The expression has to be passed unevaluated", calcError::invalidArguments, name); }
+
+            bool integralMathFunction::takesExpressions() const
+            { return true; }
+
+            real integralMathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                // The expression, the variable and the range
+                if(expressions.size() != 4)
+                {
+                    std::vector<real> extraRealInfo(2, expressions.size());
+                    extraRealInfo[1] = 4;
+                    throw calcError(expressions.size() < 4 ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+                const std::shared_ptr<const program> prog = context::compile(expressions[0], &env);
+                const string variable = solverMathFunction::variableName(expressions[1], name, 2);
+                const real low = context::compile(expressions[2], &env)->execute(env);
+                const real high = context::compile(expressions[3], &env)->execute(env);
+                if(!std::isfinite(low))
+                    throw calcError("Invalid argument", calcError::invalidArguments, name, low);
+                if(!std::isfinite(high))
+                    throw calcError("Invalid argument", calcError::invalidArguments, name, high);
+
+                quadrature integrator(*prog, variable, env);
+                try
+                {
+                    return integrator.integrate(low, high);
+                }
+                catch(calcError& err)
+                {
+                    if(err.msg == "No convergence")
+                        err.extraStringInfo.insert(err.extraStringInfo.begin(), name);
+                    throw;
+                }
+            }
+}
@@ -0,0 +1,94 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <vector>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "mathfunction.h"
+#include "series.h"
+
+namespace calc
+{
+    // Calculates integrals of a compiled expression to a variable by adaptive Gauss-Kronrod quadrature
+    // Every interval is calculated with the 15 points of the Kronrod rule, which include the 7 points of the Gauss rule, and the
+    // difference between both estimates the error like QUADPACK does. The intervals with the largest errors are halved until the
+    // estimated error of the whole integral is at most the tolerance times the integral of the absolute value of the expression.
+    // The points of all intervals of a round are calculated at once (see variableLoop), and the sums are compensated (see compensatedSum).
+    class quadrature
+    {
+        public:
+            // The default tolerance, relative to the integral of the absolute value of the expression
+            static constexpr real defaultTolerance = 1e-12;
+            // The largest number of intervals the range is divided into
+            static const size_t maxIntervals = 4096;
+
+            // Constructor, the program and the environment have to outlive the quadrature
+            quadrature(const program& prog, const string& variable, environment& env, const real& tolerance = defaultTolerance);
+
+            // Calculate the integral from low to high, which may be less than low
+            // Throws a calcError if the expression can't be calculated somewhere, or if the tolerance isn't reached
+            real integrate(const real& low, const real& high);
+
+            // Get the estimated error of the last integral
+            real getError() const;
+            // Get the number of times the expression has been calculated so far
+            size_t getEvaluations() const;
+
+        private:
+            // A part of the range
+            struct interval
+            {
+                real low;                           // The start
+                real high;                          // The end
+                real integral;                      // The integral by the Kronrod rule
+                real error;                         // The estimated error of the integral
+                real absolute;                      // The integral of the absolute value
+            };
+
+            // Calculate the integrals and errors of the intervals, all points of all intervals at once
+            void estimate(std::vector<interval>& intervals);
+
+            variableLoop loop;                      // Calculates the expression
+            real tolerance;                         // The tolerance
+            real error;                             // The estimated error of the last integral
+            std::vector<real> points;               // The points of the intervals being estimated
+            std::vector<real> values;               // The values of the expression at the points
+    };
+
+    // The function INTEGRATE(expression, variable, low, high), it calculates the integral of the expression to the variable from low to high
+    // The variable is a name, it only has the values of the points while the expression is calculated (see quadrature).
+    class integralMathFunction : public mathFunction
+    {
+        public:
+            // Constructor
+            constexpr integralMathFunction(const bool& cleanUpNeeded = false) : mathFunction(cleanUpNeeded) {}
+
+            // Throws an error, the expression has to be passed unevaluated
+            virtual real execute(const argList& vars, const string& name);
+            // Calculate the integral
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true, the arguments are passed unevaluated
+            virtual bool takesExpressions() const;
+    };
+}
+
+#endif // QUADRATURE_H
@@ -0,0 +1,122 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "random.h"
+#include <random>
+#include <chrono>
+
+namespace calc
+{
+    namespace
+    {
+        // The next number of splitmix64, which advances x
+        std::uint64_t splitMix(std::uint64_t& x)
+        {
+            std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        // Rotate the bits to the left
+        inline std::uint64_t rotateLeft(const std::uint64_t& x, const int& bits)
+        { return (x << bits) | (x >> (64 - bits)); }
+    }
+
+    // randomGenerator:
+        // Public:
+            randomGenerator::randomGenerator(const std::uint64_t& seed)
+            { setSeed(seed); }
+
+            void randomGenerator::setSeed(const std::uint64_t& newSeed)
+            {
+                // The state may not be all zeros, splitmix64 never gives four zeros in a row
+                seed = newSeed;
+                std::uint64_t x = newSeed;
+                for(int i = 0; i < 4; ++i)
+                    state[i] = splitMix(x);
+            }
+
+            std::uint64_t randomGenerator::getSeed() const
+            { return seed; }
+
+            std::uint64_t randomGenerator::next()
+            {
+                const std::uint64_t out = rotateLeft(state[1] * 5, 7) * 9;
+                const std::uint64_t shifted = state[1] << 17;
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= shifted;
+                state[3] = rotateLeft(state[3], 45);
+                return out;
+            }
+
+            real randomGenerator::nextReal()
+            { return static_cast<real>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+            std::uint64_t randomGenerator::nextBelow(const std::uint64_t& bound)
+            {
+                // The numbers below 2^64 mod bound are skipped, so every remainder is left an equal number of times
+                const std::uint64_t skipped = (0 - bound) % bound;
+                std::uint64_t out = next();
+                while(out < skipped)
+                    out = next();
+                return out % bound;
+            }
+
+            randomGenerator randomGenerator::split()
+            { return randomGenerator(next()); }
+
+            bool randomGenerator::operator==(const randomGenerator& other) const
+            {
+                return state[0] == other.state[0] && state[1] == other.state[1] &&
+                       state[2] == other.state[2] && state[3] == other.state[3];
+            }
+
+            bool randomGenerator::operator!=(const randomGenerator& other) const
+            { return !(*this == other); }
+
+            std::uint64_t randomGenerator::unpredictableSeed()
+            {
+                // The clock is mixed in as well, because the random device may not be random on every platform
+                std::uint64_t out = static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+                try
+                {
+                    std::random_device device;
+                    out ^= (static_cast<std::uint64_t>(device()) << 32) ^ device();
+                }
+                catch(...)
+                {}
+                return splitMix(out);
+            }
+
+            randomGenerator& randomGenerator::current()
+            { return innermost ? *innermost : shared(); }
+
+            randomGenerator& randomGenerator::shared()
+            {
+                static randomGenerator generator(unpredictableSeed());
+                return generator;
+            }
+
+        // Private:
+            // Static:
+                thread_local randomGenerator* randomGenerator::innermost = 0;
+}
@@ -0,0 +1,98 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include "types.h"
+
+namespace calc
+{
+    // A pseudo random number generator, using xoshiro256** (by Blackman and Vigna) which is fast and passes the common statistical tests
+    // The numbers only depend on the seed, so the same seed gives the same numbers every time. A generator can be split into
+    // streams that don't overlap in practice, e.g. one for every expression of a batch, so the numbers of an expression don't
+    // depend on which thread calculates it. A generator isn't thread-safe, every thread should use its own.
+    // RAND draws its numbers from the generator of the current thread (see current()), which is the one of the environment
+    // a program is executed in (see environment::getRandomGenerator()).
+    class randomGenerator
+    {
+        public:
+            // Constructor, starts with the given seed
+            explicit randomGenerator(const std::uint64_t& seed = 0);
+
+            // Start over with the given seed, the state is filled with the numbers splitmix64 makes out of the seed
+            void setSeed(const std::uint64_t& newSeed);
+            // Get the seed the generator started with
+            std::uint64_t getSeed() const;
+
+            // Get the next 64 random bits
+            std::uint64_t next();
+            // Get a random real in the range [0, 1), every multiple of 2^-53 in the range is equally likely
+            real nextReal();
+            // Get a random integer in the range [0, bound), every integer is equally likely (bound can't be 0)
+            std::uint64_t nextBelow(const std::uint64_t& bound);
+            // Split off a new stream, seeded by the next number of this generator
+            // The numbers of the new stream don't depend on how many numbers are drawn from this one or the other streams.
+            randomGenerator split();
+
+            // Returns true if both generators are in the same state, i.e. they give the same numbers from here on
+            bool operator==(const randomGenerator& other) const;
+            bool operator!=(const randomGenerator& other) const;
+
+            // Get a seed that's different every time, for a generator whose seed isn't chosen
+            static std::uint64_t unpredictableSeed();
+
+            // Get the generator RAND uses in the current thread: the one of the innermost scope, or the shared generator if there is none
+            static randomGenerator& current();
+            // Get the generator shared by everything that doesn't use a scope, like calc, which starts with an unpredictable seed
+            // It's shared by all threads, so like the variables of calc it may only be used by one thread at a time.
+            static randomGenerator& shared();
+
+            // Lets current() return the given generator in the current thread for as long as the scope exists, 0 keeps the current one
+            class scope
+            {
+                public:
+                    // Constructor, switches to the generator
+                    scope(randomGenerator* generator)
+                    : previous(innermost)
+                    {
+                        if(generator)
+                            innermost = generator;
+                    }
+                    // Destructor, switches back to the generator that was used before
+                    ~scope()
+                    { innermost = previous; }
+
+                private:
+                    // Prevent copying:
+                    scope& operator=(const scope& other);
+                    scope(const scope& other);
+
+                    randomGenerator* previous;          // The generator used before the scope
+            };
+
+        private:
+            std::uint64_t seed;                         // The seed
+            std::uint64_t state[4];                     // The state of xoshiro256**
+
+            static thread_local randomGenerator* innermost;     // The generator of the innermost scope of the current thread
+    };
+}
+
+#endif // RANDOM_H
@@ -0,0 +1,599 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "rational.h"
+#include "calc.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+namespace calc
+{
+    namespace
+    {
+        typedef unsigned long long int wide;
+
+        // The largest magnitude of the numerator and denominator of a small number
+        const integer largest = std::numeric_limits<integer>::max();
+        // The most digits the integers of an exact number can have, larger ones become approximations so that a calculation
+        // can't run out of memory (the exact decimals can't divide integers with much more digits anyway)
+        const long long maxExactDigits = 100000;
+        // The digits that are added when a fraction is divided to write it in decimals
+        const int guardDigits = 10;
+        // The largest root pow() tries to take exactly
+        const integer maxRootDegree = 64;
+
+        // The magnitude of an integer that isn't the smallest integer
+        inline wide magnitudeOf(const integer& x)
+        { return x < 0 ? static_cast<wide>(-x) : static_cast<wide>(x); }
+
+        // The greatest common divisor, by Euclid's algorithm
+        wide gcd(wide a, wide b)
+        {
+            while(b != 0)
+            {
+                const wide rest = a % b;
+                a = b;
+                b = rest;
+            }
+            return a;
+        }
+
+        // The greatest common divisor of two exact integers, NaN if they're too large to divide
+        decimal gcd(decimal a, decimal b)
+        {
+            a = decimal::abs(a);
+            b = decimal::abs(b);
+            if(a == decimal(1) || b == decimal(1))
+                return decimal(1);
+            while(!b.isZero())
+            {
+                const decimal rest = decimal::fmod(a, b);
+                if(rest.isNaN())
+                    return rest;
+                a = b;
+                b = rest;
+            }
+            return a;
+        }
+
+        // Add two integers, returns false if the sum doesn't fit (the smallest integer doesn't fit either)
+        inline bool addChecked(const integer& a, const integer& b, integer& out)
+        {
+            if((b > 0 && a > largest - b) || (b < 0 && a < -largest - b))
+                return false;
+            out = a + b;
+            return true;
+        }
+
+        // Multiply two integers, returns false if the product doesn't fit
+        inline bool multiplyChecked(const integer& a, const integer& b, integer& out)
+        {
+            // Factors below 2^31 can't overflow, which saves a division in the common case
+            const wide x = magnitudeOf(a), y = magnitudeOf(b);
+            if(((x | y) >> 31) != 0 && x != 0 && y > static_cast<wide>(largest) / x)
+                return false;
+            const integer product = static_cast<integer>(x * y);
+            out = (a < 0) != (b < 0) ? -product : product;
+            return true;
+        }
+
+        // Take the root of the given degree of x exactly, returns false if the root isn't an integer
+        bool integerRoot(const integer& x, const integer& degree, integer& root)
+        {
+            // The root of the real is off by at most one
+            const integer estimate = static_cast<integer>(std::floor(std::pow(static_cast<real>(x), 1 / static_cast<real>(degree)) + 0.5));
+            for(integer candidate = std::max(estimate - 1, integer(0)); candidate <= estimate + 1; ++candidate)
+            {
+                integer power = 1;
+                bool fits = true;
+                for(integer i = 0; i < degree && fits; ++i)
+                    fits = multiplyChecked(power, candidate, power);
+                if(fits && power == x)
+                {
+                    root = candidate;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // The power of a real, a base that's too large or too small for a real is raised to the power as a decimal
+        real realPower(const rational& base, const real& exponent)
+        {
+            const real x = base.toReal();
+            if(!base.isExact() || base.isZero() || (x != 0 && std::abs(x) != std::numeric_limits<real>::infinity()))
+                return std::pow(x, exponent);
+            const decimal value = base.getNumerator().withDigits(std::numeric_limits<real>::digits10 + guardDigits) / base.getDenominator();
+            return decimal::pow(value, decimal::fromReal(exponent)).toReal();
+        }
+
+        // The product of the positive integers from first to last as an exact decimal
+        // The range is split in halves, so the factors of the multiplications have about the same size, which Karatsuba is fast for.
+        decimal productOf(const integer& first, const integer& last)
+        {
+            if(last - first >= 16)
+            {
+                const integer middle = first + (last - first) / 2;
+                return productOf(first, middle) * productOf(middle + 1, last);
+            }
+            // Short ranges are multiplied as machine integers as long as they fit
+            decimal out(1);
+            integer part = 1;
+            for(integer i = first; i <= last; ++i)
+            {
+                if(!multiplyChecked(part, i, part))
+                {
+                    out *= decimal::fromInteger(part);
+                    part = i;
+                }
+            }
+            return out * decimal::fromInteger(part);
+        }
+    }
+
+    // rational:
+        // Public:
+            rational::rational()
+            : type(small), numerator(0), denominator(1), value(0) {}
+
+            rational::rational(const int& value)
+            : type(small), numerator(value), denominator(1), value(0) {}
+
+            rational rational::fromInteger(const integer& value)
+            {
+                if(value < -largest)
+                    return fraction(decimal::fromInteger(value), decimal(1));
+                return smallFraction(value, 1);
+            }
+
+            rational rational::fromReal(const real& value)
+            {
+                if(value != value || value == std::numeric_limits<real>::infinity() || value == -std::numeric_limits<real>::infinity())
+                    return approximation(value);
+
+                // Only reals that read back from a representation with digits10 digits are exact, the others are approximations
+                char buffer[48];
+                std::snprintf(buffer, sizeof(buffer), "%.*e", std::numeric_limits<real>::digits10 - 1, value);
+                if(std::strtod(buffer, 0) != value)
+                    return approximation(value);
+                return fromDecimal(decimal::parse(buffer, 0));
+            }
+
+            rational rational::approximation(const real& value)
+            {
+                rational out;
+                out.type = approximate;
+                out.value = value;
+                return out;
+            }
+
+            rational rational::fromDecimal(const decimal& value)
+            {
+                if(value.getDigits() != 0 || value.isNaN() || value.isInfinite())
+                    return approximation(value.toReal());
+                if(value.isZero())
+                    return rational();
+
+                // The decimal is the integer of its digits divided by a power of 10
+                const long long decimals = value.fractionDigits();
+                if(decimals > maxExactDigits || value.topDigit() > maxExactDigits)
+                    return approximation(value.toReal());
+                const decimal scale = decimal::pow(decimal(10), decimal::fromInteger(decimals));
+                return fraction(value * scale, scale);
+            }
+
+            rational rational::fraction(const decimal& numerator, const decimal& denominator)
+            { return reduce(numerator, denominator, false); }
+
+            rational rational::parse(const string& str)
+            { return fromDecimal(decimal::parse(str, 0)); }
+
+            bool rational::isExact() const
+            { return type != approximate; }
+
+            bool rational::isZero() const
+            { return type == approximate ? value == 0 : type == small && numerator == 0; }
+
+            bool rational::isNegative() const
+            { return type == small ? numerator < 0 : type == big ? bigNumerator.isNegative() : value < 0; }
+
+            bool rational::isInteger() const
+            {
+                if(type == approximate)
+                    return std::floor(value) == value;
+                return type == small ? denominator == 1 : bigDenominator == decimal(1);
+            }
+
+            decimal rational::getNumerator() const
+            { return type == small ? decimal::fromInteger(numerator) : type == big ? bigNumerator : decimal::notANumber(); }
+
+            decimal rational::getDenominator() const
+            { return type == small ? decimal::fromInteger(denominator) : type == big ? bigDenominator : decimal::notANumber(); }
+
+            real rational::toReal() const
+            {
+                if(type == approximate)
+                    return value;
+                // Integers below 2^53 are reals exactly, so their quotient is rounded once
+                const wide exactReals = wide(1) << std::numeric_limits<real>::digits;
+                if(type == small && magnitudeOf(numerator) <= exactReals && static_cast<wide>(denominator) <= exactReals)
+                    return static_cast<real>(numerator) / static_cast<real>(denominator);
+                return (getNumerator().withDigits(std::numeric_limits<real>::digits10 + guardDigits) / getDenominator()).toReal();
+            }
+
+            integer rational::toInteger() const
+            {
+                if(type == approximate)
+                {
+                    const real rounded = std::round(value);
+                    if(!(rounded >= static_cast<real>(std::numeric_limits<integer>::min()) && rounded < -static_cast<real>(std::numeric_limits<integer>::min())))
+                        return std::numeric_limits<integer>::min();
+                    return static_cast<integer>(rounded);
+                }
+                const rational half = smallFraction(1, 2);
+                const rational rounded = isNegative() ? -floorOfExact(-*this + half) : floorOfExact(*this + half);
+                return rounded.type == small ? rounded.numerator : std::numeric_limits<integer>::min();
+            }
+
+            string rational::toString(const realOutputType& outputType, const int& precision) const
+            {
+                if(type == approximate)
+                    return real2str(value, outputType, precision);
+                switch(outputType)
+                {
+                    case outputType_time:
+                    return real2str(toReal(), outputType, precision);
+
+                    // Integers in another base are written exactly
+                    case outputType_bin:
+                    case outputType_oct:
+                    case outputType_hex:
+                    {
+                        const rational rounded = round(*this);
+                        return rounded.type == small ? integer2str(rounded.numerator, outputType) : rounded.bigNumerator.toString(outputType);
+                    }
+
+                    // The numerator and denominator are written exactly
+                    case outputType_auto:
+                    {
+                        const string top = type == small ? integer2str(numerator, outputType_dec) : bigNumerator.toString(outputType_dec, 0);
+                        if(isInteger())
+                            return top;
+                        return top + '/' + (type == small ? integer2str(denominator, outputType_dec) : bigDenominator.toString(outputType_dec, 0));
+                    }
+
+                    // The other formats divide the fraction with enough digits for the digits in front of the dot and the decimals
+                    default:
+                    {
+                        const int decimals = precision >= 0 ? precision : std::numeric_limits<real>::digits10;
+                        const decimal top = getNumerator(), bottom = getDenominator();
+                        const long long integerDigits = top.isZero() ? 0 : std::max(top.topDigit() - bottom.topDigit() + 1, 0LL);
+                        const long long digits = (outputType == outputType_scientific ? 1 : integerDigits) + decimals + guardDigits;
+                        return (top.withDigits(static_cast<int>(digits)) / bottom).toString(outputType, decimals);
+                    }
+                }
+            }
+
+            rational rational::operator-() const
+            {
+                rational out(*this);
+                if(type == small)
+                    out.numerator = -numerator;
+                else if(type == big)
+                    out.bigNumerator = -bigNumerator;
+                else
+                    out.value = -value;
+                return out;
+            }
+
+            rational rational::operator+(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate)
+                    return approximation(toReal() + other.toReal());
+                if(type == small && other.type == small)
+                {
+                    integer sum;
+                    // Integers don't need a gcd
+                    if(denominator == 1 && other.denominator == 1)
+                    {
+                        if(addChecked(numerator, other.numerator, sum))
+                            return smallFraction(sum, 1);
+                    }
+                    // a/b + c/d = (a*(d/g) + c*(b/g)) / (b*d/g) with g = gcd(b, d), the only common factors of that are those of g
+                    else
+                    {
+                        const integer g = static_cast<integer>(gcd(denominator, other.denominator));
+                        integer left, right, bottom;
+                        if(multiplyChecked(numerator, other.denominator / g, left) && multiplyChecked(other.numerator, denominator / g, right) &&
+                           addChecked(left, right, sum))
+                        {
+                            if(sum == 0)
+                                return rational();
+                            const integer common = g == 1 ? 1 : static_cast<integer>(gcd(magnitudeOf(sum), g));
+                            if(multiplyChecked(denominator / g, other.denominator / common, bottom))
+                                return smallFraction(sum / common, bottom);
+                        }
+                    }
+                }
+
+                // Otherwise the integers are promoted and added the same way, sums of integers don't need a gcd at all
+                const decimal a = getNumerator(), b = getDenominator(), c = other.getNumerator(), d = other.getDenominator();
+                if(b == decimal(1) && d == decimal(1))
+                    return reduce(a + c, b, true);
+                const decimal g = gcd(b, d);
+                const decimal sum = a * (d / g) + c * (b / g);
+                const decimal common = gcd(sum, g);
+                return reduce(sum / common, (b / g) * (d / common), true);
+            }
+
+            rational rational::operator-(const rational& other) const
+            { return *this + (-other); }
+
+            rational rational::operator*(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate)
+                    return approximation(toReal() * other.toReal());
+                if(type == small && other.type == small)
+                {
+                    integer top, bottom;
+                    if(denominator == 1 && other.denominator == 1)
+                    {
+                        if(multiplyChecked(numerator, other.numerator, top))
+                            return smallFraction(top, 1);
+                    }
+                    // (a/b) * (c/d) = ((a/g)*(c/h)) / ((b/h)*(d/g)) with g = gcd(a, d) and h = gcd(c, b), which is reduced already
+                    else
+                    {
+                        const integer g = static_cast<integer>(gcd(magnitudeOf(numerator), other.denominator));
+                        const integer h = static_cast<integer>(gcd(magnitudeOf(other.numerator), denominator));
+                        if(multiplyChecked(numerator / g, other.numerator / h, top) && multiplyChecked(denominator / h, other.denominator / g, bottom))
+                            return top == 0 ? rational() : smallFraction(top, bottom);
+                    }
+                }
+                // Big integers are cancelled the same way, so the gcds are taken of the smaller integers before they're multiplied
+                const decimal a = getNumerator(), b = getDenominator(), c = other.getNumerator(), d = other.getDenominator();
+                const decimal g = gcd(a, d), h = gcd(c, b);
+                return reduce((a / g) * (c / h), (b / h) * (d / g), true);
+            }
+
+            rational rational::operator/(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate || other.isZero())
+                    return approximation(toReal() / other.toReal());
+
+                // Multiply by the inverse, which is reduced already
+                rational inverse(other);
+                if(other.type == small)
+                {
+                    inverse.numerator = other.numerator < 0 ? -other.denominator : other.denominator;
+                    inverse.denominator = static_cast<integer>(magnitudeOf(other.numerator));
+                }
+                else
+                {
+                    inverse.bigNumerator = other.bigNumerator.isNegative() ? -other.bigDenominator : other.bigDenominator;
+                    inverse.bigDenominator = decimal::abs(other.bigNumerator);
+                }
+                return *this * inverse;
+            }
+
+            rational& rational::operator+=(const rational& other)
+            { return *this = *this + other; }
+
+            rational& rational::operator-=(const rational& other)
+            { return *this = *this - other; }
+
+            rational& rational::operator*=(const rational& other)
+            { return *this = *this * other; }
+
+            rational& rational::operator/=(const rational& other)
+            { return *this = *this / other; }
+
+            bool rational::operator==(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate)
+                    return toReal() == other.toReal();
+                return compare(*this, other) == 0;
+            }
+
+            bool rational::operator!=(const rational& other) const
+            { return !(*this == other); }
+
+            bool rational::operator<(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate)
+                    return toReal() < other.toReal();
+                return compare(*this, other) < 0;
+            }
+
+            bool rational::operator>(const rational& other) const
+            { return other < *this; }
+
+            bool rational::operator<=(const rational& other) const
+            {
+                if(type == approximate || other.type == approximate)
+                    return toReal() <= other.toReal();
+                return compare(*this, other) <= 0;
+            }
+
+            bool rational::operator>=(const rational& other) const
+            { return other <= *this; }
+
+            rational rational::abs(const rational& x)
+            { return x.isNegative() ? -x : x; }
+
+            rational rational::floor(const rational& x)
+            { return x.type == approximate ? approximation(std::floor(x.value)) : floorOfExact(x); }
+
+            rational rational::ceil(const rational& x)
+            { return x.type == approximate ? approximation(std::ceil(x.value)) : -floorOfExact(-x); }
+
+            rational rational::round(const rational& x)
+            {
+                if(x.type == approximate)
+                    return approximation(x.value-std::floor(x.value) < std::ceil(x.value)-x.value ? std::floor(x.value) : std::ceil(x.value));
+                return floorOfExact(x + smallFraction(1, 2));
+            }
+
+            rational rational::fmod(const rational& a, const rational& b)
+            {
+                if(a.type == approximate || b.type == approximate || b.isZero())
+                    return approximation(std::fmod(a.toReal(), b.toReal()));
+                // a - b*trunc(a/b), which is exact
+                const rational quotient = a / b;
+                return a - b * (quotient.isNegative() ? -floorOfExact(-quotient) : floorOfExact(quotient));
+            }
+
+            rational rational::pow(const rational& base, const rational& exponent)
+            {
+                if(base.type == approximate || exponent.type == approximate)
+                    return approximation(realPower(base, exponent.toReal()));
+                if(exponent.isZero())
+                    return rational(1);
+
+                // Integer powers are calculated by repeated squaring, unless the result would get too many digits
+                if(exponent.isInteger() && exponent.type == small)
+                {
+                    const integer n = exponent.numerator;
+                    if(base.isZero())
+                        return n > 0 ? rational() : approximation(std::pow(0.0, static_cast<real>(n)));
+                    const decimal top = base.getNumerator(), bottom = base.getDenominator();
+                    const decimal larger = decimal::abs(top) > bottom ? decimal::abs(top) : bottom;
+                    const real largerReal = larger.toReal();
+                    const real digits = static_cast<real>(magnitudeOf(n)) * (largerReal < std::numeric_limits<real>::max() ? std::log10(largerReal) : static_cast<real>(larger.topDigit() + 1));
+                    if(digits > maxExactDigits)
+                        return approximation(realPower(base, static_cast<real>(n)));
+
+                    // Powers that fit in machine integers are calculated by repeated squaring
+                    if(digits < std::numeric_limits<integer>::digits10)
+                    {
+                        rational factor = base, out(1);
+                        for(wide rest = magnitudeOf(n); rest != 0; rest /= 2)
+                        {
+                            if(rest % 2 == 1)
+                                out *= factor;
+                            if(rest > 1)
+                                factor *= factor;
+                        }
+                        return n < 0 ? rational(1) / out : out;
+                    }
+                    // Otherwise the numerator and denominator are raised to the power, the powers of a reduced fraction are reduced as well
+                    const decimal power = decimal::fromInteger(static_cast<integer>(magnitudeOf(n)));
+                    const decimal topPower = decimal::pow(top, power), bottomPower = decimal::pow(bottom, power);
+                    return n < 0 ? reduce(bottomPower, topPower, true) : reduce(topPower, bottomPower, true);
+                }
+
+                // A power p/q of a positive fraction is exact if its numerator and denominator are powers of q
+                if(base.type == small && exponent.type == small && base.numerator > 0 && exponent.denominator <= maxRootDegree)
+                {
+                    integer top, bottom;
+                    if(integerRoot(base.numerator, exponent.denominator, top) && integerRoot(base.denominator, exponent.denominator, bottom))
+                        return pow(smallFraction(top, bottom), smallFraction(exponent.numerator, 1));
+                }
+                return approximation(realPower(base, exponent.toReal()));
+            }
+
+            rational rational::product(const integer& first, const integer& last)
+            {
+                if(first > last)
+                    return rational(1);
+                // The number of digits follows from the logarithm of the gamma function
+                const real digits = (std::lgamma(static_cast<real>(last) + 1) - std::lgamma(static_cast<real>(first))) / std::log(10.0);
+                if(digits > maxExactDigits)
+                    return approximation(std::exp((std::lgamma(static_cast<real>(last) + 1) - std::lgamma(static_cast<real>(first)))));
+                return fraction(productOf(first, last), decimal(1));
+            }
+
+        // Private:
+            rational rational::smallFraction(const integer& numerator, const integer& denominator)
+            {
+                rational out;
+                out.numerator = numerator;
+                out.denominator = denominator;
+                return out;
+            }
+
+            rational rational::reduce(decimal numerator, decimal denominator, const bool& coprime)
+            {
+                if(denominator.isNegative())
+                {
+                    numerator = -numerator;
+                    denominator = -denominator;
+                }
+                if(numerator.isZero())
+                    return rational();
+
+                // Integers that are too large become approximations
+                if(numerator.topDigit() > maxExactDigits || denominator.topDigit() > maxExactDigits)
+                    return approximation((numerator.withDigits(std::numeric_limits<real>::digits10 + guardDigits) / denominator).toReal());
+                if(!coprime && denominator != decimal(1))
+                {
+                    const decimal common = gcd(numerator, denominator);
+                    if(common.isNaN())
+                        return approximation((numerator.withDigits(std::numeric_limits<real>::digits10 + guardDigits) / denominator).toReal());
+                    if(common != decimal(1))
+                    {
+                        numerator /= common;
+                        denominator /= common;
+                    }
+                }
+
+                // Machine integers are used again as soon as they fit
+                const decimal limit = decimal::fromInteger(largest);
+                if(decimal::abs(numerator) <= limit && denominator <= limit)
+                    return smallFraction(numerator.toInteger(), denominator.toInteger());
+                rational out;
+                out.type = big;
+                out.bigNumerator = numerator;
+                out.bigDenominator = denominator;
+                return out;
+            }
+
+            int rational::compare(const rational& a, const rational& b)
+            {
+                if(a.type == small && b.type == small)
+                {
+                    if(a.denominator == b.denominator)
+                        return (a.numerator > b.numerator) - (a.numerator < b.numerator);
+                    integer left, right;
+                    if(multiplyChecked(a.numerator, b.denominator, left) && multiplyChecked(b.numerator, a.denominator, right))
+                        return (left > right) - (left < right);
+                }
+                const decimal left = a.getNumerator() * b.getDenominator(), right = b.getNumerator() * a.getDenominator();
+                return (left > right) - (left < right);
+            }
+
+            rational rational::floorOfExact(const rational& x)
+            {
+                if(x.type == small)
+                {
+                    integer quotient = x.numerator / x.denominator;
+                    if(x.numerator % x.denominator != 0 && x.numerator < 0)
+                        --quotient;
+                    return smallFraction(quotient, 1);
+                }
+                // The remainder has the sign of the numerator, so a negative one means the quotient was rounded up
+                const decimal rest = decimal::fmod(x.bigNumerator, x.bigDenominator);
+                decimal quotient = (x.bigNumerator - rest) / x.bigDenominator;
+                if(rest.isNegative())
+                    quotient -= decimal(1);
+                return fraction(quotient, decimal(1));
+            }
+}
@@ -0,0 +1,130 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include "types.h"
+#include "decimal.h"
+
+namespace calc
+{
+    // An exact fraction of two integers, or an approximation of a number that isn't a fraction
+    // The fraction is always reduced and its denominator is positive. As long as the numerator and denominator fit, they're
+    // machine integers and the operations only take a gcd when the result could have a common factor. Results that don't fit
+    // are promoted to integers of any size (exact decimals), and they go back to machine integers when they fit again.
+    // Numbers that can't be written as a fraction, like the results of transcendental functions, are approximated by a real.
+    // An operation on an approximation gives an approximation, so a result is only exact if everything it's made of is.
+    class rational
+    {
+        public:
+            // Constructor, creates an exact 0
+            rational();
+            // Constructor, creates an exact integer
+            explicit rational(const int& value);
+
+            // Create a number from an integer
+            static rational fromInteger(const integer& value);
+            // Create a number from a real, reals that have a decimal representation of at most std::numeric_limits<real>::digits10
+            // digits become exact (so 0.1 is 1/10), all others are approximated by the real
+            static rational fromReal(const real& value);
+            // Create an approximation of the given real
+            static rational approximation(const real& value);
+            // Create a number from a decimal, which is exact if the decimal is exact and isn't too small
+            static rational fromDecimal(const decimal& value);
+            // Create the fraction numerator/denominator of two exact integers, the denominator isn't 0
+            static rational fraction(const decimal& numerator, const decimal& denominator);
+            // Read a number as written in an expression, e.g. 1.5e-3, 0x1F or 017 (see str2real())
+            static rational parse(const string& str);
+
+            // Returns true if the number is an exact fraction, false if it's an approximation
+            bool isExact() const;
+            bool isZero() const;
+            bool isNegative() const;
+            // Returns true if the number is an integer, approximations that have no fractional part are integers as well
+            bool isInteger() const;
+
+            // Get the numerator and denominator of an exact number as exact decimals
+            decimal getNumerator() const;
+            decimal getDenominator() const;
+            // Convert to the nearest real
+            real toReal() const;
+            // Round to the nearest integer, halfway cases away from zero
+            // Numbers that don't fit (and NaN) become the smallest integer, like the conversion of a real does on x86
+            integer toInteger() const;
+            // Write the number in the given format, like real2str() does for reals
+            // The automatic format writes exact numbers as an integer or a fraction (e.g. -7/3), which reads back as the same number.
+            // The other formats write a fraction in decimals, a negative precision uses std::numeric_limits<real>::digits10.
+            string toString(const realOutputType& outputType = outputType_auto, const int& precision = -1) const;
+
+            // Arithmetic, a division by 0 gives the approximation a real division would give:
+            rational operator-() const;
+            rational operator+(const rational& other) const;
+            rational operator-(const rational& other) const;
+            rational operator*(const rational& other) const;
+            rational operator/(const rational& other) const;
+            rational& operator+=(const rational& other);
+            rational& operator-=(const rational& other);
+            rational& operator*=(const rational& other);
+            rational& operator/=(const rational& other);
+
+            // Comparison, NaN isn't equal to anything
+            bool operator==(const rational& other) const;
+            bool operator!=(const rational& other) const;
+            bool operator<(const rational& other) const;
+            bool operator>(const rational& other) const;
+            bool operator<=(const rational& other) const;
+            bool operator>=(const rational& other) const;
+
+            // Functions, like those of <cmath>:
+            static rational abs(const rational& x);
+            static rational floor(const rational& x);
+            static rational ceil(const rational& x);
+            // Rounds to the nearest integer, halfway cases are rounded up (like mathFunctions::round())
+            static rational round(const rational& x);
+            // The remainder of a/b, which has the sign of a
+            static rational fmod(const rational& a, const rational& b);
+            // Integer powers of exact numbers are exact, as are roots that are fractions (like (8/27)^(2/3)), unless the result gets too large
+            static rational pow(const rational& base, const rational& exponent);
+            // The product of the positive integers from first to last, which is exact unless it gets too large
+            static rational product(const integer& first, const integer& last);
+
+        private:
+            enum kind {small, big, approximate};
+
+            // Create an exact number from a numerator and denominator that are reduced already, the denominator is positive
+            static rational smallFraction(const integer& numerator, const integer& denominator);
+            // Create an exact number from a numerator and denominator that may have a common factor, the denominator isn't 0
+            // If coprime is true they're known to have no common factor, so no gcd is needed. The number becomes an approximation
+            // if the integers are too large.
+            static rational reduce(decimal numerator, decimal denominator, const bool& coprime);
+            // Compare two exact numbers, returns -1, 0 or 1
+            static int compare(const rational& a, const rational& b);
+            // The largest integer that isn't larger than the exact number x
+            static rational floorOfExact(const rational& x);
+
+            kind type;                              // Whether the number consists of machine integers, big integers or a real
+            integer numerator;                      // The numerator and denominator of a small number, they're never the smallest
+            integer denominator;                    // integer so their magnitude always fits
+            decimal bigNumerator;                   // The numerator and denominator of a big number, as exact decimals
+            decimal bigDenominator;
+            real value;                             // The value of an approximation
+    };
+}
+
+#endif // RATIONAL_H
@@ -0,0 +1,274 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "sampler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <thread>
+
+namespace calc
+{
+    namespace
+    {
+        // The number of values of a task, a few blocks of program::executeBlock()
+        const size_t taskSize = program::blockSize * 16;
+        // The number of values the first round of uniform() has about
+        const size_t firstRoundSize = 1024;
+
+        // Orders samples by their value
+        bool sampleBefore(const functionSampler::sample& a, const functionSampler::sample& b)
+        { return a.x < b.x; }
+
+        // Get the value of the variable at the given index of count values spread evenly over [from, to], in increasing order
+        real spread(const real& from, const real& to, const size_t& index, const size_t& count)
+        {
+            if(index == 0 || count < 2)
+                return std::min(from, to);
+            if(index + 1 == count)
+                return std::max(from, to);
+            return std::min(from, to) + std::fabs(to - from) * (static_cast<real>(index) / (count - 1));
+        }
+    }
+
+    // functionSampler:
+        // Public:
+            functionSampler::functionSampler(const size_t& threadCount)
+            : threadCount(threadCount), tolerance(0.001), maxSamples(1 << 20), maxRounds(20) {}
+
+            void functionSampler::setProgress(const progressFunction& newProgress)
+            { progress = newProgress; }
+
+            void functionSampler::setTolerance(const real& newTolerance)
+            { tolerance = newTolerance; }
+
+            void functionSampler::setMaxSamples(const size_t& newMaxSamples)
+            { maxSamples = newMaxSamples; }
+
+            void functionSampler::setMaxRounds(const unsigned int& newMaxRounds)
+            { maxRounds = newMaxRounds; }
+
+            std::vector<functionSampler::sample> functionSampler::evaluate(const context& definitions, const program& prog, const string& variable, const std::vector<real>& values) const
+            {
+                std::vector<sample> samples(values.size());
+                for(size_t i = 0; i < values.size(); ++i)
+                    samples[i].x = values[i];
+                randomGenerator random = definitions.getRandom();
+                calculate(definitions, prog, variable, samples, random);
+                reportProgress(samples);
+                return samples;
+            }
+
+            std::vector<functionSampler::sample> functionSampler::uniform(const context& definitions, const program& prog, const string& variable, const real& from, const real& to, const size_t& count) const
+            {
+                // Every round halves the distance between the values, until all values are there
+                size_t stride = 1;
+                while(count / (stride * 2) >= firstRoundSize)
+                    stride *= 2;
+
+                std::vector<sample> samples(count);
+                std::vector<sample> round;
+                std::vector<sample> done;
+                randomGenerator random = definitions.getRandom();
+                for(size_t step = stride; step > 0; step /= 2)
+                {
+                    // The first round calculates all multiples of the stride, the rounds after it the values in between
+                    round.clear();
+                    for(size_t i = 0; i < count; i += step)
+                    {
+                        if(step == stride || (i / step) % 2 == 1)
+                        {
+                            round.push_back(sample());
+                            round.back().x = spread(from, to, i, count);
+                        }
+                    }
+                    calculate(definitions, prog, variable, round, random);
+                    for(size_t i = 0, next = 0; i < count; i += step)
+                    {
+                        if(step == stride || (i / step) % 2 == 1)
+                            samples[i] = round[next++];
+                    }
+
+                    // Report the samples calculated so far, unless they're all there already
+                    if(step > 1)
+                    {
+                        done.clear();
+                        for(size_t i = 0; i < count; i += step)
+                            done.push_back(samples[i]);
+                        if(!reportProgress(done))
+                        {
+                            samples.swap(done);
+                            return samples;
+                        }
+                    }
+                }
+                reportProgress(samples);
+                return samples;
+            }
+
+            std::vector<functionSampler::sample> functionSampler::adaptive(const context& definitions, const program& prog, const string& variable, const real& from, const real& to, const size_t& count) const
+            {
+                // Start with the values spread evenly
+                std::vector<sample> samples(count);
+                for(size_t i = 0; i < count; ++i)
+                    samples[i].x = spread(from, to, i, count);
+                randomGenerator random = definitions.getRandom();
+                calculate(definitions, prog, variable, samples, random);
+                if(!reportProgress(samples))
+                    return samples;
+
+                std::vector<real> results;
+                std::vector<char> split;
+                std::vector<sample> added;
+                std::vector<sample> merged;
+                for(unsigned int roundNumber = 0; roundNumber < maxRounds && samples.size() < maxSamples; ++roundNumber)
+                {
+                    // The range of the results, leaving out the 5% smallest and largest so a pole doesn't hide the rest
+                    results.clear();
+                    for(size_t i = 0; i < samples.size(); ++i)
+                    {
+                        if(!samples[i].failed)
+                            results.push_back(samples[i].y);
+                    }
+                    real limit = 0;
+                    if(!results.empty())
+                    {
+                        std::sort(results.begin(), results.end());
+                        const real low = results[static_cast<size_t>(0.05 * (results.size() - 1))];
+                        const real high = results[static_cast<size_t>(0.95 * (results.size() - 1))];
+                        real range = high - low;
+                        if(!(range > 0))
+                            range = std::max(std::max(std::fabs(low), std::fabs(high)), static_cast<real>(1));
+                        limit = tolerance * range;
+                    }
+
+                    // Split the intervals next to a sample that's too far from the line between its neighbours,
+                    // and the intervals with a sample that failed on one side only
+                    split.assign(samples.size(), 0);
+                    for(size_t i = 0; i + 1 < samples.size(); ++i)
+                    {
+                        if(samples[i].failed != samples[i + 1].failed)
+                            split[i] = 1;
+                    }
+                    for(size_t i = 1; i + 1 < samples.size(); ++i)
+                    {
+                        const sample& previous = samples[i - 1];
+                        const sample& next = samples[i + 1];
+                        if(previous.failed || samples[i].failed || next.failed)
+                            continue;
+                        const real line = previous.y + (next.y - previous.y) * ((samples[i].x - previous.x) / (next.x - previous.x));
+                        if(!(std::fabs(samples[i].y - line) <= limit))
+                            split[i - 1] = split[i] = 1;
+                    }
+
+                    // Add the values halfway, as long as they're different from the ends and there's room for them
+                    added.clear();
+                    for(size_t i = 0; i + 1 < samples.size() && samples.size() + added.size() < maxSamples; ++i)
+                    {
+                        const real middle = samples[i].x + (samples[i + 1].x - samples[i].x) / 2;
+                        if(split[i] && middle > samples[i].x && middle < samples[i + 1].x)
+                        {
+                            added.push_back(sample());
+                            added.back().x = middle;
+                        }
+                    }
+                    if(added.empty())
+                        break;
+                    calculate(definitions, prog, variable, added, random);
+
+                    merged.resize(samples.size() + added.size());
+                    std::merge(samples.begin(), samples.end(), added.begin(), added.end(), merged.begin(), sampleBefore);
+                    samples.swap(merged);
+                    if(!reportProgress(samples))
+                        break;
+                }
+                return samples;
+            }
+
+        // Private:
+            void functionSampler::calculate(const context& definitions, const program& prog, const string& variable, std::vector<sample>& samples, randomGenerator& random) const
+            {
+                // The values of the variable are a column bound to its slot, if the program uses the variable at all
+                const std::vector<string>& variables = prog.getVariables();
+                const size_t slot = std::find(variables.begin(), variables.end(), variable) - variables.begin();
+                std::vector<real> values(samples.size());
+                for(size_t i = 0; i < samples.size(); ++i)
+                    values[i] = samples[i].x;
+                std::vector<real> results(samples.size());
+                std::vector<char> failed(samples.size(), 0);
+
+                // Every task gets its own stream, in the order of the tasks
+                const size_t taskCount = (samples.size() + taskSize - 1) / taskSize;
+                std::vector<randomGenerator> streams;
+                streams.reserve(taskCount);
+                for(size_t i = 0; i < taskCount; ++i)
+                    streams.push_back(random.split());
+
+                // Every thread takes the next task until all are done, an unexpected exception stops them
+                std::atomic<size_t> nextTask(0);
+                std::exception_ptr failure;
+                std::atomic<bool> stopped(false);
+                auto worker = [&]()
+                {
+                    try
+                    {
+                        std::vector<const real*> columns(variables.size(), 0);
+                        std::vector<program::rowError> errors;
+                        for(size_t task = nextTask++; task < taskCount && !stopped; task = nextTask++)
+                        {
+                            const size_t first = task * taskSize;
+                            const size_t rowCount = std::min(taskSize, samples.size() - first);
+                            if(slot < columns.size())
+                                columns[slot] = &values[first];
+                            contextFrame frame(definitions);
+                            frame.useRandomStream(streams[task]);
+                            errors.clear();
+                            prog.executeBlock(frame, columns, rowCount, &results[first], &failed[first], errors);
+                        }
+                    }
+                    catch(...)
+                    {
+                        if(!stopped.exchange(true))
+                            failure = std::current_exception();
+                    }
+                };
+
+                // The current thread is one of the threads
+                size_t threads = threadCount > 0 ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+                threads = std::min(threads, std::max<size_t>(taskCount, 1));
+                std::vector<std::thread> helpers;
+                for(size_t i = 1; i < threads; ++i)
+                    helpers.push_back(std::thread(worker));
+                worker();
+                for(size_t i = 0; i < helpers.size(); ++i)
+                    helpers[i].join();
+                if(failure)
+                    std::rethrow_exception(failure);
+
+                for(size_t i = 0; i < samples.size(); ++i)
+                {
+                    samples[i].failed = failed[i] != 0 || !std::isfinite(results[i]);
+                    samples[i].y = samples[i].failed ? std::numeric_limits<real>::quiet_NaN() : results[i];
+                }
+            }
+
+            bool functionSampler::reportProgress(const std::vector<sample>& samples) const
+            { return !progress || progress(samples); }
+}
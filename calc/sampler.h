@@ -0,0 +1,87 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <functional>
+#include <vector>
+#include "types.h"
+#include "program.h"
+#include "context.h"
+
+namespace calc
+{
+    // Calculates a compiled expression for many values of one of its variables, e.g. to make a table or a plot of a function
+    // The values are divided into tasks of a few blocks, which are spread over all processors. Every task is calculated in its own
+    // frame by program::executeBlock(), so the instructions are executed for a block of values at once. RAND draws from a stream
+    // for every task, split off a copy of the generator of the context in the order of the tasks, so the results don't depend on
+    // the number of threads. Assignments aren't written to the context.
+    // Values can be spread evenly over a range (see uniform()), or adaptively: more values are added where the function curves or
+    // jumps (see adaptive()). Both calculate the values in rounds, and report the samples calculated so far after every round.
+    class functionSampler
+    {
+        public:
+            // The result of the expression for a value of the variable
+            struct sample
+            {
+                real x;                                 // The value of the variable
+                real y;                                 // The result, NaN if failed is set
+                bool failed;                            // Whether the expression couldn't be calculated for this value
+            };
+            // Called after every round with all samples calculated so far, sorted by x, it returns false to stop sampling
+            // It's called by the thread that's sampling.
+            typedef std::function<bool(const std::vector<sample>& samples)> progressFunction;
+
+            // Constructor, the values are calculated by the given number of threads, 0 for one per processor
+            functionSampler(const size_t& threadCount = 0);
+
+            // Set the function that's called after every round, an empty function isn't called
+            void setProgress(const progressFunction& newProgress);
+            // Set how far the function may be from a straight line between two samples before adaptive() adds a value between them,
+            // as a fraction of the range of the results (leaving out the 5% smallest and largest ones), 0.001 by default
+            void setTolerance(const real& newTolerance);
+            // Set the largest number of samples adaptive() may calculate, 1048576 by default
+            void setMaxSamples(const size_t& newMaxSamples);
+            // Set the largest number of rounds in which adaptive() adds values, which is how many times an interval can be halved, 20 by default
+            void setMaxRounds(const unsigned int& newMaxRounds);
+
+            // Calculate the program for every value of the variable in values, in a single round
+            std::vector<sample> evaluate(const context& definitions, const program& prog, const string& variable, const std::vector<real>& values) const;
+            // Calculate the program for count values of the variable spread evenly over [from, to]
+            // The first round has every 1024th value or so, every round after it fills in the values halfway between them.
+            std::vector<sample> uniform(const context& definitions, const program& prog, const string& variable, const real& from, const real& to, const size_t& count) const;
+            // Calculate the program for count values spread evenly over [from, to], then keep adding values halfway between two samples
+            // where the function curves or jumps, or where it fails on one side only, until it's close enough to straight lines between the samples
+            std::vector<sample> adaptive(const context& definitions, const program& prog, const string& variable, const real& from, const real& to, const size_t& count) const;
+
+        private:
+            // Calculate the samples, whose x is set already, in parallel, the streams of RAND are split off the given generator
+            void calculate(const context& definitions, const program& prog, const string& variable, std::vector<sample>& samples, randomGenerator& random) const;
+            // Call the progress function, returns false if sampling should stop
+            bool reportProgress(const std::vector<sample>& samples) const;
+
+            size_t threadCount;                         // The number of threads, 0 for one per processor
+            progressFunction progress;                  // Called after every round
+            real tolerance;                             // How far the function may be from a line between two samples, relative to its range
+            size_t maxSamples;                          // The largest number of samples of adaptive()
+            unsigned int maxRounds;                     // The largest number of rounds of adaptive()
+    };
+}
+
+#endif // SAMPLER_H
@@ -0,0 +1,188 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "series.h"
+#include "context.h"
+#include "solver.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace calc
+{
+    const size_t seriesMathFunction::maxTerms;
+
+    namespace
+    {
+        // The number of values of the variable SUM() and PRODUCT() calculate the expression for at once
+        const size_t valuesAtOnce = 16 * program::blockSize;
+
+        // Multiply a product kept as a mantissa and a binary exponent by count factors, so only the result can overflow
+        // The mantissa is only split into a new mantissa and exponent when it gets far from 1, or when it would overflow or underflow.
+        void multiply(real& mantissa, integer& exponent, const real* factors, const size_t& count)
+        {
+            const real largest = std::ldexp(static_cast<real>(1), 500);
+            const real smallest = std::ldexp(static_cast<real>(1), -500);
+            for(size_t i = 0; i < count; ++i)
+            {
+                const real product = mantissa * factors[i];
+                if(std::fabs(product) <= largest && std::fabs(product) >= smallest)
+                {
+                    mantissa = product;
+                    continue;
+                }
+
+                // 0, infinity and NaN get here as well, they stay what they are
+                int mantissaShift = 0, factorShift = 0, productShift = 0;
+                const real factor = std::frexp(factors[i], &factorShift);
+                mantissa = std::frexp(std::frexp(mantissa, &mantissaShift) * factor, &productShift);
+                exponent += mantissaShift + factorShift + productShift;
+            }
+        }
+    }
+
+    // variableLoop:
+        // Public:
+            variableLoop::variableLoop(const program& prog, const string& variable, environment& env)
+            : prog(prog), local(env, variable), columns(prog.getVariables().size(), 0), evaluations(0)
+            {
+                const std::vector<string>& variables = prog.getVariables();
+                slot = std::find(variables.begin(), variables.end(), variable) - variables.begin();
+            }
+
+            void variableLoop::calculate(const real* values, const size_t& count, real* out)
+            {
+                evaluations += count;
+
+                // An expression that might read the variable from the environment gets one value at a time
+                if(prog.hasStores())
+                {
+                    for(size_t i = 0; i < count; ++i)
+                    {
+                        local.setValue(values[i]);
+                        out[i] = prog.execute(local);
+                    }
+                    return;
+                }
+
+                // Otherwise the values are bound to the variable as a column
+                if(slot < columns.size())
+                    columns[slot] = values;
+                failed.assign(count, 0);
+                errors.clear();
+                prog.executeBlock(local, columns, count, out, count > 0 ? &failed[0] : 0, errors);
+                if(!errors.empty())
+                {
+                    std::vector<program::rowError>::const_iterator first = errors.begin();
+                    for(std::vector<program::rowError>::const_iterator pos = errors.begin(); pos != errors.end(); ++pos)
+                    {
+                        if(pos->row < first->row)
+                            first = pos;
+                    }
+                    throw first->error;
+                }
+            }
+
+            size_t variableLoop::getEvaluations() const
+            { return evaluations; }
+
+    // compensatedSum:
+        // Public:
+            compensatedSum::compensatedSum()
+            : sum(0), compensation(0) {}
+
+            void compensatedSum::add(const real& term)
+            { add(&term, 1); }
+
+            void compensatedSum::add(const real* terms, const size_t& count)
+            {
+                // The rounding error of an addition is exact when it's calculated from the larger of both operands
+                // The sums are kept in locals, so the compiler can keep them in registers for the whole loop.
+                real newSum = sum;
+                real newCompensation = compensation;
+                for(size_t i = 0; i < count; ++i)
+                {
+                    const real added = newSum + terms[i];
+                    const bool larger = std::fabs(newSum) >= std::fabs(terms[i]);
+                    newCompensation += ((larger ? newSum : terms[i]) - added) + (larger ? terms[i] : newSum);
+                    newSum = added;
+                }
+                sum = newSum;
+                compensation = newCompensation;
+            }
+
+            real compensatedSum::get() const
+            {
+                // Infinities make the compensation NaN
+                return std::isfinite(sum) ? sum + compensation : sum;
+            }
+
+    // seriesMathFunction:
+        // Public:
+            real seriesMathFunction::execute(const argList&, const string& name)
+            { throw calcError("The expression has to be passed unevaluated", calcError::invalidArguments, name); }
+
+            bool seriesMathFunction::takesExpressions() const
+            { return true; }
+
+            real seriesMathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                // The variable, the range and the expression
+                if(expressions.size() != 4)
+                {
+                    std::vector<real> extraRealInfo(2, expressions.size());
+                    extraRealInfo[1] = 4;
+                    throw calcError(expressions.size() < 4 ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+                const string variable = solverMathFunction::variableName(expressions[0], name, 1);
+                const real from = context::compile(expressions[1], &env)->execute(env);
+                const real to = context::compile(expressions[2], &env)->execute(env);
+                if(!std::isfinite(from) || !std::isfinite(to) || std::floor(from) != from || std::floor(to) != to)
+                    throw calcError("Only integers allowed", calcError::invalidArguments, name);
+                const real count = to >= from ? to - from + 1 : 0;
+                if(count > maxTerms)
+                    throw calcError("Too many terms", calcError::invalidArguments, name, static_cast<real>(maxTerms));
+                const std::shared_ptr<const program> prog = context::compile(expressions[3], &env);
+
+                // The values of the variable are calculated a part at a time
+                variableLoop loop(*prog, variable, env);
+                std::vector<real> values(static_cast<size_t>(std::min(count, static_cast<real>(valuesAtOnce))));
+                std::vector<real> results(values.size());
+                compensatedSum sum;
+                real mantissa = 1;
+                integer exponent = 0;
+                for(real done = 0; done < count; done += values.size())
+                {
+                    const size_t part = static_cast<size_t>(std::min(count - done, static_cast<real>(values.size())));
+                    for(size_t i = 0; i < part; ++i)
+                        values[i] = from + (done + i);
+                    loop.calculate(&values[0], part, &results[0]);
+
+                    if(product)
+                        multiply(mantissa, exponent, &results[0], part);
+                    else
+                        sum.add(&results[0], part);
+                }
+                if(!product)
+                    return sum.get();
+                int shift = 0;
+                mantissa = std::frexp(mantissa, &shift);
+                const integer limit = std::numeric_limits<int>::max() / 2;
+                return std::ldexp(mantissa, static_cast<int>(std::max(-limit, std::min(exponent + shift, limit))));
+            }
+}
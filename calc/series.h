@@ -0,0 +1,105 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <vector>
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "mathfunction.h"
+
+namespace calc
+{
+    // Calculates a compiled expression for many values of a variable, which is local to the calculation (see localEnvironment)
+    // The values are calculated by program::executeBlock() with the variable bound to a column, so every instruction is executed
+    // for a block of values at once. Expressions that assign variables or call functions with unevaluated arguments (which might
+    // read the variable, like a SUM() inside a SUM()) are calculated one value at a time instead, with the variable in the environment.
+    class variableLoop
+    {
+        public:
+            // Constructor, the program and the environment have to outlive the loop
+            variableLoop(const program& prog, const string& variable, environment& env);
+
+            // Calculate the expression for count values of the variable, the results are written to out
+            // Throws the error of the first value for which the expression can't be calculated
+            void calculate(const real* values, const size_t& count, real* out);
+
+            // Get the number of times the expression has been calculated so far
+            size_t getEvaluations() const;
+
+        private:
+            const program& prog;                    // The expression
+            localEnvironment local;                 // The environment with the variable
+            std::vector<const real*> columns;       // The columns of the variable slots, only the variable gets one
+            size_t slot;                            // The slot of the variable, the number of variables if it isn't used
+            std::vector<char> failed;               // The rows that failed
+            std::vector<program::rowError> errors;  // The errors of the rows that failed
+            size_t evaluations;                     // The number of calculations
+    };
+
+    // Adds up reals with compensated (Neumaier) summation, the rounding error of every addition is kept and added at the end
+    // The result is as accurate as if it were calculated with twice the precision, even if large terms cancel each other out.
+    class compensatedSum
+    {
+        public:
+            // Constructor, the sum starts at 0
+            compensatedSum();
+
+            // Add a term
+            void add(const real& term);
+            // Add count terms
+            void add(const real* terms, const size_t& count);
+            // Get the sum
+            real get() const;
+
+        private:
+            real sum;                               // The sum, rounded
+            real compensation;                      // The sum of the rounding errors
+    };
+
+    // The functions SUM(variable, from, to, expression) and PRODUCT(variable, from, to, expression)
+    // They add up or multiply the expression for the variable going from from to to in steps of 1, from and to have to be integers.
+    // The variable is a name, it only has these values while the expression is calculated, and the expression is compiled once
+    // and calculated a block of values at a time (see variableLoop). The sum is compensated (see compensatedSum), the product keeps
+    // its exponent separately so it only overflows if the result does. If to is less than from the sum is 0 and the product 1.
+    // A range of more than maxTerms values is refused, so a typo like SUM(k, 1, 1e12, k) gives an error instead of running for hours.
+    class seriesMathFunction : public mathFunction
+    {
+        public:
+            // The largest number of values the variable can get
+            static const size_t maxTerms = 100000000;
+
+            // Constructor, product tells whether the function is PRODUCT instead of SUM
+            constexpr seriesMathFunction(const bool& product, const bool& cleanUpNeeded = false) : mathFunction(cleanUpNeeded), product(product) {}
+
+            // Throws an error, the expression has to be passed unevaluated
+            virtual real execute(const argList& vars, const string& name);
+            // Calculate the sum or product
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true, the arguments are passed unevaluated
+            virtual bool takesExpressions() const;
+
+        private:
+            // Whether this is PRODUCT instead of SUM
+            bool product;
+    };
+}
+
+#endif // SERIES_H
@@ -20,6 +20,7 @@
 #include "mathfunction.h"
 #include "calc_private.h"
 #include "calc.h"
+#include "context.h"
 #include <fstream>
 
 namespace calc
@@ -87,6 +88,34 @@ namespace calc
                 return succes;
             }
 
+            bool settingHandler::copyToContext(context& target) const
+            {
+                // This variable is going to remember whether the function was executed succesfully
+                bool succes = true;
+
+                // Iterate through all settings in this container, the first letter tells whether it's a variable or a function
+                for(const_iterator pos = begin(); pos != end(); ++pos)
+                {
+                    switch(pos->first[0])
+                    {
+                        case 'v':
+                            target.setVar(pos->first.substr(1), str2real(pos->second));
+                        break;
+
+                        case 'f':
+                            target.defineFunction(pos->first.substr(1), pos->second);
+                        break;
+
+                        default:
+                            succes = false;
+                        break;
+                    }
+                }
+
+                // Return whether everything went well
+                return succes;
+            }
+
             void settingHandler::loadFromFile(const string& fileName)
             {
                 clear();
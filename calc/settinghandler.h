@@ -36,6 +36,8 @@ namespace calc
             void settingsFromSource(const calc& settingSource);
             // Copy the settings to the variables and functions of the given calculator
             bool copyToCalculator(calc& calculator) const;
+            // Copy the settings to the variables and functions of the given context
+            bool copyToContext(context& target) const;
 
             // Load the settings from a file
             void loadFromFile(const string& fileName);
@@ -0,0 +1,349 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "solver.h"
+#include "context.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace calc
+{
+    namespace
+    {
+        // The largest number of steps of Newton's method
+        const unsigned int maxNewtonSteps = 100;
+        // The largest number of times a step of Newton's method is halved
+        const unsigned int maxHalvings = 40;
+        // The largest number of steps of the search for a change of sign, on either side of the guess
+        const unsigned int maxBracketSteps = 100;
+        // The factor by which the steps of the search for a change of sign grow
+        const real bracketGrowth = 1.6;
+        // The largest number of steps of Brent's method, enough to bisect the whole range of real down to a single value
+        const unsigned int maxBrentSteps = 2200;
+
+        // How close two values of the variable have to be to count as the same root
+        real tolerance(const real& x)
+        { return 4 * std::numeric_limits<real>::epsilon() * std::fabs(x) + std::numeric_limits<real>::min(); }
+
+        // Returns true if the values have a different sign, or either is 0
+        bool signChanges(const real& a, const real& b)
+        { return a == 0 || b == 0 || (a < 0) != (b < 0); }
+    }
+
+    // rootFinder:
+        // Public:
+            rootFinder::rootFinder(const program& prog, const string& variable, environment& env)
+            : prog(prog), local(env, variable), derivatives(numberTraits<dual>(variable)), evaluations(0), failures(0) {}
+
+            real rootFinder::solve(const real& guess)
+            {
+                real root = 0;
+                if(newton(guess, root))
+                    return root;
+                real low = 0, high = 0, lowValue = 0, highValue = 0;
+                if(bracket(guess, low, high, lowValue, highValue) && brent(low, high, lowValue, highValue, root))
+                    return root;
+                noRoot(guess);
+                return root;
+            }
+
+            real rootFinder::solve(const real& low, const real& high)
+            {
+                // With a change of sign between the ends the root is bracketed already
+                real lowValue = 0, highValue = 0, root = 0;
+                if(calculate(low, lowValue) && calculate(high, highValue) && signChanges(lowValue, highValue))
+                {
+                    if(brent(low, high, lowValue, highValue, root))
+                        return root;
+                }
+                // Otherwise Newton's method may still find a root in between
+                else if(newton(low + (high - low) / 2, root) && root >= std::min(low, high) && root <= std::max(low, high))
+                    return root;
+                noRoot(low + (high - low) / 2);
+                return root;
+            }
+
+            size_t rootFinder::getEvaluations() const
+            { return evaluations; }
+
+        // Private:
+            bool rootFinder::newton(const real& guess, real& root)
+            {
+                real x = guess;
+                dual y;
+                if(!calculate(x, y))
+                    return false;
+                for(unsigned int i = 0; i < maxNewtonSteps; ++i)
+                {
+                    if(y.value == 0)
+                    {
+                        root = x;
+                        return true;
+                    }
+                    const real step = y.value / y.derivative;
+                    if(!std::isfinite(step))
+                        return false;
+
+                    // Near the root the steps shrink quadratically, a step as small as the rounding means x is there
+                    if(std::fabs(step) <= tolerance(x) * 16)
+                    {
+                        root = x - step;
+                        return true;
+                    }
+
+                    // Halve the step until the expression gets closer to 0, so the method doesn't wander off
+                    real next = x - step;
+                    dual nextY;
+                    bool closer = false;
+                    for(unsigned int j = 0; j < maxHalvings && next != x; ++j)
+                    {
+                        if(calculate(next, nextY) && std::fabs(nextY.value) < std::fabs(y.value))
+                        {
+                            closer = true;
+                            break;
+                        }
+                        next = x - (x - next) / 2;
+                    }
+                    if(!closer)
+                        return false;
+                    x = next;
+                    y = nextY;
+                }
+                return false;
+            }
+
+            bool rootFinder::bracket(const real& guess, real& low, real& high, real& lowValue, real& highValue)
+            {
+                // The steps start at a hundredth of the guess, and grow until they're far enough to span any change of sign
+                real guessValue = 0;
+                const bool guessValid = calculate(guess, guessValue);
+                real below = guess, belowValue = guessValue, above = guess, aboveValue = guessValue;
+                bool belowValid = guessValid, aboveValid = guessValid;
+                real step = std::max(std::fabs(guess) / 100, static_cast<real>(0.01));
+                for(unsigned int i = 0; i < maxBracketSteps && std::isfinite(step); ++i, step *= bracketGrowth)
+                {
+                    // Step down, a value that can't be calculated isn't used for the bracket
+                    const real down = guess - step;
+                    real downValue = 0;
+                    if(calculate(down, downValue))
+                    {
+                        if(belowValid && signChanges(downValue, belowValue))
+                        {
+                            low = down;
+                            lowValue = downValue;
+                            high = below;
+                            highValue = belowValue;
+                            return true;
+                        }
+                        below = down;
+                        belowValue = downValue;
+                    }
+                    belowValid = (below == down);
+
+                    // Step up
+                    const real up = guess + step;
+                    real upValue = 0;
+                    if(calculate(up, upValue))
+                    {
+                        if(aboveValid && signChanges(aboveValue, upValue))
+                        {
+                            low = above;
+                            lowValue = aboveValue;
+                            high = up;
+                            highValue = upValue;
+                            return true;
+                        }
+                        above = up;
+                        aboveValue = upValue;
+                    }
+                    aboveValid = (above == up);
+                }
+                return false;
+            }
+
+            bool rootFinder::brent(real low, real high, real lowValue, real highValue, real& root)
+            {
+                // b is the best estimate so far, a the previous one and c the other end of the bracket [b, c]
+                const real limit = std::max(std::fabs(lowValue), std::fabs(highValue));
+                real a = low, b = high, c = high;
+                real fa = lowValue, fb = highValue, fc = highValue;
+                real d = b - a, e = d;
+                for(unsigned int i = 0; i < maxBrentSteps; ++i)
+                {
+                    if(!signChanges(fb, fc))
+                    {
+                        c = a;
+                        fc = fa;
+                        d = e = b - a;
+                    }
+                    if(std::fabs(fc) < std::fabs(fb))
+                    {
+                        a = b;
+                        b = c;
+                        c = a;
+                        fa = fb;
+                        fb = fc;
+                        fc = fa;
+                    }
+
+                    // Done once the bracket is as small as the rounding allows
+                    const real tol = tolerance(b) / 2;
+                    const real middle = (c - b) / 2;
+                    if(std::fabs(middle) <= tol || fb == 0)
+                    {
+                        // Near a pole the expression grows instead of getting closer to 0
+                        root = b;
+                        return std::fabs(fb) <= limit;
+                    }
+
+                    // Interpolate if the previous step made enough progress, otherwise bisect
+                    if(std::fabs(e) >= tol && std::fabs(fa) > std::fabs(fb))
+                    {
+                        const real s = fb / fa;
+                        real p = 0, q = 0;
+                        if(a == c)
+                        {
+                            // Linear interpolation
+                            p = 2 * middle * s;
+                            q = 1 - s;
+                        }
+                        else
+                        {
+                            // Inverse quadratic interpolation
+                            const real r = fb / fc;
+                            const real t = fa / fc;
+                            p = s * (2 * middle * t * (t - r) - (b - a) * (r - 1));
+                            q = (t - 1) * (r - 1) * (s - 1);
+                        }
+                        if(p > 0)
+                            q = -q;
+                        else
+                            p = -p;
+                        if(2 * p < std::min(3 * middle * q - std::fabs(tol * q), std::fabs(e * q)))
+                        {
+                            e = d;
+                            d = p / q;
+                        }
+                        else
+                            d = e = middle;
+                    }
+                    else
+                        d = e = middle;
+
+                    a = b;
+                    fa = fb;
+                    b += std::fabs(d) > tol ? d : (middle > 0 ? tol : -tol);
+                    if(!calculate(b, fb))
+                        return false;
+                }
+                return false;
+            }
+
+            bool rootFinder::calculate(const real& x, real& y)
+            {
+                ++evaluations;
+                local.setValue(x);
+                try
+                {
+                    y = prog.execute(local);
+                }
+                catch(calcError& err)
+                {
+                    failed(err);
+                    return false;
+                }
+                return std::isfinite(y);
+            }
+
+            bool rootFinder::calculate(const real& x, dual& y)
+            {
+                ++evaluations;
+                local.setValue(x);
+                try
+                {
+                    y = derivatives.evaluate(prog, local);
+                }
+                catch(calcError& err)
+                {
+                    failed(err);
+                    return false;
+                }
+                return std::isfinite(y.value);
+            }
+
+            void rootFinder::failed(const calcError& err)
+            {
+                if(failures++ == 0)
+                    firstError = err;
+            }
+
+            void rootFinder::noRoot(const real& near) const
+            {
+                if(failures == evaluations && failures > 0)
+                    throw firstError;
+                throw calcError("No root found", calcError::invalidArguments, near);
+            }
+
+    // solverMathFunction:
+        // Public:
+            real solverMathFunction::execute(const argList&, const string& name)
+            { throw calcError("The expression has to be passed unevaluated", calcError::invalidArguments, name); }
+
+            bool solverMathFunction::takesExpressions() const
+            { return true; }
+
+            real solverMathFunction::executeExpressions(const std::vector<string>& expressions, const string& name, environment& env)
+            {
+                // The expression, the variable and either a guess or the ends of the range
+                if(expressions.size() < 3 || expressions.size() > 4)
+                {
+                    std::vector<real> extraRealInfo(2, expressions.size());
+                    extraRealInfo[1] = expressions.size() < 3 ? 3 : 4;
+                    throw calcError(expressions.size() < 3 ? "Too less arguments" : "Too many arguments", calcError::invalidArguments, std::vector<string>(1, name), extraRealInfo);
+                }
+                const std::shared_ptr<const program> prog = context::compile(expressions[0], &env);
+                const string variable = variableName(expressions[1], name, 2);
+                std::vector<real> args;
+                for(size_t i = 2; i < expressions.size(); ++i)
+                    args.push_back(context::compile(expressions[i], &env)->execute(env));
+
+                rootFinder finder(*prog, variable, env);
+                try
+                {
+                    return args.size() == 1 ? finder.solve(args[0]) : finder.solve(args[0], args[1]);
+                }
+                catch(calcError& err)
+                {
+                    if(err.msg == "No root found")
+                        err.extraStringInfo.insert(err.extraStringInfo.begin(), name);
+                    throw;
+                }
+            }
+
+            // Static:
+                string solverMathFunction::variableName(const string& expression, const string& name, const unsigned int& position)
+                {
+                    // The argument is a name if it compiles to nothing but reading the variable
+                    const std::shared_ptr<const program> prog = context::compile(expression);
+                    const std::vector<program::instruction>& instructions = prog->getInstructions();
+                    if(instructions.size() != 1 || instructions[0].op != program::opLoad)
+                        throw calcError("Not a variable", calcError::invalidArguments, name, position);
+                    return prog->getVariables()[instructions[0].a];
+                }
+}
@@ -0,0 +1,99 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "types.h"
+#include "error.h"
+#include "program.h"
+#include "mathfunction.h"
+#include "numberengine.h"
+
+namespace calc
+{
+    // Finds a value of a variable for which a compiled expression is 0, i.e. a root of the expression
+    // The expression is calculated in a local environment in which only the variable has another value (see localEnvironment),
+    // so nothing is parsed again and the variable of the enclosing environment isn't changed.
+    // Newton's method is tried first, with the exact derivative calculated by dual numbers (see numberTraits<dual>), and a step is
+    // halved until the expression gets closer to 0. If that doesn't converge, e.g. because the derivative is 0 or the function
+    // jumps, a change of sign is searched for by stepping away from the guess in steps that grow every time, and the root within
+    // it is found by Brent's method. A change of sign at a pole (like that of 1/x) isn't taken for a root.
+    class rootFinder
+    {
+        public:
+            // Constructor, the program and the environment have to outlive the root finder
+            rootFinder(const program& prog, const string& variable, environment& env);
+
+            // Find a root near the guess, throws a calcError if none is found
+            real solve(const real& guess);
+            // Find a root between low and high, throws a calcError if none is found
+            real solve(const real& low, const real& high);
+
+            // Get the number of times the expression has been calculated so far
+            size_t getEvaluations() const;
+
+        private:
+            // Try Newton's method from the guess, returns false if it doesn't converge
+            bool newton(const real& guess, real& root);
+            // Search for a change of sign by stepping away from the guess on both sides, returns false if there is none
+            bool bracket(const real& guess, real& low, real& high, real& lowValue, real& highValue);
+            // Find the root between low and high by Brent's method, the expression has a different sign at both ends
+            // Returns false if the expression can't be calculated somewhere in between, or if the change of sign is a pole
+            bool brent(real low, real high, real lowValue, real highValue, real& root);
+
+            // Calculate the expression (and its derivative), returns false if it fails or if the result isn't a finite number
+            bool calculate(const real& x, real& y);
+            bool calculate(const real& x, dual& y);
+            // Remember the error of a calculation that failed
+            void failed(const calcError& err);
+            // Throws the error that no root was found, or the error of the expression if it couldn't be calculated at all
+            void noRoot(const real& near) const;
+
+            const program& prog;                    // The expression
+            localEnvironment local;                 // The environment with the variable
+            numberEngine<dual> derivatives;         // Calculates the expression with its derivative to the variable
+            size_t evaluations;                     // The number of calculations
+            size_t failures;                        // The number of calculations that failed
+            calcError firstError;                   // The error of the first calculation that failed
+    };
+
+    // The SOLVE(expression, variable, guess) function, it finds a root of the expression in the variable near the guess
+    // SOLVE(expression, variable, low, high) finds a root between low and high. The variable is a name, it only has the values
+    // tried for it while the expression is calculated (see rootFinder). The guess, low and high are calculated in the environment
+    // SOLVE is called in.
+    class solverMathFunction : public mathFunction
+    {
+        public:
+            // Constructor
+            constexpr solverMathFunction(const bool& cleanUpNeeded = false) : mathFunction(cleanUpNeeded) {}
+
+            // Throws an error, the expression has to be passed unevaluated
+            virtual real execute(const argList& vars, const string& name);
+            // Find the root
+            virtual real executeExpressions(const std::vector<string>& expressions, const string& name, environment& env);
+            // Returns true, the arguments are passed unevaluated
+            virtual bool takesExpressions() const;
+
+            // Get the name of the variable an argument of a function like SOLVE() names, throws a calcError if it isn't a name
+            // The position of the argument (counting from 1) is mentioned by the error.
+            static string variableName(const string& expression, const string& name, const unsigned int& position);
+    };
+}
+
+#endif // SOLVER_H
@@ -0,0 +1,180 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "statistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace calc
+{
+    // runningStatistics:
+        // Public:
+            runningStatistics::runningStatistics()
+            : count(0), mean(0), squares(0), minimum(0), maximum(0) {}
+
+            void runningStatistics::add(const real& value)
+            {
+                ++count;
+                const real difference = value - mean;
+                mean += difference / count;
+                squares += difference * (value - mean);
+                if(count == 1 || value < minimum)
+                    minimum = value;
+                if(count == 1 || value > maximum)
+                    maximum = value;
+            }
+
+            void runningStatistics::merge(const runningStatistics& other)
+            {
+                if(other.count == 0)
+                    return;
+                if(count == 0)
+                {
+                    *this = other;
+                    return;
+                }
+
+                // The formula of Chan, Golub and LeVeque for the squares of two parts
+                const real total = static_cast<real>(count) + other.count;
+                const real difference = other.mean - mean;
+                mean += difference * (other.count / total);
+                squares += other.squares + difference * difference * (count / total) * other.count;
+                count += other.count;
+                minimum = std::min(minimum, other.minimum);
+                maximum = std::max(maximum, other.maximum);
+            }
+
+            size_t runningStatistics::getCount() const
+            { return count; }
+
+            real runningStatistics::getMean() const
+            { return mean; }
+
+            real runningStatistics::getVariance() const
+            { return count > 1 ? squares / (count - 1) : 0; }
+
+            real runningStatistics::getMinimum() const
+            { return minimum; }
+
+            real runningStatistics::getMaximum() const
+            { return maximum; }
+
+    // quantileEstimator:
+        // Static:
+            const real quantileEstimator::relativeAccuracy = 0.001;
+
+        // Public:
+            quantileEstimator::quantileEstimator(const std::vector<real>& probabilities)
+            : probabilities(probabilities), zeros(0), count(0), minimum(0), maximum(0) {}
+
+            void quantileEstimator::add(const real& value)
+            {
+                if(value > 0)
+                    positive.add(bucket(value), 1);
+                else if(value < 0)
+                    negative.add(bucket(-value), 1);
+                else
+                    ++zeros;
+                ++count;
+                if(count == 1 || value < minimum)
+                    minimum = value;
+                if(count == 1 || value > maximum)
+                    maximum = value;
+            }
+
+            void quantileEstimator::merge(const quantileEstimator& other)
+            {
+                if(other.count == 0)
+                    return;
+                for(size_t i = 0; i < other.positive.counts.size(); ++i)
+                    positive.add(other.positive.first + static_cast<int>(i), other.positive.counts[i]);
+                for(size_t i = 0; i < other.negative.counts.size(); ++i)
+                    negative.add(other.negative.first + static_cast<int>(i), other.negative.counts[i]);
+                zeros += other.zeros;
+                minimum = count == 0 ? other.minimum : std::min(minimum, other.minimum);
+                maximum = count == 0 ? other.maximum : std::max(maximum, other.maximum);
+                count += other.count;
+            }
+
+            size_t quantileEstimator::getCount() const
+            { return count; }
+
+            std::vector<real> quantileEstimator::getQuantiles() const
+            {
+                std::vector<real> out(probabilities.size(), 0);
+                if(count == 0)
+                    return out;
+                for(size_t i = 0; i < probabilities.size(); ++i)
+                {
+                    // Walk through the buckets from the smallest values to the largest, until the rank is reached
+                    const size_t rank = static_cast<size_t>(probabilities[i] * (count - 1));
+                    size_t passed = 0;
+                    real estimate = maximum;
+                    bool found = false;
+                    for(size_t j = negative.counts.size(); j > 0 && !found; --j)
+                    {
+                        passed += negative.counts[j - 1];
+                        if((found = passed > rank))
+                            estimate = -bucketValue(negative.first + static_cast<int>(j - 1));
+                    }
+                    if(!found && (passed += zeros) > rank)
+                    {
+                        estimate = 0;
+                        found = true;
+                    }
+                    for(size_t j = 0; j < positive.counts.size() && !found; ++j)
+                    {
+                        passed += positive.counts[j];
+                        if((found = passed > rank))
+                            estimate = bucketValue(positive.first + static_cast<int>(j));
+                    }
+                    out[i] = std::min(std::max(estimate, minimum), maximum);
+                }
+                return out;
+            }
+
+        // Private:
+            void quantileEstimator::buckets::add(const int& bucket, const size_t& amount)
+            {
+                if(amount == 0)
+                    return;
+                if(counts.empty())
+                    first = bucket;
+                else if(bucket < first)
+                {
+                    counts.insert(counts.begin(), first - bucket, 0);
+                    first = bucket;
+                }
+                if(bucket - first >= static_cast<int>(counts.size()))
+                    counts.resize(bucket - first + 1, 0);
+                counts[bucket - first] += amount;
+            }
+
+            int quantileEstimator::bucket(const real& value)
+            {
+                // The bounds grow by (1 + accuracy) / (1 - accuracy), so the middle of a bucket is within the accuracy of its bounds
+                static const real inverseLogGrowth = 1 / std::log((1 + relativeAccuracy) / (1 - relativeAccuracy));
+                return static_cast<int>(std::ceil(std::log(value) * inverseLogGrowth));
+            }
+
+            real quantileEstimator::bucketValue(const int& bucket)
+            {
+                static const real growth = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+                return 2 * std::pow(growth, bucket) / (growth + 1);
+            }
+}
@@ -0,0 +1,111 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <vector>
+#include "types.h"
+
+namespace calc
+{
+    // The count, mean, variance, minimum and maximum of a stream of values, without storing the values
+    // The mean and variance are updated with Welford's algorithm, which doesn't lose precision like summing the squares does.
+    // The statistics of parts of a stream can be merged (see merge()), so every thread can collect the statistics of its own part.
+    class runningStatistics
+    {
+        public:
+            // Constructor, starts without any values
+            runningStatistics();
+
+            // Add a value
+            void add(const real& value);
+            // Add all values of another set of statistics, as if they were added after the values of this one
+            void merge(const runningStatistics& other);
+
+            // Get the number of values
+            size_t getCount() const;
+            // Get the mean of the values, 0 if there are none
+            real getMean() const;
+            // Get the sample variance of the values (dividing by the count minus 1), 0 if there are less than 2 values
+            real getVariance() const;
+            // Get the smallest value, 0 if there are none
+            real getMinimum() const;
+            // Get the largest value, 0 if there are none
+            real getMaximum() const;
+
+        private:
+            size_t count;                   // The number of values
+            real mean;                      // The mean of the values
+            real squares;                   // The sum of the squared differences between the values and their mean
+            real minimum;                   // The smallest value
+            real maximum;                   // The largest value
+    };
+
+    // Estimates quantiles of a stream of values without storing the values, by counting them in buckets whose bounds grow by a fixed factor
+    // Every estimate is within relativeAccuracy of a value with the rank of the quantile, however wide the values are spread, and the
+    // estimators of parts of a stream can be merged exactly (see merge()), in any order. This is the idea of DDSketch (by Masson et al).
+    class quantileEstimator
+    {
+        public:
+            // The largest relative difference between an estimate and a value with its rank
+            static const real relativeAccuracy;
+
+            // Constructor, estimates the quantiles of the given probabilities (which are between 0 and 1)
+            quantileEstimator(const std::vector<real>& probabilities);
+
+            // Add a value
+            void add(const real& value);
+            // Add all values of another estimator of the same probabilities
+            void merge(const quantileEstimator& other);
+
+            // Get the number of values
+            size_t getCount() const;
+            // Get the estimates of the quantiles, in the order of the probabilities, all 0 if there are no values
+            // The estimate of a probability p is the value at rank p times the count minus 1, counting from 0.
+            std::vector<real> getQuantiles() const;
+
+        private:
+            // The counts of a range of buckets
+            struct buckets
+            {
+                buckets() : first(0) {}
+
+                // Add to the count of a bucket, the range grows to include it
+                void add(const int& bucket, const size_t& amount);
+
+                std::vector<size_t> counts;             // The counts of the buckets
+                int first;                              // The bucket of the first count
+            };
+
+            // Get the bucket of a positive value, which holds the values between growth^(bucket-1) and growth^bucket
+            static int bucket(const real& value);
+            // Get the estimate of the values in a bucket, which is as far from both bounds relatively
+            static real bucketValue(const int& bucket);
+
+            std::vector<real> probabilities;            // The probabilities of the quantiles
+            buckets positive;                           // The number of positive values in every bucket
+            buckets negative;                           // The number of negative values in every bucket of their absolute value
+            size_t zeros;                               // The number of values that are 0
+            size_t count;                               // The number of values
+            real minimum;                               // The smallest value, the estimates never go below it
+            real maximum;                               // The largest value, the estimates never go above it
+    };
+}
+
+#endif // STATISTICS_H
@@ -0,0 +1,249 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+
+namespace calc
+{
+    // Hashes a name with 32-bit FNV-1a, this is cheap for the short names used in expressions
+    inline unsigned int hashSymbol(const std::string& name)
+    {
+        unsigned int hash = 2166136261u;
+        for(std::string::const_iterator pos = name.begin(); pos != name.end(); ++pos)
+        {
+            hash ^= static_cast<unsigned char>(*pos);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // A hash table mapping names to values, using open addressing with linear probing
+    // A lookup hashes the name once and then usually compares it to only one stored name, instead of the
+    // log(n) string compares of a std::map. The interface is the part of std::map that's used for functionLists,
+    // but the entries are not sorted: iterating visits them in an unspecified order.
+    // Adding an entry may move all entries, which invalidates all iterators and references to values.
+    template <typename T>
+    class symbolTable
+    {
+        private:
+            // The state of a slot in the table
+            enum slotState
+            {
+                slotEmpty,                          // The slot has never been used, probing stops here
+                slotUsed,                           // The slot holds an entry
+                slotRemoved                         // The slot held an entry that was erased, probing continues past it
+            };
+
+            // A slot in the table
+            struct slot
+            {
+                slot() : hash(0), state(slotEmpty) {}
+
+                std::pair<std::string, T> entry;    // The name and the value
+                unsigned int hash;                  // The hash of the name
+                slotState state;                    // Whether the slot holds an entry
+            };
+
+            // Iterator over the used slots, Slot is const for a const_iterator
+            template <typename Slot, typename Value>
+            class basicIterator
+            {
+                public:
+                    typedef std::forward_iterator_tag iterator_category;
+                    typedef Value value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef Value* pointer;
+                    typedef Value& reference;
+
+                    // Constructors, the iterator starts at the first used slot at or after pos
+                    basicIterator() : pos(0), end(0) {}
+                    basicIterator(Slot* pos, Slot* end) : pos(pos), end(end) { skipUnused(); }
+                    // Converting constructor, from iterator to const_iterator
+                    template <typename OtherSlot, typename OtherValue>
+                    basicIterator(const basicIterator<OtherSlot, OtherValue>& other) : pos(other.pos), end(other.end) {}
+
+                    reference operator*() const { return pos->entry; }
+                    pointer operator->() const { return &pos->entry; }
+                    basicIterator& operator++() { ++pos; skipUnused(); return *this; }
+                    basicIterator operator++(int) { basicIterator old = *this; ++*this; return old; }
+                    bool operator==(const basicIterator& other) const { return pos == other.pos; }
+                    bool operator!=(const basicIterator& other) const { return pos != other.pos; }
+
+                private:
+                    // Move forward to the first used slot
+                    void skipUnused()
+                    {
+                        while(pos != end && pos->state != slotUsed)
+                            ++pos;
+                    }
+
+                    Slot* pos;                      // The current slot
+                    Slot* end;                      // The end of the table
+
+                    template <typename, typename> friend class basicIterator;
+                    friend class symbolTable;
+            };
+
+        public:
+            typedef std::string key_type;
+            typedef T mapped_type;
+            // The name must not be changed through an iterator
+            typedef std::pair<std::string, T> value_type;
+            typedef std::size_t size_type;
+            typedef basicIterator<slot, value_type> iterator;
+            typedef basicIterator<const slot, const value_type> const_iterator;
+
+            // Constructor, creates an empty table
+            symbolTable() : used(0), removed(0) {}
+
+            // Iterators over all entries
+            iterator begin() { return iterator(slotsBegin(), slotsEnd()); }
+            iterator end() { return iterator(slotsEnd(), slotsEnd()); }
+            const_iterator begin() const { return const_iterator(slotsBegin(), slotsEnd()); }
+            const_iterator end() const { return const_iterator(slotsEnd(), slotsEnd()); }
+
+            // Get the number of entries
+            size_type size() const { return used; }
+            bool empty() const { return used == 0; }
+
+            // Find the entry with the given name, returns end() if there is none
+            iterator find(const std::string& name)
+            {
+                const size_type index = lookup(name, hashSymbol(name));
+                return index == npos ? end() : iterator(&slots[index], slotsEnd());
+            }
+            const_iterator find(const std::string& name) const
+            {
+                const size_type index = lookup(name, hashSymbol(name));
+                return index == npos ? end() : const_iterator(&slots[index], slotsEnd());
+            }
+
+            // Returns 1 if there is an entry with the given name, 0 otherwise
+            size_type count(const std::string& name) const
+            { return lookup(name, hashSymbol(name)) == npos ? 0 : 1; }
+
+            // Get the value of the entry with the given name, the entry is added (with the value T()) if there is none
+            T& operator[](const std::string& name)
+            {
+                const unsigned int hash = hashSymbol(name);
+                size_type index = lookup(name, hash);
+                if(index != npos)
+                    return slots[index].entry.second;
+
+                // Make sure there's room for one more entry, counting removed slots as used so probing always ends
+                if((used + removed + 1) * 4 > slots.size() * 3)
+                    rehash(used * 2 + 2 > slots.size() / 2 ? slots.size() * 2 : slots.size());
+
+                // Take the first slot that isn't used, a removed slot is reused
+                const size_type mask = slots.size() - 1;
+                for(index = hash & mask; slots[index].state == slotUsed; index = (index + 1) & mask) {}
+                if(slots[index].state == slotRemoved)
+                    --removed;
+                slot& target = slots[index];
+                target.entry.first = name;
+                target.entry.second = T();
+                target.hash = hash;
+                target.state = slotUsed;
+                ++used;
+                return target.entry.second;
+            }
+
+            // Erase the entry with the given name, returns the number of erased entries (0 or 1)
+            size_type erase(const std::string& name)
+            {
+                const size_type index = lookup(name, hashSymbol(name));
+                if(index == npos)
+                    return 0;
+                slots[index].entry = value_type();
+                slots[index].state = slotRemoved;
+                --used;
+                ++removed;
+                return 1;
+            }
+
+            // Erase all entries
+            void clear()
+            {
+                slots.clear();
+                used = removed = 0;
+            }
+
+        private:
+            // The index that means "not found"
+            static const size_type npos = static_cast<size_type>(-1);
+            // The smallest number of slots in a table that isn't empty, must be a power of two
+            static const size_type minimumSlots = 16;
+
+            // Get the index of the slot holding the given name, or npos
+            size_type lookup(const std::string& name, const unsigned int& hash) const
+            {
+                if(slots.empty())
+                    return npos;
+                const size_type mask = slots.size() - 1;
+                for(size_type index = hash & mask; slots[index].state != slotEmpty; index = (index + 1) & mask)
+                {
+                    if(slots[index].state == slotUsed && slots[index].hash == hash && slots[index].entry.first == name)
+                        return index;
+                }
+                return npos;
+            }
+
+            // Move all entries into a new table with the given number of slots (a power of two), this drops the removed slots
+            void rehash(size_type slotCount)
+            {
+                if(slotCount < minimumSlots)
+                    slotCount = minimumSlots;
+                std::vector<slot> old(slotCount);
+                old.swap(slots);
+                removed = 0;
+
+                const size_type mask = slotCount - 1;
+                for(typename std::vector<slot>::iterator pos = old.begin(); pos != old.end(); ++pos)
+                {
+                    if(pos->state != slotUsed)
+                        continue;
+                    size_type index = pos->hash & mask;
+                    while(slots[index].state == slotUsed)
+                        index = (index + 1) & mask;
+                    slots[index].entry.first.swap(pos->entry.first);
+                    slots[index].entry.second = pos->entry.second;
+                    slots[index].hash = pos->hash;
+                    slots[index].state = slotUsed;
+                }
+            }
+
+            // Pointers to the first slot and past the last slot
+            slot* slotsBegin() { return slots.empty() ? 0 : &slots[0]; }
+            slot* slotsEnd() { return slotsBegin() + slots.size(); }
+            const slot* slotsBegin() const { return slots.empty() ? 0 : &slots[0]; }
+            const slot* slotsEnd() const { return slotsBegin() + slots.size(); }
+
+            std::vector<slot> slots;                // The slots, the number of slots is 0 or a power of two
+            size_type used;                         // The number of used slots
+            size_type removed;                      // The number of removed slots
+    };
+}
+
+#endif // SYMBOLTABLE_H
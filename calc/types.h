@@ -22,6 +22,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include "symboltable.h"
 
 namespace calc
 {
@@ -30,13 +31,19 @@ namespace calc
 
     // Forward declaration of some classes
     class calc;
+    class context;
+    class decimal;
+    class rational;
+    class environment;
     class mathFunction;
+    class program;
 
     // Some typedefs
     typedef double real;
+    typedef long long int integer;         // At least 64 bits, used to calculate integers exactly
     typedef unsigned char idType;
 
-    typedef std::map<string, mathFunction*> functionList;
+    typedef symbolTable<mathFunction*> functionList;
     typedef std::map<string, real> varList;
     typedef std::vector<real> argList;
 
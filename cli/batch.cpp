@@ -0,0 +1,301 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "batch.h"
+#include "messages.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace cli
+{
+    // Public:
+        batchEvaluator::batchEvaluator(const calc::realOutputType& outputType)
+        : outputType(outputType), readSize(1 << 20), queueDepth(4), lineCount(0) {}
+
+        void batchEvaluator::setReadSize(const size_t& bytes)
+        { readSize = bytes > 0 ? bytes : 1; }
+
+        void batchEvaluator::setQueueDepth(const size_t& chunks)
+        { queueDepth = chunks; }
+
+        unsigned long long batchEvaluator::run(const calc::string& inputFile, const calc::string& outputFile)
+        {
+            inputName = inputFile;
+            outputName = outputFile;
+            lineCount = 0;
+            firstError = std::exception_ptr();
+
+            // Open the files, "-" means stdin or stdout
+            std::FILE* in = (inputFile == "-" ? stdin : std::fopen(inputFile.c_str(), "rb"));
+            if(!in)
+                throw calc::fileError(inputFile, calc::fileError::action_opening);
+            std::FILE* out = (outputFile == "-" ? stdout : std::fopen(outputFile.c_str(), "wb"));
+            if(!out)
+            {
+                if(in != stdin)
+                    std::fclose(in);
+                throw calc::fileError(outputFile, calc::fileError::action_opening);
+            }
+
+            // Create the queues between the stages, and start every stage in its own thread
+            // The write stage runs in the current thread
+            chunkQueue read2parse(queueDepth), parse2evaluate(queueDepth), evaluate2format(queueDepth), format2write(queueDepth);
+            std::thread reader(&batchEvaluator::readStage, this, in, std::ref(read2parse));
+            std::thread parser(&batchEvaluator::parseStage, this, std::ref(read2parse), std::ref(parse2evaluate));
+            std::thread evaluator(&batchEvaluator::evaluateStage, this, std::ref(parse2evaluate), std::ref(evaluate2format));
+            std::thread formatter(&batchEvaluator::formatStage, this, std::ref(evaluate2format), std::ref(format2write));
+            writeStage(out, format2write);
+
+            // Wait for all stages to finish, and close the files
+            reader.join();
+            parser.join();
+            evaluator.join();
+            formatter.join();
+            if(in != stdin)
+                std::fclose(in);
+            if(out != stdout && std::fclose(out) != 0 && !firstError)
+                firstError = std::make_exception_ptr(calc::fileError(outputFile, calc::fileError::action_writing));
+
+            // If one of the stages failed, pass the error on
+            if(firstError)
+                std::rethrow_exception(firstError);
+            return lineCount;
+        }
+
+    // Private:
+        void batchEvaluator::readStage(std::FILE* in, chunkQueue& out)
+        try
+        {
+            // The part of the last line that is read, but isn't complete yet
+            calc::string carry;
+
+            for(;;)
+            {
+                // Read a big block at once, behind the incomplete line of the previous block
+                chunkPtr current(new chunk);
+                current->input.swap(carry);
+                const size_t oldSize = current->input.size();
+                current->input.resize(oldSize + readSize);
+                const size_t bytesRead = std::fread(&current->input[oldSize], 1, readSize, in);
+                current->input.resize(oldSize + bytesRead);
+                if(bytesRead < readSize && std::ferror(in))
+                    throw calc::fileError(inputName, calc::fileError::action_reading);
+                const bool endOfFile = (bytesRead < readSize);
+
+                // Only complete lines go into this chunk, the rest is kept for the next one
+                // At the end of the file, the last line is complete even without a line ending
+                size_t end = current->input.size();
+                if(!endOfFile)
+                {
+                    const size_t lastNewline = current->input.rfind('\n');
+                    if(lastNewline == calc::string::npos)
+                    {
+                        // Not even one complete line, keep on reading
+                        carry.swap(current->input);
+                        continue;
+                    }
+                    end = lastNewline + 1;
+                    carry.assign(current->input, end, calc::string::npos);
+                    current->input.resize(end);
+                }
+
+                // Find all lines, without their line endings
+                for(size_t start = 0; start < end; )
+                {
+                    size_t newline = current->input.find('\n', start);
+                    if(newline == calc::string::npos)
+                        newline = end;
+                    size_t length = newline - start;
+                    if(length > 0 && current->input[start + length - 1] == '\r')
+                        --length;
+                    current->lineStarts.push_back(start);
+                    current->lineLengths.push_back(length);
+                    start = newline + 1;
+                }
+
+                // Hand the chunk over to the next stage, stop if the pipeline is shutting down
+                if(!current->lineStarts.empty() && !out.push(std::move(current)))
+                    break;
+                if(endOfFile)
+                    break;
+            }
+            out.close();
+        }
+        catch(...)
+        {
+            stageFailed(std::current_exception());
+            out.close();
+        }
+
+        void batchEvaluator::parseStage(chunkQueue& in, chunkQueue& out)
+        try
+        {
+            chunkPtr current;
+            while(in.pop(current))
+            {
+                // Split the input into tokens and check every expression for errors, blank lines are skipped
+                current->calculators.resize(current->lineStarts.size());
+                for(size_t i = 0; i < current->lineStarts.size(); ++i)
+                {
+                    const calc::string expr = current->input.substr(current->lineStarts[i], current->lineLengths[i]);
+                    if(expr.find_first_not_of(" \t\f\v") == calc::string::npos)
+                        continue;
+                    current->calculators[i].reset(new calc::calc(expr, false));
+                    current->calculators[i]->parse();
+                }
+
+                if(!out.push(std::move(current)))
+                    break;
+            }
+            in.close();
+            out.close();
+        }
+        catch(...)
+        {
+            stageFailed(std::current_exception());
+            in.close();
+            out.close();
+        }
+
+        void batchEvaluator::evaluateStage(chunkQueue& in, chunkQueue& out)
+        try
+        {
+            chunkPtr current;
+            while(in.pop(current))
+            {
+                // Calculate every expression, this is the only stage that uses the variables and functions of the engine
+                current->results.resize(current->calculators.size());
+                for(size_t i = 0; i < current->calculators.size(); ++i)
+                {
+                    lineResult& result = current->results[i];
+                    if(!current->calculators[i])
+                    {
+                        result.state = lineResult::stateBlank;
+                        continue;
+                    }
+
+                    try
+                    {
+                        result.value = current->calculators[i]->calculate();
+                        result.state = lineResult::stateValue;
+                    }
+                    catch(calc::calcError& err)
+                    {
+                        result.state = lineResult::stateError;
+                        result.errorIndex = current->errors.size();
+                        current->errors.push_back(err);
+                    }
+                }
+
+                // The parsed expressions aren't needed any more, free them before the chunk moves on
+                current->calculators.clear();
+
+                if(!out.push(std::move(current)))
+                    break;
+            }
+            in.close();
+            out.close();
+        }
+        catch(...)
+        {
+            stageFailed(std::current_exception());
+            in.close();
+            out.close();
+        }
+
+        void batchEvaluator::formatStage(chunkQueue& in, chunkQueue& out)
+        try
+        {
+            chunkPtr current;
+            while(in.pop(current))
+            {
+                // Convert every result to a line of text
+                for(size_t i = 0; i < current->results.size(); ++i)
+                {
+                    const lineResult& result = current->results[i];
+                    switch(result.state)
+                    {
+                        case lineResult::stateValue:
+                            try
+                            {
+                                // Like the GUI, an expression containing a time results in a time when auto detecting the output type
+                                calc::realOutputType type = outputType;
+                                if(type == calc::outputType_auto && std::memchr(current->input.data() + current->lineStarts[i], ':', current->lineLengths[i]))
+                                    type = calc::outputType_time;
+                                current->output += calc::real2str(result.value, type);
+                            }
+                            catch(calc::overflowError& err)
+                            { current->output += "error: " + errorMessage(err); }
+                        break;
+
+                        case lineResult::stateError:
+                            current->output += "error: " + errorMessage(current->errors[result.errorIndex]);
+                        break;
+
+                        default:
+                        break;
+                    }
+                    current->output += '\n';
+                }
+
+                // Only the output is needed by the last stage
+                current->input.clear();
+                current->results.clear();
+                current->errors.clear();
+
+                if(!out.push(std::move(current)))
+                    break;
+            }
+            in.close();
+            out.close();
+        }
+        catch(...)
+        {
+            stageFailed(std::current_exception());
+            in.close();
+            out.close();
+        }
+
+        void batchEvaluator::writeStage(std::FILE* out, chunkQueue& in)
+        try
+        {
+            chunkPtr current;
+            while(in.pop(current))
+            {
+                // Write the output of the whole chunk at once
+                if(std::fwrite(current->output.data(), 1, current->output.size(), out) != current->output.size())
+                    throw calc::fileError(outputName, calc::fileError::action_writing);
+                lineCount += current->lineStarts.size();
+            }
+            if(std::fflush(out) != 0)
+                throw calc::fileError(outputName, calc::fileError::action_writing);
+        }
+        catch(...)
+        {
+            stageFailed(std::current_exception());
+            in.close();
+        }
+
+        void batchEvaluator::stageFailed(const std::exception_ptr& err)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!firstError)
+                firstError = err;
+        }
+}
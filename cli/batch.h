@@ -0,0 +1,105 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <memory>
+#include <exception>
+#include <mutex>
+#include "calc/calc.h"
+#include "boundedqueue.h"
+
+namespace cli
+{
+    // Evaluates a file containing one expression per line, and writes one result per line
+    // The work is split into a pipeline of stages that each run in their own thread:
+    //   read -> parse -> evaluate -> format -> write
+    // The lines are handed from stage to stage in chunks, through bounded queues,
+    // so the memory usage doesn't depend on the size of the file.
+    // Every stage handles the chunks in the order they arrive, so the results are written in the order of the expressions.
+    // Only the evaluate stage touches the variables and functions of the calculator engine.
+    class batchEvaluator
+    {
+        public:
+            // Constructor, set the output type of the results
+            // If the output type is outputType_auto, expressions containing a time (e.g. 1:30+0:45) are written as a time
+            batchEvaluator(const calc::realOutputType& outputType = calc::outputType_auto);
+
+            // Set the number of bytes that are read from the input at once (this is also roughly the size of a chunk)
+            void setReadSize(const size_t& bytes);
+            // Set the number of chunks that may be waiting between two stages
+            void setQueueDepth(const size_t& chunks);
+
+            // Evaluate all expressions in the input file and write the results to the output file, "-" means stdin or stdout
+            // Returns the number of lines that were handled, a calc::fileError is thrown if a file couldn't be opened, read or written
+            unsigned long long run(const calc::string& inputFile, const calc::string& outputFile);
+
+        private:
+            // The result of evaluating a single line
+            struct lineResult
+            {
+                enum State
+                {
+                    stateBlank,                     // The line was empty, an empty line is written
+                    stateValue,                     // The line was evaluated succesfully, the result is in value
+                    stateError                      // An error occurred, the error is in errors[errorIndex]
+                };
+
+                State state;
+                calc::real value;
+                size_t errorIndex;
+            };
+
+            // A chunk of lines, travelling through the pipeline
+            struct chunk
+            {
+                calc::string input;                                         // The raw input, only complete lines
+                std::vector<size_t> lineStarts;                             // Where every line starts in input
+                std::vector<size_t> lineLengths;                            // The length of every line (without the line ending)
+                std::vector<std::unique_ptr<calc::calc> > calculators;      // The parsed expressions, 0 for blank lines
+                std::vector<lineResult> results;                            // The results of the expressions
+                std::vector<calc::calcError> errors;                        // The errors that occurred while evaluating
+                calc::string output;                                        // The formatted output of the whole chunk
+            };
+            typedef std::unique_ptr<chunk> chunkPtr;
+            typedef boundedQueue<chunkPtr> chunkQueue;
+
+            // The stages of the pipeline
+            void readStage(std::FILE* in, chunkQueue& out);
+            void parseStage(chunkQueue& in, chunkQueue& out);
+            void evaluateStage(chunkQueue& in, chunkQueue& out);
+            void formatStage(chunkQueue& in, chunkQueue& out);
+            void writeStage(std::FILE* out, chunkQueue& in);
+
+            // Remember the first error that occurred in one of the stages
+            void stageFailed(const std::exception_ptr& err);
+
+            calc::realOutputType outputType;        // The output type of the results
+            size_t readSize;                        // The number of bytes that are read at once
+            size_t queueDepth;                      // The number of chunks that may be waiting between two stages
+
+            calc::string inputName;                 // The name of the input file, used in errors
+            calc::string outputName;                // The name of the output file, used in errors
+            unsigned long long lineCount;           // The number of lines that have been written
+            std::exception_ptr firstError;          // The first error that occurred in one of the stages
+            std::mutex errorMutex;                  // Protects firstError
+    };
+}
+
+#endif // BATCH_H
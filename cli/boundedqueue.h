@@ -0,0 +1,90 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace cli
+{
+    // A first-in first-out queue that can be shared by two threads, holding at most a fixed number of items
+    // push() blocks while the queue is full and pop() blocks while the queue is empty,
+    // this way a fast producer can never use more memory than the capacity of the queue allows
+    template <typename T>
+    class boundedQueue
+    {
+        public:
+            // Constructor, set the maximum number of items in the queue
+            boundedQueue(const size_t& capacity)
+            : capacity(capacity > 0 ? capacity : 1), closed(false) {}
+
+            // Add an item to the back of the queue, waits until there's room for it
+            // Returns false if the queue was closed, in that case the item is not added
+            bool push(T item)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notFull.wait(lock, [this]{ return closed || items.size() < capacity; });
+                if(closed)
+                    return false;
+                items.push_back(std::move(item));
+                notEmpty.notify_one();
+                return true;
+            }
+
+            // Take the item at the front of the queue, waits until there is one
+            // Returns false if the queue is closed and no items are left
+            bool pop(T& item)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this]{ return closed || !items.empty(); });
+                if(items.empty())
+                    return false;
+                item = std::move(items.front());
+                items.pop_front();
+                notFull.notify_one();
+                return true;
+            }
+
+            // Close the queue, no items can be added after this
+            // Items that are still in the queue can still be taken out by pop()
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+                notEmpty.notify_all();
+                notFull.notify_all();
+            }
+
+        private:
+            // Prevent copying:
+            boundedQueue& operator=(const boundedQueue& other);
+            boundedQueue(const boundedQueue& other);
+
+            const size_t capacity;                  // The maximum number of items in the queue
+            bool closed;                            // Whether the queue is closed
+            std::deque<T> items;                    // The items in the queue
+            std::mutex mutex;                       // Protects all members above
+            std::condition_variable notFull;        // Signalled when an item is taken out of the queue
+            std::condition_variable notEmpty;       // Signalled when an item is added to the queue
+    };
+}
+
+#endif // BOUNDEDQUEUE_H
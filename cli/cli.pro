@@ -0,0 +1,22 @@
+# -------------------------------------------------
+# Headless command line front end of Dalculator
+# -------------------------------------------------
+TARGET = dalculator-cli
+TEMPLATE = app
+
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+include(../calc/calc.pri)
+
+SOURCES += main.cpp \
+    batch.cpp \
+    messages.cpp \
+    table.cpp
+HEADERS += batch.h \
+    boundedqueue.h \
+    messages.h \
+    table.h
+
+target.path = /usr/bin
+INSTALLS += target
@@ -0,0 +1,560 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include "calc/calc.h"
+#include "calc/builtins.h"
+#include "calc/settinghandler.h"
+#include "calc/profiler.h"
+#include "calc/pluginloader.h"
+#include "calc/nativeexport.h"
+#include "calc/numberengine.h"
+#include "calc/context.h"
+#include "calc/montecarlo.h"
+#include "calc/sampler.h"
+#include "batch.h"
+#include "table.h"
+#include "messages.h"
+
+namespace
+{
+    // Prints how this program should be used
+    void printUsage(std::ostream& out)
+    {
+        out<<"Usage: dalculator-cli [options] [expression...]\n"
+             "Calculates every expression and prints the results, one per line.\n"
+             "Without any expressions, the expressions are read from the standard input.\n"
+             "\n"
+             "Options:\n"
+             "  -o, --output TYPE      The output type: auto, scientific, bin, oct, dec, hex or time\n"
+             "  -n, --numbers TYPE     The number type the expressions are calculated with: float, double (the default),\n"
+             "                         long-double, decimal or rational (exact fractions), functions other than the built-in\n"
+             "                         ones still use doubles\n"
+             "      --digits N         The number of significant digits of the decimal number type, 50 by default\n"
+             "  -d, --degrees          Use degrees instead of radians for goniometric functions\n"
+             "      --seed N           Start the random numbers of RAND with the seed N, the same seed gives the same numbers\n"
+             "  -s, --settings FILE    Load the variables and functions from a settings file of Dalculator\n"
+             "      --plugins DIR      Load the functions of the plugins (shared libraries) in the directory DIR\n"
+             "      --export-native FILE\n"
+             "                         Write the functions of the settings file to FILE as the C++ source of a plugin\n"
+             "                         and quit, load the built plugin with --plugins to run them without interpreting them\n"
+             "  -b, --batch IN OUT     Calculate every line of the file IN and write the results to the file OUT,\n"
+             "                         use - for the standard input or output\n"
+             "  -t, --table IN OUT     Calculate the formulas for every row of the CSV file IN, and write it to OUT\n"
+             "                         with a column added for every formula, use - for the standard input or output\n"
+             "      --binary-table IN OUT\n"
+             "                         Like --table, but IN and OUT are directories with a file NAME.f64 of\n"
+             "                         native doubles for every column\n"
+             "  -f, --formula NAME=EXPR\n"
+             "                         Add a formula for --table, its variables are bound to the columns with the same\n"
+             "                         name and to the results of the formulas before it\n"
+             "      --separator CHAR   The separator of the fields in a CSV file, a comma by default\n"
+             "  -m, --monte-carlo N    Calculate every expression N times with different random numbers on all processors,\n"
+             "                         and print the mean, variance, minimum, maximum and quantiles of the results\n"
+             "      --sample VAR FROM TO N\n"
+             "                         Calculate every expression for N values of the variable VAR spread evenly over\n"
+             "                         [FROM, TO] on all processors, and write them as a CSV table for every expression\n"
+             "      --adaptive         Let --sample add values where the function curves or jumps, or where it fails\n"
+             "  -p, --profile FILE     Measure the calls of every function and write a report of them to FILE when done,\n"
+             "                         use - for the standard output\n"
+             "      --trace FILE       Like --profile, but write every call to FILE as a Chrome trace (JSON)\n"
+             "  -h, --help             Show this help\n";
+    }
+
+    // Converts the name of an output type to the output type, returns false if the name is unknown
+    bool outputTypeFromName(const calc::string& name, calc::realOutputType& type)
+    {
+        if(name == "auto")              type = calc::outputType_auto;
+        else if(name == "scientific")   type = calc::outputType_scientific;
+        else if(name == "bin")          type = calc::outputType_bin;
+        else if(name == "oct")          type = calc::outputType_oct;
+        else if(name == "dec")          type = calc::outputType_dec;
+        else if(name == "hex")          type = calc::outputType_hex;
+        else if(name == "time")         type = calc::outputType_time;
+        else                            return false;
+        return true;
+    }
+
+    // Splits a formula of the form NAME=EXPR, if there is no name the expression itself is the name
+    void splitFormula(const calc::string& formula, calc::string& name, calc::string& expression)
+    {
+        // The part before the first '=' is the name if it's a valid name
+        const size_t assignment = formula.find('=');
+        name = formula.substr(0, assignment);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        bool validName = (assignment != calc::string::npos && !name.empty() && !std::isdigit(name[0]));
+        for(calc::string::const_iterator pos = name.begin(); pos != name.end() && validName; ++pos)
+            validName = (std::isalnum(*pos) || *pos == '_');
+
+        if(validName)
+            expression = formula.substr(assignment + 1);
+        else
+            name = expression = formula;
+    }
+
+    // Gets the name of a plugin from the name of its source file, i.e. the file name without the directory and the extension
+    calc::string pluginName(const calc::string& fileName)
+    {
+        calc::string name = fileName.substr(fileName.find_last_of("/\\") + 1);
+        return name.substr(0, name.find('.'));
+    }
+
+    // Writes the measurements of the profiler to the files that were asked for when it's destroyed, i.e. when the program ends
+    struct profileWriter
+    {
+        ~profileWriter()
+        {
+            write(reportFile, false);
+            write(traceFile, true);
+        }
+
+        // Write the report or the trace to a file, "-" means stdout
+        static void write(const calc::string& fileName, const bool& trace)
+        {
+            if(fileName.empty())
+                return;
+            std::ofstream file;
+            if(fileName != "-")
+                file.open(fileName.c_str());
+            std::ostream& out = (fileName == "-" ? std::cout : file);
+            if(trace)
+                calc::profiler::writeChromeTrace(out);
+            else
+                calc::profiler::writeReport(out);
+            if(!out.flush())
+                std::cerr<<"Couldn't write the profile to "<<fileName<<std::endl;
+        }
+
+        calc::string reportFile;            // The file the report is written to, if any
+        calc::string traceFile;             // The file the trace is written to, if any
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    // The options, set by the command line arguments
+    calc::realOutputType outputType = calc::outputType_auto;
+    calc::string numberType;
+    int digits = 0;
+    calc::builtIns::angleType angleType = calc::builtIns::angleRadians;
+    calc::string seed;
+    calc::string settingsFile;
+    calc::string pluginDirectory;
+    calc::string exportFile;
+    calc::string batchInput = "-";
+    calc::string batchOutput = "-";
+    std::vector<calc::string> expressions;
+    calc::string tableInput;
+    calc::string tableOutput;
+    bool binaryTable = false;
+    char separator = ',';
+    std::vector<calc::string> formulas;
+    unsigned long long sampleCount = 0;
+    calc::string sampleVariable;
+    calc::real sampleFrom = 0;
+    calc::real sampleTo = 0;
+    unsigned long long sampleValues = 0;
+    bool adaptive = false;
+    profileWriter profile;
+
+    // Read the command line arguments
+    for(int i = 1; i < argc; ++i)
+    {
+        const calc::string arg = argv[i];
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        else if(arg == "-d" || arg == "--degrees")
+            angleType = calc::builtIns::angleDegrees;
+        else if(arg == "--seed" && i+1 < argc)
+            seed = argv[++i];
+        else if((arg == "-o" || arg == "--output") && i+1 < argc)
+        {
+            if(!outputTypeFromName(argv[++i], outputType))
+            {
+                std::cerr<<"Unknown output type: "<<argv[i]<<std::endl;
+                return 2;
+            }
+        }
+        else if((arg == "-n" || arg == "--numbers") && i+1 < argc)
+            numberType = argv[++i];
+        else if(arg == "--digits" && i+1 < argc)
+        {
+            digits = std::atoi(argv[++i]);
+            if(digits <= 0)
+            {
+                std::cerr<<"Invalid number of digits: "<<argv[i]<<std::endl;
+                return 2;
+            }
+        }
+        else if((arg == "-s" || arg == "--settings") && i+1 < argc)
+            settingsFile = argv[++i];
+        else if(arg == "--plugins" && i+1 < argc)
+            pluginDirectory = argv[++i];
+        else if(arg == "--export-native" && i+1 < argc)
+            exportFile = argv[++i];
+        else if((arg == "-b" || arg == "--batch") && i+2 < argc)
+        {
+            batchInput = argv[++i];
+            batchOutput = argv[++i];
+        }
+        else if((arg == "-t" || arg == "--table" || arg == "--binary-table") && i+2 < argc)
+        {
+            binaryTable = (arg == "--binary-table");
+            tableInput = argv[++i];
+            tableOutput = argv[++i];
+        }
+        else if((arg == "-f" || arg == "--formula") && i+1 < argc)
+            formulas.push_back(argv[++i]);
+        else if(arg == "--separator" && i+1 < argc && std::strlen(argv[i+1]) == 1)
+            separator = argv[++i][0];
+        else if((arg == "-m" || arg == "--monte-carlo") && i+1 < argc)
+        {
+            sampleCount = std::strtoull(argv[++i], 0, 10);
+            if(sampleCount == 0)
+            {
+                std::cerr<<"Invalid number of samples: "<<argv[i]<<std::endl;
+                return 2;
+            }
+        }
+        else if(arg == "--sample" && i+4 < argc)
+        {
+            sampleVariable = argv[++i];
+            sampleFrom = std::strtod(argv[++i], 0);
+            sampleTo = std::strtod(argv[++i], 0);
+            sampleValues = std::strtoull(argv[++i], 0, 10);
+            if(sampleValues < 2 || !(sampleFrom != sampleTo))
+            {
+                std::cerr<<"Invalid samples: "<<argv[i-2]<<" to "<<argv[i-1]<<", "<<argv[i]<<" values"<<std::endl;
+                return 2;
+            }
+        }
+        else if(arg == "--adaptive")
+            adaptive = true;
+        else if((arg == "-p" || arg == "--profile") && i+1 < argc)
+            profile.reportFile = argv[++i];
+        else if(arg == "--trace" && i+1 < argc)
+            profile.traceFile = argv[++i];
+        else if(arg.size() > 1 && arg[0] == '-' && !std::strchr("0123456789.(", arg[1]))
+        {
+            // Arguments starting with a minus are options, unless they look like the start of an expression
+            printUsage(std::cerr);
+            return 2;
+        }
+        else
+            expressions.push_back(arg);
+    }
+
+    // Create the number type, the name of long double is written with a dash so it doesn't have to be quoted
+    std::shared_ptr<const calc::numberBackend> backend;
+    if(!numberType.empty())
+    {
+        calc::string name = numberType;
+        std::replace(name.begin(), name.end(), '-', ' ');
+        backend = calc::numberBackend::create(name, digits);
+        if(!backend)
+        {
+            std::cerr<<"Unknown number type: "<<numberType<<std::endl;
+            return 2;
+        }
+    }
+
+    // Measure the function calls only if the measurements are written somewhere
+    calc::profiler::setEnabled(!profile.reportFile.empty() || !profile.traceFile.empty());
+
+    // Create the calculator, the built-in functions and the plugins need to outlive it
+    calc::builtIns builtIns(angleType);
+    calc::pluginLoader plugins;
+    calc::calc calculator;
+    builtIns.addTo(calculator);
+    if(!seed.empty())
+        calc::calc::setRandomSeed(std::strtoull(seed.c_str(), 0, 10));
+
+    // Add the functions of the plugins, plugins that couldn't be loaded are reported but don't stop the calculator
+    if(!pluginDirectory.empty())
+    {
+        const std::vector<calc::string> errors = plugins.loadDirectory(pluginDirectory);
+        for(std::vector<calc::string>::const_iterator pos = errors.begin(); pos != errors.end(); ++pos)
+            std::cerr<<"Couldn't load the plugin "<<*pos<<std::endl;
+        plugins.addTo(calculator);
+    }
+
+    // Load the variables and functions of the user
+    calc::settingHandler settings;
+    if(!settingsFile.empty())
+    {
+        try
+        {
+            settings.loadFromFile(settingsFile);
+            if(!settings.copyToCalculator(calculator))
+                throw calc::parseError("Corrupted file", settingsFile);
+        }
+        catch(calc::parseError& err)
+        {
+            std::cerr<<"Couldn't load the settings from "<<settingsFile<<": "<<err.msg<<std::endl;
+            return 2;
+        }
+        catch(calc::fileError& err)
+        {
+            std::cerr<<"Couldn't load the settings from "<<err.fileName<<std::endl;
+            return 2;
+        }
+    }
+
+    // Export the functions of the user to C++, the functions that can't be exported are reported
+    if(!exportFile.empty())
+    {
+        try
+        {
+            const std::vector<calc::string> messages = calc::nativeExporter(settings).saveSource(exportFile, pluginName(exportFile));
+            for(std::vector<calc::string>::const_iterator pos = messages.begin(); pos != messages.end(); ++pos)
+                std::cerr<<"Couldn't export "<<*pos<<std::endl;
+            return 0;
+        }
+        catch(calc::fileError& err)
+        {
+            std::cerr<<"Couldn't write to "<<err.fileName<<std::endl;
+            return 2;
+        }
+    }
+
+    // Functions of the user that have been exported to a plugin are executed by the plugin
+    plugins.useCompiled(calculator);
+
+    // Evaluate the formulas over a table
+    if(!tableInput.empty())
+    {
+        if(formulas.empty())
+        {
+            std::cerr<<"No formulas given for the table"<<std::endl;
+            return 2;
+        }
+
+        cli::tableEvaluator table(outputType);
+        table.setSeparator(separator);
+        for(std::vector<calc::string>::const_iterator pos = formulas.begin(); pos != formulas.end(); ++pos)
+        {
+            calc::string name, expression;
+            splitFormula(*pos, name, expression);
+            try
+            { table.addFormula(name, expression); }
+            catch(calc::calcError& err)
+            {
+                std::cerr<<"error in formula "<<name<<": "<<cli::errorMessage(err)<<std::endl;
+                return 2;
+            }
+        }
+
+        try
+        {
+            if(binaryTable)
+                table.runBinary(tableInput, tableOutput);
+            else
+                table.runCsv(tableInput, tableOutput);
+        }
+        catch(calc::fileError& err)
+        {
+            std::cerr<<"Couldn't "<<(err.action == calc::fileError::action_writing ? "write to " : "read from ")<<err.fileName<<std::endl;
+            return 2;
+        }
+
+        // Report the cells that couldn't be calculated
+        if(table.getErrorCount() > 0)
+        {
+            std::cerr<<table.getErrorCount()<<" cell(s) couldn't be calculated, the first error: "<<cli::errorMessage(table.getFirstError())<<std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // The threads of --monte-carlo and --sample can't share the calculator, so they use a context with the same functions and variables
+    calc::context definitions;
+    if(sampleCount > 0 || sampleValues > 0)
+    {
+        builtIns.addTo(definitions);
+        plugins.addTo(definitions);
+        settings.copyToContext(definitions);
+        plugins.useCompiled(definitions);
+        definitions.setRandomSeed(calc::calc::getRandomSeed());
+    }
+
+    // Calculate every expression many times and write the statistics of the results
+    if(sampleCount > 0)
+    {
+        if(expressions.empty())
+        {
+            std::cerr<<"No expressions given for the Monte Carlo simulation"<<std::endl;
+            return 2;
+        }
+
+        const calc::monteCarlo simulation;
+        int exitCode = 0;
+        for(std::vector<calc::string>::const_iterator pos = expressions.begin(); pos != expressions.end(); ++pos)
+        {
+            try
+            {
+                const calc::monteCarlo::summary result = simulation.run(definitions, *calc::context::compile(*pos), sampleCount);
+                if(result.errorCount > 0)
+                {
+                    std::cerr<<result.errorCount<<" sample(s) of "<<*pos<<" couldn't be calculated, the first error: "<<cli::errorMessage(result.firstError)<<std::endl;
+                    exitCode = 1;
+                }
+                if(result.skipped > 0)
+                    std::cerr<<result.skipped<<" result(s) of "<<*pos<<" aren't finite numbers, they're left out"<<std::endl;
+                if(result.statistics.getCount() == 0)
+                    continue;
+
+                std::cout<<"mean "<<calc::real2str(result.statistics.getMean(), outputType)
+                         <<", variance "<<calc::real2str(result.statistics.getVariance(), outputType)
+                         <<", minimum "<<calc::real2str(result.statistics.getMinimum(), outputType)
+                         <<", maximum "<<calc::real2str(result.statistics.getMaximum(), outputType);
+                for(size_t i = 0; i < result.quantiles.size(); ++i)
+                    std::cout<<", "<<calc::real2str(simulation.getProbabilities()[i] * 100)<<"% "<<calc::real2str(result.quantiles[i], outputType);
+                std::cout<<" ("<<result.statistics.getCount()<<" samples)"<<'\n';
+            }
+            catch(calc::calcError& err)
+            {
+                std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+                exitCode = 1;
+            }
+            catch(calc::overflowError& err)
+            {
+                std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+                exitCode = 1;
+            }
+        }
+        return exitCode;
+    }
+
+    // Calculate every expression for many values of a variable and write a table of them
+    if(sampleValues > 0)
+    {
+        if(expressions.empty())
+        {
+            std::cerr<<"No expressions given to sample"<<std::endl;
+            return 2;
+        }
+
+        const calc::functionSampler sampler;
+        int exitCode = 0;
+        for(std::vector<calc::string>::const_iterator pos = expressions.begin(); pos != expressions.end(); ++pos)
+        {
+            try
+            {
+                const std::shared_ptr<const calc::program> prog = calc::context::compile(*pos);
+                const std::vector<calc::functionSampler::sample> samples = adaptive ? sampler.adaptive(definitions, *prog, sampleVariable, sampleFrom, sampleTo, sampleValues)
+                                                                                    : sampler.uniform(definitions, *prog, sampleVariable, sampleFrom, sampleTo, sampleValues);
+
+                // The tables are separated by an empty line, the values that couldn't be calculated are left empty
+                if(pos != expressions.begin())
+                    std::cout<<'\n';
+                std::cout<<sampleVariable<<separator<<'"'<<*pos<<'"'<<'\n';
+                size_t failed = 0;
+                for(size_t i = 0; i < samples.size(); ++i)
+                {
+                    std::cout<<calc::real2str(samples[i].x, outputType)<<separator;
+                    if(samples[i].failed)
+                        ++failed;
+                    else
+                        std::cout<<calc::real2str(samples[i].y, outputType);
+                    std::cout<<'\n';
+                }
+                if(failed > 0)
+                    std::cerr<<failed<<" sample(s) of "<<*pos<<" couldn't be calculated"<<std::endl;
+            }
+            catch(calc::calcError& err)
+            {
+                std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+                exitCode = 1;
+            }
+            catch(calc::overflowError& err)
+            {
+                std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+                exitCode = 1;
+            }
+        }
+        return exitCode;
+    }
+
+    // Without any expressions, run all lines of the input through the batch pipeline
+    if(expressions.empty())
+    {
+        try
+        {
+            cli::batchEvaluator batch(outputType);
+            batch.run(batchInput, batchOutput);
+            return 0;
+        }
+        catch(calc::fileError& err)
+        {
+            std::cerr<<"Couldn't "<<(err.action == calc::fileError::action_writing ? "write to " : "read from ")<<err.fileName<<std::endl;
+            return 2;
+        }
+    }
+
+    // Otherwise calculate the expressions one by one
+    int exitCode = 0;
+    for(std::vector<calc::string>::const_iterator pos = expressions.begin(); pos != expressions.end(); ++pos)
+    {
+        try
+        {
+            calc::benchmarkMathFunction::forgetLastResult();
+            const bool isTime = (outputType == calc::outputType_auto && pos->find(':') != calc::string::npos);
+
+            // Another number type executes the compiled expression on the variables and functions of the calculator
+            if(backend)
+            {
+                calc::calcEnvironment env;
+                std::cout<<backend->execute(*calc::context::compile(*pos), env, isTime ? calc::outputType_time : outputType)<<'\n';
+                continue;
+            }
+
+            const calc::real result = calculator.calculate(*pos);
+            calc::integer exact = 0;
+            if(calculator.getIntegerResult(exact))
+                std::cout<<calc::integer2str(exact, isTime ? calc::outputType_time : outputType)<<'\n';
+            else
+                std::cout<<calc::real2str(result, isTime ? calc::outputType_time : outputType)<<'\n';
+
+            // The spread measured by BENCH() doesn't fit in the result, so it's reported separately
+            calc::benchmarkMathFunction::result bench;
+            if(calc::benchmarkMathFunction::takeLastResult(bench))
+                std::cerr<<"BENCH: median "<<bench.median<<" ns, fastest "<<bench.minimum<<" ns, slowest "<<bench.maximum<<" ns ("
+                         <<bench.runs<<" runs in "<<bench.samples<<" samples)"<<std::endl;
+        }
+        catch(calc::calcError& err)
+        {
+            std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+            exitCode = 1;
+        }
+        catch(calc::overflowError& err)
+        {
+            std::cerr<<"error: "<<cli::errorMessage(err)<<std::endl;
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
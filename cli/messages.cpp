@@ -0,0 +1,106 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "messages.h"
+
+namespace cli
+{
+    calc::string errorMessage(const calc::calcError& err)
+    {
+        // Find out what message should be displayed, this mirrors QTCalc::calcErrorOccurred()
+        const calc::string firstString = err.extraStringInfo.size() > 0 ? err.extraStringInfo[0] : "";
+        switch(err.type)
+        {
+            case calc::calcError::unknownToken:
+                if(err.extraRealInfo.size() > 0)
+                    return "Unknown token: '"+firstString+"', at position "+calc::real2str(err.extraRealInfo[0] + 1);
+            return "Unknown token: '"+firstString+"'";
+
+            case calc::calcError::unexpectedToken:
+                if(err.msg == "Unexptected '.'")
+                    return "Unexpected '.' in a number";
+                if(err.msg == "Unexpected token" && err.extraRealInfo.size() > 0)
+                    return "Unexpected token: '"+firstString+"', at position "+calc::real2str(err.extraRealInfo[0] + 1);
+            return "Unexpected token: '"+firstString+"'";
+
+            case calc::calcError::unclosedBracket:
+            return "You didn't close all brackets, "+calc::real2str(err.extraRealInfo[0])+" brackets still need to be closed!";
+
+            case calc::calcError::invalidExpression:
+                if(err.extraStringInfo.size() == 1)
+                    return "Invalid expression: '"+firstString+"'";
+                if(err.extraStringInfo.size() > 1)
+                    return "Invalid expression: '"+firstString+"', in function "+err.extraStringInfo[1];
+            return "Invalid expression";
+
+            case calc::calcError::invalidOperands:
+                if(err.msg == "No negative roots allowed")
+                    return "Can't take the root of a negative value";
+                if(err.msg == "Only integer powers of negative numbers")
+                    return "Only integer powers of negative numbers are allowed";
+                if(err.msg == "Division by 0")
+                    return "Can't divide by 0!";
+                if(err.msg == "Modulo by 0")
+                    return "Can't modulo by 0!";
+            return "Invalid operands";
+
+            case calc::calcError::invalidArguments:
+                if((err.msg == "Too less arguments" || err.msg == "Too many arguments") && err.extraRealInfo.size() > 1)
+                    return calc::string(err.msg == "Too less arguments" ? "To less" : "To many")+" arguments: "+calc::real2str(err.extraRealInfo[0])+" given, "+calc::real2str(err.extraRealInfo[1])+" expected in function "+firstString;
+                if(err.msg == "Only integers allowed")
+                    return "Only integer arguments are allowed in function "+firstString;
+                if(err.msg == "Not a variable" && err.extraRealInfo.size() > 0)
+                    return "Argument "+calc::real2str(err.extraRealInfo[0])+" of function "+firstString+" should be the name of a variable";
+                if(err.msg == "No root found" && err.extraRealInfo.size() > 0)
+                    return "No root found by function "+firstString+" near "+calc::real2str(err.extraRealInfo[0]);
+                if(err.msg == "Too many terms" && err.extraRealInfo.size() > 0)
+                    return "Function "+firstString+" can't calculate more than "+calc::real2str(err.extraRealInfo[0])+" terms";
+                if(err.msg == "No convergence" && err.extraRealInfo.size() > 0)
+                    return "Function "+firstString+" doesn't converge, the best estimate is "+calc::real2str(err.extraRealInfo[0]);
+                if(err.extraRealInfo.size() > 0)
+                    return "Invalid argument: "+calc::real2str(err.extraRealInfo[0])+", given to function "+firstString;
+            return "Invalid argument given to function "+firstString;
+
+            case calc::calcError::unknownName:
+            return err.msg+": "+firstString;
+
+            case calc::calcError::emptyExpression:
+            return "Can't calculate an empty expression!";
+
+            case calc::calcError::recursiveCall:
+            return "A function may not (indirectly) call itself, "+firstString+" does";
+
+            default:
+            return "An unknown error has occurred!";
+        }
+    }
+
+    calc::string errorMessage(const calc::overflowError& err)
+    {
+        // Find out the right message, depending on the type of overflow
+        switch(err.type)
+        {
+            case calc::overflowError::bin:
+            return "Value too big to convert to binary";
+            case calc::overflowError::oct:
+            return "Value too big to convert to octal";
+            default:
+            return "Value too big to convert to hexadecimal";
+        }
+    }
+}
@@ -0,0 +1,32 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+#include "calc/calc.h"
+
+namespace cli
+{
+    // Get a human readable message describing the given calculator error, these are the same messages as the GUI shows
+    calc::string errorMessage(const calc::calcError& err);
+    // Get a human readable message describing the given overflow error
+    calc::string errorMessage(const calc::overflowError& err);
+}
+
+#endif // MESSAGES_H
@@ -0,0 +1,488 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "table.h"
+#include "messages.h"
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace cli
+{
+    // Public:
+        tableEvaluator::tableEvaluator(const calc::realOutputType& outputType)
+        : outputType(outputType), separator(','), blockRows(4096), inputCount(0), errorCount(0) {}
+
+        void tableEvaluator::setSeparator(const char& separator)
+        { this->separator = separator; }
+
+        void tableEvaluator::setBlockRows(const size_t& rows)
+        { blockRows = rows > 0 ? rows : 1; }
+
+        void tableEvaluator::addFormula(const calc::string& name, const calc::string& expression)
+        {
+            // Parse the expression, throwing the first error if there is one
+            formula form;
+            form.name = name;
+            form.calculator.reset(new calc::calc(expression, false));
+            form.calculator->parse();
+            if(!form.calculator->isValidExpression())
+                throw form.calculator->getParseErrors()->front();
+
+            // Compile the expression right away, if that fails it's interpreted row by row
+            form.calculator->getProgram();
+            formulas.push_back(std::move(form));
+        }
+
+        unsigned long long tableEvaluator::runCsv(const calc::string& inputFile, const calc::string& outputFile)
+        {
+            // Open the files
+            std::FILE* in = (inputFile == "-" ? stdin : std::fopen(inputFile.c_str(), "rb"));
+            if(in == 0)
+                throw calc::fileError(inputFile, calc::fileError::action_opening);
+            std::FILE* out = (outputFile == "-" ? stdout : std::fopen(outputFile.c_str(), "wb"));
+            if(out == 0)
+            {
+                if(in != stdin)
+                    std::fclose(in);
+                throw calc::fileError(outputFile, calc::fileError::action_opening);
+            }
+
+            // The results of a formula containing a time are written as a time
+            std::vector<calc::realOutputType> outputTypes(formulas.size(), outputType);
+            for(size_t i = 0; i < formulas.size(); ++i)
+            {
+                if(outputType == calc::outputType_auto && formulas[i].calculator->getExpression().find(':') != calc::string::npos)
+                    outputTypes[i] = calc::outputType_time;
+            }
+
+            errorCount = 0;
+            unsigned long long rowCount = 0;
+            bool writeFailed = false;
+            try
+            {
+                // The first record holds the names of the columns, the input columns used by the formulas are bound to them
+                calc::string record;
+                std::vector<calc::string> fields;
+                std::vector<int> inputColumns;
+                if(!readRecord(in, record))
+                    throw calc::fileError(inputFile, calc::fileError::action_reading);
+                splitRecord(record, fields);
+                bind(fields, inputColumns);
+
+                // Write the header, with the names of the formulas added to it
+                calc::string output = record;
+                for(size_t i = 0; i < formulas.size(); ++i)
+                {
+                    output += separator;
+                    appendField(output, formulas[i].name);
+                }
+                output += '\n';
+
+                // Handle the rows in blocks
+                std::vector<calc::string> records(blockRows);
+                bool endOfFile = false;
+                while(!endOfFile)
+                {
+                    // Read a block of records
+                    size_t count = 0;
+                    while(count < blockRows && !(endOfFile = !readRecord(in, records[count])))
+                        ++count;
+
+                    // Convert the fields of the input columns to values
+                    for(size_t i = 0; i < inputCount; ++i)
+                    {
+                        columns[i].values.assign(count, 0);
+                        columns[i].failed.assign(count, 0);
+                        columns[i].errors.clear();
+                    }
+                    for(size_t row = 0; row < count; ++row)
+                    {
+                        splitRecord(records[row], fields);
+                        for(size_t i = 0; i < inputCount; ++i)
+                        {
+                            // Trim the field, an empty field can't be converted
+                            const calc::string field = inputColumns[i] < static_cast<int>(fields.size()) ? fields[inputColumns[i]] : "";
+                            const size_t start = field.find_first_not_of(" \t");
+                            if(start == calc::string::npos)
+                            {
+                                columns[i].failed[row] = 1;
+                                columns[i].errors[row] = calc::calcError("Empty expression", calc::calcError::emptyExpression);
+                                continue;
+                            }
+                            const calc::string value = field.substr(start, field.find_last_not_of(" \t") - start + 1);
+
+                            // Numbers are converted the same way the calculator converts them, a field that isn't a number is an unknown token
+                            try
+                            { columns[i].values[row] = (value.find(':') != calc::string::npos ? calc::timestr2real(value, true) : calc::str2real(value, true)); }
+                            catch(calc::calcError&)
+                            {
+                                columns[i].failed[row] = 1;
+                                columns[i].errors[row] = calc::calcError("Unknown token", calc::calcError::unknownToken, value);
+                            }
+                        }
+                    }
+
+                    // Evaluate the formulas for the whole block
+                    evaluate(count);
+
+                    // Write the records, with the results added to them
+                    for(size_t row = 0; row < count; ++row)
+                    {
+                        output += records[row];
+                        for(size_t i = 0; i < formulas.size(); ++i)
+                        {
+                            const column& result = columns[inputCount + i];
+                            output += separator;
+                            if(result.failed[row])
+                            {
+                                appendField(output, "error: "+errorMessage(result.errors.find(row)->second));
+                                continue;
+                            }
+                            try
+                            { appendField(output, calc::real2str(result.values[row], outputTypes[i])); }
+                            catch(calc::overflowError& err)
+                            { appendField(output, "error: "+errorMessage(err)); }
+                        }
+                        output += '\n';
+                    }
+                    if(std::fwrite(output.data(), 1, output.size(), out) != output.size())
+                    {
+                        writeFailed = true;
+                        throw calc::fileError(outputFile, calc::fileError::action_writing);
+                    }
+                    output.clear();
+                    rowCount += count;
+                }
+                if(std::fflush(out) != 0)
+                {
+                    writeFailed = true;
+                    throw calc::fileError(outputFile, calc::fileError::action_writing);
+                }
+            }
+            catch(...)
+            {
+                if(in != stdin)
+                    std::fclose(in);
+                if(out != stdout)
+                    std::fclose(out);
+                throw;
+            }
+
+            // Close the files
+            if(in != stdin)
+                std::fclose(in);
+            if(out != stdout && std::fclose(out) != 0 && !writeFailed)
+                throw calc::fileError(outputFile, calc::fileError::action_writing);
+            return rowCount;
+        }
+
+        unsigned long long tableEvaluator::runBinary(const calc::string& inputDir, const calc::string& outputDir)
+        {
+            // The input columns are the variables of the formulas for which a file exists
+            std::vector<calc::string> inputNames;
+            for(std::vector<formula>::const_iterator form = formulas.begin(); form != formulas.end(); ++form)
+            {
+                const calc::program* prog = form->calculator->getProgram();
+                if(prog == 0)
+                    continue;
+                for(std::vector<calc::string>::const_iterator name = prog->getVariables().begin(); name != prog->getVariables().end(); ++name)
+                {
+                    if(std::find(inputNames.begin(), inputNames.end(), *name) == inputNames.end())
+                        inputNames.push_back(*name);
+                }
+            }
+
+            // Open the files of the input columns, and find out the number of rows
+            std::vector<std::FILE*> inputFiles;
+            std::vector<calc::string> existingNames;
+            std::vector<std::FILE*> outputFiles;
+            long rowCount = -1;
+            try
+            {
+                for(std::vector<calc::string>::const_iterator name = inputNames.begin(); name != inputNames.end(); ++name)
+                {
+                    std::FILE* file = std::fopen((inputDir+"/"+*name+".f64").c_str(), "rb");
+                    if(file == 0)
+                        continue;
+                    inputFiles.push_back(file);
+                    existingNames.push_back(*name);
+
+                    // All columns need to have the same number of rows
+                    std::fseek(file, 0, SEEK_END);
+                    const long rows = std::ftell(file) / static_cast<long>(sizeof(calc::real));
+                    std::fseek(file, 0, SEEK_SET);
+                    if(rowCount >= 0 && rows != rowCount)
+                        throw calc::fileError(inputDir+"/"+*name+".f64", calc::fileError::action_reading);
+                    rowCount = rows;
+                }
+                if(rowCount < 0)
+                    throw calc::fileError(inputDir, calc::fileError::action_reading);
+
+                // Bind the formulas to the columns
+                std::vector<int> inputColumns;
+                bind(existingNames, inputColumns);
+
+                // Create the output files
+                for(std::vector<formula>::const_iterator form = formulas.begin(); form != formulas.end(); ++form)
+                {
+                    outputFiles.push_back(std::fopen((outputDir+"/"+form->name+".f64").c_str(), "wb"));
+                    if(outputFiles.back() == 0)
+                        throw calc::fileError(outputDir+"/"+form->name+".f64", calc::fileError::action_opening);
+                }
+
+                // Handle the rows in blocks
+                errorCount = 0;
+                for(long first = 0; first < rowCount; first += blockRows)
+                {
+                    const size_t count = std::min(blockRows, static_cast<size_t>(rowCount - first));
+                    for(size_t i = 0; i < inputCount; ++i)
+                    {
+                        column& col = columns[i];
+                        col.values.resize(count);
+                        col.failed.assign(count, 0);
+                        if(std::fread(&col.values[0], sizeof(calc::real), count, inputFiles[inputColumns[i]]) != count)
+                            throw calc::fileError(inputDir+"/"+col.name+".f64", calc::fileError::action_reading);
+                    }
+                    evaluate(count);
+                    for(size_t i = 0; i < formulas.size(); ++i)
+                    {
+                        if(std::fwrite(&columns[inputCount + i].values[0], sizeof(calc::real), count, outputFiles[i]) != count)
+                            throw calc::fileError(outputDir+"/"+formulas[i].name+".f64", calc::fileError::action_writing);
+                    }
+                }
+            }
+            catch(...)
+            {
+                for(size_t i = 0; i < inputFiles.size(); ++i)
+                    std::fclose(inputFiles[i]);
+                for(size_t i = 0; i < outputFiles.size(); ++i)
+                {
+                    if(outputFiles[i] != 0)
+                        std::fclose(outputFiles[i]);
+                }
+                throw;
+            }
+
+            // Close the files
+            for(size_t i = 0; i < inputFiles.size(); ++i)
+                std::fclose(inputFiles[i]);
+            for(size_t i = 0; i < outputFiles.size(); ++i)
+            {
+                if(std::fclose(outputFiles[i]) != 0)
+                    throw calc::fileError(outputDir+"/"+formulas[i].name+".f64", calc::fileError::action_writing);
+            }
+            return rowCount;
+        }
+
+        unsigned long long tableEvaluator::getErrorCount() const
+        { return errorCount; }
+
+        const calc::calcError& tableEvaluator::getFirstError() const
+        { return firstError; }
+
+    // Private:
+        void tableEvaluator::bind(const std::vector<calc::string>& inputNames, std::vector<int>& inputColumns)
+        {
+            // Find the input columns that are used by the formulas, the results of earlier formulas hide input columns with the same name
+            // A formula that couldn't be compiled gets all input columns
+            inputColumns.clear();
+            for(size_t i = 0; i < formulas.size(); ++i)
+            {
+                const calc::program* prog = formulas[i].calculator->getProgram();
+                for(size_t input = 0; input < inputNames.size(); ++input)
+                {
+                    bool used = (prog == 0);
+                    for(size_t slot = 0; prog != 0 && slot < prog->getVariables().size() && !used; ++slot)
+                        used = (prog->getVariables()[slot] == inputNames[input]);
+                    for(size_t j = 0; j < i && used; ++j)
+                        used = (formulas[j].name != inputNames[input]);
+                    if(used && std::find(inputColumns.begin(), inputColumns.end(), static_cast<int>(input)) == inputColumns.end())
+                        inputColumns.push_back(input);
+                }
+            }
+
+            // Create the columns, first the inputs then the results
+            inputCount = inputColumns.size();
+            columns.assign(inputCount + formulas.size(), column());
+            for(size_t i = 0; i < inputCount; ++i)
+                columns[i].name = inputNames[inputColumns[i]];
+            for(size_t i = 0; i < formulas.size(); ++i)
+                columns[inputCount + i].name = formulas[i].name;
+
+            // Bind the variables of every formula to the latest column with the same name before the column of the formula itself
+            for(size_t i = 0; i < formulas.size(); ++i)
+            {
+                const calc::program* prog = formulas[i].calculator->getProgram();
+                formulas[i].sources.assign(prog != 0 ? prog->getVariables().size() : 0, -1);
+                for(size_t slot = 0; slot < formulas[i].sources.size(); ++slot)
+                {
+                    for(size_t col = 0; col < inputCount + i; ++col)
+                    {
+                        if(columns[col].name == prog->getVariables()[slot])
+                            formulas[i].sources[slot] = col;
+                    }
+                }
+            }
+        }
+
+        void tableEvaluator::evaluate(const size_t& rowCount)
+        {
+            calc::calcEnvironment env;
+            std::vector<calc::program::rowError> rowErrors;
+            std::vector<const calc::real*> bound;
+            for(size_t i = 0; i < formulas.size(); ++i)
+            {
+                formula& form = formulas[i];
+                column& result = columns[inputCount + i];
+                result.values.assign(rowCount, 0);
+                result.failed.assign(rowCount, 0);
+                result.errors.clear();
+                if(rowCount == 0)
+                    continue;
+
+                // Without a program the formula is interpreted
+                const calc::program* prog = form.calculator->getProgram();
+                if(prog == 0)
+                {
+                    interpret(form, result, rowCount);
+                    continue;
+                }
+
+                // Rows in which one of the bound columns failed, fail with the same error
+                bound.assign(form.sources.size(), 0);
+                for(size_t slot = 0; slot < form.sources.size(); ++slot)
+                {
+                    if(form.sources[slot] < 0)
+                        continue;
+                    const column& source = columns[form.sources[slot]];
+                    bound[slot] = &source.values[0];
+                    for(std::map<size_t, calc::calcError>::const_iterator err = source.errors.begin(); err != source.errors.end(); ++err)
+                    {
+                        if(!result.failed[err->first])
+                            failCell(result, err->first, err->second);
+                    }
+                }
+
+                // Execute the program for all other rows
+                rowErrors.clear();
+                prog->executeBlock(env, bound, rowCount, &result.values[0], &result.failed[0], rowErrors);
+                for(std::vector<calc::program::rowError>::const_iterator err = rowErrors.begin(); err != rowErrors.end(); ++err)
+                    failCell(result, err->row, err->error);
+            }
+        }
+
+        void tableEvaluator::interpret(formula& form, column& result, const size_t& rowCount)
+        {
+            // The columns before the result column are set as variables
+            const size_t sourceCount = &result - &columns[0];
+            for(size_t row = 0; row < rowCount; ++row)
+            {
+                try
+                {
+                    for(size_t col = 0; col < sourceCount; ++col)
+                        form.calculator->setVar(columns[col].name, columns[col].failed[row] ? std::numeric_limits<calc::real>::quiet_NaN() : columns[col].values[row]);
+                    result.values[row] = form.calculator->calculate();
+                }
+                catch(calc::calcError& err)
+                { failCell(result, row, err); }
+            }
+        }
+
+        void tableEvaluator::failCell(column& col, const size_t& row, const calc::calcError& error)
+        {
+            // Remember the error, and count it
+            col.failed[row] = 1;
+            col.values[row] = std::numeric_limits<calc::real>::quiet_NaN();
+            col.errors[row] = error;
+            if(errorCount++ == 0)
+                firstError = error;
+        }
+
+        void tableEvaluator::splitRecord(const calc::string& record, std::vector<calc::string>& fields) const
+        {
+            fields.assign(1, calc::string());
+            bool quoted = false;
+            for(size_t i = 0; i < record.size(); ++i)
+            {
+                const char chr = record[i];
+                if(quoted)
+                {
+                    // Inside quotes everything is part of the field, except a quote which is written as two quotes
+                    if(chr != '"')
+                        fields.back() += chr;
+                    else if(i+1 < record.size() && record[i+1] == '"')
+                        fields.back() += record[++i];
+                    else
+                        quoted = false;
+                }
+                else if(chr == '"')
+                    quoted = true;
+                else if(chr == separator)
+                    fields.push_back(calc::string());
+                else
+                    fields.back() += chr;
+            }
+        }
+
+        bool tableEvaluator::readRecord(std::FILE* in, calc::string& record) const
+        {
+            // Read lines until the number of quotes is even, i.e. the record doesn't end inside a quoted field
+            record.clear();
+            char buffer[4096];
+            size_t quotes = 0;
+            size_t counted = 0;
+            bool anything = false;
+            while(std::fgets(buffer, sizeof(buffer), in) != 0)
+            {
+                anything = true;
+                record += buffer;
+                if(record[record.size()-1] != '\n')
+                    continue;
+                quotes += std::count(record.begin() + counted, record.end(), '"');
+                counted = record.size();
+                if(quotes % 2 == 0)
+                    break;
+            }
+
+            // Remove the line ending
+            if(!record.empty() && record[record.size()-1] == '\n')
+                record.erase(record.size()-1);
+            if(!record.empty() && record[record.size()-1] == '\r')
+                record.erase(record.size()-1);
+            return anything;
+        }
+
+        void tableEvaluator::appendField(calc::string& out, const calc::string& field) const
+        {
+            // Fields containing a separator, quote or line ending are quoted
+            if(field.find_first_of(calc::string(1, separator)+"\"\r\n") == calc::string::npos)
+            {
+                out += field;
+                return;
+            }
+            out += '"';
+            for(calc::string::const_iterator pos = field.begin(); pos != field.end(); ++pos)
+            {
+                if(*pos == '"')
+                    out += '"';
+                out += *pos;
+            }
+            out += '"';
+        }
+}
@@ -0,0 +1,111 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include "calc/calc.h"
+
+namespace cli
+{
+    // Evaluates formulas over every row of a table, adding the results as new columns
+    // The variables of a formula that have the name of a column take their value from that column,
+    // formulas can also use the results of the formulas that were added before them.
+    // The rows are handled in blocks, every formula is evaluated for a whole block at once using its compiled program.
+    // A table is either a CSV file with a header line, or a directory with a file NAME.f64 of native doubles for every column.
+    class tableEvaluator
+    {
+        public:
+            // Constructor, the formulas are evaluated using the variables and functions of the calculator engine
+            // The output type is used to write the results to a CSV file
+            tableEvaluator(const calc::realOutputType& outputType = calc::outputType_auto);
+
+            // Set the character that separates the fields of a CSV file, the default is a comma
+            void setSeparator(const char& separator);
+            // Set the number of rows that are read and evaluated at once
+            void setBlockRows(const size_t& rows);
+
+            // Add a formula, its results are written to a new column with the given name
+            // If the expression contains errors the first one is thrown
+            void addFormula(const calc::string& name, const calc::string& expression);
+
+            // Evaluate the formulas for every row of a CSV file, and write the file with the result columns added
+            // "-" means stdin or stdout, returns the number of rows. Cells that couldn't be calculated contain the error.
+            // A calc::fileError is thrown if a file couldn't be opened, read or written
+            unsigned long long runCsv(const calc::string& inputFile, const calc::string& outputFile);
+            // Evaluate the formulas for every row of the columns in the directory inputDir, and write a file for every formula to outputDir
+            // Rows that couldn't be calculated contain a NaN, returns the number of rows
+            // A calc::fileError is thrown if a file couldn't be opened, read or written, or if the columns have different lengths
+            unsigned long long runBinary(const calc::string& inputDir, const calc::string& outputDir);
+
+            // Get the number of cells that couldn't be calculated during the last run
+            unsigned long long getErrorCount() const;
+            // Get the first error that occurred during the last run, only valid if getErrorCount() isn't 0
+            const calc::calcError& getFirstError() const;
+
+        private:
+            // A column of values of the block that is evaluated
+            struct column
+            {
+                calc::string name;                              // The name of the column
+                std::vector<calc::real> values;                 // The values of the rows
+                std::vector<char> failed;                       // Whether the value of a row is an error
+                std::map<size_t, calc::calcError> errors;       // The errors of the rows that failed
+            };
+
+            // A formula
+            struct formula
+            {
+                calc::string name;                              // The name of its column
+                std::unique_ptr<calc::calc> calculator;         // The expression
+                std::vector<int> sources;                       // For every variable slot of the program: the column it's bound to, -1 if none
+            };
+
+            // Bind the variables of the formulas to the input columns (by name) and the results of earlier formulas
+            // The columns list is filled with the input columns that are used, followed by one column for every formula
+            void bind(const std::vector<calc::string>& inputNames, std::vector<int>& inputColumns);
+            // Evaluate all formulas for the first rowCount rows of the columns
+            void evaluate(const size_t& rowCount);
+            // Evaluate a formula that couldn't be compiled row by row, by setting the columns as variables
+            void interpret(formula& form, column& result, const size_t& rowCount);
+            // Mark a cell as failed
+            void failCell(column& col, const size_t& row, const calc::calcError& error);
+
+            // Split a CSV record into its fields, removing quotes
+            void splitRecord(const calc::string& record, std::vector<calc::string>& fields) const;
+            // Read a CSV record (which may span multiple lines when a field is quoted), returns false at the end of the file
+            bool readRecord(std::FILE* in, calc::string& record) const;
+            // Write a value to a CSV field, quoting it if needed
+            void appendField(calc::string& out, const calc::string& field) const;
+
+            calc::realOutputType outputType;                    // The output type of the results
+            char separator;                                     // The separator of CSV fields
+            size_t blockRows;                                   // The number of rows evaluated at once
+
+            std::vector<formula> formulas;                      // The formulas
+            std::vector<column> columns;                        // The input columns that are used, followed by the result columns
+            size_t inputCount;                                  // The number of input columns in columns
+            unsigned long long errorCount;                      // The number of cells that couldn't be calculated
+            calc::calcError firstError;                         // The first error that occurred
+    };
+}
+
+#endif // TABLE_H
@@ -3,7 +3,7 @@
 #include <QEvent>
 
 // Public:
-    funcsWidget::funcsWidget(const std::map<QString, QString>& initFuncs, QWidget *parent) :
+    funcsWidget::funcsWidget(const std::map<QString, QString>& initFuncs, const std::map<QString, QString>& initReadOnlyFuncs, QWidget *parent) :
     QWidget(parent), layout(new QVBoxLayout(this)), buttonAddFunction(new QPushButton(QIcon(":/icons/plus.png"), tr("Add function"), this))
     {
         connect(buttonAddFunction, SIGNAL(clicked()), this, SLOT(addFunction()));
@@ -11,7 +11,7 @@
         layout->addStretch();
         this->setLayout(layout);
 
-        this->setFuncs(initFuncs);
+        this->setFuncs(initFuncs, initReadOnlyFuncs);
     }
 
     funcsWidget::~funcsWidget()
@@ -21,7 +21,7 @@
     }
 
 // Public slots:
-    void funcsWidget::setFuncs(const std::map<QString, QString>& newFuncs)
+    void funcsWidget::setFuncs(const std::map<QString, QString>& newFuncs, const std::map<QString, QString>& readOnlyFuncs)
     {
         clearLayout();
         for(std::map<QString, QString>::const_iterator pos=newFuncs.begin(); pos!=newFuncs.end(); pos++)
@@ -32,6 +32,25 @@
             connect(funcWidgets.back(), SIGNAL(renamed(const QString&, const QString&, funcWidget*)), this, SLOT(changeName(const QString&, const QString&, funcWidget*)));
             connect(funcWidgets.back(), SIGNAL(contentChanged(const QString&, const QString&)), this, SIGNAL(funcContentChanged(const QString&, const QString&)));
         }
+        // The read-only functions aren't connected, they can't be renamed or changed
+        for(std::map<QString, QString>::const_iterator pos=readOnlyFuncs.begin(); pos!=readOnlyFuncs.end(); pos++)
+        {
+            funcWidgets.push_back(new funcWidget(pos->first, pos->second, this, this->width()));
+            funcWidgets.back()->setReadOnly(true);
+            layout->insertWidget(layout->count()-2, funcWidgets.back());
+        }
+    }
+
+    void funcsWidget::setProfiles(const std::map<QString, calc::profiler::functionProfile>& profiles, const bool& shown)
+    {
+        for(funcWidgetList::const_iterator pos=funcWidgets.begin(); pos!=funcWidgets.end(); pos++)
+        {
+            std::map<QString, calc::profiler::functionProfile>::const_iterator profile = profiles.find((*pos)->funcName());
+            if(shown && profile != profiles.end())
+                (*pos)->setProfile(profile->second);
+            else
+                (*pos)->clearProfile();
+        }
     }
 
 // Protected:
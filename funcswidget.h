@@ -12,11 +12,14 @@ class funcsWidget : public QWidget
 {
     Q_OBJECT
     public:
-        explicit funcsWidget(const std::map<QString, QString>& initFuncs=std::map<QString, QString>(), QWidget *parent = 0);
+        explicit funcsWidget(const std::map<QString, QString>& initFuncs=std::map<QString, QString>(), const std::map<QString, QString>& initReadOnlyFuncs=std::map<QString, QString>(), QWidget *parent = 0);
         ~funcsWidget();
 
     public slots:
-        void setFuncs(const std::map<QString, QString>& newFuncs);
+        // Show the given functions, the read-only functions (e.g. of plugins) are shown after them and can't be edited
+        void setFuncs(const std::map<QString, QString>& newFuncs, const std::map<QString, QString>& readOnlyFuncs=std::map<QString, QString>());
+        // Show the measured calls next to the functions that have been called, or hide them if shown is false
+        void setProfiles(const std::map<QString, calc::profiler::functionProfile>& profiles, const bool& shown);
 
     signals:
         void funcAdded(const QString& name, const QString& content);
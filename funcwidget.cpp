@@ -5,7 +5,7 @@
 
 // Public:
     funcWidget::funcWidget(const QString& name, const QString& content, QWidget *parent, const int& minWidth) :
-    QWidget(parent), nameEdit(new QLineEdit(name, this)), contentEdit(new QLineEdit(content, this)), oldName(name)
+    QWidget(parent), nameEdit(new QLineEdit(name, this)), contentEdit(new QLineEdit(content, this)), profileLabel(new QLabel(this)), oldName(name)
     {
         QHBoxLayout* layout=new QHBoxLayout(this);
 
@@ -17,6 +17,9 @@
         connect(contentEdit, SIGNAL(textChanged(const QString&)), this, SLOT(contentHasChanged(const QString&)));
         layout->addWidget(contentEdit, 2);
 
+        profileLabel->setVisible(false);
+        layout->addWidget(profileLabel);
+
         layout->setSizeConstraint(QLayout::SetFixedSize);
         this->setLayout(layout);
         this->setMinimumWidth(minWidth);
@@ -41,6 +44,17 @@
             return out;
         }
 
+        QString funcWidget::formatDuration(const unsigned long long& nanoseconds)
+        {
+            if(nanoseconds < 1000)
+                return tr("%1 ns").arg(nanoseconds);
+            else if(nanoseconds < 1000000)
+                return tr("%1 %2s").arg(nanoseconds / 1000.0, 0, 'f', 1).arg(QChar(0xB5));
+            else if(nanoseconds < 1000000000)
+                return tr("%1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 1);
+            return tr("%1 s").arg(nanoseconds / 1000000000.0, 0, 'f', 2);
+        }
+
 // Public slots:
     void funcWidget::rename(QString newName, const QString& forceOldName)
     {
@@ -56,6 +70,32 @@
     void funcWidget::changeContent(const QString& newContent)
     { contentEdit->setText(newContent); }
 
+    void funcWidget::setProfile(const calc::profiler::functionProfile& profile)
+    {
+        // The label shows the number of calls and the time spent in the function itself, the tooltip has the details
+        profileLabel->setText(tr("%n call(s), %1", "", profile.calls).arg(formatDuration(profile.exclusiveNanoseconds)));
+        profileLabel->setToolTip(tr("Calls: %1
+Cache hits: %2
+Inclusive time: %3
+Exclusive time: %4
+Time per call: %5")
+                                 .arg(profile.calls).arg(profile.cacheHits)
+                                 .arg(formatDuration(profile.inclusiveNanoseconds)).arg(formatDuration(profile.exclusiveNanoseconds))
+                                 .arg(formatDuration(profile.calls ? profile.inclusiveNanoseconds / profile.calls : 0)));
+        profileLabel->setVisible(true);
+    }
+
+    void funcWidget::clearProfile()
+    { profileLabel->setVisible(false); }
+
+    void funcWidget::setReadOnly(const bool& readOnly)
+    {
+        nameEdit->setReadOnly(readOnly);
+        contentEdit->setReadOnly(readOnly);
+        nameEdit->setToolTip(readOnly ? tr("The name of the function, it can't be changed") : tr("The name of the function"));
+        contentEdit->setToolTip(readOnly ? tr("Where the function comes from, it can't be changed") : tr("What the function does"));
+    }
+
 // Protected:
     void funcWidget::changeEvent(QEvent* e)
     {
@@ -63,8 +103,7 @@
         switch (e->type())
         {
             case QEvent::LanguageChange:
-                nameEdit->setToolTip(tr("The name of the function"));
-                contentEdit->setToolTip(tr("What the function does"));
+                setReadOnly(nameEdit->isReadOnly());
             break;
 
             default:
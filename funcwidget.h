@@ -3,6 +3,8 @@
 
 #include <QWidget>
 #include <QLineEdit>
+#include <QLabel>
+#include "calc/profiler.h"
 
 class funcWidget : public QWidget
 {
@@ -14,10 +16,18 @@ class funcWidget : public QWidget
         QString funcContent() const;
 
         static QString checkName(const QString& name);
+        // Convert a number of nanoseconds to a readable duration, e.g. "12.3 ms"
+        static QString formatDuration(const unsigned long long& nanoseconds);
 
     public slots:
         void rename(QString newName, const QString& forceOldName = "");
         void changeContent(const QString& newContent);
+        // Show the measured calls of the function next to it
+        void setProfile(const calc::profiler::functionProfile& profile);
+        // Hide the measured calls of the function
+        void clearProfile();
+        // Make the name and the content read-only, used for functions that can't be edited (e.g. of plugins)
+        void setReadOnly(const bool& readOnly);
 
     signals:
         void renamed(const QString& oldName, const QString& newName, funcWidget* self);
@@ -33,6 +43,7 @@ class funcWidget : public QWidget
     private:
         QLineEdit* nameEdit;
         QLineEdit* contentEdit;
+        QLabel* profileLabel;
         QString oldName;
 };
 
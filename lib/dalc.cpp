@@ -0,0 +1,442 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "dalc.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <exception>
+#include "calc/calc.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/montecarlo.h"
+#include "calc/gradient.h"
+#include "cli/messages.h"
+
+namespace
+{
+    // A function implemented in C by the user of the library
+    class cFunction : public calc::mathFunction
+    {
+        public:
+            cFunction(const dalc_function& function, void* userData)
+            : calc::mathFunction(false), function(function), userData(userData) {}
+
+            calc::real execute(const calc::argList& args, const calc::string& name)
+            {
+                double result = 0;
+                if(function(userData, args.empty() ? 0 : &args[0], args.size(), &result) != 0)
+                    throw calc::calcError("Invalid argument", calc::calcError::invalidArguments, name);
+                return result;
+            }
+
+        private:
+            dalc_function function;                 // The function
+            void* userData;                         // Passed to every call of the function
+    };
+
+    // The message of the last error of this thread
+    thread_local calc::string lastError;
+
+    // Remember the message of an error, and return the status
+    int fail(const int& status, const calc::string& message)
+    {
+        lastError = message;
+        return status;
+    }
+
+    // Handle the exception that is being thrown, returns the status describing it
+    // No exception may leave the library, so every function catches all of them and calls this
+    int failWithCurrentException()
+    {
+        try
+        { throw; }
+        catch(calc::calcError& err)
+        { return fail(DALC_ERROR, cli::errorMessage(err)); }
+        catch(calc::overflowError& err)
+        { return fail(DALC_ERROR_OVERFLOW, cli::errorMessage(err)); }
+        catch(std::bad_alloc&)
+        { return fail(DALC_ERROR_MEMORY, "Out of memory"); }
+        catch(std::exception& err)
+        { return fail(DALC_ERROR, err.what()); }
+        catch(...)
+        { return fail(DALC_ERROR, "Unknown error occurred"); }
+    }
+}
+
+// The handles
+struct dalc_context
+{
+    std::shared_ptr<calc::builtIns> builtIns;                   // The built-in functions, shared with the clones
+    std::vector<std::shared_ptr<cFunction> > cFunctions;        // The functions implemented in C, shared with the clones
+    calc::context definitions;                                  // The variables and functions
+};
+
+struct dalc_program
+{
+    std::shared_ptr<const calc::program> prog;                  // The compiled expression
+};
+
+int dalc_api_version(void)
+{ return DALC_API_VERSION; }
+
+const char* dalc_last_error(void)
+{ return lastError.c_str(); }
+
+dalc_context* dalc_context_new(unsigned int flags)
+{
+    try
+    {
+        dalc_context* result = new dalc_context;
+        if(flags & DALC_BUILTINS)
+        {
+            result->builtIns = std::make_shared<calc::builtIns>((flags & DALC_DEGREES) ? calc::builtIns::angleDegrees : calc::builtIns::angleRadians);
+            result->builtIns->addTo(result->definitions);
+        }
+        return result;
+    }
+    catch(...)
+    {
+        failWithCurrentException();
+        return 0;
+    }
+}
+
+dalc_context* dalc_context_clone(const dalc_context* context)
+{
+    if(!context)
+    {
+        fail(DALC_ERROR_ARGUMENT, "No context given");
+        return 0;
+    }
+    try
+    { return new dalc_context(*context); }
+    catch(...)
+    {
+        failWithCurrentException();
+        return 0;
+    }
+}
+
+void dalc_context_free(dalc_context* context)
+{ delete context; }
+
+int dalc_set_var(dalc_context* context, const char* name, double value)
+{
+    if(!context || !name || !*name)
+        return fail(DALC_ERROR_ARGUMENT, "No context or name given");
+    try
+    {
+        context->definitions.setVar(name, value);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_get_var(const dalc_context* context, const char* name, double* value)
+{
+    if(!context || !name || !value)
+        return fail(DALC_ERROR_ARGUMENT, "No context, name or value given");
+    try
+    {
+        if(!context->definitions.varExists(name))
+            throw calc::calcError("Unknown variable", calc::calcError::unknownName, name);
+        *value = context->definitions.getVar(name);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_delete_var(dalc_context* context, const char* name)
+{
+    if(!context || !name)
+        return fail(DALC_ERROR_ARGUMENT, "No context or name given");
+    try
+    {
+        if(!context->definitions.deleteVar(name))
+            throw calc::calcError("Unknown variable", calc::calcError::unknownName, name);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_define_function(dalc_context* context, const char* name, const char* expression)
+{
+    if(!context || !name || !*name || !expression)
+        return fail(DALC_ERROR_ARGUMENT, "No context, name or expression given");
+    try
+    {
+        // Unlike the calculator, invalid expressions are refused right away
+        calc::context::compile(expression);
+        context->definitions.defineFunction(name, expression);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_set_function(dalc_context* context, const char* name, dalc_function function, void* user_data)
+{
+    if(!context || !name || !*name || !function)
+        return fail(DALC_ERROR_ARGUMENT, "No context, name or function given");
+    try
+    {
+        context->cFunctions.push_back(std::make_shared<cFunction>(function, user_data));
+        context->definitions.setFunction(name, context->cFunctions.back().get());
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_delete_function(dalc_context* context, const char* name)
+{
+    if(!context || !name)
+        return fail(DALC_ERROR_ARGUMENT, "No context or name given");
+    try
+    {
+        if(!context->definitions.deleteFunction(name))
+            throw calc::calcError("Unknown function", calc::calcError::unknownName, name);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_set_seed(dalc_context* context, unsigned long long seed)
+{
+    if(!context)
+        return fail(DALC_ERROR_ARGUMENT, "No context given");
+    context->definitions.setRandomSeed(seed);
+    return DALC_OK;
+}
+
+dalc_program* dalc_compile(const char* expression)
+{
+    if(!expression)
+    {
+        fail(DALC_ERROR_ARGUMENT, "No expression given");
+        return 0;
+    }
+    try
+    {
+        dalc_program* result = new dalc_program;
+        try
+        { result->prog = calc::context::compile(expression); }
+        catch(...)
+        {
+            delete result;
+            throw;
+        }
+        return result;
+    }
+    catch(...)
+    {
+        failWithCurrentException();
+        return 0;
+    }
+}
+
+void dalc_program_free(dalc_program* program)
+{ delete program; }
+
+size_t dalc_program_var_count(const dalc_program* program)
+{ return program ? program->prog->getVariables().size() : 0; }
+
+const char* dalc_program_var_name(const dalc_program* program, size_t index)
+{
+    if(!program || index >= program->prog->getVariables().size())
+        return 0;
+    return program->prog->getVariables()[index].c_str();
+}
+
+int dalc_evaluate(dalc_context* context, const char* expression, double* result)
+{
+    if(!context || !expression || !result)
+        return fail(DALC_ERROR_ARGUMENT, "No context, expression or result given");
+    try
+    {
+        *result = context->definitions.evaluate(expression);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_execute(dalc_context* context, const dalc_program* program, double* result)
+{
+    if(!context || !program || !result)
+        return fail(DALC_ERROR_ARGUMENT, "No context, program or result given");
+    try
+    {
+        *result = context->definitions.execute(*program->prog);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_execute_batch(dalc_context* context, const dalc_program* program,
+                       const char* const* column_names, const double* const* columns, size_t column_count,
+                       size_t row_count, double* results, unsigned char* failed)
+{
+    if(!context || !program || (column_count > 0 && (!column_names || !columns)) || (row_count > 0 && !results))
+        return fail(DALC_ERROR_ARGUMENT, "No context, program, columns or results given");
+    try
+    {
+        // Bind the columns to the variable slots of the program
+        const std::vector<calc::string>& variables = program->prog->getVariables();
+        std::vector<const calc::real*> bound(variables.size(), 0);
+        for(size_t i = 0; i < column_count; ++i)
+        {
+            if(!column_names[i] || !columns[i])
+                return fail(DALC_ERROR_ARGUMENT, "No name or values given for a column");
+            for(size_t slot = 0; slot < variables.size(); ++slot)
+            {
+                if(variables[slot] == column_names[i])
+                    bound[slot] = columns[i];
+            }
+        }
+
+        // Execute the program, the assignments are written to the context afterwards
+        std::vector<char> rowFailed(row_count, 0);
+        std::vector<calc::program::rowError> errors;
+        calc::contextFrame frame(context->definitions);
+        if(row_count > 0)
+            program->prog->executeBlock(frame, bound, row_count, results, &rowFailed[0], errors);
+        if(frame.hasAssignments())
+            frame.commit(context->definitions);
+
+        if(failed)
+        {
+            for(size_t row = 0; row < row_count; ++row)
+                failed[row] = rowFailed[row];
+        }
+        if(!errors.empty())
+            return fail(DALC_ERROR, cli::errorMessage(errors.front().error));
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_monte_carlo(dalc_context* context, const dalc_program* program, size_t sample_count, size_t thread_count,
+                     const double* probabilities, size_t probability_count, double* quantiles, dalc_statistics* statistics)
+{
+    if(!context || !program || !statistics || (probability_count > 0 && (!probabilities || !quantiles)))
+        return fail(DALC_ERROR_ARGUMENT, "No context, program, probabilities, quantiles or statistics given");
+    // The statistics have to hold at least the fields of the first version
+    if(statistics->size < offsetof(dalc_statistics, maximum) + sizeof(statistics->maximum))
+        return fail(DALC_ERROR_ARGUMENT, "The size of the statistics isn't set");
+    for(size_t i = 0; i < probability_count; ++i)
+    {
+        if(!(probabilities[i] >= 0 && probabilities[i] <= 1))
+            return fail(DALC_ERROR_ARGUMENT, "A probability isn't between 0 and 1");
+    }
+    try
+    {
+        calc::monteCarlo simulation(thread_count);
+        simulation.setProbabilities(std::vector<calc::real>(probabilities, probabilities + probability_count));
+        const calc::monteCarlo::summary result = simulation.run(context->definitions, *program->prog, sample_count);
+
+        std::copy(result.quantiles.begin(), result.quantiles.end(), quantiles);
+
+        statistics->count = result.statistics.getCount();
+        statistics->failed = result.errorCount + result.skipped;
+        statistics->mean = result.statistics.getMean();
+        statistics->variance = result.statistics.getVariance();
+        statistics->minimum = result.statistics.getMinimum();
+        statistics->maximum = result.statistics.getMaximum();
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_gradient(dalc_context* context, const dalc_program* program, double* result, double* derivatives)
+{
+    if(!context || !program || !result || (!derivatives && !program->prog->getVariables().empty()))
+        return fail(DALC_ERROR_ARGUMENT, "No context, program, result or derivatives given");
+    try
+    {
+        // Like dalc_execute(), assignments done before an error occurred are kept
+        calc::contextFrame frame(context->definitions);
+        calc::gradientTape tape;
+        std::vector<calc::real> gradient;
+        try
+        {
+            *result = tape.calculate(*program->prog, frame, gradient);
+        }
+        catch(calc::calcError&)
+        {
+            frame.commit(context->definitions);
+            throw;
+        }
+        frame.commit(context->definitions);
+        std::copy(gradient.begin(), gradient.end(), derivatives);
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_format(double value, int output_type, char* buffer, size_t buffer_size, size_t* length)
+{
+    if(output_type < DALC_OUTPUT_AUTO || output_type > DALC_OUTPUT_TIME || (buffer_size > 0 && !buffer))
+        return fail(DALC_ERROR_ARGUMENT, "Invalid output type or no buffer given");
+    try
+    {
+        // The output types have the same order as calc::realOutputType
+        const calc::string text = calc::real2str(value, static_cast<calc::realOutputType>(output_type));
+        if(length)
+            *length = text.size();
+        if(buffer_size > 0)
+        {
+            const size_t copied = std::min(text.size(), buffer_size - 1);
+            std::memcpy(buffer, text.data(), copied);
+            buffer[copied] = 0;
+        }
+        return DALC_OK;
+    }
+    catch(...)
+    { return failWithCurrentException(); }
+}
+
+int dalc_parse(const char* text, double* value)
+{
+    if(!text || !value)
+        return fail(DALC_ERROR_ARGUMENT, "No text or value given");
+    try
+    {
+        if(!*text)
+            throw calc::calcError("Empty expression", calc::calcError::emptyExpression);
+        *value = calc::str2real(text, true);
+        return DALC_OK;
+    }
+    catch(calc::calcError&)
+    { return fail(DALC_ERROR, "Invalid number: '"+calc::string(text)+"'"); }
+    catch(...)
+    { return failWithCurrentException(); }
+}
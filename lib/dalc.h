@@ -0,0 +1,174 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef DALC_H
+#define DALC_H
+
+/*
+ * The C interface of the calculator engine of Dalculator (libdalc)
+ *
+ * Everything is reached through opaque handles, so the layout of the engine can change without breaking programs
+ * that use the library. Only functions are added to this interface, the existing ones keep their meaning.
+ *
+ * A context holds variables and functions, and may only be used by one thread at a time.
+ * A program is a compiled expression, it doesn't depend on a context and can be executed by several threads at once.
+ *
+ * Functions that can fail return a status (DALC_OK on success). The message describing the last error that occurred
+ * in the calling thread can be retrieved using dalc_last_error().
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#   if defined(DALC_BUILDING)
+#       define DALC_API __declspec(dllexport)
+#   elif defined(DALC_SHARED)
+#       define DALC_API __declspec(dllimport)
+#   else
+#       define DALC_API
+#   endif
+#elif defined(__GNUC__)
+#   define DALC_API __attribute__((visibility("default")))
+#else
+#   define DALC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The version of this interface, it's raised when functions are added */
+#define DALC_API_VERSION 4
+
+/* The statuses returned by the functions */
+#define DALC_OK                 0   /* Succeeded */
+#define DALC_ERROR              1   /* The calculation failed, e.g. a division by 0 or an unknown variable */
+#define DALC_ERROR_OVERFLOW     2   /* The value is too big for the requested output type */
+#define DALC_ERROR_ARGUMENT     3   /* One of the arguments is invalid, e.g. a null pointer */
+#define DALC_ERROR_MEMORY       4   /* Out of memory */
+
+/* The flags of dalc_context_new() */
+#define DALC_BUILTINS           1   /* Add the built-in functions and variables (sin, cos, pi, ...) */
+#define DALC_DEGREES            2   /* The built-in goniometric functions use degrees instead of radians */
+
+/* The output types of dalc_format() */
+#define DALC_OUTPUT_AUTO        0
+#define DALC_OUTPUT_SCIENTIFIC  1
+#define DALC_OUTPUT_BIN         2
+#define DALC_OUTPUT_OCT         3
+#define DALC_OUTPUT_DEC         4
+#define DALC_OUTPUT_HEX         5
+#define DALC_OUTPUT_TIME        6
+
+/* The handles */
+typedef struct dalc_context dalc_context;
+typedef struct dalc_program dalc_program;
+
+/* The statistics of the results of dalc_monte_carlo()
+ * The caller sets size to sizeof(dalc_statistics), fields added by later versions are only written if they fit in that size. */
+typedef struct dalc_statistics
+{
+    size_t size;                    /* The size of the structure as the caller knows it */
+    size_t count;                   /* The number of results the statistics are of */
+    size_t failed;                  /* The number of samples that couldn't be calculated or whose result isn't a finite number */
+    double mean;                    /* The mean of the results */
+    double variance;                /* The sample variance of the results (dividing by count - 1) */
+    double minimum;                 /* The smallest result */
+    double maximum;                 /* The largest result */
+} dalc_statistics;
+
+/* A function implemented by the user of the library
+ * It gets the arguments of the call and writes its result to result, it should return 0 on success
+ * and anything else if the arguments are invalid. It may be called by several threads at once. */
+typedef int (*dalc_function)(void* user_data, const double* args, size_t arg_count, double* result);
+
+/* Get the version of the interface implemented by the library, i.e. the DALC_API_VERSION it was built with */
+DALC_API int dalc_api_version(void);
+/* Get the message describing the last error that occurred in the calling thread */
+DALC_API const char* dalc_last_error(void);
+
+/* Create a context, flags is a combination of DALC_BUILTINS and DALC_DEGREES, returns 0 if out of memory */
+DALC_API dalc_context* dalc_context_new(unsigned int flags);
+/* Create a copy of a context, the copy can be used by another thread, returns 0 if out of memory */
+DALC_API dalc_context* dalc_context_clone(const dalc_context* context);
+/* Destroy a context */
+DALC_API void dalc_context_free(dalc_context* context);
+
+/* Set the value of a variable, the variable is created if it doesn't exist */
+DALC_API int dalc_set_var(dalc_context* context, const char* name, double value);
+/* Get the value of a variable, DALC_ERROR is returned if the variable doesn't exist */
+DALC_API int dalc_get_var(const dalc_context* context, const char* name, double* value);
+/* Delete a variable, DALC_ERROR is returned if the variable doesn't exist */
+DALC_API int dalc_delete_var(dalc_context* context, const char* name);
+/* Define a function by an expression, ARG0, ARG1, ... are its arguments, DALC_ERROR is returned if the expression is invalid */
+DALC_API int dalc_define_function(dalc_context* context, const char* name, const char* expression);
+/* Define a function implemented in C, user_data is passed to every call */
+DALC_API int dalc_set_function(dalc_context* context, const char* name, dalc_function function, void* user_data);
+/* Delete a function, DALC_ERROR is returned if the function doesn't exist */
+DALC_API int dalc_delete_function(dalc_context* context, const char* name);
+/* Start the random numbers of RAND over with the given seed, the same seed gives the same numbers (since version 2)
+ * A new context gets a seed that's different every time, a clone continues with the same numbers as its original. */
+DALC_API int dalc_set_seed(dalc_context* context, unsigned long long seed);
+
+/* Compile an expression, returns 0 if the expression is invalid */
+DALC_API dalc_program* dalc_compile(const char* expression);
+/* Destroy a compiled expression */
+DALC_API void dalc_program_free(dalc_program* program);
+/* Get the number of variables used by a compiled expression */
+DALC_API size_t dalc_program_var_count(const dalc_program* program);
+/* Get the name of a variable used by a compiled expression, index has to be less than dalc_program_var_count() */
+DALC_API const char* dalc_program_var_name(const dalc_program* program, size_t index);
+
+/* Evaluate an expression in a context, assignments change the variables of the context */
+DALC_API int dalc_evaluate(dalc_context* context, const char* expression, double* result);
+/* Execute a compiled expression in a context, assignments change the variables of the context */
+DALC_API int dalc_execute(dalc_context* context, const dalc_program* program, double* result);
+/* Execute a compiled expression for row_count rows at once
+ * The variable named column_names[i] takes its value from columns[i][row], all other variables come from the context.
+ * The result of every row is written to results, rows in which an error occurs get a NaN result and failed[row] set to 1
+ * (failed may be 0). DALC_ERROR is returned if any row failed, dalc_last_error() then describes the first of them. */
+DALC_API int dalc_execute_batch(dalc_context* context, const dalc_program* program,
+                                const char* const* column_names, const double* const* columns, size_t column_count,
+                                size_t row_count, double* results, unsigned char* failed);
+
+/* Execute a compiled expression sample_count times with different random numbers, using thread_count threads (0 for one per processor)
+ * The statistics of the results are written to statistics, whose size has to be set, and the estimated quantiles of the probability_count probabilities
+ * (between 0 and 1) to quantiles, in the same order. The samples aren't stored and assignments aren't kept (since version 3).
+ * RAND draws from streams split off the context, so the same seed gives the same statistics for any number of threads.
+ * DALC_ERROR is returned if every sample of a part of the samples failed, dalc_last_error() then describes the error. */
+DALC_API int dalc_monte_carlo(dalc_context* context, const dalc_program* program, size_t sample_count, size_t thread_count,
+                              const double* probabilities, size_t probability_count, double* quantiles, dalc_statistics* statistics);
+
+/* Execute a compiled expression in a context and calculate the derivatives of its result to all of its variables at once (since version 4)
+ * derivatives[i] becomes the derivative to the variable named dalc_program_var_name(program, i), so it needs dalc_program_var_count()
+ * entries. The built-in functions and the functions defined by an expression are differentiated exactly, functions implemented in C
+ * by central differences. Assignments change the variables of the context. */
+DALC_API int dalc_gradient(dalc_context* context, const dalc_program* program, double* result, double* derivatives);
+
+/* Format a value using one of the DALC_OUTPUT_* types, like the calculator shows it
+ * At most buffer_size bytes are written to buffer (including the terminating 0), the full length of the text
+ * (without the terminating 0) is written to length (which may be 0). */
+DALC_API int dalc_format(double value, int output_type, char* buffer, size_t buffer_size, size_t* length);
+/* Parse a number written like the calculator accepts it (e.g. 12.5, 0x1F or 017 for an octal number) */
+DALC_API int dalc_parse(const char* text, double* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DALC_H */
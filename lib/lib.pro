@@ -0,0 +1,26 @@
+# -------------------------------------------------
+# libdalc, the calculator engine as a library with a C interface (see dalc.h)
+# A shared library is built by default, use "qmake CONFIG+=staticlib" for a static library
+# -------------------------------------------------
+TARGET = dalc
+TEMPLATE = lib
+VERSION = 1.0.0
+
+CONFIG += thread hide_symbols
+CONFIG -= qt
+
+DEFINES += DALC_BUILDING
+
+include(../calc/calc.pri)
+
+SOURCES += dalc.cpp \
+    ../cli/messages.cpp
+HEADERS += dalc.h \
+    ../cli/messages.h
+
+target.path = /usr/lib
+INSTALLS += target
+
+headers.path = /usr/include
+headers.files = dalc.h
+INSTALLS += headers
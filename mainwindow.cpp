@@ -6,16 +6,17 @@
 #include <QFile>
 #include <QKeySequence>
 #include <QDir>
+#include <QInputDialog>
 
 // Public:
     MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), ui(new Ui::MainWindow),
-      errorMessageTimer(0), errorMessageOpacity(0),
+      errorMessageTimer(0), errorMessageOpacity(0), errorMessageColor("255,0,0"),
       myVarsFuncsDialog(0),
       myUpdateChecker(updates::version(2, 2, 0, 0, false)), updateWindow(0),
       aboutDialog(0),
       englishTranslator(0), dutchTranslator(0),
-      historyDialog(100, this)
+      historyDialog(100, this), myPlotDialog(0)
     {
         // Set the right value for the data directory
 #ifdef Q_WS_X11
@@ -57,10 +58,12 @@
         // Connect calculator:
             connect(this, SIGNAL(calcString(const QString&)), &calculator, SLOT(calculate(const QString&)));
             connect(&calculator, SIGNAL(result(const QString&, const bool&)), this, SLOT(calculated(const QString&, const bool&)));
+            connect(&calculator, SIGNAL(message(const QString&)), this, SLOT(displayMessage(const QString&)));
             connect(this, SIGNAL(saveCalculator()), &calculator, SLOT(saveSettings()));
             connect(this, SIGNAL(loadCalculator()), &calculator, SLOT(loadSettings()));
             connect(&calculator, SIGNAL(error(const QString&)), this, SLOT(settingLoadError(const QString&)));
             connect(this, SIGNAL(recalculate()), &calculator, SLOT(recalculate()));
+            connect(&calculator, SIGNAL(statistics(const QString&)), ui->statistics, SLOT(setText(const QString&)));
 
         // Initialise the calculator and all settings
             initialise();
@@ -77,6 +80,8 @@
             delete updateWindow;
         if(aboutDialog != 0)
             delete aboutDialog;
+        if(myPlotDialog != 0)
+            delete myPlotDialog;
         if(englishTranslator != 0)
             delete englishTranslator;
         if(dutchTranslator != 0)
@@ -120,9 +125,10 @@
 
     void MainWindow::displayErrorMessage(const QString& msg)
     {
-        // Set the error text
+        // Set the error text, errors are red
+        errorMessageColor = "255,0,0";
         ui->errorMessage->setText(msg);
-        ui->errorMessage->setStyleSheet("color:rgba(255,0,0,0%);font-weight:bold;width:100%;");
+        ui->errorMessage->setStyleSheet(QString("color:rgba(%1,0%);font-weight:bold;width:100%;").arg(errorMessageColor));
         // Set the opacity to 0, to create a nice fade-in effect
         errorMessageOpacity = 0;
         // Enable the button containing the error message
@@ -138,6 +144,13 @@
         errorMessageTimer->start(75);
     }
 
+    void MainWindow::displayMessage(const QString& msg)
+    {
+        // Other messages fade in like errors do, but they're black
+        displayErrorMessage(msg);
+        errorMessageColor = "0,0,0";
+    }
+
 // Protected:
     void MainWindow::changeEvent(QEvent* e)
     {
@@ -176,7 +189,12 @@
                 if(!settings["history"]["history_size"].validateType(dini::typeInt))
                     historyDialog.clear();
 
+                if(!settings["main"]["showStatistics"].validateType(dini::typeBool))
+                    settings["main"]["showStatistics"]=false;
+
                 ui->actionAutocheck_for_updates->setChecked(settings["main"]["autoCheckForUpdates"].toBool());
+                ui->actionShow_statistics->setChecked(settings["main"]["showStatistics"].toBool());
+                on_actionShow_statistics_triggered(settings["main"]["showStatistics"].toBool());
 
                 if(settings["main"]["language"].toString()=="nl")
                     on_actionDutch_triggered();
@@ -212,6 +230,10 @@
                     ui->action_Degrees->trigger();
                 else
                     ui->action_Radians->trigger();
+
+                // Without a seed the random numbers are different every time
+                if(!settings["calculator"]["randomSeed"].toString().empty())
+                    calculator.setRandomSeed(QString::fromStdString(settings["calculator"]["randomSeed"].toString()));
             }
             catch(...)
             {}
@@ -247,7 +269,7 @@
     void MainWindow::errorMessageTimerEnded()
     {
         // Make the error message fade in a bit more
-        ui->errorMessage->setStyleSheet(QString("color:rgba(255,0,0,%1%);font-weight:bold;").arg(std::min(int(errorMessageOpacity+=10), 100)));
+        ui->errorMessage->setStyleSheet(QString("color:rgba(%1,%2%);font-weight:bold;").arg(errorMessageColor).arg(std::min(int(errorMessageOpacity+=10), 100)));
         // When the opacity is 100 or greater we stop the timer and make sure the opacity is set to 100
         if(errorMessageOpacity >= 100)
         {
@@ -259,7 +281,7 @@
     void MainWindow::errorMessageCloseTimerEnded()
     {
         // Make the error message fade out a bit more
-        ui->errorMessage->setStyleSheet(QString("color:rgba(255,0,0,%1%);font-weight:bold;").arg(std::max(int(errorMessageOpacity-=10), 0)));
+        ui->errorMessage->setStyleSheet(QString("color:rgba(%1,%2%);font-weight:bold;").arg(errorMessageColor).arg(std::max(int(errorMessageOpacity-=10), 0)));
         // When the opacity is 0 or smaller we clear the error message, stop the timer and make sure the opacity is set to 0
         if(errorMessageOpacity <= 0)
         {
@@ -403,9 +425,29 @@
             aboutDialog->show();
         }
 
+        void MainWindow::on_actionPlot_triggered()
+        {
+            // If the dialog isn't created yet, we create it
+            if(!myPlotDialog)
+                myPlotDialog = new plotDialog(calculator, this);
+            // Show the dialog
+            myPlotDialog->show();
+        }
+
         void MainWindow::on_actionAutocheck_for_updates_triggered(const bool& checked)
         { settings["main"]["autoCheckForUpdates"] = checked; }
 
+        void MainWindow::on_actionShow_statistics_triggered(const bool& checked)
+        {
+            // Show or hide the statistics below the result, the window grows or shrinks to make room for their two lines
+            settings["main"]["showStatistics"] = checked;
+            calculator.setStatisticsShown(checked);
+            ui->statistics->setVisible(checked);
+            const int height = 127 + (checked ? 2 * ui->statistics->fontMetrics().lineSpacing() + ui->verticalLayout->spacing() : 0);
+            setMinimumHeight(height);
+            setMaximumHeight(height);
+        }
+
         void MainWindow::on_actionEnglish_triggered()
         {
             // Get the right font and make the right menu button bold
@@ -530,5 +572,31 @@
             settings["calculator"]["angleType"]="rad";
         }
 
+        void MainWindow::on_actionRandom_seed_triggered()
+        {
+            // Ask for the seed, the current one is filled in
+            bool accepted = false;
+            const QString seed = QInputDialog::getText(this, tr("Random seed"),
+                                                       tr("The seed of the random numbers of RAND, the same seed gives the same numbers.\n"
+                                                          "Leave it empty to get different numbers every time."),
+                                                       QLineEdit::Normal, QString::fromStdString(settings["calculator"]["randomSeed"].toString()),
+                                                       &accepted).trimmed();
+            if(!accepted)
+                return;
+
+            // The seed has to be a non-negative integer
+            bool valid = seed.isEmpty();
+            if(!valid)
+                seed.toULongLong(&valid);
+            if(!valid)
+            {
+                QMessageBox::critical(this, tr("Error"), tr("The seed should be a non-negative integer."));
+                return;
+            }
+
+            calculator.setRandomSeed(seed);
+            settings["calculator"]["randomSeed"] = seed.toStdString();
+        }
+
         void MainWindow::on_actionShow_history_triggered()
         { historyDialog.show(); }
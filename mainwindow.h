@@ -12,6 +12,7 @@
 #include "dialogabout.h"
 #include "dini/dini.h"
 #include "calchistorydialog.h"
+#include "plotdialog.h"
 
 namespace Ui { class MainWindow; }
 
@@ -31,6 +32,8 @@ class MainWindow : public QMainWindow
         void calculated(const QString& msg, const bool& errorOccurred);
         // Displays an error message
         void displayErrorMessage(const QString& msg);
+        // Displays a message that isn't an error, in the same place as the error messages
+        void displayMessage(const QString& msg);
 
     signals:
         // Gives the command to calculate the given expression
@@ -53,6 +56,7 @@ class MainWindow : public QMainWindow
 
         QTimer* errorMessageTimer;                                              // Timer that's used to create a nice smooth animation for the error to fade away
         int errorMessageOpacity;                                                // Holds the current opacity of the animation
+        QString errorMessageColor;                                              // The color of the message, as "red,green,blue"
 
         varsFuncsDialog* myVarsFuncsDialog;                                     // A pointer to the dialog containing all variables and functions
 
@@ -67,6 +71,7 @@ class MainWindow : public QMainWindow
         QTranslator* dutchTranslator;                                           // QTranslator used to translate the UI to Dutch
 
         calcHistoryDialog historyDialog;                                        // Dialog that holds the calculation history
+        plotDialog* myPlotDialog;                                               // Dialog that plots an expression, created when it's shown first
 
         QString dataDir;                                                        // Directory containing the data, like the language files
 
@@ -82,6 +87,8 @@ class MainWindow : public QMainWindow
     // The names of the private slots are self-explaining
     private slots:
         void on_actionShow_history_triggered();
+        void on_actionShow_statistics_triggered(const bool& checked);
+        void on_actionPlot_triggered();
         void on_actionScientific_triggered();
         void on_actionHexadecimal_triggered();
         void on_actionBinary_triggered();
@@ -89,6 +96,7 @@ class MainWindow : public QMainWindow
         void on_actionDecimal_triggered();
         void on_action_Radians_triggered();
         void on_action_Degrees_triggered();
+        void on_actionRandom_seed_triggered();
         void on_action_Auto_detect_triggered();
         void on_actionTime_triggered();
         void on_actionHelp_triggered();
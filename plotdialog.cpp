@@ -0,0 +1,145 @@
+#include "plotdialog.h"
+#include "ui_plotdialog.h"
+#include <exception>
+#include <memory>
+
+// Public:
+    plotDialog::plotDialog(const QTCalc& calculator, QWidget* parent)
+    : QDialog(parent), ui(new Ui::plotDialog), calculator(calculator), cancelled(false)
+    {
+        // Setup the ui
+        ui->setupUi(this);
+    }
+
+    plotDialog::~plotDialog()
+    {
+        stop();
+        delete ui;
+    }
+
+// Protected:
+    void plotDialog::changeEvent(QEvent* e)
+    {
+        // In case the language changes, the ui needs to be retranslated
+        QDialog::changeEvent(e);
+        switch (e->type())
+        {
+            case QEvent::LanguageChange:
+                ui->retranslateUi(this);
+            break;
+
+            default:
+            break;
+        }
+    }
+
+    void plotDialog::hideEvent(QHideEvent* e)
+    {
+        stop();
+        QDialog::hideEvent(e);
+    }
+
+// Private:
+    void plotDialog::stop()
+    {
+        // The sampler checks the flag after every round
+        cancelled = true;
+        if(worker.joinable())
+            worker.join();
+        cancelled = false;
+
+        std::lock_guard<std::mutex> lock(latestMutex);
+        latest.clear();
+    }
+
+// Private slots:
+    void plotDialog::on_buttonPlot_clicked()
+    {
+        stop();
+        ui->plot->clear();
+
+        // Read the settings of the plot
+        bool validFrom = false, validTo = false;
+        const calc::real from = ui->lineFrom->text().toDouble(&validFrom);
+        const calc::real to = ui->lineTo->text().toDouble(&validTo);
+        if(!validFrom || !validTo || from == to)
+        {
+            ui->labelStatus->setText(tr("The range should be two different numbers"));
+            return;
+        }
+        const std::string variable = ui->lineVariable->text().trimmed().toStdString();
+        const size_t count = ui->spinSamples->value();
+        const bool adaptive = ui->checkAdaptive->isChecked();
+
+        // The expression is compiled here, so its errors are shown right away
+        std::shared_ptr<const calc::program> prog;
+        try
+        {
+            prog = calc::context::compile(ui->lineExpression->text().toStdString());
+        }
+        catch(calc::calcError& err)
+        {
+            ui->labelStatus->setText(calculator.errorMessage(err));
+            return;
+        }
+
+        // The thread calculates in a copy of the functions and variables of the calculator, and hands over the samples after every round
+        ui->labelStatus->setText(tr("Calculating..."));
+        const calc::context definitions = calculator.getContext();
+        worker = std::thread([this, definitions, prog, variable, from, to, count, adaptive]()
+        {
+            calc::functionSampler sampler;
+            sampler.setProgress([this](const std::vector<calc::functionSampler::sample>& samples)
+            {
+                if(cancelled)
+                    return false;
+                {
+                    std::lock_guard<std::mutex> lock(latestMutex);
+                    latest = samples;
+                }
+                QMetaObject::invokeMethod(this, "showSamples", Qt::QueuedConnection);
+                return true;
+            });
+
+            QString error;
+            try
+            {
+                if(adaptive)
+                    sampler.adaptive(definitions, *prog, variable, from, to, count);
+                else
+                    sampler.uniform(definitions, *prog, variable, from, to, count);
+            }
+            catch(calc::calcError& err)
+            {
+                error = calculator.errorMessage(err);
+            }
+            catch(std::exception& err)
+            {
+                error = err.what();
+            }
+            QMetaObject::invokeMethod(this, "plotFinished", Qt::QueuedConnection, Q_ARG(QString, error));
+        });
+    }
+
+    void plotDialog::on_buttonClose_clicked()
+    { close(); }
+
+    void plotDialog::showSamples()
+    {
+        std::vector<calc::functionSampler::sample> samples;
+        {
+            std::lock_guard<std::mutex> lock(latestMutex);
+            samples.swap(latest);
+        }
+        // The samples were taken already, or the plot was stopped
+        if(samples.empty())
+            return;
+        ui->plot->setSamples(samples);
+        ui->labelStatus->setText(tr("%1 samples").arg(ui->plot->sampleCount()));
+    }
+
+    void plotDialog::plotFinished(const QString& error)
+    {
+        if(!error.isEmpty())
+            ui->labelStatus->setText(error);
+    }
@@ -0,0 +1,54 @@
+#ifndef PLOTDIALOG_H
+#define PLOTDIALOG_H
+
+#include <QDialog>
+#include <QString>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "qtcalc.h"
+#include "calc/sampler.h"
+
+namespace Ui { class plotDialog; }
+
+// Dialog that plots an expression as a function of one of its variables
+// The samples are calculated by another thread, and the plot is updated after every round of the sampler (see calc::functionSampler).
+class plotDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        // Constructor and destructor, the calculator has to outlive the dialog
+        plotDialog(const QTCalc& calculator, QWidget* parent = 0);
+        ~plotDialog();
+
+    protected:
+        // To handle translate events
+        void changeEvent(QEvent* e);
+        // Stops plotting when the dialog is hidden
+        void hideEvent(QHideEvent* e);
+
+    private:
+        // Stop the thread that's calculating the samples, if there is one
+        void stop();
+
+        Ui::plotDialog* ui;                                                     // The actual ui of the dialog
+        const QTCalc& calculator;                                               // The calculator whose functions and variables are used
+
+        std::thread worker;                                                     // The thread that's calculating the samples
+        std::atomic<bool> cancelled;                                            // Set to let the thread stop after the current round
+        std::mutex latestMutex;                                                 // Guards latest
+        std::vector<calc::functionSampler::sample> latest;                      // The samples of the last round, waiting to be shown
+
+    private slots:
+        void on_buttonPlot_clicked();
+        void on_buttonClose_clicked();
+
+        // Show the samples of the last round
+        void showSamples();
+        // Called when the thread is done, with the error that stopped it, if any
+        void plotFinished(const QString& error);
+};
+
+#endif // PLOTDIALOG_H
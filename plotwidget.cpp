@@ -0,0 +1,109 @@
+#include "plotwidget.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+
+// Public:
+    plotWidget::plotWidget(QWidget* parent)
+    : QWidget(parent), left(0), right(1), bottom(0), top(1)
+    {
+        setMinimumSize(200, 150);
+        setBackgroundRole(QPalette::Base);
+        setAutoFillBackground(true);
+    }
+
+    void plotWidget::setSamples(const std::vector<calc::functionSampler::sample>& newSamples)
+    {
+        samples = newSamples;
+
+        // Show all values of x
+        left = samples.empty() ? 0 : samples.front().x;
+        right = samples.empty() ? 1 : samples.back().x;
+        if(!(right > left))
+        {
+            left -= 1;
+            right += 1;
+        }
+
+        // Show the results but the 1% smallest and largest, so a pole doesn't squash the rest of the function
+        std::vector<calc::real> results;
+        for(size_t i = 0; i < samples.size(); ++i)
+        {
+            if(!samples[i].failed)
+                results.push_back(samples[i].y);
+        }
+        bottom = 0;
+        top = 1;
+        if(!results.empty())
+        {
+            std::sort(results.begin(), results.end());
+            bottom = results[static_cast<size_t>(0.01 * (results.size() - 1))];
+            top = results[static_cast<size_t>(0.99 * (results.size() - 1))];
+            const calc::real margin = top > bottom ? (top - bottom) / 20 : std::max(std::fabs(top), static_cast<calc::real>(1));
+            bottom -= margin;
+            top += margin;
+        }
+        update();
+    }
+
+    size_t plotWidget::sampleCount() const
+    { return samples.size(); }
+
+// Public slots:
+    void plotWidget::clear()
+    {
+        samples.clear();
+        update();
+    }
+
+// Protected:
+    void plotWidget::paintEvent(QPaintEvent*)
+    {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        const qreal width = this->width() - 1;
+        const qreal height = this->height() - 1;
+
+        // The axes, if they're in sight
+        painter.setPen(palette().color(QPalette::Mid));
+        if(left <= 0 && right >= 0)
+        {
+            const qreal x = -left / (right - left) * width;
+            painter.drawLine(QPointF(x, 0), QPointF(x, height));
+        }
+        if(bottom <= 0 && top >= 0)
+        {
+            const qreal y = top / (top - bottom) * height;
+            painter.drawLine(QPointF(0, y), QPointF(width, y));
+        }
+        if(samples.empty())
+            return;
+
+        // The range that's shown
+        painter.setPen(palette().color(QPalette::Text));
+        const QFontMetrics metrics(font());
+        painter.drawText(QPointF(2, metrics.ascent() + 2), QString::number(static_cast<double>(top)));
+        painter.drawText(QPointF(2, height - metrics.descent() - 2), QString::number(static_cast<double>(bottom)));
+        const QString rightText = QString::number(static_cast<double>(right));
+        painter.drawText(QPointF(width - metrics.width(rightText) - 2, height - metrics.descent() - 2), rightText);
+
+        // The lines between the samples, broken where the function failed or jumps past the whole plot
+        painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+        QPolygonF line;
+        for(size_t i = 0; i < samples.size(); ++i)
+        {
+            const bool jump = !line.isEmpty() && ((samples[i - 1].y > top && samples[i].y < bottom) || (samples[i - 1].y < bottom && samples[i].y > top));
+            if(samples[i].failed || jump)
+            {
+                painter.drawPolyline(line);
+                line.clear();
+                if(samples[i].failed)
+                    continue;
+            }
+            // Points far outside the plot are moved closer, so they don't overflow the coordinates
+            const calc::real y = std::min(std::max(samples[i].y, bottom - 10 * (top - bottom)), top + 10 * (top - bottom));
+            line.append(QPointF((samples[i].x - left) / (right - left) * width, (top - y) / (top - bottom) * height));
+        }
+        painter.drawPolyline(line);
+    }
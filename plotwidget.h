@@ -0,0 +1,39 @@
+#ifndef PLOTWIDGET_H
+#define PLOTWIDGET_H
+
+#include <QWidget>
+#include <vector>
+#include "calc/sampler.h"
+
+// Widget that draws the samples of a function as lines between them
+// The lines are broken where the function couldn't be calculated, or where it jumps from one side of the plot to the other.
+class plotWidget : public QWidget
+{
+    Q_OBJECT
+
+    public:
+        // Constructor
+        plotWidget(QWidget* parent = 0);
+
+        // Set the samples to draw, sorted by x, the plot shows all values of x and most of the results
+        void setSamples(const std::vector<calc::functionSampler::sample>& newSamples);
+        // Get the number of samples that are drawn
+        size_t sampleCount() const;
+
+    public slots:
+        // Remove all samples
+        void clear();
+
+    protected:
+        // Draws the axes and the samples
+        void paintEvent(QPaintEvent* e);
+
+    private:
+        std::vector<calc::functionSampler::sample> samples;                     // The samples, sorted by x
+        calc::real left;                                                        // The smallest x that's shown
+        calc::real right;                                                       // The largest x that's shown
+        calc::real bottom;                                                      // The smallest y that's shown
+        calc::real top;                                                         // The largest y that's shown
+};
+
+#endif // PLOTWIDGET_H
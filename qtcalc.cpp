@@ -18,82 +18,20 @@
 
 
 #include "qtcalc.h"
+#include "calc/random.h"
 #include <QFile>
-#include <cmath>
-#include <cstdlib>
 #include <QDir>
+#include <QStringList>
+#include <fstream>
 
 // Class QTCalc:
     // Public:
         QTCalc::QTCalc(const outputType& calcOutputType, const angleType& angle)
-        : settingFilename("calcsettings"),
-        calcOutputType(calcOutputType), currAngleType(angle)
+        : builtIns(angle == angleDegrees ? calc::builtIns::angleDegrees : calc::builtIns::angleRadians),
+        settingFilename("calcsettings"), pluginDirectory("plugins"), calcOutputType(calcOutputType)
         {
-            // Set the built-in functions, and store them in a calc::functionList
-            // Set the names in both capital and non-capital form
-            builtInFunctions["ABS"]     = new calc::cppMathFunction(std::abs, false);
-            builtInFunctions["CEIL"]    = new calc::cppMathFunction(std::ceil, false);
-            builtInFunctions["EXP"]     = new calc::cppMathFunction(std::exp, false);
-            builtInFunctions["LOG"]     = new calc::cppMathFunction(std::log, false);
-            builtInFunctions["LOG10"]   = new calc::cppMathFunction(std::log10, false);
-            builtInFunctions["FLOOR"]   = new calc::cppMathFunction(std::floor, false);
-            builtInFunctions["DEG"]     = new calc::cppMathFunction(mathFunctions::deg, false);
-            builtInFunctions["RAD"]     = new calc::cppMathFunction(mathFunctions::rad, false);
-            builtInFunctions["ROUND"]   = new calc::cppMathFunction(mathFunctions::round, false);
-            builtInFunctions["FACULTY"] = new calc::cppMathFunction(mathFunctions::faculty, false);
-            builtInFunctions["abs"]     = new calc::cppMathFunction(std::abs, false);
-            builtInFunctions["ceil"]    = new calc::cppMathFunction(std::ceil, false);
-            builtInFunctions["exp"]     = new calc::cppMathFunction(std::exp, false);
-            builtInFunctions["log"]     = new calc::cppMathFunction(std::log, false);
-            builtInFunctions["log10"]   = new calc::cppMathFunction(std::log10, false);
-            builtInFunctions["floor"]   = new calc::cppMathFunction(std::floor, false);
-            builtInFunctions["deg"]     = new calc::cppMathFunction(mathFunctions::deg, false);
-            builtInFunctions["rad"]     = new calc::cppMathFunction(mathFunctions::rad, false);
-            builtInFunctions["round"]   = new calc::cppMathFunction(mathFunctions::round, false);
-            builtInFunctions["faculty"] = new calc::cppMathFunction(mathFunctions::faculty, false);
-
-
-            builtInFunctions["COS"]     = new QTCalcMemberMathFunction(&QTCalc::cos, this, false);
-            builtInFunctions["ACOS"]    = new QTCalcMemberMathFunction(&QTCalc::acos, this, false);
-            builtInFunctions["COSH"]    = new QTCalcMemberMathFunction(&QTCalc::cosh, this, false);
-            builtInFunctions["SIN"]     = new QTCalcMemberMathFunction(&QTCalc::sin, this, false);
-            builtInFunctions["ASIN"]    = new QTCalcMemberMathFunction(&QTCalc::asin, this, false);
-            builtInFunctions["SINH"]    = new QTCalcMemberMathFunction(&QTCalc::sinh, this, false);
-            builtInFunctions["TAN"]     = new QTCalcMemberMathFunction(&QTCalc::tan, this, false);
-            builtInFunctions["ATAN"]    = new QTCalcMemberMathFunction(&QTCalc::atan, this, false);
-            builtInFunctions["TANH"]    = new QTCalcMemberMathFunction(&QTCalc::tanh, this, false);
-            builtInFunctions["AVG"]     = new QTCalcMemberMathFunction(&QTCalc::avg, this, false);
-            builtInFunctions["NCR"]     = new QTCalcMemberMathFunction(&QTCalc::ncr, this, false);
-            builtInFunctions["NPR"]     = new QTCalcMemberMathFunction(&QTCalc::npr, this, false);
-            builtInFunctions["cos"]     = new QTCalcMemberMathFunction(&QTCalc::cos, this, false);
-            builtInFunctions["acos"]    = new QTCalcMemberMathFunction(&QTCalc::acos, this, false);
-            builtInFunctions["cosh"]    = new QTCalcMemberMathFunction(&QTCalc::cosh, this, false);
-            builtInFunctions["sin"]     = new QTCalcMemberMathFunction(&QTCalc::sin, this, false);
-            builtInFunctions["asin"]    = new QTCalcMemberMathFunction(&QTCalc::asin, this, false);
-            builtInFunctions["sinh"]    = new QTCalcMemberMathFunction(&QTCalc::sinh, this, false);
-            builtInFunctions["tan"]     = new QTCalcMemberMathFunction(&QTCalc::tan, this, false);
-            builtInFunctions["atan"]    = new QTCalcMemberMathFunction(&QTCalc::atan, this, false);
-            builtInFunctions["tanh"]    = new QTCalcMemberMathFunction(&QTCalc::tanh, this, false);
-            builtInFunctions["avg"]     = new QTCalcMemberMathFunction(&QTCalc::avg, this, false);
-            builtInFunctions["ncr"]     = new QTCalcMemberMathFunction(&QTCalc::ncr, this, false);
-            builtInFunctions["npr"]     = new QTCalcMemberMathFunction(&QTCalc::npr, this, false);
-
-            builtInFunctions["RAND"]    = new calc::preDefinedMathFunction(mathFunctions::random, false);
-            builtInFunctions["IF"]      = new calc::preDefinedMathFunction(mathFunctions::ifFunction, false);
-            builtInFunctions["rand"]    = new calc::preDefinedMathFunction(mathFunctions::random, false);
-            builtInFunctions["if"]      = new calc::preDefinedMathFunction(mathFunctions::ifFunction, false);
-
-            // Add the built-in functions to the calculator
-            for(calc::functionList::iterator pos = builtInFunctions.begin(); pos != builtInFunctions.end(); ++pos)
-                calculator.setFunction(pos->first, pos->second);
-
-            // Set the built in variables
-            calculator.setVar("pi", mathConstant::PI);
-            calculator.setVar("e", mathConstant::E);
-            calculator.setVar("phi", mathConstant::PHI);
-
-            // Remember the built-in variables
-            builtInVars = *calculator.getVars();
+            // Add the built-in functions and variables to the calculator
+            builtIns.addTo(calculator);
 
             // Use a timer to save the settings of the calculator every now and then, this way the settings are always up-to-date but not saving constantly
             connect(&saveSettingsTimer, SIGNAL(timeout()), this, SLOT(saveSettings()));
@@ -102,11 +40,7 @@
         }
 
         QTCalc::~QTCalc()
-        {
-            // Set all built in functions to be cleaned up, the destructor of the calculator object will then make sure this actually happens
-            for(calc::functionList::iterator pos = builtInFunctions.begin(); pos != builtInFunctions.end(); ++pos)
-                pos->second->setCleanUpNeeded(true);
-        }
+        {}
 
         std::map<QString, QString> QTCalc::getFuncs() const throw()
         {
@@ -126,6 +60,22 @@
             return out;
         }
 
+        std::map<QString, QString> QTCalc::getPluginFuncs() const
+        {
+            // Describe every function by the plugin it comes from, functions that have been replaced in the calculator are left out
+            std::map<QString, QString> out;
+            const std::vector<calc::pluginLoader::pluginInfo> loaded = plugins.getPlugins();
+            for(std::vector<calc::pluginLoader::pluginInfo>::const_iterator plugin = loaded.begin(); plugin != loaded.end(); ++plugin)
+            {
+                for(std::vector<std::string>::const_iterator pos = plugin->functions.begin(); pos != plugin->functions.end(); ++pos)
+                {
+                    if(calculator.getFunction(*pos) == plugins.getFunction(*pos))
+                        out[pos->c_str()] = tr("Plugin %1 %2").arg(plugin->name.c_str()).arg(plugin->version.c_str());
+                }
+            }
+            return out;
+        }
+
         std::map<QString, calc::real> QTCalc::getVars() const throw()
         {
             // Get the variables from the calculator
@@ -140,20 +90,142 @@
             return out;
         }
 
+        std::map<QString, calc::profiler::functionProfile> QTCalc::getProfiles() const
+        {
+            // Copy the measurements of every function to the map
+            const calc::profiler::profileList profiles = calc::profiler::getProfiles();
+            std::map<QString, calc::profiler::functionProfile> out;
+            for(calc::profiler::profileList::const_iterator pos = profiles.begin(); pos != profiles.end(); ++pos)
+                out[pos->first.c_str()] = pos->second;
+            return out;
+        }
+
+        calc::context QTCalc::getContext() const
+        {
+            calc::context out;
+            builtIns.addTo(out);
+            plugins.addTo(out);
+            calc::settingHandler(calculator).copyToContext(out);
+            plugins.useCompiled(out);
+            out.setRandomSeed(calc::calc::getRandomSeed());
+            return out;
+        }
+
+        QString QTCalc::errorMessage(const calc::calcError& err) const
+        {
+            // Find out what message should be displayed
+            QString msg = "";
+            switch(err.type)
+            {
+                case calc::calcError::unknownToken:
+                    if(err.extraRealInfo.size()>0)
+                        msg = tr("Unknown token: '%1', at position %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0] + 1);
+                    else
+                        msg = tr("Unknown token: '%1'").arg(err.extraStringInfo[0].c_str());
+                break;
+
+                case calc::calcError::unexpectedToken:
+                    if(err.msg == "Unexptected '.'")
+                        msg = tr("Unexpected '.' in a number");
+                    else if(err.msg == "Unexpected token")
+                        msg = tr("Unexpected token: '%1', at position %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0] + 1);
+                    else
+                        msg = tr("Unexpected token: '%1'").arg(err.extraStringInfo[0].c_str());
+                break;
+
+                case calc::calcError::unclosedBracket:
+                    msg = tr("You didn't close all brackets, %1 brackets still need to be closed!").arg(err.extraRealInfo[0]);
+                break;
+
+                case calc::calcError::invalidExpression:
+                    if(err.extraStringInfo.size() == 1)
+                        msg = tr("Invalid expression: '%1'").arg(err.extraStringInfo[0].c_str());
+                    else
+                        msg = tr("Invalid expression: '%1', in function %2").arg(err.extraStringInfo[0].c_str(), err.extraStringInfo[1].c_str());
+                break;
+
+                case calc::calcError::invalidOperands:
+                    if(err.msg == "No negative roots allowed")
+                        msg = tr("Can't take the root of a negative value");
+                    else if(err.msg == "Only integer powers of negative numbers")
+                        msg = tr("Only integer powers of negative numbers are allowed");
+                    else if(err.msg == "Division by 0")
+                        msg = tr("Can't divide by 0!");
+                    else if(err.msg == "Modulo by 0")
+                        msg = tr("Can't modulo by 0!");
+                break;
+
+                case calc::calcError::invalidArguments:
+                    if(err.msg == "Too less arguments")
+                        msg = tr("To less arguments: %1 given, %2 expected in function %3").arg(err.extraRealInfo[0]).arg(err.extraRealInfo[1]).arg(err.extraStringInfo[0].c_str());
+                    else if(err.msg == "Too many arguments")
+                        msg = tr("To many arguments: %1 given, %2 expected in function %3").arg(err.extraRealInfo[0]).arg(err.extraRealInfo[1]).arg(err.extraStringInfo[0].c_str());
+                    else if(err.msg == "Only integers allowed")
+                        msg = tr("Only integer arguments are allowed in function %1").arg(err.extraStringInfo[0].c_str());
+                    else if(err.msg == "Not a variable")
+                        msg = tr("Argument %1 of function %2 should be the name of a variable").arg(err.extraRealInfo[0]).arg(err.extraStringInfo[0].c_str());
+                    else if(err.msg == "No root found")
+                        msg = tr("No root found by function %1 near %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0]);
+                    else if(err.msg == "Too many terms")
+                        msg = tr("Function %1 can't calculate more than %2 terms").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0]);
+                    else if(err.msg == "No convergence")
+                        msg = tr("Function %1 doesn't converge, the best estimate is %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0]);
+                    else
+                        msg = tr("Invalid argument: %1, given to function %2").arg(err.extraRealInfo[0]).arg(err.extraStringInfo[0].c_str());
+                break;
+
+                case calc::calcError::unknownName:
+                    msg = tr((err.msg+": %1").c_str()).arg(err.extraStringInfo[0].c_str());        // err.getMsg is of "Unknown function" of "Unknown variable".
+                break;
+
+                case calc::calcError::emptyExpression:
+                    msg = tr("Can't calculate an empty expression!");
+                break;
+
+                case calc::calcError::recursiveCall:
+                    msg = tr("A function may function may not (indirectly) call itself, %1 does").arg(err.extraStringInfo[0].c_str());
+                break;
+
+                default:
+                    msg = tr("An unknown error has occurred!");
+                break;
+            }
+            return msg;
+        }
+
+        bool QTCalc::isProfiling() const
+        { return calc::profiler::isEnabled(); }
+
+        bool QTCalc::exportProfile(const QString& filename, const bool& chromeTrace) const
+        {
+            std::ofstream file(QFile::encodeName(filename).constData());
+            if(chromeTrace)
+                calc::profiler::writeChromeTrace(file);
+            else
+                calc::profiler::writeReport(file);
+            file.flush();
+            return file.good();
+        }
+
         void QTCalc::setSettingFilename(const QString& filename)
         { settingFilename = filename; }
 
+        void QTCalc::setPluginDirectory(const QString& directory)
+        { pluginDirectory = directory; }
+
         QTCalc::outputType QTCalc::getOutputType() const
         { return calcOutputType; }
 
         QTCalc::angleType QTCalc::getAngleType() const
-        { return currAngleType; }
+        { return builtIns.getAngleType() == calc::builtIns::angleDegrees ? angleDegrees : angleRadians; }
 
     // Public slots:
         void QTCalc::calculate(const QString& expr)
         try
         {
             // Calculate the expression, any errors will be caught below
+            calc::calc::resetStatistics();
+            calc::benchmarkMathFunction::forgetLastResult();
             const calc::real out = calculator.calculate(expr.toStdString());
 
             // Determine the output type, and store the output in a string
@@ -161,52 +233,62 @@
             switch(calcOutputType)
             {
                 case outputScientific:
-                    msg = calc::real2str(out, calc::outputType_scientific).c_str();
+                    msg = formatResult(out, calc::outputType_scientific);
                 break;
 
                 case outputBin:
-                    msg = calc::real2str(out, calc::outputType_bin).c_str();
+                    msg = formatResult(out, calc::outputType_bin);
                 break;
 
                 case outputOct:
-                    msg = calc::real2str(out, calc::outputType_oct).c_str();
+                    msg = formatResult(out, calc::outputType_oct);
                 break;
 
                 case outputDec:
-                    msg = calc::real2str(out, calc::outputType_dec).c_str();
+                    msg = formatResult(out, calc::outputType_dec);
                 break;
 
                 case outputHex:
-                    msg = calc::real2str(out, calc::outputType_hex).c_str();
+                    msg = formatResult(out, calc::outputType_hex);
                 break;
 
                 case outputTime:
-                    msg = calc::real2str(out, calc::outputType_time).c_str();
+                    msg = formatResult(out, calc::outputType_time);
                 break;
 
                 case outputAutoDetect:
                     if(expr.indexOf(':')!=-1)
-                        msg = calc::real2str(out, calc::outputType_time).c_str();
+                        msg = formatResult(out, calc::outputType_time);
                     else
-                        msg = calc::real2str(out, calc::outputType_auto).c_str();
+                        msg = formatResult(out, calc::outputType_auto);
                 break;
             }
 
             // Output the result
             result(msg, false);
+            reportStatistics();
+            reportBenchmark();
 
             // Schedule the settings to be saved, since variables may have changed
             saveSettingsLater();
         }
         catch(calc::calcError& err)
-        { calcErrorOccurred(err); }
+        {
+            calcErrorOccurred(err);
+            reportStatistics();
+        }
         catch(calc::overflowError& err)
-        { calcErrorOccurred(err); }
+        {
+            calcErrorOccurred(err);
+            reportStatistics();
+        }
 
         void QTCalc::recalculate()
         try
         {
             // Recalculate the expression, any errors will be caught below
+            calc::calc::resetStatistics();
+            calc::benchmarkMathFunction::forgetLastResult();
             const calc::real out = calculator.calculate();
 
             // Determine the output type, and store the output in a string
@@ -214,47 +296,55 @@
             switch(calcOutputType)
             {
                 case outputScientific:
-                    msg=calc::real2str(out, calc::outputType_scientific).c_str();
+                    msg=formatResult(out, calc::outputType_scientific);
                 break;
 
                 case outputBin:
-                    msg=calc::real2str(out, calc::outputType_bin).c_str();
+                    msg=formatResult(out, calc::outputType_bin);
                 break;
 
                 case outputOct:
-                    msg=calc::real2str(out, calc::outputType_oct).c_str();
+                    msg=formatResult(out, calc::outputType_oct);
                 break;
 
                 case outputDec:
-                    msg=calc::real2str(out, calc::outputType_dec).c_str();
+                    msg=formatResult(out, calc::outputType_dec);
                 break;
 
                 case outputHex:
-                    msg=calc::real2str(out, calc::outputType_hex).c_str();
+                    msg=formatResult(out, calc::outputType_hex);
                 break;
 
                 case outputTime:
-                    msg=calc::real2str(out, calc::outputType_time).c_str();
+                    msg=formatResult(out, calc::outputType_time);
                 break;
 
                 case outputAutoDetect:
                     if(calculator.getExpression().find(':')!=calc::string::npos)
-                        msg=calc::real2str(out, calc::outputType_time).c_str();
+                        msg=formatResult(out, calc::outputType_time);
                     else
-                        msg=calc::real2str(out, calc::outputType_auto).c_str();
+                        msg=formatResult(out, calc::outputType_auto);
                 break;
             }
 
             // Output the result
             result(msg, false);
+            reportStatistics();
+            reportBenchmark();
 
             // Schedule the settings to be saved, since variables may have changed
             saveSettingsLater();
         }
         catch(calc::calcError& err)
-        { calcErrorOccurred(err); }
+        {
+            calcErrorOccurred(err);
+            reportStatistics();
+        }
         catch(calc::overflowError& err)
-        { calcErrorOccurred(err); }
+        {
+            calcErrorOccurred(err);
+            reportStatistics();
+        }
 
         void QTCalc::setVar(const QString& name, const calc::real& value)
         {
@@ -269,8 +359,8 @@
             // Rename the variable
             calculator.renameVar(oldName.toStdString(), newName.toStdString());
             // If there is a built-in variable with the same name as the old name, restore the value of the built-in variable
-            calc::varList::iterator foundPos;
-            if((foundPos = builtInVars.find(oldName.toStdString())) != builtInVars.end())
+            calc::varList::const_iterator foundPos;
+            if((foundPos = builtIns.getVars().find(oldName.toStdString())) != builtIns.getVars().end())
                 calculator.setVar(foundPos->first, foundPos->second);
             // Schedule the settings to be saved
             saveSettingsLater();
@@ -281,8 +371,8 @@
             // Delete the variable
             calculator.deleteVar(name.toStdString());
             // If there is a built-in variable with the same name as the deleted variable, restore the value of the built-in variable
-            calc::varList::iterator foundPos;
-            if((foundPos = builtInVars.find(name.toStdString())) != builtInVars.end())
+            calc::varList::const_iterator foundPos;
+            if((foundPos = builtIns.getVars().find(name.toStdString())) != builtIns.getVars().end())
                 calculator.setVar(foundPos->first, foundPos->second);
             // Schedule the settings to be saved
             saveSettingsLater();
@@ -301,6 +391,8 @@
             else
                 calculator.setFunction(name.toStdString(), new calc::userDefinedMathFunction(content.toStdString(), true));
 
+            // The functions exported to a plugin are only used as long as none of them has been changed
+            plugins.useCompiled(calculator);
             // Schedule the settings to be saved
             saveSettingsLater();
         }
@@ -308,15 +400,16 @@
         void QTCalc::renameFunc(const QString& oldName, const QString& newName)
         {
             // If there is already a built in function with the same name as the new name, we delete it from the calculator
-            if(builtInFunctions.find(newName.toStdString()) != builtInFunctions.end() && !dynamic_cast<calc::userDefinedMathFunction*>(calculator.getFunction(newName.toStdString())))
+            if(getNativeFunc(newName.toStdString()) && !dynamic_cast<calc::userDefinedMathFunction*>(calculator.getFunction(newName.toStdString())))
                 calculator.deleteFunction(newName.toStdString());
 
             // Rename the function
             calculator.renameFunction(oldName.toStdString(), newName.toStdString());
-            calc::functionList::iterator foundPos;
             // If the is a built-in function with the same name as the old name, restore it
-            if((foundPos = builtInFunctions.find(oldName.toStdString())) != builtInFunctions.end())
-                calculator.setFunction(foundPos->first, foundPos->second);
+            if(calc::mathFunction* builtIn = getNativeFunc(oldName.toStdString()))
+                calculator.setFunction(oldName.toStdString(), builtIn);
+            // The functions exported to a plugin are only used as long as none of them has been renamed
+            plugins.useCompiled(calculator);
             // Schedule the settings to be saved
             saveSettingsLater();
         }
@@ -326,15 +419,19 @@
             // Delete the function
             calculator.deleteFunction(name.toStdString());
             // If there is a built-in function with the same name as the deleted function, restore the built-in function
-            calc::functionList::iterator foundPos;
-            if((foundPos=builtInFunctions.find(name.toStdString())) != builtInFunctions.end())
-                calculator.setFunction(foundPos->first, foundPos->second);
+            if(calc::mathFunction* builtIn = getNativeFunc(name.toStdString()))
+                calculator.setFunction(name.toStdString(), builtIn);
+            // The functions exported to a plugin are only used as long as none of them has been deleted
+            plugins.useCompiled(calculator);
             // Schedule the settings to be saved
             saveSettingsLater();
         }
 
         void QTCalc::loadSettings()
         {
+            // The plugins are loaded first, so user defined functions can replace their functions
+            loadPlugins();
+
             try
             {
                 // If the file doesn't exist, there is nothing to be done
@@ -344,6 +441,9 @@
                 settingHandler.loadFromFile((QDir::currentPath()+'/'+settingFilename).toStdString());
                 if(!settingHandler.copyToCalculator(calculator))
                     throw calc::parseError("Corrupted file", (QDir::currentPath()+'/'+settingFilename).toStdString());
+
+                // Functions that have been exported to a plugin are executed by the plugin
+                plugins.useCompiled(calculator);
             }
             // Catch any errors and display the right message
             catch(calc::parseError& err)
@@ -377,82 +477,33 @@
         { calcOutputType = newType; }
 
         void QTCalc::setAngleType(const angleType& newType)
-        { currAngleType = newType; }
+        { builtIns.setAngleType(newType == angleDegrees ? calc::builtIns::angleDegrees : calc::builtIns::angleRadians); }
 
-    // Private slots:
-        void QTCalc::calcErrorOccurred(const calc::calcError& err)
+        void QTCalc::setRandomSeed(const QString& seed)
         {
-            // Find out what message should be displayed and display it
-            QString msg = "";
-            switch(err.type)
-            {
-                case calc::calcError::unknownToken:
-                    if(err.extraRealInfo.size()>0)
-                        msg = tr("Unknown token: '%1', at position %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0] + 1);
-                    else
-                        msg = tr("Unknown token: '%1'").arg(err.extraStringInfo[0].c_str());
-                break;
-
-                case calc::calcError::unexpectedToken:
-                    if(err.msg == "Unexptected '.'")
-                        msg = tr("Unexpected '.' in a number");
-                    else if(err.msg == "Unexpected token")
-                        msg = tr("Unexpected token: '%1', at position %2").arg(err.extraStringInfo[0].c_str()).arg(err.extraRealInfo[0] + 1);
-                    else
-                        msg = tr("Unexpected token: '%1'").arg(err.extraStringInfo[0].c_str());
-                break;
-
-                case calc::calcError::unclosedBracket:
-                    msg = tr("You didn't close all brackets, %1 brackets still need to be closed!").arg(err.extraRealInfo[0]);
-                break;
-
-                case calc::calcError::invalidExpression:
-                    if(err.extraStringInfo.size() == 1)
-                        msg = tr("Invalid expression: '%1'").arg(err.extraStringInfo[0].c_str());
-                    else
-                        msg = tr("Invalid expression: '%1', in function %2").arg(err.extraStringInfo[0].c_str(), err.extraStringInfo[1].c_str());
-                break;
-
-                case calc::calcError::invalidOperands:
-                    if(err.msg == "No negative roots allowed")
-                        msg = tr("Can't take the root of a negative value");
-                    else if(err.msg == "Only integer powers of negative numbers")
-                        msg = tr("Only integer powers of negative numbers are allowed");
-                    else if(err.msg == "Division by 0")
-                        msg = tr("Can't divide by 0!");
-                    else if(err.msg == "Modulo by 0")
-                        msg = tr("Can't modulo by 0!");
-                break;
-
-                case calc::calcError::invalidArguments:
-                    if(err.msg == "Too less arguments")
-                        msg = tr("To less arguments: %1 given, %2 expected in function %3").arg(err.extraRealInfo[0]).arg(err.extraRealInfo[1]).arg(err.extraStringInfo[0].c_str());
-                    else if(err.msg == "Too many arguments")
-                        msg = tr("To many arguments: %1 given, %2 expected in function %3").arg(err.extraRealInfo[0]).arg(err.extraRealInfo[1]).arg(err.extraStringInfo[0].c_str());
-                    else if(err.msg == "Only integers allowed")
-                        msg = tr("Only integer arguments are allowed in function %1").arg(err.extraStringInfo[0].c_str());
-                    else
-                        msg = tr("Invalid argument: %1, given to function %2").arg(err.extraRealInfo[0]).arg(err.extraStringInfo[0].c_str());
-                break;
+            if(seed.isEmpty())
+                calc::calc::setRandomSeed(calc::randomGenerator::unpredictableSeed());
+            else
+                calc::calc::setRandomSeed(seed.toULongLong());
+        }
 
-                case calc::calcError::unknownName:
-                    msg = tr((err.msg+": %1").c_str()).arg(err.extraStringInfo[0].c_str());        // err.getMsg is of "Unknown function" of "Unknown variable".
-                break;
+        void QTCalc::setStatisticsShown(const bool& shown)
+        {
+            // The engine only measures anything while the statistics are shown
+            calc::calc::setInstrumentation(shown);
+            calc::calc::resetStatistics();
+            statistics(shown ? tr("Calculate something to see where the time is spent") : QString());
+        }
 
-                case calc::calcError::emptyExpression:
-                    msg = tr("Can't calculate an empty expression!");
-                break;
+        void QTCalc::setProfiling(const bool& enabled)
+        { calc::profiler::setEnabled(enabled); }
 
-                case calc::calcError::recursiveCall:
-                    msg = tr("A function may function may not (indirectly) call itself, %1 does").arg(err.extraStringInfo[0].c_str());
-                break;
+        void QTCalc::resetProfile()
+        { calc::profiler::reset(); }
 
-                default:
-                    msg = tr("An unknown error has occurred!");
-                break;
-            }
-            result(msg, true);
-        }
+    // Private slots:
+        void QTCalc::calcErrorOccurred(const calc::calcError& err)
+        { result(errorMessage(err), true); }
 
         void QTCalc::calcErrorOccurred(const calc::overflowError& err)
         {
@@ -472,279 +523,64 @@
         }
 
     // Private:
-        void QTCalc::saveSettingsLater()
-        {
-            if(!saveSettingsTimer.isActive())
-                saveSettingsTimer.start();
-        }
-
-        calc::real QTCalc::cos(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::cos(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::cosh(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::cosh(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::acos(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            if(currAngleType == angleDegrees)
-                return mathFunctions::deg(std::acos(args[0]));
-            return std::acos(args[0]);
-        }
-
-        calc::real QTCalc::sin(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::sin(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::sinh(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::sinh(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::asin(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            if(currAngleType == angleDegrees)
-                return mathFunctions::deg(std::asin(args[0]));
-            return std::asin(args[0]);
-        }
-
-        calc::real QTCalc::tan(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::tan(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::tanh(const calc::argList& args)
-        {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            return std::tanh(currAngleType == angleDegrees ? mathFunctions::rad(args[0]) : args[0]);
-        }
-
-        calc::real QTCalc::atan(const calc::argList& args)
+        void QTCalc::reportBenchmark()
         {
-            if(args.size() != 1)
-            {
-                calc::calcError err(args.size() ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-            if(currAngleType == angleDegrees)
-                return mathFunctions::deg(std::atan(args[0]));
-            return std::atan(args[0]);
+            calc::benchmarkMathFunction::result bench;
+            if(calc::benchmarkMathFunction::takeLastResult(bench))
+                message(tr("BENCH: median %1 ns, fastest %2 ns, slowest %3 ns (%4 runs in %5 samples)")
+                        .arg(bench.median, 0, 'f', 1).arg(bench.minimum, 0, 'f', 1).arg(bench.maximum, 0, 'f', 1)
+                        .arg(bench.runs).arg(bench.samples));
         }
 
-        calc::real QTCalc::avg(const calc::argList& args)
+        void QTCalc::loadPlugins()
         {
-            if(args.size() == 0)
-            {
-                calc::calcError err("Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(1);
-                throw err;
-            }
-
-            calc::real total = 0;
-            for(calc::real arg : args)
-                total += arg;
-            return total / args.size();
-        }
-
-        calc::real QTCalc::ncr(const calc::argList& args)
-        {
-            if(args.size() != 2)
-            {
-                calc::calcError err(args.size() > 2 ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(2);
-                throw err;
-            }
-
-            if(std::floor(args[0]) != args[0] || std::floor(args[1]) != args[1])
-                throw calc::calcError("Only integers allowed", calc::calcError::invalidArguments);
-
-            if(args[0] < args[1] || args[1] < 0)
-                return 0;
-
-            unsigned int n = args[0];
-            unsigned int k = args[1];
-
-            unsigned int numerator = 1;
-            for(unsigned int i = n - k + 1; i <= n; ++i)
-                numerator *= i;
-            unsigned int denominator = 1;
-            for(unsigned int i = 1; i <= k; ++i)
-                denominator *= i;
-            return static_cast<calc::real>(numerator) / denominator;
-
+            // Load every plugin in the directory and report the ones that failed
+            const std::vector<std::string> errors = plugins.loadDirectory((QDir::currentPath()+'/'+pluginDirectory).toStdString());
+            for(std::vector<std::string>::const_iterator pos = errors.begin(); pos != errors.end(); ++pos)
+                error(tr("Couldn't load the plugin %1").arg(pos->c_str()));
+            plugins.addTo(calculator);
         }
 
-        calc::real QTCalc::npr(const calc::argList& args)
+        calc::mathFunction* QTCalc::getNativeFunc(const std::string& name) const
         {
-            if(args.size() != 2)
-            {
-                calc::calcError err(args.size() > 2 ? "Too many arguments" : "Too less arguments", calc::calcError::invalidArguments, args.size());
-                err.extraRealInfo.push_back(2);
-                throw err;
-            }
-
-            if(std::floor(args[0]) != args[0] || std::floor(args[1]) != args[1])
-                throw calc::calcError("Only integers allowed", calc::calcError::invalidArguments);
-
-            if(args[0] < args[1] || args[1] < 0)
-                return 0;
-
-            unsigned int n = args[0];
-            unsigned int k = args[1];
-
-            unsigned int result = 1;
-            for(unsigned int i = n - k + 1; i <= n; ++i)
-                result *= i;
-
-            return result;
+            // A plugin function replaces a built-in function with the same name
+            if(calc::mathFunction* function = plugins.getFunction(name))
+                return function;
+            return builtIns.getFunction(name);
         }
 
-// class QTCalcMemberMathFunction:
-    // Public:
-        QTCalcMemberMathFunction::QTCalcMemberMathFunction(function initFunction, QTCalc* obj, const bool& cleanUpNeeded)
-        : calc::mathFunction(cleanUpNeeded), currFunc(initFunction), obj(obj) {}
-
-        calc::real QTCalcMemberMathFunction::execute(const calc::argList& vars, const calc::string& name)
+        void QTCalc::saveSettingsLater()
         {
-            try
-            {
-                // If the object is null-pointer, throw an error
-                if(!obj)
-                    throw calc::calcError("The function couldn't be executed", calc::calcError::unknown, name);
-
-                // Execute the function
-                return (obj->*currFunc)(vars);
-            }
-            catch(calc::calcError& err)
-            {
-                // If the member function throws an error, we only need to attach the name of the function
-                err.extraStringInfo.push_back(name);
-                throw err;
-            }
-            catch(...)
-            { throw calc::calcError("Unknown error", calc::calcError::unknown); }
+            if(!saveSettingsTimer.isActive())
+                saveSettingsTimer.start();
         }
 
-// Functions:
-    namespace mathFunctions
-    {
-        inline double rad(double deg)
-        { return deg/(180/mathConstant::PI); }
-
-        inline double deg(double rad)
-        { return rad*(180/mathConstant::PI); }
-
-        inline double round(double src)
-        { return (src-std::floor(src) < std::ceil(src)-src ? std::floor(src) : std::ceil(src)); }
-
-        inline double faculty(double n)
+        QString QTCalc::formatResult(const calc::real& out, const calc::realOutputType& type) const
         {
-            if(n<0)
-                throw calc::calcError("Invalid argument!", calc::calcError::invalidArguments, n);
-            return (n > 1 ? n*faculty(n-1) : 1);
+            calc::integer exact = 0;
+            if(calculator.getIntegerResult(exact))
+                return calc::integer2str(exact, type).c_str();
+            return calc::real2str(out, type).c_str();
         }
 
-        calc::real random(const calc::argList& vars)
+        void QTCalc::reportStatistics()
         {
-            // Look at the number of arguments, using that we decide how the function  should be executed
-            switch(vars.size())
-            {
-                // No arguments, just a random number between 0 and 1
-                case 0:
-                return static_cast<calc::real>(qrand())/RAND_MAX;
-
-                // One argument, being the maximum value to be returned
-                // So return a random integer between 0 and the argument (included)
-                case 1:
-                    if(vars[0] <= 0)
-                        throw calc::calcError("Invalid argument!", calc::calcError::invalidArguments);
-                return qrand() % static_cast<unsigned int>(vars[0]+1);
-
-                // Two arguments, a minimum and a maximum
-                // So return a random integer between the first and the second argument (both included)
-                case 2:
-                    if(vars[0] >= vars[1])
-                        throw calc::calcError("Invalid argument!", calc::calcError::invalidArguments);
-                return qrand() % static_cast<unsigned int>(vars[1]-vars[0]+1) + vars[0];
-
-                // More arguments means an invalid argument count
-                default:
-                {
-                    calc::calcError err("Too many arguments", calc::calcError::invalidArguments, vars.size());
-                    err.extraRealInfo.push_back(2);
-                    throw err;
-                }
-                break;
-            }
-        }
+            if(!calc::instrumentation::isEnabled())
+                return;
+            const calc::instrumentation::statistics& stats = calc::calc::getStatistics();
 
-        calc::real ifFunction(const calc::argList& vars)
-        {
-            // Check whether the number of arguments is right
-            if(vars.size()<2)
-            {
-                calc::calcError err("Too less arguments", calc::calcError::invalidArguments, vars.size());
-                err.extraRealInfo.push_back(2);
-                throw err;
-            }
+            // The first line shows the time spent in every phase, in microseconds
+            const QString phaseNames[calc::instrumentation::phaseCount] = {tr("lex"), tr("validate"), tr("compile"), tr("evaluate"), tr("functions"), tr("format")};
+            QStringList phases;
+            for(int i = 0; i < calc::instrumentation::phaseCount; ++i)
+                phases<<tr("%1 %2 %3s").arg(phaseNames[i]).arg(stats.nanoseconds[i] / 1000.0, 0, 'f', 1).arg(QChar(0xB5));
 
-            // If the first argument is not 0, the second argument is returned
-            // Otherwise the third argument is returned, the third argument defaults to zero
-            if(vars[0] != 0)
-                return vars[1];
-            else
-                return (vars.size() >= 3 ? vars[2] : 0);
+            // The second line shows the counters
+            const QString counters = tr("%1 tokens, %2 nodes, %3 function calls, %4 allocations, %5 exceptions")
+                                        .arg(stats.counters[calc::instrumentation::counterTokens])
+                                        .arg(stats.counters[calc::instrumentation::counterNodes])
+                                        .arg(stats.counters[calc::instrumentation::counterFunctionCalls])
+                                        .arg(stats.counters[calc::instrumentation::counterAllocations])
+                                        .arg(stats.counters[calc::instrumentation::counterExceptions]);
+            statistics(phases.join(", ")+"\n"+counters);
         }
-    }
@@ -24,6 +24,10 @@
 #include <QTimer>
 #include <map>
 #include "calc/calc.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/pluginloader.h"
+#include "calc/profiler.h"
 
 // Class that makes the calculator engine interact with the GUI
 class QTCalc : public QObject
@@ -43,11 +47,27 @@ class QTCalc : public QObject
 
         // Get a map containing all the functions and their expressions
         std::map<QString, QString> getFuncs() const throw();
+        // Get a map containing all functions of plugins and a description of them
+        std::map<QString, QString> getPluginFuncs() const;
         // Get a map containing all variables and their values
         std::map<QString, calc::real> getVars() const throw();
+        // Get a map containing the measured calls of every function that has been called while profiling
+        std::map<QString, calc::profiler::functionProfile> getProfiles() const;
+        // Get a context with the functions and variables of the calculator, in which other threads can calculate (see calc::context)
+        // It continues the random numbers of RAND where the seed of the calculator starts them.
+        calc::context getContext() const;
+        // Get the message to display for an error
+        QString errorMessage(const calc::calcError& err) const;
+
+        // Returns true if the calls of the functions are measured
+        bool isProfiling() const;
+        // Write the measured calls to a file, as a report or as a Chrome trace, returns false if the file couldn't be written
+        bool exportProfile(const QString& filename, const bool& chromeTrace) const;
 
         // Set the location of the settings file
         void setSettingFilename(const QString& filename);
+        // Set the directory the plugins are loaded from, relative to the settings file
+        void setPluginDirectory(const QString& directory);
 
         // Get the output type
         outputType getOutputType() const;
@@ -74,7 +94,7 @@ class QTCalc : public QObject
         // Delete a function
         void deleteFunc(const QString& name);
 
-        // Load the calculator settings (i.e. the variables and functions)
+        // Load the plugins and the calculator settings (i.e. the variables and functions)
         void loadSettings();
         // Save the calculator settings (i.e. the variables and functions)
         void saveSettings();
@@ -83,12 +103,24 @@ class QTCalc : public QObject
         void setOutputType(const outputType& newType);
         // Change the angle type
         void setAngleType(const angleType& newType);
+        // Start the random numbers of RAND over with the given seed, an empty seed gives different numbers every time
+        void setRandomSeed(const QString& seed);
+        // Set whether the statistics of every calculation are measured and reported
+        void setStatisticsShown(const bool& shown);
+        // Set whether the calls of the functions are measured
+        void setProfiling(const bool& enabled);
+        // Forget the measured calls of the functions
+        void resetProfile();
 
     signals:
         // Reports the result of a calculation
         void result(const QString& msg, const bool& errorOccurred);
         // Reports an error
         void error(const QString& msg);
+        // Reports where the time of the last calculation was spent, only if the statistics are shown
+        void statistics(const QString& text);
+        // Reports something about the last calculation that isn't an error, e.g. the spread measured by BENCH()
+        void message(const QString& msg);
 
     private slots:
         // Functions to handle a calculator error and display the right error
@@ -98,95 +130,36 @@ class QTCalc : public QObject
     private:
         // Schedules the settings to be saved in a while
         void saveSettingsLater();
-
+        // Report the statistics of the last calculation, if they're shown
+        void reportStatistics();
+        // Report the spread of the last BENCH() of the last calculation, if it called BENCH()
+        void reportBenchmark();
+        // Write the result of the last calculation in the given format, integers that were calculated exactly are written exactly
+        QString formatResult(const calc::real& out, const calc::realOutputType& type) const;
+        // Load the plugins in the plugin directory and add their functions to the calculator
+        void loadPlugins();
+        // Get the function of a plugin or the built-in function with the given name, returns 0 if there is none
+        calc::mathFunction* getNativeFunc(const std::string& name) const;
+
+        // The built-in functions and variables, these need to outlive the calculator
+        calc::builtIns builtIns;
+        // The plugins adding functions, these need to outlive the calculator as well
+        calc::pluginLoader plugins;
         // Calculator, the engine
         calc::calc calculator;
 
         // The filename of the settings file
         QString settingFilename;
+        // The directory the plugins are loaded from
+        QString pluginDirectory;
         // The setting handler
         calc::settingHandler settingHandler;
 
         // The current output type
         outputType calcOutputType;
-        // The current angle type
-        angleType currAngleType;
 
         // Timer used to schedule saving the settings
         QTimer saveSettingsTimer;
-
-        // A list of built-in variables
-        calc::varList builtInVars;
-        // A list of built-in functions
-        calc::functionList builtInFunctions;
-
-        // Some built-in functions, the names are self explaining
-        // The current angle type is used for the type of angles
-        inline calc::real cos(const calc::argList& args);
-        inline calc::real cosh(const calc::argList& args);
-        inline calc::real acos(const calc::argList& args);
-        inline calc::real sin(const calc::argList& args);
-        inline calc::real sinh(const calc::argList& args);
-        inline calc::real asin(const calc::argList& args);
-        inline calc::real tan(const calc::argList& args);
-        inline calc::real tanh(const calc::argList& args);
-        inline calc::real atan(const calc::argList& args);
-        inline calc::real avg(const calc::argList& args);
-        inline calc::real ncr(const calc::argList& args);
-        inline calc::real npr(const calc::argList& args);
-};
-
-// Class to make member functions from the QTCalc class available as math functions for the calculator engine
-class QTCalcMemberMathFunction : public calc::mathFunction
-{
-    public:
-        // Typedef what a function is
-        typedef calc::real (QTCalc::*function)(const calc::argList&);
-
-        // Constructor
-        QTCalcMemberMathFunction(function initFunction, QTCalc* obj, const bool& cleanUpNeeded = false);
-
-        // Execute this function
-        calc::real execute(const calc::argList& vars, const calc::string& name);
-
-    private:
-        // The current function to be executed by execute()
-        function currFunc;
-
-        // The object that should be used by execute() to execute the function on
-        QTCalc* obj;
 };
 
-// Some constants
-namespace mathConstant
-{
-    const double PI     = 3.1415926535897932385;
-    const double E      = 2.718281828459;
-    const double PHI    = 1.618033988749895;
-}
-
-// Some built-in functions
-namespace mathFunctions
-{
-    // Convert the number of degrees to radians
-    inline double rad(double deg);
-    // Convert the number of radians to degrees
-    inline double deg(double rad);
-    // Rounds the number to the nearest integer
-    inline double round(double src);
-    // Returns the faculty of n, in other words: n!
-    inline double faculty(double n);
-
-    // Returns a random argument
-    // What numbers are possible depends on the number of arguments:
-    //  0 =>    A random number in the range [0, 1] is returned
-    //  1 =>    A random integer in the range [0, firstArgument] is returned
-    //  2 =>    A random integer in the range [firstArgument, secondArgument] is returned
-    calc::real random(const calc::argList& vars);
-
-    // If the first argument is not 0, the second argument is returned
-    // Otherwise the third argument is returned, the third argument defaults to zero
-    calc::real ifFunction(const calc::argList& vars);
-}
-
 #endif // QTCALC_H
@@ -0,0 +1,166 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/settinghandler.h"
+#include "calc/pluginloader.h"
+#include "server.h"
+
+namespace
+{
+    // The server, used by the signal handler
+    server::socketServer* runningServer = 0;
+
+    // Stops the server when the process is asked to terminate
+    void stopServer(int)
+    {
+        if(runningServer)
+            runningServer->stop();
+    }
+
+    // Prints how this program should be used
+    void printUsage(std::ostream& out)
+    {
+        out<<"Usage: dalculatord [options]\n"
+             "Calculates expressions sent to a Unix domain socket, see server/protocol.h for the protocol.\n"
+             "\n"
+             "Options:\n"
+             "  -s, --socket PATH      The path of the socket, $XDG_RUNTIME_DIR/dalculator.sock by default\n"
+             "  -t, --threads N        The number of threads handling requests, one per processor by default\n"
+             "      --settings FILE    Load the variables and functions from a settings file of Dalculator\n"
+             "      --plugins DIR      Load the functions of the plugins (shared libraries) in the directory DIR\n"
+             "  -d, --degrees          Use degrees instead of radians for goniometric functions\n"
+             "      --seed N           Start the random numbers of RAND with the seed N, the same seed gives the same numbers\n"
+             "  -h, --help             Show this help\n";
+    }
+
+    // Get the default path of the socket
+    calc::string defaultSocketPath()
+    {
+        const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+        if(runtimeDir && *runtimeDir)
+            return calc::string(runtimeDir) + "/dalculator.sock";
+        std::ostringstream path;
+        path<<"/tmp/dalculator-"<<getuid()<<".sock";
+        return path.str();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // The options, set by the command line arguments
+    calc::string socketPath = defaultSocketPath();
+    size_t threadCount = std::thread::hardware_concurrency();
+    calc::string settingsFile;
+    calc::string pluginDirectory;
+    calc::builtIns::angleType angleType = calc::builtIns::angleRadians;
+    calc::string seed;
+
+    // Read the command line arguments
+    for(int i = 1; i < argc; ++i)
+    {
+        const calc::string arg = argv[i];
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        else if((arg == "-s" || arg == "--socket") && i+1 < argc)
+            socketPath = argv[++i];
+        else if((arg == "-t" || arg == "--threads") && i+1 < argc)
+            threadCount = std::strtoul(argv[++i], 0, 10);
+        else if(arg == "--settings" && i+1 < argc)
+            settingsFile = argv[++i];
+        else if(arg == "--plugins" && i+1 < argc)
+            pluginDirectory = argv[++i];
+        else if(arg == "-d" || arg == "--degrees")
+            angleType = calc::builtIns::angleDegrees;
+        else if(arg == "--seed" && i+1 < argc)
+            seed = argv[++i];
+        else
+        {
+            printUsage(std::cerr);
+            return 2;
+        }
+    }
+
+    // The built-in functions and the plugins need to outlive the server
+    calc::builtIns builtIns(angleType);
+    calc::pluginLoader plugins;
+    calc::context definitions;
+    builtIns.addTo(definitions);
+    if(!seed.empty())
+        definitions.setRandomSeed(std::strtoull(seed.c_str(), 0, 10));
+
+    // Add the functions of the plugins, plugins that couldn't be loaded are reported but don't stop the server
+    if(!pluginDirectory.empty())
+    {
+        const std::vector<calc::string> errors = plugins.loadDirectory(pluginDirectory);
+        for(std::vector<calc::string>::const_iterator pos = errors.begin(); pos != errors.end(); ++pos)
+            std::cerr<<"Couldn't load the plugin "<<*pos<<std::endl;
+        plugins.addTo(definitions);
+    }
+
+    // Load the variables and functions of the user
+    if(!settingsFile.empty())
+    {
+        try
+        {
+            calc::settingHandler settings;
+            settings.loadFromFile(settingsFile);
+            if(!settings.copyToContext(definitions))
+                throw calc::parseError("Corrupted file", settingsFile);
+        }
+        catch(calc::parseError& err)
+        {
+            std::cerr<<"Couldn't load the settings from "<<settingsFile<<": "<<err.msg<<std::endl;
+            return 2;
+        }
+        catch(calc::fileError& err)
+        {
+            std::cerr<<"Couldn't load the settings from "<<err.fileName<<std::endl;
+            return 2;
+        }
+    }
+
+    // Functions of the user that have been exported to a plugin are executed by the plugin
+    plugins.useCompiled(definitions);
+
+    // Start the server, it runs until the process is interrupted or terminated
+    server::socketServer socketServer(definitions, threadCount);
+    try
+    { socketServer.listen(socketPath); }
+    catch(calc::fileError& err)
+    {
+        std::cerr<<"Couldn't create the socket "<<err.fileName<<std::endl;
+        return 2;
+    }
+    runningServer = &socketServer;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    socketServer.run();
+    runningServer = 0;
+    return 0;
+}
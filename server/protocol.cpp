@@ -0,0 +1,108 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "protocol.h"
+#include <cstring>
+
+namespace server
+{
+    namespace protocol
+    {
+        // reader:
+            reader::reader(const calc::string& message)
+            : message(message), pos(0) {}
+
+            bool reader::readByte(std::uint8_t& out)
+            {
+                if(pos + 1 > message.size())
+                    return false;
+                out = static_cast<std::uint8_t>(message[pos++]);
+                return true;
+            }
+
+            bool reader::readUInt32(std::uint32_t& out)
+            {
+                if(pos + 4 > message.size())
+                    return false;
+                out = 0;
+                for(int i = 3; i >= 0; --i)
+                    out = (out << 8) | static_cast<std::uint8_t>(message[pos + i]);
+                pos += 4;
+                return true;
+            }
+
+            bool reader::readReal(calc::real& out)
+            {
+                if(pos + 8 > message.size())
+                    return false;
+                std::uint64_t bits = 0;
+                for(int i = 7; i >= 0; --i)
+                    bits = (bits << 8) | static_cast<std::uint8_t>(message[pos + i]);
+                std::memcpy(&out, &bits, sizeof(out));
+                pos += 8;
+                return true;
+            }
+
+            bool reader::readString(calc::string& out)
+            {
+                std::uint32_t length;
+                if(!readUInt32(length) || pos + length > message.size())
+                    return false;
+                out.assign(message, pos, length);
+                pos += length;
+                return true;
+            }
+
+            void reader::readRest(calc::string& out)
+            {
+                out.assign(message, pos, calc::string::npos);
+                pos = message.size();
+            }
+
+        // Functions:
+            void writeByte(calc::string& message, const std::uint8_t& value)
+            { message += static_cast<char>(value); }
+
+            void writeUInt32(calc::string& message, const std::uint32_t& value)
+            {
+                for(int i = 0; i < 4; ++i)
+                    message += static_cast<char>((value >> (8*i)) & 0xff);
+            }
+
+            void writeReal(calc::string& message, const calc::real& value)
+            {
+                std::uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                for(int i = 0; i < 8; ++i)
+                    message += static_cast<char>((bits >> (8*i)) & 0xff);
+            }
+
+            void writeString(calc::string& message, const calc::string& value)
+            {
+                writeUInt32(message, value.size());
+                message += value;
+            }
+
+            void finishMessage(calc::string& message)
+            {
+                calc::string length;
+                writeUInt32(length, message.size());
+                message.insert(0, length);
+            }
+    }
+}
@@ -0,0 +1,103 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+#include "calc/types.h"
+
+namespace server
+{
+    // The protocol spoken over the socket of the server
+    // Every message starts with its length as a 32 bits unsigned integer, followed by that number of bytes.
+    // All integers are little endian, reals are IEEE 754 doubles sent as a little endian 64 bits integer.
+    // Strings are sent as a 32 bits length followed by the bytes, except when a string is the last field of a message.
+    //
+    // A request consists of:
+    //   type (8 bits)   The type of request, see requestType
+    //   id (32 bits)    Chosen by the client, the response carries the same id
+    //   fields          Depending on the type:
+    //     requestEvaluate      expression (rest of the message)
+    //     requestBatch         count (32 bits), followed by count expressions (strings)
+    //     requestSetVar        name (string), value (real)
+    //     requestDefine        name (string), expression (rest of the message)
+    //     requestDelete        name (rest of the message), the variable and the function with that name are deleted
+    //
+    // A response consists of the type and id of the request, followed by:
+    //   requestBatch           count (32 bits), followed by count results
+    //   any other request      one result
+    // A result is a status (8 bits), followed by the value (real) if the status is statusOk,
+    // or by a human readable message (string) if the status is statusError.
+    //
+    // A client may send several requests without waiting for the responses (pipelining).
+    // The requests of one connection are handled in the order in which they are sent, the responses are sent in the same order.
+    namespace protocol
+    {
+        // The types of requests
+        enum requestType
+        {
+            requestEvaluate = 'e',
+            requestBatch    = 'b',
+            requestSetVar   = 'v',
+            requestDefine   = 'f',
+            requestDelete   = 'd'
+        };
+
+        // The status of a result
+        enum resultStatus
+        {
+            statusOk    = 0,
+            statusError = 1
+        };
+
+        // The maximum length of a message, longer messages close the connection
+        const std::uint32_t maxMessageLength = 64*1024*1024;
+
+        // Reads the fields of a message
+        class reader
+        {
+            public:
+                // Constructor, the message has to outlive the reader
+                reader(const calc::string& message);
+
+                // Read a field, returns false if the message is too short
+                bool readByte(std::uint8_t& out);
+                bool readUInt32(std::uint32_t& out);
+                bool readReal(calc::real& out);
+                bool readString(calc::string& out);
+                // Read everything that's left in the message
+                void readRest(calc::string& out);
+
+            private:
+                const calc::string& message;        // The message
+                size_t pos;                         // The position of the next field
+        };
+
+        // Append fields to a message
+        void writeByte(calc::string& message, const std::uint8_t& value);
+        void writeUInt32(calc::string& message, const std::uint32_t& value);
+        void writeReal(calc::string& message, const calc::real& value);
+        void writeString(calc::string& message, const calc::string& value);
+
+        // Append the length of a message in front of it, after this the message can be sent
+        void finishMessage(calc::string& message);
+    }
+}
+
+#endif // PROTOCOL_H
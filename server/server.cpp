@@ -0,0 +1,454 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "server.h"
+#include "protocol.h"
+#include "cli/messages.h"
+#include <deque>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace server
+{
+    namespace
+    {
+        // The number of expressions of a batch that are handled by one thread at a time
+        const size_t batchChunkSize = 64;
+        // The maximum number of compiled expressions that are cached
+        const size_t maxCachedPrograms = 16384;
+
+        // Send all bytes, returns false if the connection is broken
+        bool sendAll(const int& socket, const calc::string& data)
+        {
+            size_t sent = 0;
+            while(sent < data.size())
+            {
+                const ssize_t result = ::send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if(result < 0 && errno == EINTR)
+                    continue;
+                if(result <= 0)
+                    return false;
+                sent += result;
+            }
+            return true;
+        }
+
+        // Write an error result
+        void writeError(calc::string& response, const calc::string& message)
+        {
+            protocol::writeByte(response, protocol::statusError);
+            protocol::writeString(response, message);
+        }
+
+        // Write a succesful result
+        void writeValue(calc::string& response, const calc::real& value)
+        {
+            protocol::writeByte(response, protocol::statusOk);
+            protocol::writeReal(response, value);
+        }
+    }
+
+    // A connection with a client
+    struct socketServer::connection
+    {
+        int socket;                                 // The socket of the connection
+        std::deque<calc::string> requests;          // The requests that are waiting to be handled
+        bool handling;                              // Whether a task of the pool is handling the requests
+        std::mutex mutex;                           // Protects requests and handling
+
+        connection(const int& socket)
+        : socket(socket), handling(false) {}
+
+        ~connection()
+        { ::close(socket); }
+    };
+
+    // sharedContext:
+        // Public:
+            sharedContext::sharedContext(const calc::context& initial)
+            : current(new calc::context(initial)) {}
+
+            std::shared_ptr<const calc::context> sharedContext::snapshot() const
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                return current;
+            }
+
+            void sharedContext::commit(const std::vector<const calc::contextFrame*>& frames)
+            {
+                change([&frames](calc::context& next)
+                {
+                    for(size_t i = 0; i < frames.size(); ++i)
+                        frames[i]->commit(next);
+                });
+            }
+
+            void sharedContext::change(const std::function<void(calc::context&)>& modifier)
+            {
+                // The new version is a copy of the latest version, requests that are running keep their own snapshot
+                std::lock_guard<std::mutex> lock(mutex);
+                std::shared_ptr<calc::context> next(new calc::context(*current));
+                modifier(*next);
+                current = next;
+            }
+
+    // socketServer:
+        // Public:
+            socketServer::socketServer(const calc::context& definitions, const size_t& threadCount)
+            : definitions(definitions), listenSocket(-1), pool(threadCount) {}
+
+            socketServer::~socketServer()
+            { stop(); }
+
+            void socketServer::listen(const calc::string& path)
+            {
+                // The path has to fit in the address
+                sockaddr_un address;
+                std::memset(&address, 0, sizeof(address));
+                address.sun_family = AF_UNIX;
+                if(path.empty() || path.size() >= sizeof(address.sun_path))
+                    throw calc::fileError(path, calc::fileError::action_opening);
+                std::strcpy(address.sun_path, path.c_str());
+
+                // Create the socket, replacing a socket left behind by an earlier run
+                const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if(fd < 0)
+                    throw calc::fileError(path, calc::fileError::action_opening);
+                ::unlink(path.c_str());
+                if(::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0)
+                {
+                    ::close(fd);
+                    throw calc::fileError(path, calc::fileError::action_opening);
+                }
+                socketPath = path;
+                listenSocket = fd;
+            }
+
+            void socketServer::run()
+            {
+                // Accept connections, every connection gets its own thread reading the requests
+                while(true)
+                {
+                    const int fd = listenSocket;
+                    if(fd < 0)
+                        break;
+                    const int client = ::accept(fd, 0, 0);
+                    if(client < 0)
+                    {
+                        if(errno == EINTR || errno == ECONNABORTED)
+                            continue;
+                        break;
+                    }
+
+                    connectionPtr conn(new connection(client));
+                    {
+                        std::lock_guard<std::mutex> lock(connectionsMutex);
+                        connections.push_back(conn);
+                    }
+                    std::thread(&socketServer::readConnection, this, conn).detach();
+                }
+
+                // Stop reading from the connections, the responses to the requests that have been read are still sent
+                std::unique_lock<std::mutex> lock(connectionsMutex);
+                for(std::list<connectionPtr>::const_iterator pos = connections.begin(); pos != connections.end(); ++pos)
+                    ::shutdown((*pos)->socket, SHUT_RD);
+                connectionClosed.wait(lock, [this]{ return connections.empty(); });
+                if(!socketPath.empty())
+                    ::unlink(socketPath.c_str());
+            }
+
+            void socketServer::stop()
+            {
+                // Only async-signal-safe functions are used here
+                const int fd = listenSocket.exchange(-1);
+                if(fd >= 0)
+                {
+                    ::shutdown(fd, SHUT_RDWR);
+                    ::close(fd);
+                }
+            }
+
+        // Private:
+            void socketServer::readConnection(connectionPtr conn)
+            {
+                // Read as much as possible at once, a read may contain several (pipelined) requests
+                calc::string buffer;
+                char data[65536];
+                bool broken = false;
+                while(!broken)
+                {
+                    const ssize_t received = ::recv(conn->socket, data, sizeof(data), 0);
+                    if(received < 0 && errno == EINTR)
+                        continue;
+                    if(received <= 0)
+                        break;
+                    buffer.append(data, received);
+
+                    // Take all complete requests out of the buffer
+                    std::vector<calc::string> requests;
+                    size_t pos = 0;
+                    while(buffer.size() - pos >= 4)
+                    {
+                        calc::string header(buffer, pos, 4);
+                        std::uint32_t length;
+                        protocol::reader(header).readUInt32(length);
+                        if(length > protocol::maxMessageLength)
+                        {
+                            broken = true;
+                            break;
+                        }
+                        if(buffer.size() - pos - 4 < length)
+                            break;
+                        requests.push_back(buffer.substr(pos + 4, length));
+                        pos += 4 + length;
+                    }
+                    buffer.erase(0, pos);
+                    if(requests.empty())
+                        continue;
+
+                    // Queue them, and let the pool handle them if it isn't doing so already
+                    std::lock_guard<std::mutex> lock(conn->mutex);
+                    conn->requests.insert(conn->requests.end(), requests.begin(), requests.end());
+                    if(!conn->handling)
+                    {
+                        conn->handling = true;
+                        pool.submit([this, conn]{ handleRequests(conn); });
+                    }
+                }
+
+                // The connection is closed, it's destroyed as soon as its last requests are handled
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                connections.remove(conn);
+                connectionClosed.notify_all();
+            }
+
+            void socketServer::handleRequests(connectionPtr conn)
+            {
+                // Handle the requests in the order they came in, the responses to all waiting requests are sent at once
+                while(true)
+                {
+                    std::deque<calc::string> requests;
+                    {
+                        std::lock_guard<std::mutex> lock(conn->mutex);
+                        if(conn->requests.empty())
+                        {
+                            conn->handling = false;
+                            return;
+                        }
+                        requests.swap(conn->requests);
+                    }
+
+                    calc::string responses;
+                    for(std::deque<calc::string>::const_iterator pos = requests.begin(); pos != requests.end(); ++pos)
+                        responses += handleRequest(*pos);
+                    sendAll(conn->socket, responses);
+                }
+            }
+
+            calc::string socketServer::handleRequest(const calc::string& request)
+            {
+                // Every response starts with the type and id of the request
+                protocol::reader in(request);
+                std::uint8_t type = 0;
+                std::uint32_t id = 0;
+                calc::string response;
+                const bool validHeader = in.readByte(type) && in.readUInt32(id);
+                protocol::writeByte(response, type);
+                protocol::writeUInt32(response, id);
+                if(!validHeader)
+                {
+                    writeError(response, "Invalid request");
+                    protocol::finishMessage(response);
+                    return response;
+                }
+
+                switch(type)
+                {
+                    case protocol::requestEvaluate:
+                    {
+                        // Evaluate the expression on the current version of the context, and keep its assignments if it succeeded
+                        calc::string expression;
+                        in.readRest(expression);
+                        std::shared_ptr<const calc::context> snapshot = definitions.snapshot();
+                        calc::contextFrame frame(*snapshot);
+                        if(evaluate(expression, frame, response) && frame.hasAssignments())
+                            definitions.commit(std::vector<const calc::contextFrame*>(1, &frame));
+                    }
+                    break;
+
+                    case protocol::requestBatch:
+                    {
+                        // Read all expressions
+                        std::uint32_t count = 0;
+                        std::vector<calc::string> expressions;
+                        bool valid = in.readUInt32(count);
+                        for(std::uint32_t i = 0; i < count && valid; ++i)
+                        {
+                            expressions.push_back(calc::string());
+                            valid = in.readString(expressions.back());
+                        }
+                        if(!valid)
+                        {
+                            writeError(response, "Invalid request");
+                            break;
+                        }
+
+                        // All expressions are evaluated on the same snapshot, in chunks spread over the pool
+                        std::shared_ptr<const calc::context> snapshot = definitions.snapshot();
+                        // Every expression gets its own stream of random numbers, split off in the order of the expressions,
+                        // so the results don't depend on the number of threads or on which thread calculates which expression
+                        calc::randomGenerator random = snapshot->getRandom();
+                        std::vector<calc::randomGenerator> streams;
+                        streams.reserve(count);
+                        for(std::uint32_t i = 0; i < count; ++i)
+                            streams.push_back(random.split());
+                        std::vector<std::unique_ptr<calc::contextFrame> > frames(count);
+                        std::vector<calc::string> results(count);
+                        std::vector<char> succeeded(count, 0);
+                        pool.parallelFor((count + batchChunkSize - 1) / batchChunkSize, [&](size_t chunk)
+                        {
+                            for(size_t i = chunk * batchChunkSize; i < count && i < (chunk + 1) * batchChunkSize; ++i)
+                            {
+                                frames[i].reset(new calc::contextFrame(*snapshot));
+                                frames[i]->useRandomStream(streams[i]);
+                                succeeded[i] = evaluate(expressions[i], *frames[i], results[i]);
+                            }
+                        });
+
+                        // The assignments of the expressions that succeeded are kept, in the order of the expressions
+                        // If any expression used RAND, the context continues after the streams that were split off
+                        std::vector<const calc::contextFrame*> assigning;
+                        bool drawn = false;
+                        for(size_t i = 0; i < count; ++i)
+                        {
+                            if(succeeded[i] && frames[i]->hasAssignments())
+                                assigning.push_back(frames[i].get());
+                            drawn |= frames[i]->getRandom() != streams[i];
+                        }
+                        if(drawn)
+                        {
+                            definitions.change([&](calc::context& next)
+                            {
+                                for(size_t i = 0; i < assigning.size(); ++i)
+                                    assigning[i]->commit(next);
+                                next.setRandom(random);
+                            });
+                        }
+                        else if(!assigning.empty())
+                            definitions.commit(assigning);
+
+                        // Write the results
+                        protocol::writeUInt32(response, count);
+                        for(size_t i = 0; i < count; ++i)
+                            response += results[i];
+                    }
+                    break;
+
+                    case protocol::requestSetVar:
+                    {
+                        calc::string name;
+                        calc::real value;
+                        if(!in.readString(name) || !in.readReal(value) || name.empty())
+                        {
+                            writeError(response, "Invalid request");
+                            break;
+                        }
+                        definitions.change([&](calc::context& next){ next.setVar(name, value); });
+                        writeValue(response, value);
+                    }
+                    break;
+
+                    case protocol::requestDefine:
+                    {
+                        calc::string name, expression;
+                        if(!in.readString(name) || name.empty())
+                        {
+                            writeError(response, "Invalid request");
+                            break;
+                        }
+                        in.readRest(expression);
+
+                        // Unlike the calculator, functions with an invalid expression are refused right away
+                        try
+                        { calc::context::compile(expression); }
+                        catch(calc::calcError& err)
+                        {
+                            writeError(response, cli::errorMessage(err));
+                            break;
+                        }
+                        definitions.change([&](calc::context& next){ next.defineFunction(name, expression); });
+                        writeValue(response, 0);
+                    }
+                    break;
+
+                    case protocol::requestDelete:
+                    {
+                        calc::string name;
+                        in.readRest(name);
+                        bool deleted = false;
+                        definitions.change([&](calc::context& next){ deleted = next.deleteVar(name) | next.deleteFunction(name); });
+                        writeValue(response, deleted);
+                    }
+                    break;
+
+                    default:
+                        writeError(response, "Unknown request type");
+                    break;
+                }
+
+                protocol::finishMessage(response);
+                return response;
+            }
+
+            bool socketServer::evaluate(const calc::string& expression, calc::contextFrame& frame, calc::string& response)
+            {
+                try
+                {
+                    std::shared_ptr<const calc::program> prog = compile(expression);
+                    writeValue(response, frame.execute(*prog));
+                    return true;
+                }
+                catch(calc::calcError& err)
+                { writeError(response, cli::errorMessage(err)); }
+                catch(calc::overflowError& err)
+                { writeError(response, cli::errorMessage(err)); }
+                return false;
+            }
+
+            std::shared_ptr<const calc::program> socketServer::compile(const calc::string& expression)
+            {
+                // Look in the cache first
+                {
+                    std::lock_guard<std::mutex> lock(programsMutex);
+                    std::map<calc::string, std::shared_ptr<const calc::program> >::const_iterator pos = programs.find(expression);
+                    if(pos != programs.end())
+                        return pos->second;
+                }
+
+                // Compile the expression without holding the lock, then add it to the cache
+                std::shared_ptr<const calc::program> prog = calc::context::compile(expression);
+                std::lock_guard<std::mutex> lock(programsMutex);
+                if(programs.size() >= maxCachedPrograms)
+                    programs.clear();
+                programs[expression] = prog;
+                return prog;
+            }
+}
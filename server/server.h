@@ -0,0 +1,109 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <map>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include "calc/context.h"
+#include "threadpool.h"
+
+namespace server
+{
+    // The variables and functions shared by all clients
+    // Every request works on a snapshot: the version of the context at the moment the request started.
+    // Assignments are collected while the request is handled and written to a new version of the context when it succeeded,
+    // so other requests never see the changes of a request that is still running (snapshot isolation).
+    // When two requests assign the same variable, the one that finishes last wins.
+    class sharedContext
+    {
+        public:
+            // Constructor, set the first version of the context
+            sharedContext(const calc::context& initial);
+
+            // Get the current version of the context
+            std::shared_ptr<const calc::context> snapshot() const;
+            // Write the assignments collected by the frames to a new version of the context
+            void commit(const std::vector<const calc::contextFrame*>& frames);
+            // Change the context, the change is applied to a new version of the context
+            void change(const std::function<void(calc::context&)>& modifier);
+
+        private:
+            std::shared_ptr<const calc::context> current;   // The current version
+            mutable std::mutex mutex;                       // Protects current
+    };
+
+    // Answers requests on a Unix domain socket, see protocol.h for the messages
+    // Every connection is read by its own thread, the requests are handled by a thread pool.
+    class socketServer
+    {
+        public:
+            // Constructor, the server uses the given variables and functions and handles requests using threadCount threads
+            socketServer(const calc::context& definitions, const size_t& threadCount);
+            // Destructor
+            ~socketServer();
+
+            // Listen on the socket with the given path, a file that already exists at that path is removed
+            // Throws a calc::fileError if the socket can't be created
+            void listen(const calc::string& path);
+            // Accept connections until stop() is called
+            void run();
+            // Stop the server, this may be called from a signal handler
+            void stop();
+
+        private:
+            // Prevent copying:
+            socketServer& operator=(const socketServer& other);
+            socketServer(const socketServer& other);
+
+            struct connection;
+            typedef std::shared_ptr<connection> connectionPtr;
+
+            // Read the requests of a connection until it's closed
+            void readConnection(connectionPtr conn);
+            // Handle the requests that are waiting in a connection, one at a time
+            void handleRequests(connectionPtr conn);
+            // Handle a single request, returns the response
+            calc::string handleRequest(const calc::string& request);
+
+            // Evaluate an expression in a frame on a snapshot, the result is written to the response
+            // The frame collects the assignments, returns true if the expression was evaluated succesfully
+            bool evaluate(const calc::string& expression, calc::contextFrame& frame, calc::string& response);
+            // Get the compiled form of an expression, compiled programs are cached
+            std::shared_ptr<const calc::program> compile(const calc::string& expression);
+
+            sharedContext definitions;                                          // The variables and functions
+
+            std::map<calc::string, std::shared_ptr<const calc::program> > programs;    // The compiled expressions
+            std::mutex programsMutex;                                           // Protects programs
+
+            std::atomic<int> listenSocket;                                      // The socket accepting connections, -1 if stopped
+            calc::string socketPath;                                            // The path of that socket
+            std::list<connectionPtr> connections;                               // The open connections
+            std::mutex connectionsMutex;                                        // Protects connections
+            std::condition_variable connectionClosed;                           // Signalled when a connection is removed from connections
+
+            threadPool pool;                                                    // The threads handling the requests, destroyed first
+    };
+}
+
+#endif // SERVER_H
@@ -0,0 +1,23 @@
+# -------------------------------------------------
+# Calculation server of Dalculator
+# -------------------------------------------------
+TARGET = dalculatord
+TEMPLATE = app
+
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+include(../calc/calc.pri)
+
+SOURCES += main.cpp \
+    protocol.cpp \
+    server.cpp \
+    threadpool.cpp \
+    ../cli/messages.cpp
+HEADERS += protocol.h \
+    server.h \
+    threadpool.h \
+    ../cli/messages.h
+
+target.path = /usr/bin
+INSTALLS += target
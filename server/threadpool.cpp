@@ -0,0 +1,122 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "threadpool.h"
+#include <atomic>
+#include <memory>
+
+namespace server
+{
+    namespace
+    {
+        // The shared state of a parallelFor(), the threads of the pool may still hold it after parallelFor() returned
+        struct parallelLoop
+        {
+            size_t count;                                   // The number of iterations
+            std::function<void(size_t)> body;               // The body of the loop
+            std::atomic<size_t> next;                       // The next iteration that isn't claimed by a thread
+            std::atomic<size_t> done;                       // The number of iterations that are done
+            std::mutex mutex;                               // Used to wait for done
+            std::condition_variable finished;               // Signalled when all iterations are done
+
+            // Execute iterations until there are none left
+            void run()
+            {
+                size_t i;
+                while((i = next++) < count)
+                {
+                    body(i);
+                    if(++done == count)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        finished.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    // Public:
+        threadPool::threadPool(const size_t& threadCount)
+        : stopping(false)
+        {
+            for(size_t i = 0; i < (threadCount > 0 ? threadCount : 1); ++i)
+                threads.push_back(std::thread(&threadPool::worker, this));
+        }
+
+        threadPool::~threadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                taskAdded.notify_all();
+            }
+            for(size_t i = 0; i < threads.size(); ++i)
+                threads[i].join();
+        }
+
+        size_t threadPool::size() const
+        { return threads.size(); }
+
+        void threadPool::submit(const std::function<void()>& task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(task);
+            taskAdded.notify_one();
+        }
+
+        void threadPool::parallelFor(const size_t& count, const std::function<void(size_t)>& body)
+        {
+            if(count == 0)
+                return;
+
+            // Let some threads of the pool help, the calling thread does its part as well
+            // A thread that starts after all iterations are claimed just returns, so waiting for the helpers isn't needed
+            std::shared_ptr<parallelLoop> loop(new parallelLoop());
+            loop->count = count;
+            loop->body = body;
+            loop->next = 0;
+            loop->done = 0;
+            for(size_t i = 1; i < count && i <= threads.size(); ++i)
+                submit([loop]{ loop->run(); });
+            loop->run();
+
+            // Wait until the iterations claimed by the helpers are done as well
+            std::unique_lock<std::mutex> lock(loop->mutex);
+            loop->finished.wait(lock, [&loop]{ return loop->done == loop->count; });
+        }
+
+    // Private:
+        void threadPool::worker()
+        {
+            while(true)
+            {
+                // Wait for a task, once the pool is stopping the remaining tasks are still executed
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    taskAdded.wait(lock, [this]{ return stopping || !tasks.empty(); });
+                    if(tasks.empty())
+                        return;
+                    task = tasks.front();
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+}
@@ -0,0 +1,67 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace server
+{
+    // A fixed number of threads that execute tasks in the order in which they are submitted
+    class threadPool
+    {
+        public:
+            // Constructor, starts the threads (at least one)
+            threadPool(const size_t& threadCount);
+            // Destructor, executes the tasks that are still waiting and stops the threads
+            ~threadPool();
+
+            // Get the number of threads
+            size_t size() const;
+
+            // Add a task, it will be executed by one of the threads
+            void submit(const std::function<void()>& task);
+
+            // Execute body(0), body(1), ..., body(count-1) using the calling thread and the threads of the pool
+            // Returns when all of them are done, this may be called from a task of the pool itself.
+            // The body shouldn't throw.
+            void parallelFor(const size_t& count, const std::function<void(size_t)>& body);
+
+        private:
+            // Prevent copying:
+            threadPool& operator=(const threadPool& other);
+            threadPool(const threadPool& other);
+
+            // The function executed by every thread
+            void worker();
+
+            std::vector<std::thread> threads;               // The threads
+            std::deque<std::function<void()> > tasks;       // The tasks waiting to be executed
+            bool stopping;                                  // Whether the pool is being destroyed
+            std::mutex mutex;                               // Protects tasks and stopping
+            std::condition_variable taskAdded;              // Signalled when a task is added or the pool is stopping
+    };
+}
+
+#endif // THREADPOOL_H
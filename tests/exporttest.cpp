@@ -0,0 +1,286 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "test.h"
+#include "calc/calc.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/mathfunction.h"
+#include "calc/settinghandler.h"
+#include "calc/nativeexport.h"
+#include "calc/pluginloader.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// The directory of plugin.h, the plugins built by the tests include it
+#ifndef TESTS_PLUGIN_INCLUDE_DIR
+#   define TESTS_PLUGIN_INCLUDE_DIR "../calc"
+#endif
+
+namespace test
+{
+    namespace
+    {
+        using calc::real;
+
+        // A small random generator that gives the same numbers on every platform
+        class generator
+        {
+            public:
+                generator(const unsigned long long& seed)
+                : state(seed) {}
+
+                // Get a number in [low, high)
+                real next(const real& low, const real& high)
+                {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    return low + (high - low) * static_cast<real>(state >> 11) / 9007199254740992.0;
+                }
+
+            private:
+                unsigned long long state;
+        };
+
+        // Write a value as it's written in an expression, giving exactly the same value
+        std::string literal(const real& value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.17g", value);
+            return text;
+        }
+
+        // Write a result or an error, with the bits of every number so two results are only written the same if they're exactly the same
+        std::string describe(const real& value)
+        {
+            unsigned long long bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            char text[64];
+            std::snprintf(text, sizeof(text), "%.17g (0x%llx)", value, bits);
+            return text;
+        }
+        std::string describe(const calc::calcError& err)
+        {
+            std::ostringstream out;
+            out<<"error \""<<err.msg<<"\" of type "<<err.type;
+            for(std::vector<calc::string>::const_iterator pos = err.extraStringInfo.begin(); pos != err.extraStringInfo.end(); ++pos)
+                out<<", "<<*pos;
+            for(std::vector<real>::const_iterator pos = err.extraRealInfo.begin(); pos != err.extraRealInfo.end(); ++pos)
+                out<<", "<<describe(*pos);
+            return out.str();
+        }
+
+        // Calculate an expression with a calculator or a context, returns the result or the error
+        std::string calculate(calc::calc& calculator, const calc::string& expression)
+        {
+            try
+            { return describe(calculator.calculate(expression)); }
+            catch(calc::calcError& err)
+            { return describe(err); }
+        }
+        std::string calculate(calc::context& target, const calc::string& expression)
+        {
+            try
+            { return describe(target.evaluate(expression)); }
+            catch(calc::calcError& err)
+            { return describe(err); }
+        }
+
+        // Calculate an expression for a block of rows of the variables x and y, returns the result or the error of every row
+        std::vector<std::string> calculateBlock(calc::context& target, const calc::string& expression, const std::vector<real>& x, const std::vector<real>& y)
+        {
+            std::shared_ptr<const calc::program> prog = calc::context::compile(expression);
+            std::vector<const real*> columns(prog->getVariables().size(), 0);
+            for(size_t slot = 0; slot < columns.size(); ++slot)
+                columns[slot] = prog->getVariables()[slot] == "x" ? &x[0] : (prog->getVariables()[slot] == "y" ? &y[0] : 0);
+            std::vector<real> out(x.size(), 0);
+            std::vector<char> failed(x.size(), 0);
+            std::vector<calc::program::rowError> errors;
+            calc::contextFrame frame(target);
+            prog->executeBlock(frame, columns, x.size(), &out[0], &failed[0], errors);
+
+            std::vector<std::string> results(x.size());
+            for(size_t row = 0; row < x.size(); ++row)
+                results[row] = describe(out[row]);
+            for(std::vector<calc::program::rowError>::const_iterator pos = errors.begin(); pos != errors.end(); ++pos)
+                results[pos->row] = describe(pos->error);
+            return results;
+        }
+
+        // Build a plugin with the C++ compiler of the system (or the one in CXX), returns false if it couldn't be built
+        bool buildPlugin(const std::string& source, const std::string& library)
+        {
+            const char* compiler = std::getenv("CXX");
+            const std::string command = std::string(compiler && *compiler ? compiler : "c++") +
+                                        " -std=c++11 -O2 -ffp-contract=off -fno-builtin -fPIC -shared -I\"" TESTS_PLUGIN_INCLUDE_DIR "\" \"" +
+                                        source + "\" -o \"" + library + "\"";
+            return std::system(command.c_str()) == 0;
+        }
+
+        // Load a plugin, returns false and fails the test if it couldn't be loaded
+        bool loadPlugin(runner& tests, calc::pluginLoader& loader, const std::string& library)
+        {
+            try
+            { loader.load(library); }
+            catch(calc::parseError& err)
+            {
+                tests.check(false, "Loading " + library + ": " + err.msg, __FILE__, __LINE__);
+                return false;
+            }
+            return true;
+        }
+
+        // The source of a plugin made for version 1 of the plugin interface, whose functions didn't have an expression yet
+        const char* pluginVersion1 =
+            "#include <stddef.h>\n"
+            "typedef struct { const char* name; int min_args; int max_args;\n"
+            "                 int (*scalar)(const double*, size_t, double*, void*); void* batch; void* user_data; } function_v1;\n"
+            "typedef struct { unsigned int abi_version; const char* name; const char* version; const function_v1* functions; size_t function_count; } plugin_v1;\n"
+            "static int triple(const double* args, size_t, double* result, void*) { *result = 3*args[0]; return 0; }\n"
+            "static int half(const double* args, size_t, double* result, void*) { *result = args[0]/2; return 0; }\n"
+            "static const function_v1 functions[] = {{\"triple\", 1, 1, triple, 0, 0}, {\"half\", 1, 1, half, 0, 0}};\n"
+            "static const plugin_v1 plugin = {1, \"old\", \"1.0\", functions, 2};\n"
+            "extern \"C\" __attribute__((visibility(\"default\"))) const plugin_v1* dalc_plugin_entry(unsigned int host)\n"
+            "{ return host == 1 ? &plugin : NULL; }\n";
+    }
+
+    void exportTests(runner& tests)
+    {
+#ifndef _WIN32
+        // Exported functions give exactly the same results and errors as the functions they were exported from,
+        // when they're called one by one by a calculator or a context and when they calculate a block of rows
+        tests.run("export/roundtrip", [&]
+        {
+            calc::settingHandler settings;
+            settings["fsq"] = "ARG0*ARG0";
+            settings["fhyp"] = "(sq(ARG0)+sq(ARG1))~2";
+            settings["fpoly"] = "3.1*ARG0^3-2*ARG0^2+0.1*ARG0-7/3";
+            settings["fdivs"] = "ARG0/ARG1+ARG0%ARG1";
+            settings["fpw"] = "ARG0^ARG1";
+            settings["frt"] = "ARG0~ARG1";
+            settings["fmix"] = "abs(ARG0)+FLOOR(ARG1)-ceil(ARG0)+exp(ARG0/10)+log(abs(ARG1)+1)+LOG10(abs(ARG0)+1)+DEG(ARG1)+rad(ARG0)+ROUND(ARG1)";
+            settings["fbits"] = "(ARG0|ARG1)+(ARG0&ARG1)+(ARG0>ARG1)+(ARG0<ARG1)-ARG0";
+            settings["fneg"] = "-sq(ARG0)+-ARG1";
+            settings["fchain"] = "hyp(ARG0, poly(ARG1))/divs(ARG0,ARG1)";
+            settings["fint"] = "((ARG0|0xF0)*3+7)%11-(ARG1&12)*2+(ARG0>ARG1)*0x7FFFFFFFFFFF";
+            settings["fbig"] = "(0x7FFFFFFFFFFFFFF0|ARG0)+4611686018427387904*ARG1";
+            settings["fkonst"] = "1e308*10+0.1";
+            settings["fusesvar"] = "ARG0*k";
+            settings["vk"] = "2";
+
+            // The calls, with arguments that are zero, negative or integral now and then so every error occurs
+            std::vector<calc::string> expressions;
+            const char* two[] = {"bits", "divs", "mix", "pw", "rt", "hyp", "chain", "int", "big"};
+            const char* one[] = {"poly", "sq", "neg", "usesvar"};
+            generator numbers(1);
+            std::vector<real> x, y;
+            for(int i = 0; i < 2000; ++i)
+            {
+                real first = numbers.next(-20, 20), second = numbers.next(-20, 20);
+                if(i % 7 == 0)
+                    second = 0;
+                if(i % 5 == 0)
+                    second = std::floor(second);
+                if(i % 11 == 0)
+                    first = std::floor(first);
+                x.push_back(first);
+                y.push_back(second);
+                for(const char* name : two)
+                    expressions.push_back(calc::string(name) + "(" + literal(first) + "," + literal(second) + ")");
+                for(const char* name : one)
+                    expressions.push_back(calc::string(name) + "(" + literal(first) + ")");
+            }
+            const char* others[] = {"konst()", "sq(1,2)", "sq()", "hyp(1)", "-0*sq(-0)", "divs(1,-0)"};
+            expressions.insert(expressions.end(), others, others + sizeof(others)/sizeof(others[0]));
+
+            // The results of the interpreter
+            calc::builtIns builtIns;
+            calculator calculator;
+            calc::context target;
+            builtIns.addTo(target);
+            settings.copyToCalculator(calculator);
+            settings.copyToContext(target);
+            std::vector<std::string> interpreted, interpretedContext;
+            for(std::vector<calc::string>::const_iterator expression = expressions.begin(); expression != expressions.end(); ++expression)
+            {
+                interpreted.push_back(calculate(calculator, *expression));
+                interpretedContext.push_back(calculate(target, *expression));
+            }
+            const std::vector<std::string> interpretedBlock = calculateBlock(target, "chain(x,y)+bits(x,y)*int(x,y)", x, y);
+
+            // Export the functions, build the plugin and load it
+            const std::string source = tests.getTempDirectory() + "/dalculator-tests-export.cpp";
+            const std::string library = tests.getTempDirectory() + "/dalculator-tests-export.so";
+            const std::vector<calc::string> problems = calc::nativeExporter(settings).saveSource(source, "export");
+            TEST_EQUAL(tests, problems.size(), 1u);                     // usesvar reads a variable
+            TEST_CHECK(tests, buildPlugin(source, library));
+            calc::pluginLoader loader;
+            const bool loaded = loadPlugin(tests, loader, library);
+            std::remove(source.c_str());
+            std::remove(library.c_str());
+            if(!loaded)
+                return;
+            loader.useCompiled(calculator);
+            loader.useCompiled(target);
+            TEST_CHECK(tests, dynamic_cast<calc::userDefinedMathFunction*>(calculator.getFunction("chain"))->getCompiled() != 0);
+            TEST_CHECK(tests, dynamic_cast<calc::userDefinedMathFunction*>(calculator.getFunction("usesvar"))->getCompiled() == 0);
+
+            // The same calls with the exported functions
+            for(size_t i = 0; i < expressions.size(); ++i)
+            {
+                tests.checkEqual(calculate(calculator, expressions[i]), interpreted[i], expressions[i], __FILE__, __LINE__);
+                tests.checkEqual(calculate(target, expressions[i]), interpretedContext[i], expressions[i] + " in a context", __FILE__, __LINE__);
+            }
+            const std::vector<std::string> exportedBlock = calculateBlock(target, "chain(x,y)+bits(x,y)*int(x,y)", x, y);
+            for(size_t row = 0; row < x.size(); ++row)
+                tests.checkEqual(exportedBlock[row], interpretedBlock[row], "row " + std::to_string(row) + " of a block", __FILE__, __LINE__);
+
+            // Changing a definition stops using the exported functions
+            dynamic_cast<calc::userDefinedMathFunction*>(calculator.getFunction("sq"))->setExpression("ARG0*3");
+            loader.useCompiled(calculator);
+            TEST_EQUAL(tests, calculate(calculator, "hyp(3,4)"), describe(std::sqrt(21.0)));
+        });
+
+        // Plugins made for version 1 of the plugin interface are still loaded
+        tests.run("export/plugin-version-1", [&]
+        {
+            const std::string source = tests.getTempDirectory() + "/dalculator-tests-v1.cpp";
+            const std::string library = tests.getTempDirectory() + "/dalculator-tests-v1.so";
+            std::ofstream(source.c_str())<<pluginVersion1;
+            TEST_CHECK(tests, buildPlugin(source, library));
+            calc::pluginLoader loader;
+            const bool loaded = loadPlugin(tests, loader, library);
+            std::remove(source.c_str());
+            std::remove(library.c_str());
+            if(!loaded)
+                return;
+
+            calculator calculator;
+            loader.addTo(calculator);
+            TEST_EQUAL(tests, calculator.calculate("triple(2)+half(5)"), 8.5);
+            TEST_EQUAL(tests, loader.getPlugins().size(), 1u);
+            TEST_EQUAL(tests, loader.getPlugins()[0].functions.size(), 2u);
+        });
+#else
+        static_cast<void>(tests);
+#endif
+    }
+}
@@ -0,0 +1,170 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "test.h"
+#include "calc/calc.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/mathfunction.h"
+#include "calc/series.h"
+#include <vector>
+
+namespace test
+{
+    namespace
+    {
+        using calc::real;
+
+        // Calculate an expression with a calculator or a context, returns the message of the error if it fails
+        std::string calculate(calc::calc& calculator, const calc::string& expression)
+        {
+            try
+            {
+                std::ostringstream out;
+                out.precision(15);
+                out<<calculator.calculate(expression);
+                return out.str();
+            }
+            catch(calc::calcError& err)
+            { return err.msg; }
+        }
+        std::string calculate(calc::context& target, const calc::string& expression)
+        {
+            try
+            {
+                std::ostringstream out;
+                out.precision(15);
+                out<<target.evaluate(expression);
+                return out.str();
+            }
+            catch(calc::calcError& err)
+            { return err.msg; }
+        }
+
+        // Check the calls of user defined functions with a calculator or a context, which both have the functions of definitions
+        template<class Calculator> void checkCalls(runner& tests, Calculator& calculator)
+        {
+            // A function that fails while SOLVE() or INTEGRATE() calls it can be called again, like an expression without the function
+            TEST_EQUAL(tests, calculate(calculator, "SOLVE(f(x)-1,x,0)"), calculate(calculator, "SOLVE(1/x-1,x,0)"));
+            TEST_EQUAL(tests, calculate(calculator, "SOLVE(f(x)-1,x,0)"), "1");
+            TEST_EQUAL(tests, calculate(calculator, "INTEGRATE(f(x),x,-1,1)"), calculate(calculator, "INTEGRATE(1/x,x,-1,1)"));
+            TEST_EQUAL(tests, calculate(calculator, "f(2)"), "0.5");
+
+            // The functions calling the function that fails find the call stack as they left it
+            TEST_EQUAL(tests, calculate(calculator, "outer(4)+outer(2)"), "2.75");
+            TEST_EQUAL(tests, calculate(calculator, "f(0)"), "Division by 0");
+            TEST_EQUAL(tests, calculate(calculator, "outer(4)"), "1.25");
+
+            // Recursion is still found, also after it has been found before
+            TEST_EQUAL(tests, calculate(calculator, "self(1)"), "A function may not (indirectly) call itself");
+            TEST_EQUAL(tests, calculate(calculator, "SOLVE(self(x),x,1)+1"), "A function may not (indirectly) call itself");
+            TEST_EQUAL(tests, calculate(calculator, "f(4)"), "0.25");
+        }
+    }
+
+    void functionTests(runner& tests)
+    {
+        const char* definitions[][2] = {{"f", "1/ARG0"}, {"outer", "SOLVE(f(x)-ARG0,x,0.5)+one(1)"}, {"one", "ARG0"}, {"self", "self(ARG0)"}};
+
+        tests.run("functions/calc-call-stack", [&]
+        {
+            calculator calculator;
+            for(const auto& definition : definitions)
+                calculator.setFunction(definition[0], new calc::userDefinedMathFunction(definition[1], true));
+            checkCalls(tests, calculator);
+        });
+
+        tests.run("functions/context-call-stack", [&]
+        {
+            calc::builtIns builtIns;
+            calc::context target;
+            builtIns.addTo(target);
+            for(const auto& definition : definitions)
+                target.defineFunction(definition[0], definition[1]);
+            checkCalls(tests, target);
+
+            // A row that fails in a function doesn't fail the rows after it
+            std::shared_ptr<const calc::program> prog = calc::context::compile("f(x)");
+            const real x[] = {1, 0, 2, 4};
+            std::vector<const real*> columns(1, x);
+            real out[4] = {0, 0, 0, 0};
+            char failed[4] = {0, 0, 0, 0};
+            std::vector<calc::program::rowError> errors;
+            calc::contextFrame frame(target);
+            prog->executeBlock(frame, columns, 4, out, failed, errors);
+            TEST_EQUAL(tests, errors.size(), 1u);
+            TEST_EQUAL(tests, out[0], 1.0);
+            TEST_EQUAL(tests, out[2], 0.5);
+            TEST_EQUAL(tests, out[3], 0.25);
+        });
+
+        tests.run("functions/expression-arguments", [&]
+        {
+            // Only the functions that take their arguments unevaluated get them unevaluated, whatever their name is
+            calculator calculator;
+            calculator.setFunction("sum", new calc::userDefinedMathFunction("ARG0+ARG1", true));
+            calculator.setFunction("product", new calc::userDefinedMathFunction("ARG0*ARG1", true));
+            calculator.setFunction("total", calculator.getFunction("SUM"));
+            TEST_EQUAL(tests, calculate(calculator, "sum(2,(3))*product(2,3)"), "30");
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1,4,sum(k,1))"), "14");
+            TEST_EQUAL(tests, calculate(calculator, "total(k,1,4,k)"), "10");
+            TEST_EQUAL(tests, calculate(calculator, "-total(k,1,4,product(k,k))"), "-30");
+
+            calc::builtIns builtIns;
+            calc::context target;
+            builtIns.addTo(target);
+            target.defineFunction("sum", "ARG0+ARG1");
+            target.defineFunction("twice", "2*sum(ARG0,ARG0)");
+            target.setFunction("total", builtIns.getFunction("SUM"));
+            TEST_EQUAL(tests, calculate(target, "sum(2,3)"), "5");
+            TEST_EQUAL(tests, calculate(target, "twice(3)"), "12");
+            TEST_EQUAL(tests, calculate(target, "total(k,1,4,sum(k,1))"), "14");
+            TEST_EQUAL(tests, calculate(target, "PRODUCT(k,1,3,twice(k))"), "384");
+
+            // An expression compiled before the function changed still calls it with evaluated arguments
+            std::shared_ptr<const calc::program> prog = calc::context::compile("sum(1,2)");
+            TEST_EQUAL(tests, target.execute(*prog), 3.0);
+        });
+
+        tests.run("functions/combinatorics-arguments", [&]
+        {
+            // NCR and NPR take any integer that fits in 64 bits
+            calculator calculator;
+            TEST_EQUAL(tests, calculate(calculator, "ncr(5000000000,2)"), "1.24999999975e+19");
+            TEST_EQUAL(tests, calculate(calculator, "npr(5000000000,2)"), "2.4999999995e+19");
+            TEST_EQUAL(tests, calc::mathFunctions::ncr(4294967297LL, 2), 9223372039002259456.0);
+            TEST_EQUAL(tests, calc::mathFunctions::ncr(9000000000000000000LL, 1), 9e18);
+            TEST_EQUAL(tests, calculate(calculator, "ncr(2^62,1)"), "4.61168601842739e+18");
+            TEST_EQUAL(tests, calculate(calculator, "ncr(2^63,1)"), "Invalid argument!");
+            TEST_EQUAL(tests, calculate(calculator, "ncr(-2^63,1)"), "0");
+            TEST_EQUAL(tests, calculate(calculator, "ncr(5.5,2)"), "Only integers allowed");
+        });
+
+        tests.run("functions/series-limit", [&]
+        {
+            // A range of more than maxTerms values is refused before anything is calculated, the largest range is still calculated
+            calculator calculator;
+            const calc::string most = calc::real2str(calc::seriesMathFunction::maxTerms);
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1,1e12,k)"), "Too many terms");
+            TEST_EQUAL(tests, calculate(calculator, "PRODUCT(k,0,"+most+",k)"), "Too many terms");
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,-1e15,1e15,k)"), "Too many terms");
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1,"+most+",1)"), most);
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1e12,1,k)"), "0");
+        });
+    }
+}
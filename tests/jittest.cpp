@@ -0,0 +1,192 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "test.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/program.h"
+#include "calc/jit.h"
+#include <set>
+#include <vector>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace test
+{
+    namespace
+    {
+        using calc::real;
+        using calc::program;
+
+        // Write a value with its bits, so two values are only written the same if they're exactly the same (including the sign of zeros and NaNs)
+        std::string describe(const real& value)
+        {
+            unsigned long long bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            std::ostringstream out;
+            out.precision(17);
+            out<<value<<" (0x"<<std::hex<<bits<<")";
+            return out.str();
+        }
+
+        // Execute a program in a frame of the context and write everything it did: the result and its integer value or the error,
+        // and the variables it assigned. With native set, the program is compiled to native code before it's executed.
+        std::string execute(const program& compiled, const calc::context& source, const bool& native)
+        {
+            // Copies of a program don't have native code, so it's made (or not) by this execution
+            const program prog(compiled);
+            program::setJitThreshold(native ? 1 : 0);
+            calc::contextFrame frame(source);
+            std::string out;
+            try
+            {
+                program::exactInteger exact = {0, false};
+                out = describe(prog.execute(frame, exact));
+                if(exact.exact)
+                {
+                    std::ostringstream value;
+                    value<<" exactly "<<exact.value;
+                    out += value.str();
+                }
+            }
+            catch(calc::calcError& err)
+            {
+                std::ostringstream error;
+                error<<"error \""<<err.msg<<"\" of type "<<err.type;
+                for(std::vector<calc::string>::const_iterator pos = err.extraStringInfo.begin(); pos != err.extraStringInfo.end(); ++pos)
+                    error<<", "<<*pos;
+                for(std::vector<real>::const_iterator pos = err.extraRealInfo.begin(); pos != err.extraRealInfo.end(); ++pos)
+                    error<<", "<<describe(*pos);
+                out = error.str();
+            }
+
+            // The variables that have been assigned
+            calc::context after(source);
+            frame.commit(after);
+            const calc::varList& vars = after.getVars();
+            for(calc::varList::const_iterator pos = vars.begin(); pos != vars.end(); ++pos)
+            {
+                if(!source.varExists(pos->first) || describe(source.getVar(pos->first)) != describe(pos->second))
+                    out += " " + pos->first + "=" + describe(pos->second);
+            }
+            return out;
+        }
+
+#ifdef CALC_JIT
+        // A step function for jitCode::compile() that's never called, only used to find out whether there is native code at all
+        int unusedStep(void*, const program*, unsigned int)
+        { return 1; }
+#endif
+
+        // The expressions used by the differential tests
+        // Every binary operator of the calculator is tried on every pair of operands, the operands include variables with
+        // special values (zeros of both signs, NaN, infinity, denormals and numbers near the largest value), integers that
+        // only fit in 64 bits (which use the integer instructions) and unknown variables (which give errors).
+        std::vector<calc::string> operatorExpressions()
+        {
+            const char* operands[] = {"a", "b", "h", "zero", "mz", "neg", "big", "tiny", "nan", "inf", "7", "2", "0", "-3", "0.1", "1:30",
+                                      "9007199254740993", "0x7FFFFFFFFFFFFFFF", "-a", "unknown"};
+            const char* operators[] = {"^", "~", "*", "/", "%", "+", "-", ">", "<", "|", "&"};
+            const size_t operandCount = sizeof(operands)/sizeof(operands[0]), operatorCount = sizeof(operators)/sizeof(operators[0]);
+
+            std::vector<calc::string> expressions;
+            for(size_t op = 0; op < operatorCount; ++op)
+            {
+                for(size_t first = 0; first < operandCount; ++first)
+                {
+                    for(size_t second = 0; second < operandCount; ++second)
+                        expressions.push_back(calc::string(operands[first]) + operators[op] + operands[second]);
+                }
+
+                // Negations, assignments and the precedence of every pair of operators
+                expressions.push_back(calc::string("-(a") + operators[op] + "b)");
+                expressions.push_back(calc::string("-(9007199254740993") + operators[op] + "3)");
+                expressions.push_back(calc::string("q=h") + operators[op] + "neg");
+                expressions.push_back(calc::string("q=zero") + operators[op] + "zero");
+                for(size_t next = 0; next < operatorCount; ++next)
+                {
+                    expressions.push_back(calc::string("a") + operators[op] + "7" + operators[next] + "b");
+                    expressions.push_back(calc::string("9007199254740993") + operators[op] + "5" + operators[next] + "0x7FFFFFFFFFFFFFF0");
+                }
+            }
+
+            // Integers that don't fit any more, function calls (known, unknown, user defined and with unevaluated arguments) and assignments
+            const char* others[] = {"0x7FFFFFFFFFFFFFFF+1", "-0x7FFFFFFFFFFFFFFF-1", "0x7FFFFFFFFFFFFFFF*2-1", "4294967296*4294967296", "-9007199254740993*-1",
+                                    "9007199254740993%0", "9007199254740993%-2", "(0x7FFFFFFFFFFFFFFF|1)&0xF0", "-(0x7FFFFFFFFFFFFFFF|0)",
+                                    "ABS(b)*2", "ABS(nan)", "SIN(a)+COS(b)", "NCR(7,3)-1", "AVG(a,b,h)", "IF(a>b,a,b)", "twice(a)+1", "twice(unknown)",
+                                    "nope(a)", "nope(a)+unknown", "ABS(1,2)", "SOLVE(x^2-2,x,1)", "q=a", "q=r=a*2", "q=a/zero", "a=a+1", "q=unknown"};
+            expressions.insert(expressions.end(), others, others + sizeof(others)/sizeof(others[0]));
+            return expressions;
+        }
+    }
+
+    void jitTests(runner& tests)
+    {
+        // A context with the built-in functions, a user defined function and variables with special values
+        calc::builtIns builtIns;
+        calc::context source;
+        builtIns.addTo(source);
+        source.defineFunction("twice", "ARG0*2");
+        source.setVar("a", 3);
+        source.setVar("b", -2.5);
+        source.setVar("h", 0.5);
+        source.setVar("zero", 0);
+        source.setVar("mz", -0.0);
+        source.setVar("neg", -4);
+        source.setVar("big", std::numeric_limits<real>::max());
+        source.setVar("tiny", std::numeric_limits<real>::denorm_min());
+        source.setVar("nan", std::numeric_limits<real>::quiet_NaN());
+        source.setVar("inf", std::numeric_limits<real>::infinity());
+
+        tests.run("jit/available", [&]
+        {
+#ifdef CALC_JIT
+            // On supported platforms every program gets native code
+            std::unique_ptr<calc::jitCode> code(calc::jitCode::compile(*calc::context::compile("a*2+b"), &unusedStep));
+            TEST_CHECK(tests, code.get() != 0);
+#endif
+        });
+
+        // Every expression has to give exactly the same results, integers, errors and assignments with native code as with the interpreter
+        tests.run("jit/operators", [&]
+        {
+            const std::vector<calc::string> expressions = operatorExpressions();
+            std::set<int> opcodes;
+            for(std::vector<calc::string>::const_iterator expression = expressions.begin(); expression != expressions.end(); ++expression)
+            {
+                std::shared_ptr<const program> prog;
+                try
+                { prog = calc::context::compile(*expression); }
+                catch(calc::calcError& err)
+                {
+                    tests.check(false, *expression + " doesn't compile: " + err.msg, __FILE__, __LINE__);
+                    continue;
+                }
+                for(std::vector<program::instruction>::const_iterator instr = prog->getInstructions().begin(); instr != prog->getInstructions().end(); ++instr)
+                    opcodes.insert(instr->op);
+                tests.checkEqual(execute(*prog, source, true), execute(*prog, source, false), *expression, __FILE__, __LINE__);
+            }
+
+            // The expressions use every instruction, the ones the native code does itself and the ones it hands back to the interpreter
+            for(int op = program::opConstant; op <= program::opIntLess; ++op)
+                tests.checkEqual(opcodes.count(op), 1u, "uses of instruction " + std::to_string(op), __FILE__, __LINE__);
+            program::setJitThreshold(program::defaultJitThreshold);
+        });
+    }
+}
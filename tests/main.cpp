@@ -0,0 +1,78 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+#include "calc/types.h"
+#include "test.h"
+
+namespace
+{
+    // Prints how this program should be used
+    void printUsage(std::ostream& out)
+    {
+        out<<"Usage: dalculator-tests [options]\n"
+             "Runs the tests of the calculator engine, prints every test that ran and the checks that failed.\n"
+             "Exits with 1 if any test failed.\n"
+             "\n"
+             "Options:\n"
+             "  -f, --filter TEXT      Only run the tests whose name contains TEXT\n"
+             "      --temp-dir DIR     The directory for the files made by the tests\n"
+             "      --list             Only list the names of the tests\n"
+             "  -h, --help             Show this help\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // The options, set by the command line arguments
+    test::runner runner(std::cout);
+    const char* tempDir = std::getenv("TMPDIR");
+    runner.setTempDirectory(tempDir && *tempDir ? tempDir : ".");
+
+    // Read the command line arguments
+    for(int i = 1; i < argc; ++i)
+    {
+        const calc::string arg = argv[i];
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        else if((arg == "-f" || arg == "--filter") && i+1 < argc)
+            runner.setFilter(argv[++i]);
+        else if(arg == "--temp-dir" && i+1 < argc)
+            runner.setTempDirectory(argv[++i]);
+        else if(arg == "--list")
+            runner.setListOnly(true);
+        else
+        {
+            printUsage(std::cerr);
+            return 2;
+        }
+    }
+
+    // Run the tests
+    test::jitTests(runner);
+    test::functionTests(runner);
+    test::exportTests(runner);
+    test::programTests(runner);
+
+    std::cout<<runner.getTestCount()<<" tests, "<<runner.getCheckCount()<<" checks, "<<runner.getFailedCount()<<" failed"<<std::endl;
+    return runner.getFailedCount() ? 1 : 0;
+}
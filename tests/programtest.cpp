@@ -0,0 +1,160 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "test.h"
+#include "calc/calc.h"
+#include "calc/context.h"
+#include "calc/builtins.h"
+#include "calc/program.h"
+#include "calc/sampler.h"
+#include "lib/dalc.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace test
+{
+    namespace
+    {
+        using calc::real;
+
+        // Calculate an expression with a calculator, returns the message of the error if it fails
+        std::string calculate(calc::calc& calculator, const calc::string& expression)
+        {
+            try
+            {
+                std::ostringstream out;
+                out.precision(15);
+                out<<calculator.calculate(expression);
+                return out.str();
+            }
+            catch(calc::calcError& err)
+            { return err.msg; }
+        }
+    }
+
+    void programTests(runner& tests)
+    {
+        tests.run("program/unknown-function-block", [&]
+        {
+            // Every row of a block fails, whether or not the function is called with a column
+            calc::builtIns builtIns;
+            calc::context target;
+            builtIns.addTo(target);
+            const char* expressions[] = {"foo(a)", "foo(2)+a", "a+foo(a, 2)"};
+            for(const char* expression : expressions)
+            {
+                std::shared_ptr<const calc::program> prog = calc::context::compile(expression);
+                std::vector<real> a(calc::program::blockSize + 3, 1);
+                std::vector<const real*> columns(prog->getVariables().size(), 0);
+                for(size_t slot = 0; slot < columns.size(); ++slot)
+                {
+                    if(prog->getVariables()[slot] == "a")
+                        columns[slot] = a.data();
+                }
+                std::vector<real> out(a.size(), 0);
+                std::vector<char> failed(a.size(), 0);
+                std::vector<calc::program::rowError> errors;
+                calc::contextFrame frame(target);
+                prog->executeBlock(frame, columns, a.size(), out.data(), failed.data(), errors);
+                TEST_EQUAL(tests, errors.size(), a.size());
+                TEST_CHECK(tests, std::find(failed.begin(), failed.end(), 0) == failed.end());
+                TEST_CHECK(tests, !errors.empty() && errors.front().error.type == calc::calcError::unknownName
+                                  && errors.front().error.extraStringInfo == std::vector<calc::string>(1, "foo"));
+            }
+        });
+
+        tests.run("program/unknown-function-batch", [&]
+        {
+            dalc_context* context = dalc_context_new(DALC_BUILTINS);
+            dalc_program* prog = dalc_compile("foo(a)");
+            TEST_CHECK(tests, context != 0 && prog != 0);
+            const char* names[] = {"a"};
+            const double a[] = {1, 2, 3};
+            const double* columns[] = {a};
+            double results[3] = {0, 0, 0};
+            unsigned char failed[3] = {0, 0, 0};
+            TEST_EQUAL(tests, dalc_execute_batch(context, prog, names, columns, 1, 3, results, failed), DALC_ERROR);
+            TEST_EQUAL(tests, std::string(dalc_last_error()), "Unknown function: foo");
+            for(size_t row = 0; row < 3; ++row)
+                TEST_CHECK(tests, failed[row] == 1 && std::isnan(results[row]));
+            dalc_program_free(prog);
+            dalc_context_free(context);
+        });
+
+        tests.run("program/statistics-size", [&]
+        {
+            // The statistics are only written if the caller set their size
+            dalc_context* context = dalc_context_new(DALC_BUILTINS);
+            dalc_program* prog = dalc_compile("RAND()");
+            dalc_statistics statistics;
+            std::memset(&statistics, 0, sizeof(statistics));
+            TEST_EQUAL(tests, dalc_monte_carlo(context, prog, 100, 1, 0, 0, 0, &statistics), DALC_ERROR_ARGUMENT);
+            TEST_EQUAL(tests, statistics.count, 0u);
+            statistics.size = sizeof(statistics);
+            TEST_EQUAL(tests, dalc_monte_carlo(context, prog, 100, 1, 0, 0, 0, &statistics), DALC_OK);
+            TEST_EQUAL(tests, statistics.size, sizeof(statistics));
+            TEST_EQUAL(tests, statistics.count, 100u);
+            TEST_CHECK(tests, statistics.minimum >= 0 && statistics.maximum < 1 && statistics.minimum < statistics.maximum);
+            dalc_program_free(prog);
+            dalc_context_free(context);
+        });
+
+        tests.run("program/base-output", [&]
+        {
+            // Values whose magnitude doesn't fit in 64 bits can't be written in a base, instead of being written as 0
+            const int types[] = {DALC_OUTPUT_BIN, DALC_OUTPUT_OCT, DALC_OUTPUT_HEX};
+            const double tooBig[] = {18446744073709551615.0, -18446744073709551616.0, 1e30, std::numeric_limits<double>::quiet_NaN()};
+            char buffer[80];
+            for(int type : types)
+            {
+                for(double value : tooBig)
+                    TEST_EQUAL(tests, dalc_format(value, type, buffer, sizeof(buffer), 0), DALC_ERROR_OVERFLOW);
+            }
+            TEST_EQUAL(tests, calc::real2str(18446744073709549568.0, calc::outputType_hex), "0xfffffffffffff800");
+            TEST_EQUAL(tests, calc::real2str(-9223372036854775808.0, calc::outputType_hex), "-0x8000000000000000");
+            TEST_EQUAL(tests, calc::real2str(18446744073709549568.0, calc::outputType_oct), "01777777777777777774000");
+            TEST_EQUAL(tests, calc::real2str(255, calc::outputType_bin), "11111111");
+        });
+
+        tests.run("program/unknown-function-sample", [&]
+        {
+            calc::builtIns builtIns;
+            calc::context target;
+            builtIns.addTo(target);
+            std::shared_ptr<const calc::program> prog = calc::context::compile("foo(x)");
+            std::vector<calc::functionSampler::sample> samples = calc::functionSampler(2).uniform(target, *prog, "x", 0, 1, 5);
+            TEST_EQUAL(tests, samples.size(), 5u);
+            for(const calc::functionSampler::sample& s : samples)
+                TEST_CHECK(tests, s.failed);
+        });
+
+        tests.run("program/unknown-function-series", [&]
+        {
+            // SUM() and INTEGRATE() evaluate their expression for a block of values at once
+            calculator calculator;
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1,3,foo(k))"), "Unknown function");
+            TEST_EQUAL(tests, calculate(calculator, "PRODUCT(k,1,3,k*foo(k))"), "Unknown function");
+            TEST_EQUAL(tests, calculate(calculator, "INTEGRATE(foo(x),x,0,1)"), "Unknown function");
+            TEST_EQUAL(tests, calculate(calculator, "INTEGRATE(1/sqrt(x),x,0,1)"), "Unknown function");
+            TEST_EQUAL(tests, calculate(calculator, "SUM(k,1,3,k)"), "6");
+        });
+    }
+}
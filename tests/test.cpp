@@ -0,0 +1,105 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#include "test.h"
+#include <iostream>
+#include <exception>
+#include <vector>
+
+namespace test
+{
+    // runner:
+        // Public:
+            runner::runner(std::ostream& log)
+            : log(log), listOnly(false), tempDirectory("."), currentFailed(false), tests(0), failedTests(0), checks(0) {}
+
+            void runner::setFilter(const std::string& newFilter)
+            { filter = newFilter; }
+
+            void runner::setListOnly(const bool& newListOnly)
+            { listOnly = newListOnly; }
+
+            void runner::setTempDirectory(const std::string& directory)
+            { tempDirectory = directory; }
+
+            const std::string& runner::getTempDirectory() const
+            { return tempDirectory; }
+
+            bool runner::selected(const std::string& name) const
+            { return name.find(filter) != std::string::npos; }
+
+            void runner::run(const std::string& name, const std::function<void()>& body)
+            {
+                if(!selected(name))
+                    return;
+                if(listOnly)
+                {
+                    std::cout<<name<<std::endl;
+                    return;
+                }
+
+                // Run the test, an exception fails it
+                current = name;
+                currentFailed = false;
+                try
+                { body(); }
+                catch(std::exception& exc)
+                { check(false, std::string("Exception: ") + exc.what(), __FILE__, __LINE__); }
+                catch(...)
+                { check(false, "Unknown exception", __FILE__, __LINE__); }
+
+                ++tests;
+                if(currentFailed)
+                    ++failedTests;
+                log<<(currentFailed ? "FAIL " : "ok   ")<<name<<std::endl;
+            }
+
+            void runner::check(const bool& passed, const std::string& description, const char* file, const int& line)
+            {
+                ++checks;
+                if(passed)
+                    return;
+                currentFailed = true;
+                log<<current<<": "<<file<<":"<<line<<": "<<description<<std::endl;
+            }
+
+            unsigned int runner::getTestCount() const
+            { return tests; }
+
+            unsigned int runner::getFailedCount() const
+            { return failedTests; }
+
+            unsigned long long runner::getCheckCount() const
+            { return checks; }
+
+    // calculator:
+        // Public:
+            calculator::calculator()
+            : ::calc::calc("", false)
+            { builtIns.addTo(*this); }
+
+            calculator::~calculator()
+            {
+                std::vector< ::calc::string> names;
+                for(::calc::functionList::const_iterator pos = getFunctions()->begin(); pos != getFunctions()->end(); ++pos)
+                    names.push_back(pos->first);
+                for(std::vector< ::calc::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+                    deleteFunction(*name);
+                setVarlist(::calc::varList());
+            }
+}
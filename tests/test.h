@@ -0,0 +1,116 @@
+/******************************* License - GPLv3 ********************************
+* Dalculator, a simple calculator                                               *
+* Copyright (C) 2011 Divendo                                                    *
+*                                                                               *
+* This program is free software: you can redistribute it and/or modify          *
+* it under the terms of the GNU General Public License as published by          *
+* the Free Software Foundation, either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This program is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                  *
+* GNU General Public License for more details.                                  *
+*                                                                               *
+* You should have received a copy of the GNU General Public License             *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.         *
+********************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <string>
+#include <sstream>
+#include <ostream>
+#include <functional>
+#include "calc/calc.h"
+#include "calc/builtins.h"
+
+namespace test
+{
+    // Runs tests and reports the checks that fail
+    // A test is a function doing any number of checks, a check that fails doesn't stop the test.
+    // An exception escaping from a test fails it as well.
+    class runner
+    {
+        public:
+            // Constructor, the checks that fail are reported to log
+            runner(std::ostream& log);
+
+            // Only run the tests whose name contains the filter
+            void setFilter(const std::string& newFilter);
+            // Only list the names of the tests instead of running them
+            void setListOnly(const bool& newListOnly);
+            // Set the directory for the files made by the tests
+            void setTempDirectory(const std::string& directory);
+            // Get the directory for the files made by the tests
+            const std::string& getTempDirectory() const;
+
+            // Returns true if the test with the given name should run, this can be used to skip expensive preparations
+            bool selected(const std::string& name) const;
+            // Run a test
+            void run(const std::string& name, const std::function<void()>& body);
+
+            // Record a check of the current test, if it didn't pass it's reported with the description and the place of the check
+            void check(const bool& passed, const std::string& description, const char* file, const int& line);
+            // Record a check whether two values are the same, if they aren't they're reported as well
+            template<class Actual, class Expected> void checkEqual(const Actual& actual, const Expected& expected, const std::string& description, const char* file, const int& line)
+            {
+                if(actual == expected)
+                {
+                    check(true, description, file, line);
+                    return;
+                }
+                std::ostringstream out;
+                out.precision(17);
+                out<<description<<": got "<<actual<<", expected "<<expected;
+                check(false, out.str(), file, line);
+            }
+
+            // Get the number of tests that ran
+            unsigned int getTestCount() const;
+            // Get the number of tests that failed
+            unsigned int getFailedCount() const;
+            // Get the number of checks done by all tests
+            unsigned long long getCheckCount() const;
+
+        private:
+            std::ostream& log;                      // Where the checks that fail are reported
+            std::string filter;                     // The filter on the names of the tests
+            bool listOnly;                          // Whether only the names are listed
+            std::string tempDirectory;              // The directory for the files made by the tests
+            std::string current;                    // The name of the test that is running
+            bool currentFailed;                     // Whether any check of the test that is running failed
+            unsigned int tests;                     // The number of tests that ran
+            unsigned int failedTests;               // The number of tests that failed
+            unsigned long long checks;              // The number of checks
+    };
+
+    // A calculator with the built-in functions
+    // The variables and functions of calc are shared by all its instances, so they're all deleted again when this calculator is
+    // destroyed. That way every test starts without the functions and variables of the tests before it.
+    class calculator : public calc::calc
+    {
+        public:
+            // Constructor, adds the built-in functions and variables
+            calculator();
+            // Destructor, deletes all functions and variables
+            ~calculator();
+
+        private:
+            ::calc::builtIns builtIns;              // The built-in functions
+    };
+
+    // The tests, every file of tests has a function running all of its tests
+    void jitTests(runner& tests);
+    void functionTests(runner& tests);
+    void exportTests(runner& tests);
+    void programTests(runner& tests);
+}
+
+// Check a condition in a test
+#define TEST_CHECK(tests, condition) (tests).check((condition), #condition, __FILE__, __LINE__)
+// Check whether a value is the expected value in a test
+#define TEST_EQUAL(tests, actual, expected) (tests).checkEqual((actual), (expected), #actual, __FILE__, __LINE__)
+
+#endif // TEST_H
@@ -0,0 +1,28 @@
+# -------------------------------------------------
+# Tests of the calculator engine
+# Run dalculator-tests, it exits with 1 if any test failed, see dalculator-tests --help for the options
+# -------------------------------------------------
+TARGET = dalculator-tests
+TEMPLATE = app
+
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+include(../calc/calc.pri)
+
+# The plugins built by the tests include plugin.h
+DEFINES += TESTS_PLUGIN_INCLUDE_DIR=\\\"$$PWD/../calc\\\"
+# The library is linked in statically to test its C interface
+DEFINES += DALC_BUILDING
+
+SOURCES += main.cpp \
+    test.cpp \
+    jittest.cpp \
+    functiontest.cpp \
+    exporttest.cpp \
+    programtest.cpp \
+    ../lib/dalc.cpp \
+    ../cli/messages.cpp
+HEADERS += test.h \
+    ../lib/dalc.h \
+    ../cli/messages.h
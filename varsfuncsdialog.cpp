@@ -1,6 +1,8 @@
 #include "varsfuncsdialog.h"
 #include "ui_varsfuncsdialog.h"
 
+#include <QFileDialog>
+#include <QMessageBox>
 #include <iostream>
 
 // Public:
@@ -8,7 +10,7 @@
     QDialog(parent), ui(new Ui::varsFuncsDialog),
     calculator(calculator),
     myVarsWidget(new varsWidget(calculator->getVars())),
-    myFuncsWidget(new funcsWidget(calculator->getFuncs()))
+    myFuncsWidget(new funcsWidget(calculator->getFuncs(), calculator->getPluginFuncs()))
     {
         ui->setupUi(this);
 
@@ -26,6 +28,9 @@
 
         connect(this, SIGNAL(deleteVar(const QString&)), calculator, SLOT(deleteVar(const QString&)));
         connect(this, SIGNAL(deleteFunc(const QString&)), calculator, SLOT(deleteFunc(const QString&)));
+
+        ui->profileFunctions->setChecked(calculator->isProfiling());
+        reloadProfiles();
     }
 
     varsFuncsDialog::~varsFuncsDialog()
@@ -42,6 +47,7 @@
         reloadFuncList();
         reloadDeleteVarList();
         reloadDeleteFuncList();
+        reloadProfiles();
     }
 
 // Protected:
@@ -74,6 +80,34 @@
             reloadDeleteVarList();
             reloadDeleteFuncList();
         }
+        // The functions may have been called since the profiles were shown
+        else if(index == 1)
+            reloadProfiles();
+    }
+
+    void varsFuncsDialog::on_profileFunctions_toggled(bool checked)
+    {
+        calculator->setProfiling(checked);
+        reloadProfiles();
+    }
+
+    void varsFuncsDialog::on_resetProfile_clicked()
+    {
+        calculator->resetProfile();
+        reloadProfiles();
+    }
+
+    void varsFuncsDialog::on_exportProfile_clicked()
+    {
+        // The chosen filter decides whether a report or a trace is written
+        const QString reportFilter = tr("Report (*.txt)");
+        const QString traceFilter = tr("Chrome trace (*.json)");
+        QString selectedFilter = reportFilter;
+        const QString filename = QFileDialog::getSaveFileName(this, tr("Export profile"), QString(), reportFilter+";;"+traceFilter, &selectedFilter);
+        if(filename.isEmpty())
+            return;
+        if(!calculator->exportProfile(filename, selectedFilter == traceFilter))
+            QMessageBox::warning(this, tr("Export profile"), tr("The profile couldn't be written to %1").arg(filename));
     }
 
     void varsFuncsDialog::on_varsList_itemSelectionChanged()
@@ -116,7 +150,10 @@
     { myVarsWidget->setVars(calculator->getVars()); }
 
     void varsFuncsDialog::reloadFuncList()
-    { myFuncsWidget->setFuncs(calculator->getFuncs()); }
+    { myFuncsWidget->setFuncs(calculator->getFuncs(), calculator->getPluginFuncs()); }
+
+    void varsFuncsDialog::reloadProfiles()
+    { myFuncsWidget->setProfiles(calculator->getProfiles(), calculator->isProfiling()); }
 
     void varsFuncsDialog::reloadDeleteVarList()
     {
@@ -37,6 +37,9 @@ class varsFuncsDialog : public QDialog
         void on_funcsList_itemSelectionChanged();
         void on_varsList_itemSelectionChanged();
         void on_varsFuncsTab_currentChanged(int index);
+        void on_profileFunctions_toggled(bool checked);
+        void on_resetProfile_clicked();
+        void on_exportProfile_clicked();
         void variableAdded(const QString& name, const calc::real& value);
         void functionAdded(const QString& name, const QString& content);
 
@@ -45,6 +48,7 @@ class varsFuncsDialog : public QDialog
         void reloadFuncList();
         void reloadDeleteVarList();
         void reloadDeleteFuncList();
+        void reloadProfiles();
 
         Ui::varsFuncsDialog* ui;
 